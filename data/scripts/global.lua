@@ -33,6 +33,7 @@ global_def.lightingDithering = false
 
 global_def.tick_world = true
 global_def.tick_box2d = true
+global_def.chunk_mesh_rects = false
 global_def.tick_temperature = true
 global_def.hd_objects = false
 
@@ -45,4 +46,9 @@ global_def.draw_console = false
 global_def.draw_pack_editor = false
 
 global_def.cell_iter = 3
+global_def.tick_budget_ms = 0
+global_def.tick_budget_near = 2
+global_def.sim_lod = false
+global_def.sim_lod_near = 2
+global_def.sim_lod_mid = 4
 global_def.brush_size = 5
\ No newline at end of file
@@ -0,0 +1,39 @@
+-- Copyright(c) 2022-2023, KaoruXun All rights reserved.
+-- ScriptingWorldGenerator 的默认生成脚本
+-- 每个区块调用一次 缓冲区由引擎从池中分配 通过 ffi.cast 按下标(从0开始)访问
+--   noise[x + y * w]    预采样噪声 [-1, 1]
+--   height[x]           该列地表高度 (世界坐标)
+--   material[x + y * w] 输出材料ID -1 为空气
+local ffi = require("ffi")
+
+local SMOOTH_STONE = materials_get_id("SMOOTH_STONE")
+local SMOOTH_DIRT = materials_get_id("SMOOTH_DIRT")
+local SOFT_DIRT = materials_get_id("SOFT_DIRT")
+local GRASS = materials_get_id("GRASS")
+local AIR = -1
+
+return function(cx, cy, w, h, noise_p, height_p, material_p)
+    local noise = ffi.cast("float *", noise_p)
+    local height = ffi.cast("int32_t *", height_p)
+    local material = ffi.cast("int32_t *", material_p)
+
+    for x = 0, w - 1 do
+        local surf = height[x]
+        for y = 0, h - 1 do
+            local py = y + cy * h
+            local i = x + y * w
+            if py > surf then
+                -- 越深石头越多
+                local thru = math.min(math.max(0, (py - surf) / 150.0), 1)
+                local n = (noise[i] / 2.0 + 0.5) - 0.1
+                material[i] = (n * (1 - thru) + 0.4 * thru) < 0.5 and SMOOTH_STONE or SMOOTH_DIRT
+            elseif py > surf - 64 then
+                material[i] = ((noise[i] / 2.0 + 0.5) + 0.4) / 2.0 < math.abs((surf - 64) - py) / 64.0 and SMOOTH_DIRT or SOFT_DIRT
+            elseif py > surf - 65 then
+                material[i] = GRASS
+            else
+                material[i] = AIR
+            end
+        end
+    end
+end
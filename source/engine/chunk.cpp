@@ -2,6 +2,7 @@
 
 #include "chunk.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -14,6 +15,70 @@
 
 namespace ME {
 
+// 冻结刚体跟在背景数据之后 旧的区块文件没有这一段
+static void write_frozen_bodies(std::ofstream &f, const std::vector<FrozenBody> &bodies) {
+    int count = (int)bodies.size();
+    f.write((char *)&count, sizeof(int));
+    for (const FrozenBody &b : bodies) {
+        f32 head[10] = {b.x, b.y, b.cx, b.cy, b.angle, b.vx, b.vy, b.av, b.density, b.friction};
+        int dims[4] = {b.w, b.h, (int)b.shapes.size(), b.needsUpdate ? 1 : 0};
+        f.write((char *)head, sizeof(head));
+        f.write((char *)dims, sizeof(dims));
+        for (const b2PolygonShape &s : b.shapes) {
+            f.write((char *)&s.m_count, sizeof(int));
+            f.write((char *)s.m_vertices, s.m_count * sizeof(b2Vec2));
+        }
+        f.write((char *)b.tiles.data(), b.tiles.size() * sizeof(MaterialInstanceData));
+    }
+}
+
+static bool read_frozen_bodies(std::ifstream &f, std::vector<FrozenBody> &bodies) {
+    bodies.clear();
+    int count = 0;
+    if (!f.read((char *)&count, sizeof(int))) return true;
+    if (count < 0 || count > 65536) return false;
+
+    bodies.resize(count);
+    for (FrozenBody &b : bodies) {
+        f32 head[10];
+        int dims[4];
+        if (!f.read((char *)head, sizeof(head)) || !f.read((char *)dims, sizeof(dims))) return false;
+        b.x = head[0];
+        b.y = head[1];
+        b.cx = head[2];
+        b.cy = head[3];
+        b.angle = head[4];
+        b.vx = head[5];
+        b.vy = head[6];
+        b.av = head[7];
+        b.density = head[8];
+        b.friction = head[9];
+        b.w = dims[0];
+        b.h = dims[1];
+        b.needsUpdate = dims[3] != 0;
+        if (b.w <= 0 || b.h <= 0 || b.w > 4096 || b.h > 4096 || dims[2] <= 0 || dims[2] > 4096) return false;
+
+        b.shapes.resize(dims[2]);
+        for (b2PolygonShape &s : b.shapes) {
+            int n = 0;
+            b2Vec2 verts[b2_maxPolygonVertices];
+            if (!f.read((char *)&n, sizeof(int)) || n < 3 || n > b2_maxPolygonVertices) return false;
+            if (!f.read((char *)verts, n * sizeof(b2Vec2))) return false;
+            s.Set(verts, n);
+        }
+
+        b.tiles.resize((size_t)b.w * b.h);
+        if (!f.read((char *)b.tiles.data(), b.tiles.size() * sizeof(MaterialInstanceData))) return false;
+    }
+
+    // 材料表与存盘时不同或数据损坏时材料下标越界 只丢掉这些刚体 解冻时直接按下标取材料
+    size_t dropped = std::erase_if(bodies, [](const FrozenBody &b) {
+        return std::any_of(b.tiles.begin(), b.tiles.end(), [](const MaterialInstanceData &t) { return (i64)t.index < 0 || (i64)t.index >= GAME()->materials_count; });
+    });
+    if (dropped > 0) METADOT_ERROR(std::format("Dropped {0} frozen rigid bodies with unknown materials", dropped).c_str());
+    return true;
+}
+
 void Chunk::ChunkInit(int x, int y, const std::string &worldName) {
     this->x = x;
     this->y = y;
@@ -27,6 +92,9 @@ void Chunk::ChunkDelete() {
 
     // 清空群系索引
     this->biomes_id.clear();
+
+    // 冻结刚体已随区块写入磁盘
+    this->frozenBodies.clear();
 }
 
 void Chunk::ChunkLoadMeta() {
@@ -200,6 +268,11 @@ void Chunk::ChunkRead() {
 
         free(readBuf);
 
+        if (!read_frozen_bodies(myfile, this->frozenBodies)) {
+            METADOT_ERROR(std::format("Frozen rigid bodies in chunk {0},{1} are corrupt, dropped", this->x, this->y).c_str());
+            this->frozenBodies.clear();
+        }
+
         myfile.close();
     } else {
         METADOT_ERROR(std::format("Read chunk {0},{1} faild", this->x, this->y).c_str());
@@ -223,6 +296,9 @@ void Chunk::ChunkWrite(MaterialInstance *tiles, MaterialInstance *layer2, u32 *b
     if (this->tiles == NULL || this->layer2 == NULL || this->background == NULL) return;
     this->hasTileCache = true;
 
+    // 未修改的区块可以由种子重新生成 不需要写入磁盘
+    if (this->pristine) return;
+
     // TODO: make these loops faster
     // for (int i = 0; i < CHUNK_W * CHUNK_H; i++) {
     //     myfile.write((char *)&tiles[i].mat.id, sizeof(unsigned int));
@@ -321,6 +397,8 @@ void Chunk::ChunkWrite(MaterialInstance *tiles, MaterialInstance *layer2, u32 *b
     myfile.write((char *)compressed_data, compressed_data_size);
     myfile.write((char *)compressed_data2, compressed_data_size2);
 
+    write_frozen_bodies(myfile, this->frozenBodies);
+
     free(compressed_data);
     free(compressed_data2);
 
@@ -334,6 +412,26 @@ bool Chunk::ChunkHasFile() {
     return (stat(this->pack_filename.c_str(), &buffer) == 0);
 }
 
+u64 Chunk::ChunkContentHash() const {
+    if (tiles == nullptr || layer2 == nullptr || background == nullptr) return 0;
+
+    // FNV-1a
+    u64 h = 14695981039346656037ull;
+    auto mix = [&h](u32 v) {
+        h ^= v;
+        h *= 1099511628211ull;
+    };
+    for (int i = 0; i < CHUNK_W * CHUNK_H; i++) {
+        mix(tiles[i].mat->id);
+        mix(tiles[i].color);
+        mix((u16)tiles[i].temperature);
+        mix(layer2[i].mat->id);
+        mix(layer2[i].color);
+        mix(background[i]);
+    }
+    return h;
+}
+
 u64 Chunk::get_chunk_size() {
 
     // size_t biomes_vectorSize = sizeof(biomes_id);
@@ -351,6 +449,8 @@ u64 Chunk::get_chunk_size() {
     total += sizeof(u32) * CHUNK_W * CHUNK_H;
     total += biomes_totalSize + polys_totalSize;
 
+    for (const FrozenBody &b : frozenBodies) total += sizeof(FrozenBody) + b.shapes.size() * sizeof(b2PolygonShape) + b.tiles.size() * sizeof(MaterialInstanceData);
+
     total += sizeof(Chunk);
 
     return total;
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "engine/core/const.h"
 #include "engine/core/core.hpp"
@@ -39,6 +40,20 @@ struct meta::static_refl::TypeInfo<MaterialInstanceData> : TypeInfoBase<Material
     };
 };
 
+// 冻结在区块中的刚体 不占用 box2d 与 world::rigidBodies
+// 位置相对区块左上角 与 loadZone 平移无关 随区块文件一同写入磁盘
+struct FrozenBody {
+    f32 x = 0, y = 0;    // 刚体原点
+    f32 cx = 0, cy = 0;  // 质心 用于判断何时解冻
+    f32 angle = 0;
+    f32 vx = 0, vy = 0, av = 0;
+    f32 density = 1, friction = 0.3f;
+    int w = 0, h = 0;
+    bool needsUpdate = false;  // 冻结时 hitbox 尚未按 tiles 更新
+    std::vector<b2PolygonShape> shapes;
+    std::vector<MaterialInstanceData> tiles;
+};
+
 // Chunk data structure
 struct Chunk {
     std::string pack_filename;
@@ -52,6 +67,12 @@ struct Chunk {
     bool pleaseDelete = false;
 
     bool hasTileCache = false;
+
+    // 区块由生成器产生后从未被修改 不写入磁盘 再次访问时按种子重新生成
+    // pristineHash 为生成时的内容哈希 卸载时用于判断区块是否被修改过
+    bool pristine = false;
+    u64 pristineHash = 0;
+
     MaterialInstance *tiles = nullptr;
     MaterialInstance *layer2 = nullptr;
 
@@ -63,6 +84,13 @@ struct Chunk {
     std::vector<b2PolygonShape> polys{};
     RigidBody *rb = nullptr;
 
+    // 碰撞网格缓存 实心掩码哈希不变时复用 rb 不重新生成
+    bool meshCached = false;
+    u64 meshHash = 0;
+
+    // 离开 tickZone 后被冻结的刚体 回到 tickZone 时由 world 解冻
+    std::vector<FrozenBody> frozenBodies{};
+
     // Initialize a chunk
     void ChunkInit(int x, int y, const std::string &worldName);
     // Uninitialize a chunk
@@ -74,6 +102,8 @@ struct Chunk {
     void ChunkRead();
     void ChunkWrite(MaterialInstance *tiles, MaterialInstance *layer2, u32 *background);
     bool ChunkHasFile();
+    // 计算 tiles/layer2/background 的内容哈希
+    u64 ChunkContentHash() const;
 
     // 粗略计算区块占用内存字节
     u64 get_chunk_size();
@@ -106,6 +136,7 @@ struct ME::meta::static_refl::TypeInfo<ME::Chunk> : TypeInfoBase<Chunk> {
             Field{TSTR("generationPhase"), &Chunk::generationPhase},
             Field{TSTR("pleaseDelete"), &Type::pleaseDelete},
             Field{TSTR("hasTileCache"), &Chunk::hasTileCache},
+            Field{TSTR("pristine"), &Chunk::pristine},
             Field{TSTR("tiles"), &Chunk::tiles},
             Field{TSTR("layer2"), &Chunk::layer2},
             Field{TSTR("background"), &Type::background},
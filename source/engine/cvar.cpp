@@ -41,6 +41,7 @@ void InitGlobalDEF(GlobalDEF* s, bool open_debugui) {
             .member_("lightingDithering", &GlobalDEF::lightingDithering, {.metadata{{"info", "是否启用光照抖动"s}}})
             .member_("tick_world", &GlobalDEF::tick_world, {.metadata{{"info", "是否启用世界更新"s}}})
             .member_("tick_box2d", &GlobalDEF::tick_box2d, {.metadata{{"info", "是否启用刚体物理更新"s}}})
+            .member_("chunk_mesh_rects", &GlobalDEF::chunk_mesh_rects, {.metadata{{"info", "地形碰撞网格使用矩形合并代替三角化"s}}})
             .member_("tick_temperature", &GlobalDEF::tick_temperature, {.metadata{{"info", "是否启用世界温度更新"s}}})
             .member_("hd_objects", &GlobalDEF::hd_objects, {.metadata{{"info", ""s}}})
             .member_("hd_objects_size", &GlobalDEF::hd_objects_size, {.metadata{{"info", ""s}}})
@@ -51,6 +52,11 @@ void InitGlobalDEF(GlobalDEF* s, bool open_debugui) {
             .member_("draw_pack_editor", &GlobalDEF::draw_pack_editor, {.metadata{{"info", "是否显示包编辑器"s}}})
             .member_("draw_code_editor", &GlobalDEF::draw_code_editor, {.metadata{{"info", "是否显示脚本编辑器"s}}})
             .member_("cell_iter", &GlobalDEF::cell_iter, {.metadata{{"info", "Cell迭代次数"s}}})
+            .member_("tick_budget_ms", &GlobalDEF::tick_budget_ms, {.metadata{{"info", "世界模拟每帧时间预算(毫秒) 0为不限制"s}}})
+            .member_("tick_budget_near", &GlobalDEF::tick_budget_near, {.metadata{{"info", "相机与玩家周围每帧必定更新的区块半径"s}}})
+            .member_("sim_lod", &GlobalDEF::sim_lod, {.metadata{{"info", "远离相机与玩家的区块降低模拟频率"s}}})
+            .member_("sim_lod_near", &GlobalDEF::sim_lod_near, {.metadata{{"info", "细节层次近环半径(区块)"s}}})
+            .member_("sim_lod_mid", &GlobalDEF::sim_lod_mid, {.metadata{{"info", "细节层次中环半径(区块)"s}}})
             .member_("brush_size", &GlobalDEF::brush_size, {.metadata{{"info", "编辑器笔刷大小"s}}})
             .member_("debug_entities_test", &GlobalDEF::debug_entities_test, {.metadata{{"info", "是否启用实体调试"s}}});
 
@@ -86,6 +92,7 @@ void InitGlobalDEF(GlobalDEF* s, bool open_debugui) {
         s->lightingDithering = GlobalDEF["lightingDithering"].get<decltype(s->lightingDithering)>();
         s->tick_world = GlobalDEF["tick_world"].get<decltype(s->tick_world)>();
         s->tick_box2d = GlobalDEF["tick_box2d"].get<decltype(s->tick_box2d)>();
+        s->chunk_mesh_rects = GlobalDEF["chunk_mesh_rects"].get<decltype(s->chunk_mesh_rects)>();
         s->tick_temperature = GlobalDEF["tick_temperature"].get<decltype(s->tick_temperature)>();
         s->hd_objects = GlobalDEF["hd_objects"].get<decltype(s->hd_objects)>();
         s->hd_objects_size = GlobalDEF["hd_objects_size"].get<decltype(s->hd_objects_size)>();
@@ -96,6 +103,11 @@ void InitGlobalDEF(GlobalDEF* s, bool open_debugui) {
         s->draw_pack_editor = GlobalDEF["draw_pack_editor"].get<decltype(s->draw_pack_editor)>();
 
         s->cell_iter = GlobalDEF["cell_iter"].get<int>();
+        s->tick_budget_ms = GlobalDEF["tick_budget_ms"].get<decltype(s->tick_budget_ms)>();
+        s->tick_budget_near = GlobalDEF["tick_budget_near"].get<decltype(s->tick_budget_near)>();
+        s->sim_lod = GlobalDEF["sim_lod"].get<decltype(s->sim_lod)>();
+        s->sim_lod_near = GlobalDEF["sim_lod_near"].get<decltype(s->sim_lod_near)>();
+        s->sim_lod_mid = GlobalDEF["sim_lod_mid"].get<decltype(s->sim_lod_mid)>();
         s->brush_size = GlobalDEF["brush_size"].get<int>();
 
     } else {
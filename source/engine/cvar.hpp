@@ -68,6 +68,7 @@ struct GlobalDEF {
 
     bool tick_world;
     bool tick_box2d;
+    bool chunk_mesh_rects;
     bool tick_temperature;
     bool hd_objects;
 
@@ -81,6 +82,11 @@ struct GlobalDEF {
     bool draw_code_editor;
 
     int cell_iter;
+    float tick_budget_ms;
+    int tick_budget_near;
+    bool sim_lod;
+    int sim_lod_near;
+    int sim_lod_mid;
     int brush_size;
 
     bool debug_entities_test;
@@ -6,6 +6,7 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <cstring>
 #include <cstdlib>
 #include <functional>
 #include <iterator>
@@ -49,6 +50,7 @@
 #include "reflectionflat.hpp"
 #include "textures.hpp"
 #include "world_generator.h"
+#include "world_pregen.hpp"
 
 int ME_main(int argc, char *argv[]) {
     auto params = ME::engine::parameters("test", "nodebug").get();
@@ -107,6 +109,9 @@ int game::init(int argc, char *argv[]) {
     if (ret == METADOT_FAILED) return METADOT_FAILED;
     if (ret == RUNNER_EXIT) return METADOT_OK;
 
+    // 无窗口世界预生成 不进入游戏循环
+    if (argc > 1 && !strcmp(argv[1], "pregen")) return pregen::run(argc, argv);
+
     METADOT_INFO("Starting game...");
 
     // Initialization of ECSSystem and Engine
@@ -206,6 +211,7 @@ int game::init(int argc, char *argv[]) {
 
     ME_profiler_graph_init(&this->fps, GRAPH_RENDER_FPS, "Frame Time");
     ME_profiler_graph_init(&this->cpuGraph, GRAPH_RENDER_MS, "CPU Time");
+    ME_profiler_graph_init(&this->tickBudgetGraph, GRAPH_RENDER_PERCENT, "Tick Budget");
 
     surface = ME_surface_CreateGL3(ME_SURFACE_ANTIALIAS | ME_SURFACE_STENCIL_STROKES | ME_SURFACE_DEBUG);
 
@@ -626,11 +632,11 @@ int game::run(int argc, char *argv[]) {
                     lastEraseMY = y;
 
                     // erase from rigidbodies
-                    // this copies the vector
-                    std::vector<RigidBody *> *rbs = &Iso.world->rigidBodies;
+                    std::vector<RigidBody *> rbs;
+                    Iso.world->queryRigidBodies(x - 3, y - 3, x + 3, y + 3, rbs);
 
-                    for (size_t i = 0; i < rbs->size(); i++) {
-                        RigidBody *cur = (*rbs)[i];
+                    for (size_t i = 0; i < rbs.size(); i++) {
+                        RigidBody *cur = rbs[i];
                         if (!static_cast<bool>(cur->get_surface())) continue;
                         if (cur->body->IsEnabled()) {
                             f32 s = sin(-cur->body->GetAngle());
@@ -648,9 +654,8 @@ int game::run(int argc, char *argv[]) {
                                     int nty = (int)(tx * s + ty * c);
 
                                     if (ntx >= 0 && nty >= 0 && ntx < cur->get_surface()->w && nty < cur->get_surface()->h) {
-                                        u32 pixel = ME_get_pixel(cur->get_surface(), ntx, nty);
-                                        if (((pixel >> 24) & 0xff) != 0x00) {
-                                            ME_get_pixel(cur->get_surface(), ntx, nty) = 0x00000000;
+                                        if (cur->solidAt(ntx, nty)) {
+                                            cur->setTile(ntx, nty, Tiles_NOTHING);
                                             upd = true;
                                         }
                                     }
@@ -659,11 +664,9 @@ int game::run(int argc, char *argv[]) {
 
                             if (upd) {
 
-                                // 更新rigidbody的image
-                                cur->updateImage({});
-                                // R_FreeImage(cur->get_texture());
-                                // cur->set_texture(R_CopyImageFromSurface(cur->get_surface()));
-                                // R_SetImageFilter(cur->get_texture(), R_FILTER_NEAREST);
+                                // 只写回被挖的行 image 在渲染时更新
+                                cur->syncSurface();
+                                cur->texNeedsUpdate = true;
                                 //  GameIsolate_.world->updateRigidBodyHitbox(cur);
                                 cur->needsUpdate = true;
                             }
@@ -721,41 +724,9 @@ int game::run(int argc, char *argv[]) {
                                 int x = (int)((mx - GAME()->ofsX - GAME()->camX) / the<engine>().eng()->render_scale);
                                 int y = (int)((my - GAME()->ofsY - GAME()->camY) / the<engine>().eng()->render_scale);
 
-                                std::vector<RigidBody *> rbs = Iso.world->rigidBodies;  // copy
-                                for (size_t i = 0; i < rbs.size(); i++) {
-                                    RigidBody *cur = rbs[i];
-
-                                    bool connect = false;
-                                    if (cur->body->IsEnabled()) {
-                                        f32 s = sin(-cur->body->GetAngle());
-                                        f32 c = cos(-cur->body->GetAngle());
-                                        bool upd = false;
-                                        for (f32 xx = -3; xx <= 3; xx += 0.5) {
-                                            for (f32 yy = -3; yy <= 3; yy += 0.5) {
-                                                if (abs(xx) + abs(yy) == 6) continue;
-                                                // rotate point
-
-                                                f32 tx = x + xx - cur->body->GetPosition().x;
-                                                f32 ty = y + yy - cur->body->GetPosition().y;
-
-                                                int ntx = (int)(tx * c - ty * s);
-                                                int nty = (int)(tx * s + ty * c);
-
-                                                if (ntx >= 0 && nty >= 0 && ntx < cur->get_surface()->w && nty < cur->get_surface()->h) {
-                                                    u32 pixel = ME_get_pixel(cur->get_surface(), ntx, nty);
-                                                    if (((pixel >> 24) & 0xff) != 0x00) {
-                                                        connect = true;
-                                                    }
-                                                }
-                                            }
-                                        }
-                                    }
-
-                                    if (connect) {
-                                        // 凿子界面
-                                        the<gui>().chisel_ui(cur);
-                                        break;
-                                    }
+                                if (RigidBody *cur = Iso.world->rigidBodyAt(x, y)) {
+                                    // 凿子界面
+                                    the<gui>().chisel_ui(cur);
                                 }
 
                             } else if (pl->heldItem->getFlag(ItemFlags::ItemFlags_Tool)) {
@@ -898,13 +869,8 @@ int game::run(int argc, char *argv[]) {
                                     int hx = (pl->hammerX + (endInd % Iso.world->width)) / 2;
                                     int hy = (pl->hammerY + (endInd / Iso.world->width)) / 2;
 
-                                    if (Iso.world->getTile((int)(hx + udy * 2), (int)(hy - udx * 2)).mat->physicsType == PhysicsType::SOLID) {
-                                        Iso.world->physicsCheck((int)(hx + udy * 2), (int)(hy - udx * 2));
-                                    }
-
-                                    if (Iso.world->getTile((int)(hx - udy * 2), (int)(hy + udx * 2)).mat->physicsType == PhysicsType::SOLID) {
-                                        Iso.world->physicsCheck((int)(hx - udy * 2), (int)(hy + udx * 2));
-                                    }
+                                    // 凿开处两侧各取一个种子 一次标记完成
+                                    Iso.world->physicsCheckBatch({{(int)(hx + udy * 2), (int)(hy - udx * 2)}, {(int)(hx - udy * 2), (int)(hy + udx * 2)}});
 
                                     if (nTilesChanged > 0) {
                                         global.audio.PlayEvent("event:/Player/Impact");
@@ -928,48 +894,16 @@ int game::run(int argc, char *argv[]) {
                     int y = (int)((my - GAME()->ofsY - GAME()->camY) / the<engine>().eng()->render_scale);
 
                     bool swapped = false;
-                    std::vector<RigidBody *> *rbs = &Iso.world->rigidBodies;
-                    for (size_t i = 0; i < rbs->size(); i++) {
-                        RigidBody *cur = (*rbs)[i];
-
-                        bool connect = false;
-                        if (!static_cast<bool>(cur->get_surface())) continue;  // skip if it does not have surface
-                        if (cur->body->IsEnabled()) {
-                            f32 s = sin(-cur->body->GetAngle());
-                            f32 c = cos(-cur->body->GetAngle());
-                            bool upd = false;
-                            for (f32 xx = -3; xx <= 3; xx += 0.5) {
-                                for (f32 yy = -3; yy <= 3; yy += 0.5) {
-                                    if (abs(xx) + abs(yy) == 6) continue;
-                                    // rotate point
-
-                                    f32 tx = x + xx - cur->body->GetPosition().x;
-                                    f32 ty = y + yy - cur->body->GetPosition().y;
-
-                                    int ntx = (int)(tx * c - ty * s);
-                                    int nty = (int)(tx * s + ty * c);
-
-                                    if (ntx >= 0 && nty >= 0 && ntx < cur->get_surface()->w && nty < cur->get_surface()->h) {
-                                        if (((ME_get_pixel(cur->get_surface(), ntx, nty) >> 24) & 0xff) != 0x00) {
-                                            connect = true;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-
-                        if (connect) {
-                            if (Iso.world->player) {
+                    if (RigidBody *cur = Iso.world->rigidBodyAt(x, y)) {
+                        if (Iso.world->player) {
 
-                                auto [pl_we, pl] = Iso.world->getHostPlayer();
+                            auto [pl_we, pl] = Iso.world->getHostPlayer();
 
-                                pl->setItemInHand(Iso.world->Reg().find_component<WorldEntity>(Iso.world->player), Item::makeItem(ItemFlags::ItemFlags_Rigidbody, cur), Iso.world.get());
+                            pl->setItemInHand(Iso.world->Reg().find_component<WorldEntity>(Iso.world->player), Item::makeItem(ItemFlags::ItemFlags_Rigidbody, cur), Iso.world.get());
 
-                                Iso.world->rigidBodies.erase(std::remove(Iso.world->rigidBodies.begin(), Iso.world->rigidBodies.end(), cur), Iso.world->rigidBodies.end());
+                            Iso.world->rigidBodies.erase(cur);
 
-                                swapped = true;
-                            }
-                            break;
+                            swapped = true;
                         }
                     }
 
@@ -1075,6 +1009,8 @@ int game::run(int argc, char *argv[]) {
         if (Iso.globaldef.draw_frame_graph) {
             ME_profiler_graph_render(this->surface, the<engine>().eng()->windowWidth - 210, the<engine>().eng()->windowHeight - 45, &this->fps);
             ME_profiler_graph_render(this->surface, the<engine>().eng()->windowWidth - 210 - 200 - 5, the<engine>().eng()->windowHeight - 45, &this->cpuGraph);
+            if (Iso.globaldef.tick_budget_ms > 0)
+                ME_profiler_graph_render(this->surface, the<engine>().eng()->windowWidth - 210 - (200 + 5) * 2, the<engine>().eng()->windowHeight - 45, &this->tickBudgetGraph);
         }
 
         ME_surface_EndFrame(surface);
@@ -1095,10 +1031,11 @@ int game::run(int argc, char *argv[]) {
                 // Drawing::drawText(target, tile.mat->name.c_str(), font16, mx + 14, my, 0xff, 0xff, 0xff, ALIGN_LEFT);
 
                 if (tile.mat->id == GAME()->materials_list.GENERIC_AIR.id) {
-                    std::vector<RigidBody *> *rbs = &Iso.world->rigidBodies;
+                    std::vector<RigidBody *> &rbs = Iso.world->rigidBodyQueryHits;
+                    Iso.world->queryRigidBodies(msx, msy, msx + 1, msy + 1, rbs);
 
-                    for (size_t i = 0; i < rbs->size(); i++) {
-                        RigidBody *cur = (*rbs)[i];
+                    for (size_t i = 0; i < rbs.size(); i++) {
+                        RigidBody *cur = rbs[i];
                         if (cur->body->IsEnabled() && static_cast<bool>(cur->get_surface())) {
                             f32 s = sin(-cur->body->GetAngle());
                             f32 c = cos(-cur->body->GetAngle());
@@ -1505,8 +1442,8 @@ void game::updateFrameEarly() {
 
                     MaterialInstance mat = pl->heldItem->carry[pl->heldItem->carry.size() - 1];
                     pl->heldItem->carry.pop_back();
-                    Iso.world->addCell(new CellData(mat, (f32)x, (f32)y, (f32)(pl_we->vx / 2 + (rand() % 10 - 5) / 10.0f + 1.5f * (f32)cos((pl->holdAngle + 180) * 3.1415f / 180.0f)),
-                                                    (f32)(pl_we->vy / 2 + -(rand() % 5 + 5) / 10.0f + 1.5f * (f32)sin((pl->holdAngle + 180) * 3.1415f / 180.0f)), 0, (f32)0.1));
+                    Iso.world->addCell(CellData(mat, (f32)x, (f32)y, (f32)(pl_we->vx / 2 + (rand() % 10 - 5) / 10.0f + 1.5f * (f32)cos((pl->holdAngle + 180) * 3.1415f / 180.0f)),
+                                                (f32)(pl_we->vy / 2 + -(rand() % 5 + 5) / 10.0f + 1.5f * (f32)sin((pl->holdAngle + 180) * 3.1415f / 180.0f)), 0, (f32)0.1));
 
                     int i = (int)pl->heldItem->carry.size();
                     i = (int)((i / (f32)pl->heldItem->capacity) * pl->heldItem->fill.size());
@@ -1571,55 +1508,15 @@ void game::updateFrameEarly() {
         int x = (int)((mx - GAME()->ofsX - GAME()->camX) / the<engine>().eng()->render_scale);
         int y = (int)((my - GAME()->ofsY - GAME()->camY) / the<engine>().eng()->render_scale);
 
-        bool swapped = false;
         f32 hoverDelta = 10.0 * the<engine>().eng()->time.deltaTime / 1000.0;
 
-        // this copies the vector
-        std::vector<RigidBody *> rbs = Iso.world->rigidBodies;
-        for (size_t i = 0; i < rbs.size(); i++) {
-            RigidBody *cur = rbs[i];
-
+        // 只有鼠标附近的刚体需要采样 其余刚体的悬停值衰减
+        RigidBody *hovered = Iso.world->rigidBodyAt(x, y);
+        for (RigidBody *cur : Iso.world->rigidBodies) {
             ME_ASSERT(cur);
-
-            if (swapped) {
-                cur->hover = (f32)std::fmax(0, cur->hover - hoverDelta);
-                continue;
-            }
-
-            bool connect = false;
-            if (cur->body->IsEnabled()) {
-                f32 s = sin(-cur->body->GetAngle());
-                f32 c = cos(-cur->body->GetAngle());
-                bool upd = false;
-                for (f32 xx = -3; xx <= 3; xx += 0.5) {
-                    for (f32 yy = -3; yy <= 3; yy += 0.5) {
-                        if (abs(xx) + abs(yy) == 6) continue;
-                        // rotate point
-
-                        f32 tx = x + xx - cur->body->GetPosition().x;
-                        f32 ty = y + yy - cur->body->GetPosition().y;
-
-                        int ntx = (int)(tx * c - ty * s);
-                        int nty = (int)(tx * s + ty * c);
-
-                        if (cur->get_surface() != nullptr) {
-                            if (ntx >= 0 && nty >= 0 && ntx < cur->get_surface()->w && nty < cur->get_surface()->h) {
-                                if (((ME_get_pixel(cur->get_surface(), ntx, nty) >> 24) & 0xff) != 0x00) {
-                                    connect = true;
-                                }
-                            }
-                        } else {
-                            // METADOT_ERROR("cur->get_surface() = nullptr");
-                            continue;
-                        }
-                    }
-                }
-            }
-
-            if (connect) {
-                swapped = true;
+            if (cur == hovered) {
                 cur->hover = (f32)std::fmin(1, cur->hover + hoverDelta);
-            } else {
+            } else if (cur->hover > 0) {
                 cur->hover = (f32)std::fmax(0, cur->hover - hoverDelta);
             }
         }
@@ -1788,8 +1685,8 @@ void game::tick() {
                             // objectDelete[wxd + wyd * Iso.world->width] = true;
                             break;
                         } else if (Iso.world->real_tiles[wxd + wyd * Iso.world->width].mat->physicsType == PhysicsType::SAND) {
-                            Iso.world->addCell(new CellData(Iso.world->real_tiles[wxd + wyd * Iso.world->width], (f32)wxd, (f32)(wyd - 3), (f32)((rand() % 10 - 5) / 10.0f),
-                                                            (f32)(-(rand() % 5 + 5) / 10.0f), 0, (f32)0.1));
+                            Iso.world->addCell(CellData(Iso.world->real_tiles[wxd + wyd * Iso.world->width], (f32)wxd, (f32)(wyd - 3), (f32)((rand() % 10 - 5) / 10.0f),
+                                                        (f32)(-(rand() % 5 + 5) / 10.0f), 0, (f32)0.1));
                             Iso.world->real_tiles[wxd + wyd * Iso.world->width] = rmat;
                             // objectDelete[wxd + wyd * Iso.world->width] = true;
                             Iso.world->dirty[wxd + wyd * Iso.world->width] = true;
@@ -1798,8 +1695,8 @@ void game::tick() {
                             cur->body->SetAngularVelocity(cur->body->GetAngularVelocity() * (f32)0.98);
                             break;
                         } else if (Iso.world->real_tiles[wxd + wyd * Iso.world->width].mat->physicsType == PhysicsType::SOUP) {
-                            Iso.world->addCell(new CellData(Iso.world->real_tiles[wxd + wyd * Iso.world->width], (f32)wxd, (f32)(wyd - 3), (f32)((rand() % 10 - 5) / 10.0f),
-                                                            (f32)(-(rand() % 5 + 5) / 10.0f), 0, (f32)0.1));
+                            Iso.world->addCell(CellData(Iso.world->real_tiles[wxd + wyd * Iso.world->width], (f32)wxd, (f32)(wyd - 3), (f32)((rand() % 10 - 5) / 10.0f),
+                                                        (f32)(-(rand() % 5 + 5) / 10.0f), 0, (f32)0.1));
                             Iso.world->real_tiles[wxd + wyd * Iso.world->width] = rmat;
                             // objectDelete[wxd + wyd * Iso.world->width] = true;
                             Iso.world->dirty[wxd + wyd * Iso.world->width] = true;
@@ -1835,7 +1732,27 @@ void game::tick() {
         entity_update_event e{.g = this};
         Iso.world->Reg().process_event(e);
 
+        // 本帧排队的爆炸统一处理
+        Iso.world->tickExplosions();
+
         if ((Iso.globaldef.tick_world && Iso.world->readyToMerge.size() == 0) || input::DEBUG_TICK->get()) {
+            ME_profiler_scope_auto("WorldTick");
+
+            // 预算不足时优先更新相机与玩家附近的区块 细节层次同样以它们为中心
+            TickBudget &budget = Iso.world->tickBudget;
+            budget.budgetMs = Iso.globaldef.tick_budget_ms;
+            budget.nearRadius = Iso.globaldef.tick_budget_near;
+            Iso.world->tickLod.enabled = Iso.globaldef.sim_lod;
+            Iso.world->tickLod.nearRadius = Iso.globaldef.sim_lod_near;
+            Iso.world->tickLod.midRadius = Iso.globaldef.sim_lod_mid;
+            budget.focus.clear();
+            budget.focus.emplace_back((int)((the<engine>().eng()->windowWidth / 2.0f - GAME()->ofsX - GAME()->camX) / the<engine>().eng()->render_scale),
+                                      (int)((the<engine>().eng()->windowHeight / 2.0f - GAME()->ofsY - GAME()->camY) / the<engine>().eng()->render_scale));
+            if (Iso.world->player) {
+                auto [pl_we, pl] = Iso.world->getHostPlayer();
+                if (pl_we != nullptr) budget.focus.emplace_back((int)pl_we->x + pl_we->hw / 2 + Iso.world->loadZone.x, (int)pl_we->y + pl_we->hh / 2 + Iso.world->loadZone.y);
+            }
+
             Iso.world->tick();
         }
 
@@ -1885,7 +1802,8 @@ void game::tick() {
             Iso.world->tickCells();
         }));
 
-        if (Iso.world->readyToMerge.size() == 0) {
+        bool tickBounds = Iso.world->readyToMerge.size() == 0;
+        if (tickBounds) {
             results.push_back(Iso.updateDirtyPool->push([&](int id) { Iso.world->tickObjectBounds(); }));
         }
 
@@ -1893,6 +1811,9 @@ void game::tick() {
             results[i].get();
         }
 
+        // 启用状态的变化与冻结/解冻会修改 box2d 宽相位 只在主线程进行
+        if (tickBounds) Iso.world->applyObjectBounds();
+
         for (size_t i = 0; i < Iso.world->rigidBodies.size(); i++) {
             RigidBody *cur = Iso.world->rigidBodies[i];
             if (cur == nullptr) continue;
@@ -1922,7 +1843,7 @@ void game::tick() {
 
                         if (wxd < 0 || wyd < 0 || wxd >= Iso.world->width || wyd >= Iso.world->height) continue;
                         if (Iso.world->real_tiles[wxd + wyd * Iso.world->width].id == rmat.id) {
-                            cur->tiles[tx + ty * cur->matWidth] = Iso.world->real_tiles[wxd + wyd * Iso.world->width];
+                            cur->setTile(tx, ty, Iso.world->real_tiles[wxd + wyd * Iso.world->width]);
                             Iso.world->real_tiles[wxd + wyd * Iso.world->width] = Tiles_NOTHING;
                             Iso.world->dirty[wxd + wyd * Iso.world->width] = true;
                             found = true;
@@ -1957,7 +1878,7 @@ void game::tick() {
 
                     if (!found && !Iso.world->real_tiles.empty()) {
                         try {
-                            if (Iso.world->real_tiles.at(wx + wy * Iso.world->width).mat->id == GAME()->materials_list.GENERIC_AIR.id) cur->tiles[tx + ty * cur->matWidth] = Tiles_NOTHING;
+                            if (Iso.world->real_tiles.at(wx + wy * Iso.world->width).mat->id == GAME()->materials_list.GENERIC_AIR.id) cur->setTile(tx, ty, Tiles_NOTHING);
                         } catch (const std::out_of_range &ex) {
                             METADOT_ERROR(std::format("[Exception] world->tiles[{0}] {1}", wx + wy * Iso.world->width, ex.what()).c_str());
                         }
@@ -1965,21 +1886,9 @@ void game::tick() {
                 }
             }
 
-            for (int tx = 0; tx < cur->get_surface()->w; tx++) {
-                for (int ty = 0; ty < cur->get_surface()->h; ty++) {
-                    MaterialInstance mat = cur->tiles[tx + ty * cur->get_surface()->w];
-                    if (mat.mat->id == GAME()->materials_list.GENERIC_AIR.id) {
-                        ME_get_pixel(cur->get_surface(), tx, ty) = 0x00000000;
-                    } else {
-                        ME_get_pixel(cur->get_surface(), tx, ty) = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
-                    }
-                }
-            }
-
-            // 更新rigidbody的image
-            cur->updateImage({});
-
-            cur->needsUpdate = true;
+            // 只写回有变化的行 实心位图变化时才重建 hitbox
+            if (cur->syncSurface() > 0) cur->texNeedsUpdate = true;
+            if (cur->maskChanged) cur->needsUpdate = true;
         }
 
         if (Iso.world->readyToMerge.size() == 0) {
@@ -1998,6 +1907,8 @@ void game::tick() {
                 if (Iso.world->dirty[i]) {
                     hadDirty = true;
                     movingTiles[Iso.world->real_tiles[i].mat->id]++;
+                    Iso.world->setTileBits(i % Iso.world->width, i / Iso.world->width, Iso.world->real_tiles[i].mat);
+                    Iso.world->noteTile(i);
                     if (Iso.world->real_tiles[i].mat->physicsType == PhysicsType::AIR) {
                         dpixels_ar[offset + 0] = 0;                     // b
                         dpixels_ar[offset + 1] = 0;                     // g
@@ -2196,7 +2107,10 @@ NULL,
 GameIsolate_.world->width * 4
 );*/
 
-        if (Iso.globaldef.tick_box2d && the<engine>().eng()->time.tickCount % GameTick == 0) Iso.world->updateWorldMesh();
+        if (Iso.globaldef.tick_box2d && the<engine>().eng()->time.tickCount % GameTick == 0) {
+            Iso.world->setMeshRects(Iso.globaldef.chunk_mesh_rects);
+            Iso.world->updateWorldMesh();
+        }
     }
 }
 
@@ -2404,11 +2318,10 @@ void game::tickPlayer() {
         if (input::PLAYER_UP->get() && !input::DEBUG_DRAW->get()) {
             global.audio.SetEventParameter("event:/Player/Fly", "Intensity", 1);
             for (int i = 0; i < 4; i++) {
-                CellData *p = new CellData(TilesCreateLava(), (f32)(pl_we->x + Iso.world->loadZone.x + pl_we->hw / 2 + rand() % 5 - 2 + pl_we->vx),
-                                           (f32)(pl_we->y + Iso.world->loadZone.y + pl_we->hh + pl_we->vy), (f32)((rand() % 10 - 5) / 10.0f + pl_we->vx / 2.0f),
-                                           (f32)((rand() % 10) / 10.0f + 1 + pl_we->vy / 2.0f), 0, (f32)0.025);
-                p->temporary = true;
-                p->lifetime = 120;
+                CellData p(TilesCreateLava(), (f32)(pl_we->x + Iso.world->loadZone.x + pl_we->hw / 2 + rand() % 5 - 2 + pl_we->vx), (f32)(pl_we->y + Iso.world->loadZone.y + pl_we->hh + pl_we->vy),
+                           (f32)((rand() % 10 - 5) / 10.0f + pl_we->vx / 2.0f), (f32)((rand() % 10) / 10.0f + 1 + pl_we->vy / 2.0f), 0, (f32)0.025);
+                p.temporary = true;
+                p.lifetime = 120;
                 Iso.world->addCell(p);
             }
         } else {
@@ -2489,38 +2402,25 @@ void game::tickPlayer() {
                         int y = sind == -1 ? wmy : sind / Iso.world->width;
 
                         std::function<void(MaterialInstance, int, int)> makeCell = [&](MaterialInstance tile, int xPos, int yPos) {
-                            CellData *par = new CellData(tile, xPos, yPos, 0, 0, 0, (f32)0.01f);
-                            par->vx = (rand() % 10 - 5) / 5.0f * 1.0f;
-                            par->vy = (rand() % 10 - 5) / 5.0f * 1.0f;
-                            par->ax = -par->vx / 10.0f;
-                            par->ay = -par->vy / 10.0f;
-                            if (par->ay == 0 && par->ax == 0) par->ay = 0.01f;
+                            CellData par(tile, xPos, yPos, 0, 0, 0, (f32)0.01f);
+                            par.vx = (rand() % 10 - 5) / 5.0f * 1.0f;
+                            par.vy = (rand() % 10 - 5) / 5.0f * 1.0f;
+                            par.ax = -par.vx / 10.0f;
+                            par.ay = -par.vy / 10.0f;
+                            if (par.ay == 0 && par.ax == 0) par.ay = 0.01f;
 
                             // par->targetX = pl_we->x + pl_we->hw / 2 + GameIsolate_.world->loadZone.x;
                             // par->targetY = pl_we->y + pl_we->hh / 2 + GameIsolate_.world->loadZone.y;
                             // par->targetForce = 0.35f;
 
-                            par->lifetime = 6;
-
-                            par->phase = true;
-
-                            pl->heldItem->vacuumCells.push_back(par);
-
-                            par->killCallback = [&par, this]() {
-                                Player *pl = nullptr;
-                                WorldEntity *pl_we = nullptr;
+                            par.lifetime = 6;
 
-                                if (Iso.world->player) {
-                                    std::tie(pl_we, pl) = Iso.world->getHostPlayer();
-                                }
+                            par.phase = true;
 
-                                if (pl->holdtype != EnumPlayerHoldType::HoldTypeNone) {
-                                    auto &v = pl->heldItem->vacuumCells;
-                                    v.erase(std::remove(v.begin(), v.end(), par), v.end());
-                                }
-                            };
+                            // 死亡时通过 CellPool::deaths 从 vacuumCells 中移除
+                            par.event = CELL_EVENT_VACUUM;
 
-                            Iso.world->addCell(par);
+                            pl->heldItem->vacuumCells.push_back(Iso.world->addCell(par));
                         };
 
                         int rad = 5;
@@ -2543,59 +2443,47 @@ void game::tickPlayer() {
                             }
                         }
 
-                        auto func = [&](CellData *cur) {
-                            if (cur->targetForce == 0 && !cur->phase) {
+                        CellPool &cells = Iso.world->cells;
+                        for (u32 i = 0; i < cells.capacity(); i++) {
+                            if (!cells.alive[i]) continue;
+                            if (cells.targetForce[i] == 0 && !cells.phase[i]) {
                                 int rad = 5;
                                 for (int xx = -rad; xx <= rad; xx++) {
                                     for (int yy = -rad; yy <= rad; yy++) {
                                         if ((yy == -rad || yy == rad) && (xx == -rad || x == rad)) continue;
 
-                                        if (((int)(cur->x) == (x + xx)) && ((int)(cur->y) == (y + yy))) {
+                                        if (((int)(cells.x[i]) == (x + xx)) && ((int)(cells.y[i]) == (y + yy))) {
 
-                                            cur->vx = (rand() % 10 - 5) / 5.0f * 1.0f;
-                                            cur->vy = (rand() % 10 - 5) / 5.0f * 1.0f;
-                                            cur->ax = -cur->vx / 10.0f;
-                                            cur->ay = -cur->vy / 10.0f;
-                                            if (cur->ay == 0 && cur->ax == 0) cur->ay = 0.01f;
+                                            cells.vx[i] = (rand() % 10 - 5) / 5.0f * 1.0f;
+                                            cells.vy[i] = (rand() % 10 - 5) / 5.0f * 1.0f;
+                                            cells.ax[i] = -cells.vx[i] / 10.0f;
+                                            cells.ay[i] = -cells.vy[i] / 10.0f;
+                                            if (cells.ay[i] == 0 && cells.ax[i] == 0) cells.ay[i] = 0.01f;
 
                                             // par->targetX = pl_we->x + pl_we->hw / 2 + GameIsolate_.world->loadZone.x;
                                             // par->targetY = pl_we->y + pl_we->hh / 2 + GameIsolate_.world->loadZone.y;
                                             // par->targetForce = 0.35f;
 
-                                            cur->lifetime = 6;
-
-                                            cur->phase = true;
-
-                                            pl->heldItem->vacuumCells.push_back(cur);
+                                            cells.lifetime[i] = 6;
 
-                                            cur->killCallback = [&cur, this]() {
-                                                Player *pl = nullptr;
-                                                WorldEntity *pl_we = nullptr;
+                                            cells.phase[i] = true;
+                                            cells.event[i] = CELL_EVENT_VACUUM;
 
-                                                if (Iso.world->player) std::tie(pl_we, pl) = Iso.world->getHostPlayer();
+                                            pl->heldItem->vacuumCells.push_back(cells.handle(i));
 
-                                                if (NULL == pl) return;
-                                                if (pl->holdtype != EnumPlayerHoldType::HoldTypeNone) {
-                                                    auto &v = pl->heldItem->vacuumCells;
-                                                    std::erase_if(v, [&](CellData *c) { return c == cur; });
-                                                }
-                                            };
-
-                                            return false;
+                                            xx = rad + 1;
+                                            break;
                                         }
                                     }
                                 }
                             }
+                        }
 
-                            return false;
-                        };
-
-                        std::erase_if(Iso.world->cells, func);
-
-                        std::vector<RigidBody *> *rbs = &Iso.world->rigidBodies;
+                        std::vector<RigidBody *> rbs;
+                        Iso.world->queryRigidBodies(x - rad, y - rad, x + rad, y + rad, rbs);
 
-                        for (size_t i = 0; i < rbs->size(); i++) {
-                            RigidBody *cur = (*rbs)[i];
+                        for (size_t i = 0; i < rbs.size(); i++) {
+                            RigidBody *cur = rbs[i];
                             if (!static_cast<bool>(cur->get_surface())) continue;
                             if (cur->body->IsEnabled()) {
                                 f32 s = sin(-cur->body->GetAngle());
@@ -2613,9 +2501,9 @@ void game::tickPlayer() {
                                         int nty = (int)(tx * s + ty * c);
 
                                         if (ntx >= 0 && nty >= 0 && ntx < cur->get_surface()->w && nty < cur->get_surface()->h) {
-                                            u32 pixel = ME_get_pixel(cur->get_surface(), ntx, nty);
-                                            if (((pixel >> 24) & 0xff) != 0x00) {
-                                                ME_get_pixel(cur->get_surface(), ntx, nty) = 0x00000000;
+                                            if (cur->solidAt(ntx, nty)) {
+                                                u32 pixel = ME_get_pixel(cur->get_surface(), ntx, nty);
+                                                cur->setTile(ntx, nty, Tiles_NOTHING);
                                                 upd = true;
 
                                                 makeCell(MaterialInstance(&GAME()->materials_list.GENERIC_SOLID, pixel), (x + xx), (y + yy));
@@ -2626,11 +2514,9 @@ void game::tickPlayer() {
 
                                 if (upd) {
 
-                                    // 更新rigidbody的image
-                                    cur->updateImage({});
-                                    // R_FreeImage(cur->get_texture());
-                                    // cur->set_texture(R_CopyImageFromSurface(cur->get_surface()));
-                                    // R_SetImageFilter(cur->get_texture(), R_FILTER_NEAREST);
+                                    // 只写回被挖的行 image 在渲染时更新
+                                    cur->syncSurface();
+                                    cur->texNeedsUpdate = true;
                                     //  GameIsolate_.world->updateRigidBodyHitbox(cur);
                                     cur->needsUpdate = true;
                                 }
@@ -2640,29 +2526,38 @@ void game::tickPlayer() {
                 }
 
                 if (pl->heldItem->vacuumCells.size() > 0) {
-                    pl->heldItem->vacuumCells.erase(std::remove_if(pl->heldItem->vacuumCells.begin(), pl->heldItem->vacuumCells.end(),
-                                                                   [&](CellData *cur) {
-                                                                       if (cur->lifetime <= 0) {
-                                                                           cur->targetForce = 0.45f;
-                                                                           cur->targetX = pl_we->x + pl_we->hw / 2.0f + Iso.world->loadZone.x;
-                                                                           cur->targetY = pl_we->y + pl_we->hh / 2.0f + Iso.world->loadZone.y;
-                                                                           cur->ax = 0;
-                                                                           cur->ay = 0.01f;
-                                                                       }
-
-                                                                       f32 tdx = cur->targetX - cur->x;
-                                                                       f32 tdy = cur->targetY - cur->y;
-
-                                                                       if (tdx * tdx + tdy * tdy < 10 * 10) {
-                                                                           cur->temporary = true;
-                                                                           cur->lifetime = 0;
-                                                                           // METADOT_BUG("vacuum {}", cur->tile.mat->name.c_str());
-                                                                           return true;
-                                                                       }
-
-                                                                       return false;
-                                                                   }),
-                                                    pl->heldItem->vacuumCells.end());
+                    CellPool &cells = Iso.world->cells;
+                    auto &v = pl->heldItem->vacuumCells;
+
+                    // 上一次 tickCells 中死亡的被吸取粒子
+                    for (const CellDeath &d : cells.deaths) {
+                        if (d.event != CELL_EVENT_VACUUM) continue;
+                        std::erase_if(v, [&](CellHandle h) { return h.index == d.handle.index && h.gen == d.handle.gen; });
+                    }
+
+                    std::erase_if(v, [&](CellHandle h) {
+                        if (!cells.valid(h)) return true;
+                        u32 i = h.index;
+
+                        if (cells.lifetime[i] <= 0) {
+                            cells.targetForce[i] = 0.45f;
+                            cells.targetX[i] = pl_we->x + pl_we->hw / 2.0f + Iso.world->loadZone.x;
+                            cells.targetY[i] = pl_we->y + pl_we->hh / 2.0f + Iso.world->loadZone.y;
+                            cells.ax[i] = 0;
+                            cells.ay[i] = 0.01f;
+                        }
+
+                        f32 tdx = cells.targetX[i] - cells.x[i];
+                        f32 tdy = cells.targetY[i] - cells.y[i];
+
+                        if (tdx * tdx + tdy * tdy < 10 * 10) {
+                            cells.temporary[i] = true;
+                            cells.lifetime[i] = 0;
+                            return true;
+                        }
+
+                        return false;
+                    });
                 }
             }
         }
@@ -2687,6 +2582,9 @@ void game::tickProfiler() {
 
         ME_profiler_graph_update(&fps, the<engine>().eng()->time.deltaTime);
         ME_profiler_graph_update(&cpuGraph, cpuTime);
+
+        // 世界模拟用掉的预算百分比
+        if (Iso.world && Iso.globaldef.tick_budget_ms > 0) ME_profiler_graph_update(&tickBudgetGraph, Iso.world->tickBudget.usedMs / Iso.globaldef.tick_budget_ms * 100.0f);
     }
 
     // if (MemCurrentUsageBytes() >= the<engine>().eng()->max_mem) {
@@ -3275,7 +3173,7 @@ void game::renderOverlays() {
         // 物理引擎相关信息
 
         for (size_t i = 0; i < Iso.world->rigidBodies.size(); i++) {
-            RigidBody cur = *Iso.world->rigidBodies[i];
+            const RigidBody &cur = *Iso.world->rigidBodies[i];
             b2Fixture *fix = cur.body->GetFixtureList();
             while (fix) {
                 b2Shape *shape = fix->GetShape();
@@ -3307,6 +3205,7 @@ void game::renderOverlays() {
 
         int chCt = 0;
         size_t chCt_size = 0;
+        int frozenCt = 0;
 
         // TODO: 23/7/31 修复 phmap 相关
         for (auto &p : Iso.world->chunkCache) {
@@ -3316,9 +3215,14 @@ void game::renderOverlays() {
                 if (p2.first == INT_MIN) continue;
                 chCt++;
                 chCt_size += p2.second->get_chunk_size();
+                frozenCt += (int)p2.second->frozenBodies.size();
             }
         }
 
+        // 统计缓存里各块的活动格子 不用逐格扫描
+        u32 activeCt = 0;
+        for (const ChunkStats &st : Iso.world->chunkStats.blocks) activeCt += st.active;
+
         constexpr const char *buffAsStdStr1 = R"(
 {0} {1}
 XY: {2:.2f} / {3:.2f}
@@ -3331,6 +3235,9 @@ Cached Chunks: {14}
 Cached Chunks size: {15:.2f} mb
 ReadyToReadyToMerge ({16})
 ReadyToMerge ({17})
+World Mesh: {18:.3f} ms ({19} rebuilt / {20} reused)
+Body Bounds: {21:.3f} ms ({22} dormant / {23} frozen)
+Active Cells: {24} ({25} idle blocks)
 )";
 
         float pl_vx = 0.0f;
@@ -3345,7 +3252,9 @@ ReadyToMerge ({17})
 
         auto a = std::format(buffAsStdStr1, win_title_client, METADOT_VERSION_TEXT, GAME()->plPosX, GAME()->plPosY, pl_vx, pl_vy, (int)Iso.world->cells.size(), (int)Iso.world->Reg().entity_count(),
                              rbCt, (int)Iso.world->rigidBodies.size(), (int)Iso.world->worldRigidBodies.size(), rbTriACt, rbTriCt, rbTriWCt, chCt, ((f64)chCt_size / 1048576.0f),
-                             (int)Iso.world->toLoadAsyncList.size(), (int)Iso.world->readyToMerge.size());
+                             (int)Iso.world->toLoadAsyncList.size(), (int)Iso.world->readyToMerge.size(), Iso.world->meshStats.avgMs, Iso.world->meshStats.rebuilt,
+                             Iso.world->meshStats.reused, Iso.world->boundsStats.lastMs, Iso.world->boundsStats.dormant, frozenCt, activeCt,
+                             Iso.world->tickBudget.idle);
 
         ME_draw_text(a, {255, 255, 255, 255}, 10, 0, true);
 
@@ -162,7 +162,7 @@ public:
     f32 accLoadY = 0;
 
     // profiler
-    profiler_graph fps, cpuGraph;
+    profiler_graph fps, cpuGraph, tickBudgetGraph;
 
     i64 fadeInStart = 0;
     i64 fadeInLength = 0;
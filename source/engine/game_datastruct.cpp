@@ -2,6 +2,7 @@
 
 #include "game_datastruct.hpp"
 
+#include <algorithm>
 #include <string>
 #include <string_view>
 
@@ -293,6 +294,7 @@ void PushMaterials() {
         m.is_scriptable = true;
     }
     GAME()->materials_array = GAME()->materials_container.data();
+    GAME()->materials_interactions.build(GAME()->materials_container);
 
     // for (int i = 0; i < GAME()->materials_count; i++) {
     //     GAME()->mat_instance_container.push_back(TilesCreate());
@@ -301,6 +303,35 @@ void PushMaterials() {
 
 #undef REGISTER
 
+void MaterialInteractionTable::build(const std::vector<Material *> &materials) {
+    count = (u32)materials.size();
+    any.assign(((size_t)count * count + 63) / 64, 0);
+    offsets.assign((size_t)count * count + 1, 0);
+    list.clear();
+    reach = 0;
+
+    // InitMaterials 之后通过脚本注册的材料没有相互作用数组
+    // 有数组的材料是 id 连续的前 n 个 数组长度也是 n
+    u32 n = 0;
+    while (n < count && materials[n]->nInteractions != nullptr) n++;
+
+    for (u32 a = 0; a < count; a++) {
+        const Material *m = materials[a];
+        for (u32 b = 0; b < count; b++) {
+            u32 k = a * count + b;
+            offsets[k] = (u32)list.size();
+            if (!m->interact || a >= n || b >= n || m->nInteractions[b] <= 0) continue;
+            for (int i = 0; i < m->nInteractions[b]; i++) {
+                const MaterialInteraction &in = m->interactions[b][i];
+                list.push_back(in);
+                if (in.type == INTERACT_TRANSFORM_MATERIAL || in.type == INTERACT_SPAWN_MATERIAL) reach = std::max(reach, std::max(std::abs(in.ofsX), std::abs(in.ofsY)) + in.data2);
+            }
+            any[k >> 6] |= 1ull << (k & 63);
+        }
+    }
+    offsets[(size_t)count * count] = (u32)list.size();
+}
+
 MaterialInstance::MaterialInstance(Material *mat, u32 color, mat_temperature temperature) {
     this->id = mat->id;
     this->mat = mat;
@@ -317,9 +348,23 @@ MaterialInstance Tiles_TEST_LIQUID = MaterialInstance(&GAME()->materials_list.GE
 MaterialInstance Tiles_TEST_GAS = MaterialInstance(&GAME()->materials_list.GENERIC_GAS, 0x800080);
 MaterialInstance Tiles_OBJECT = MaterialInstance(&GAME()->materials_list.GENERIC_OBJECT, 0x00ff00);
 
+static thread_local u32 s_tiles_rand_state = 0x9E3779B9u;
+
+void TilesSeedRand(u32 seed) { s_tiles_rand_state = seed != 0 ? seed : 0x9E3779B9u; }
+
+u32 TilesRand() {
+    // xorshift32
+    u32 x = s_tiles_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_tiles_rand_state = x;
+    return x & 0x7fffffff;
+}
+
 MaterialInstance TilesCreateTestSand() {
     u32 rgb = 220;
-    rgb = (rgb << 8) + 155 + rand() % 30;
+    rgb = (rgb << 8) + 155 + TilesRand() % 30;
     rgb = (rgb << 8) + 100;
     return MaterialInstance(&GAME()->materials_list.ScriptableMaterials[1001], rgb);
 }
@@ -357,13 +402,13 @@ MaterialInstance TilesCreateStone(int x, int y) {
 
 MaterialInstance TilesCreateGrass() {
     u32 rgb = 40;
-    rgb = (rgb << 8) + 120 + rand() % 20;
+    rgb = (rgb << 8) + 120 + TilesRand() % 20;
     rgb = (rgb << 8) + 20;
     return MaterialInstance(&GAME()->materials_list.GRASS, rgb);
 }
 
 MaterialInstance TilesCreateDirt() {
-    u32 rgb = 60 + rand() % 10;
+    u32 rgb = 60 + TilesRand() % 10;
     rgb = (rgb << 8) + 40;
     rgb = (rgb << 8) + 20;
     return MaterialInstance(&GAME()->materials_list.DIRT, rgb);
@@ -485,7 +530,7 @@ MaterialInstance TilesCreateSteam() { return MaterialInstance(&GAME()->materials
 MaterialInstance TilesCreateFire() {
 
     u32 rgb = 255;
-    rgb = (rgb << 8) + 100 + rand() % 50;
+    rgb = (rgb << 8) + 100 + TilesRand() % 50;
     rgb = (rgb << 8) + 50;
 
     return MaterialInstance(&GAME()->materials_list.FIRE, rgb);
@@ -595,6 +640,7 @@ Structure::Structure(int w, int h, MaterialInstance *tiles) {
     this->w = w;
     this->h = h;
     this->tiles = tiles;
+    compile();
 }
 
 Structure::Structure(C_Surface *texture, Material mat) {
@@ -617,6 +663,67 @@ Structure::Structure(C_Surface *texture, Material mat) {
     this->w = texture->w;
     this->h = texture->h;
     this->tiles = tiles;
+    compile();
+}
+
+void Structure::compile() {
+    spans.clear();
+    rowSpans.assign(h + 1, 0);
+
+    bx0 = w;
+    by0 = h;
+    bx1 = 0;
+    by1 = 0;
+
+    for (int y = 0; y < h; y++) {
+        rowSpans[y] = (u32)spans.size();
+        MaterialInstance *row = &tiles[y * w];
+        int x = 0;
+        while (x < w) {
+            if (row[x].mat->physicsType == PhysicsType::AIR) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < w && row[x].mat->physicsType != PhysicsType::AIR) x++;
+            spans.push_back({(u16)start, (u16)(x - start)});
+
+            bx0 = std::min(bx0, start);
+            bx1 = std::max(bx1, x);
+            by0 = std::min(by0, y);
+            by1 = y + 1;
+        }
+    }
+    rowSpans[h] = (u32)spans.size();
+
+    // 全空气
+    if (spans.empty()) bx0 = by0 = bx1 = by1 = 0;
+}
+
+int Structure::stampRect(MaterialInstance *dst, int dstW, int ox, int oy, int x0, int y0, int x1, int y1, bool *dirty) const {
+    int n = 0;
+    for (int y = y0; y < y1; y++) {
+        int dstRow = (oy + y) * dstW + ox;
+        for (u32 i = rowSpans[y]; i < rowSpans[y + 1]; i++) {
+            const StructureSpan &sp = spans[i];
+            int s0 = std::max((int)sp.x, x0);
+            int s1 = std::min((int)sp.x + sp.len, x1);
+            if (s0 >= s1) continue;
+            std::copy(&tiles[s0 + y * w], &tiles[s1 + y * w], &dst[dstRow + s0]);
+            if (dirty != nullptr) std::fill(&dirty[dstRow + s0], &dirty[dstRow + s1], true);
+            n += s1 - s0;
+        }
+    }
+    return n;
+}
+
+int Structure::stamp(MaterialInstance *dst, int dstW, int dstH, int ox, int oy, bool *dirty) const {
+    int x0 = std::max(bx0, -ox);
+    int y0 = std::max(by0, -oy);
+    int x1 = std::min(bx1, dstW - ox);
+    int y1 = std::min(by1, dstH - oy);
+    if (x0 >= x1 || y0 >= y1) return 0;
+    return stampRect(dst, dstW, ox, oy, x0, y0, x1, y1, dirty);
 }
 
 Structure Structures::makeTree(world world, int x, int y) {
@@ -687,6 +794,35 @@ PlacedStructure::PlacedStructure(Structure base, int x, int y) {
     this->base = base;
     this->x = x;
     this->y = y;
+    if (!this->base.compiled()) this->base.compile();
+}
+
+std::vector<StructureChunkRect> PlacedStructure::splitChunks() const {
+    std::vector<StructureChunkRect> rects;
+    if (base.bx0 >= base.bx1 || base.by0 >= base.by1) return rects;
+
+    // 包围盒的世界坐标 注意负坐标需要向下取整
+    int wx0 = x + base.bx0, wy0 = y + base.by0;
+    int wx1 = x + base.bx1, wy1 = y + base.by1;
+    int cx0 = (int)std::floor(wx0 / (f32)CHUNK_W), cy0 = (int)std::floor(wy0 / (f32)CHUNK_H);
+    int cx1 = (int)std::floor((wx1 - 1) / (f32)CHUNK_W), cy1 = (int)std::floor((wy1 - 1) / (f32)CHUNK_H);
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            StructureChunkRect r;
+            r.cx = cx;
+            r.cy = cy;
+            r.x0 = std::max(wx0, cx * CHUNK_W) - x;
+            r.y0 = std::max(wy0, cy * CHUNK_H) - y;
+            r.x1 = std::min(wx1, (cx + 1) * CHUNK_W) - x;
+            r.y1 = std::min(wy1, (cy + 1) * CHUNK_H) - y;
+            // 该矩形内没有任何行段时跳过
+            bool any = false;
+            for (int ty = r.y0; ty < r.y1 && !any; ty++) any = base.rowSpans[ty] != base.rowSpans[ty + 1];
+            if (any) rects.push_back(r);
+        }
+    }
+    return rects;
 }
 
 // std::vector<PlacedStructure> Populator::apply(MaterialInstance* tiles, Chunk ch, World world){
@@ -915,7 +1051,7 @@ std::vector<PlacedStructure> CavePopulator::apply(MaterialInstance *chunk, Mater
                 if (n2 + n + ndetail < std::fmin(0.95, (py) / 1000.0)) {
                     f64 nlav = world->noise.GetPerlin(px / 4.0, py / 4.0, 7018);
                     if (nlav > 0.45) {
-                        chunk[x + y * CHUNK_W] = rand() % 3 == 0 ? (ch->y > 15 ? TilesCreateLava() : TilesCreateWater()) : Tiles_NOTHING;
+                        chunk[x + y * CHUNK_W] = TilesRand() % 3 == 0 ? (ch->y > 15 ? TilesCreateLava() : TilesCreateWater()) : Tiles_NOTHING;
                     } else {
                         chunk[x + y * CHUNK_W] = Tiles_NOTHING;
                     }
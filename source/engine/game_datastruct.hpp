@@ -33,6 +33,12 @@ struct Material;
 struct Player;
 struct game;
 
+// CellPool 中粒子的句柄 槽位被回收后 gen 不再匹配
+struct CellHandle {
+    u32 index = UINT32_MAX;
+    u32 gen = 0;
+};
+
 #define RegisterFunctions(name, func)    \
     Meta::AnyFunction any_##func{&func}; \
     GAME()->HostData.Functions.insert(std::make_pair(#name, any_##func))
@@ -230,6 +236,28 @@ struct meta::static_refl::TypeInfo<MaterialInstance> : TypeInfoBase<MaterialInst
     static constexpr FieldList fields = {};
 };
 
+// 材料相互作用的扁平查找表 由 PushMaterials 在全部材料注册后构建
+// any 中 a * count + b 位表示 a 落在 b 上时有相互作用 用于快速否定
+// 相互作用按 (a, b) 顺序连续存放 offsets[k] 到 offsets[k + 1] 是第 k 对的区间
+// reach 为所有相互作用读写到的最远格子距离 (max(|ofsX|, |ofsY|) + data2)
+struct MaterialInteractionTable {
+    u32 count = 0;
+    int reach = 0;
+    std::vector<u64> any;
+    std::vector<u32> offsets;
+    std::vector<MaterialInteraction> list;
+
+    void build(const std::vector<Material *> &materials);
+
+    bool has(mat_id a, mat_id b) const {
+        if (a >= count || b >= count) return false;
+        u32 k = a * count + b;
+        return (any[k >> 6] >> (k & 63)) & 1;
+    }
+    const MaterialInteraction *begin(mat_id a, mat_id b) const { return list.data() + offsets[a * count + b]; }
+    const MaterialInteraction *end(mat_id a, mat_id b) const { return list.data() + offsets[a * count + b + 1]; }
+};
+
 struct GameData {
     i32 ofsX = 0;
     i32 ofsY = 0;
@@ -251,6 +279,7 @@ struct GameData {
     std::vector<Material *> materials_container;
     i32 materials_count;
     Material **materials_array;
+    MaterialInteractionTable materials_interactions;
 
     std::vector<MaterialInstance> mat_instance_container;
     MaterialInstance *mat_instance_array;
@@ -290,19 +319,58 @@ MaterialInstance TilesCreateObsidian(int x, int y);
 MaterialInstance TilesCreateSteam();
 MaterialInstance TilesCreateFire();
 MaterialInstance TilesCreate(mat_id id, int x, int y);
+
+// 区块生成使用的线程局部随机数
+// 生成前按世界种子与区块坐标播种 保证同一区块重新生成的结果一致
+void TilesSeedRand(u32 seed);
+u32 TilesRand();
 // MaterialInstance TilesCreate(mat_id id, int x, int y, int test);
 
 #pragma endregion Material
 
+// 结构中一行内连续的非空气格子
+struct StructureSpan {
+    u16 x;
+    u16 len;
+};
+
+// 结构在某个区块内的覆盖矩形 (结构局部坐标 [x0, x1) x [y0, y1))
+struct StructureChunkRect {
+    int cx;
+    int cy;
+    int x0, y0;
+    int x1, y1;
+};
+
 class Structure {
 public:
     MaterialInstance *tiles;
     int w;
     int h;
 
+    // 预编译数据 第 y 行的段为 spans[rowSpans[y]] .. spans[rowSpans[y + 1]]
+    std::vector<StructureSpan> spans;
+    std::vector<u32> rowSpans;
+
+    // 非空气格子的包围盒 [bx0, bx1) x [by0, by1)
+    int bx0 = 0, by0 = 0;
+    int bx1 = 0, by1 = 0;
+
     Structure(int w, int h, MaterialInstance *tiles);
     Structure(C_Surface *texture, Material templ);
     Structure() = default;
+
+    // 扫描 tiles 生成行段与包围盒 tiles 修改后需要重新调用
+    void compile();
+    bool compiled() const { return !rowSpans.empty(); }
+
+    // 将结构局部矩形 [x0, x1) x [y0, y1) 内的非空气格子按行段拷贝到 dst
+    // (ox, oy) 为结构原点在 dst 中的坐标 矩形必须已经裁剪在 dst 范围内
+    // 若 dirty 不为空则同时标记被写入的格子 返回写入的格子数
+    int stampRect(MaterialInstance *dst, int dstW, int ox, int oy, int x0, int y0, int x1, int y1, bool *dirty = nullptr) const;
+
+    // 带裁剪的写入 dst 大小为 dstW x dstH
+    int stamp(MaterialInstance *dst, int dstW, int dstH, int ox, int oy, bool *dirty = nullptr) const;
 };
 
 class world;
@@ -320,11 +388,10 @@ public:
     int y;
 
     PlacedStructure(Structure base, int x, int y);
-    PlacedStructure(const PlacedStructure &p2) {
-        this->base = Structure(base);
-        this->x = x;
-        this->y = y;
-    }
+    PlacedStructure(const PlacedStructure &p2) = default;
+
+    // 按区块边界切分结构包围盒 结果只依赖放置位置 可以缓存复用
+    std::vector<StructureChunkRect> splitChunks() const;
 };
 
 class Biome {
@@ -351,6 +418,7 @@ struct meta::static_refl::TypeInfo<Biome> : TypeInfoBase<Biome> {
 };
 
 struct WorldGenerator {
+    virtual ~WorldGenerator() = default;
     virtual void generateChunk(world *world, Chunk *ch) = 0;
     virtual std::vector<Populator *> getPopulators() = 0;
 };
@@ -377,7 +377,7 @@ void MainMenuUI__DrawCreateWorldUI(game *game) {
 
     ImGui::Text("%s: %s", LANG("ui_worldname"), gameUI.MainMenuUI__worldFolderLabel.c_str());
 
-    const char *world_types[] = {"Material Test World", "Default World (WIP)"};
+    const char *world_types[] = {"Material Test World", "Default World (WIP)", "Scripted World (Lua)"};
 
     ImGui::ListBox(LANG("ui_worldgenerator"), &gameUI.MainMenuUI__selIndex, world_types, IM_ARRAYSIZE(world_types), 4);
 
@@ -419,6 +419,8 @@ void MainMenuUI__DrawCreateWorldUI(game *game) {
             generator = new MaterialTestGenerator();
         } else if (gameUI.MainMenuUI__selIndex == 1) {
             generator = new DefaultGenerator();
+        } else if (gameUI.MainMenuUI__selIndex == 2) {
+            generator = new ScriptingWorldGenerator();
         } else {
             generator = new MaterialTestGenerator();
         }
@@ -10,6 +10,74 @@
 
 namespace ME {
 
+CellHandle CellPool::add(const CellData &c) {
+    u32 i;
+    if (!freeList.empty()) {
+        i = freeList.back();
+        freeList.pop_back();
+    } else {
+        i = capacity();
+        x.push_back(0), y.push_back(0), vx.push_back(0), vy.push_back(0), ax.push_back(0), ay.push_back(0);
+        targetX.push_back(0), targetY.push_back(0), targetForce.push_back(0);
+        tile.emplace_back();
+        lifetime.push_back(0), fadeTime.push_back(0);
+        phase.push_back(0), temporary.push_back(0), inObjectState.push_back(0), event.push_back(0);
+        alive.push_back(0);
+        gen.push_back(0);
+    }
+
+    x[i] = c.x;
+    y[i] = c.y;
+    vx[i] = c.vx;
+    vy[i] = c.vy;
+    ax[i] = c.ax;
+    ay[i] = c.ay;
+    targetX[i] = c.targetX;
+    targetY[i] = c.targetY;
+    targetForce[i] = c.targetForce;
+    tile[i] = c.tile;
+    lifetime[i] = c.lifetime;
+    fadeTime[i] = c.fadeTime;
+    phase[i] = c.phase;
+    temporary[i] = c.temporary;
+    inObjectState[i] = c.inObjectState;
+    event[i] = c.event;
+    alive[i] = 1;
+    live++;
+
+    return {i, gen[i]};
+}
+
+void CellPool::kill(u32 i) {
+    if (!alive[i]) return;
+    if (event[i] != CELL_EVENT_NONE) deaths.push_back({event[i], {i, gen[i]}, x[i], y[i]});
+    alive[i] = 0;
+    gen[i]++;
+    freeList.push_back(i);
+    live--;
+}
+
+void CellPool::clear() {
+    for (auto *v : {&x, &y, &vx, &vy, &ax, &ay, &targetX, &targetY, &targetForce}) v->clear();
+    tile.clear();
+    lifetime.clear();
+    fadeTime.clear();
+    for (auto *v : {&phase, &temporary, &inObjectState, &event, &alive}) v->clear();
+    gen.clear();
+    freeList.clear();
+    deaths.clear();
+    live = 0;
+}
+
+void CellPool::reserve(u32 n) {
+    for (auto *v : {&x, &y, &vx, &vy, &ax, &ay, &targetX, &targetY, &targetForce}) v->reserve(n);
+    tile.reserve(n);
+    lifetime.reserve(n);
+    fadeTime.reserve(n);
+    for (auto *v : {&phase, &temporary, &inObjectState, &event, &alive}) v->reserve(n);
+    gen.reserve(n);
+}
+
 inline float Deg2Rad(float a) { return a * 0.01745329252f; }
 
 inline float Rad2Deg(float a) { return a * 57.29577951f; }
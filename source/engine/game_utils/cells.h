@@ -12,6 +12,13 @@
 
 namespace ME {
 
+// 粒子死亡事件 非 NONE 的粒子死亡时写入 CellPool::deaths 代替逐个粒子的回调
+enum CellEvent : u8 {
+    CELL_EVENT_NONE = 0,
+    CELL_EVENT_VACUUM = 1,  // 被吸取中的粒子 死亡时从 Item::vacuumCells 移除
+};
+
+// 生成粒子时的描述 按值传递 加入 CellPool 后拆成各字段数组
 struct CellData {
 
     MaterialInstance tile{};
@@ -29,10 +36,41 @@ struct CellData {
     int lifetime = 0;
     int fadeTime = 60;
     u8 inObjectState = 0;
-    std::function<void()> killCallback = []() {};
+    u8 event = CELL_EVENT_NONE;
 
     explicit CellData(MaterialInstance tile, f32 x, f32 y, f32 vx, f32 vy, f32 ax, f32 ay) : tile(std::move(tile)), x(x), y(y), vx(vx), vy(vy), ax(ax), ay(ay) {}
-    CellData(const CellData& part) : tile(part.tile), x(part.x), y(part.y), vx(part.vx), vy(part.vy), ax(part.ax), ay(part.ay) {}
 };
 
-}  // namespace ME
\ No newline at end of file
+struct CellDeath {
+    u8 event;
+    CellHandle handle;
+    f32 x, y;
+};
+
+// 粒子池 各字段连续存放 槽位由空闲链表回收复用
+// 遍历 [0, capacity()) 并跳过 alive 为 0 的空槽 槽位复用时 gen 加一使旧句柄失效
+struct CellPool {
+    std::vector<f32> x, y, vx, vy, ax, ay;
+    std::vector<f32> targetX, targetY, targetForce;
+    std::vector<MaterialInstance> tile;
+    std::vector<i32> lifetime, fadeTime;
+    std::vector<u8> phase, temporary, inObjectState, event;
+    std::vector<u8> alive;
+    std::vector<u32> gen;
+
+    std::vector<u32> freeList;
+    std::vector<CellDeath> deaths;  // 上一次 tickCells 中带事件的死亡
+    u32 live = 0;
+
+    CellHandle add(const CellData &c);
+    void kill(u32 i);
+    void clear();
+    void reserve(u32 n);
+
+    bool valid(CellHandle h) const { return h.index < alive.size() && alive[h.index] && gen[h.index] == h.gen; }
+    CellHandle handle(u32 i) const { return {i, gen[i]}; }
+    u32 capacity() const { return (u32)alive.size(); }
+    u32 size() const { return live; }
+};
+
+}  // namespace ME
@@ -482,41 +482,30 @@ void b2Body::SetEnabled(bool flag) {
         return;
     }
 
+    b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+
+    // The broad-phase only marks the tree for a rebuild on Add/Remove, so toggling
+    // many bodies between two steps costs a single rebuild in the next step.
     if (flag) {
         m_flags |= e_enabledFlag;
 
         // Create all proxies.
-        // TODO
-        /*b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-        for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
-        {
-          f->CreateProxies(broadPhase, m_xf);
+        for (b2Fixture* f = m_fixtureList; f; f = f->m_next) {
+            f->UpdateAABB();
+            broadPhase->Add(f);
         }
-        */
-
-        // Contacts are created at the beginning of the next
-        m_world->m_newContacts = true;
     } else {
         m_flags &= ~e_enabledFlag;
 
-        // Destroy all proxies.
-        // TODO
-        /*b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
-        for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
-        {
-          f->DestroyProxies(broadPhase);
-        }
-
-        // Destroy the attached contacts.
-        b2ContactEdge* ce = m_contactList;
-        while (ce)
-        {
-          b2ContactEdge* ce0 = ce;
-          ce = ce->next;
-          m_world->m_contactManager.Destroy(ce0->contact);
+        // Destroy all proxies. The attached contacts are no longer reported by the
+        // broad-phase and are removed as dead contacts in the next step.
+        for (b2Fixture* f = m_fixtureList; f; f = f->m_next) {
+            broadPhase->Remove(f);
         }
-        m_contactList = nullptr;*/
     }
+
+    // Contacts are created/removed at the beginning of the next step
+    m_world->m_newContacts = true;
 }
 
 void b2Body::SetFixedRotation(bool flag) {
@@ -109,8 +109,11 @@ void b2ContactSolver::Initialize(b2ContactSolverDef* def) {
         vc->tangentSpeed = contact->m_tangentSpeed;
 #endif  // ENABLE_TANGENT_SPEED
 
-        vc->indexA = bodyA->m_islandIndex;
-        vc->indexB = bodyB->m_islandIndex;
+        int32 indexA = def->indices ? def->indices[2 * i + 0] : bodyA->m_islandIndex;
+        int32 indexB = def->indices ? def->indices[2 * i + 1] : bodyB->m_islandIndex;
+
+        vc->indexA = indexA;
+        vc->indexB = indexB;
         vc->invMassA = bodyA->m_invMass;
         vc->invMassB = bodyB->m_invMass;
         vc->invIA = bodyA->m_invI;
@@ -118,8 +121,8 @@ void b2ContactSolver::Initialize(b2ContactSolverDef* def) {
         vc->manifold = manifold;
         vc->pointCount = pointCount;
 
-        pc->indexA = bodyA->m_islandIndex;
-        pc->indexB = bodyB->m_islandIndex;
+        pc->indexA = indexA;
+        pc->indexB = indexB;
         pc->invMassA = bodyA->m_invMass;
         pc->invMassB = bodyB->m_invMass;
         pc->localCenterA = bodyA->m_sweep.localCenter;
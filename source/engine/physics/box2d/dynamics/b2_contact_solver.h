@@ -87,6 +87,7 @@ struct b2ContactSolverDef {
     b2Position* positions;
     b2Velocity* velocities;
     b2StackAllocator* allocator;
+    const int32* indices = nullptr;  // optional island indices, 2 per contact
 };
 
 class b2ContactSolver {
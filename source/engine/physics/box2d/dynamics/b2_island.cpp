@@ -164,6 +164,7 @@ b2Island::b2Island(int32 bodyCapacity, int32 contactCapacity, int32 jointCapacit
 
     m_allocator = allocator;
     m_listener = listener;
+    m_contactIndices = nullptr;
 
     m_bodies = (b2Body**)m_allocator->Allocate(bodyCapacity * sizeof(b2Body*));
     m_contacts = (b2Contact**)m_allocator->Allocate(contactCapacity * sizeof(b2Contact*));
@@ -305,6 +306,7 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
         contactSolverDef.positions = m_positions;
         contactSolverDef.velocities = m_velocities;
         contactSolverDef.allocator = m_allocator;
+        contactSolverDef.indices = m_contactIndices;
 
         contactSolver.Initialize(&contactSolverDef);
         contactSolver.InitializeVelocityConstraints();
@@ -410,6 +412,10 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
     // Copy state buffers back to the bodies
     for (int32 i = 0; i < m_bodyCount; ++i) {
         b2Body* body = m_bodies[i];
+        // Static bodies never move, and they may be shared with islands solved on other threads.
+        if (body->m_type == b2_staticBody) {
+            continue;
+        }
         body->m_sweep.c = m_positions[i].c;
         body->m_sweep.a = m_positions[i].a;
         body->m_linearVelocity = m_velocities[i].v;
@@ -85,6 +85,11 @@ public:
     b2Position* m_positions;
     b2Velocity* m_velocities;
 
+    // Optional island indices of both bodies of each contact (2 per contact).
+    // Set when the island is solved on a worker thread, because static bodies shared
+    // with other islands cannot carry a per-island m_islandIndex.
+    const int32* m_contactIndices;
+
     int32 m_bodyCount;
     int32 m_jointCount;
     int32 m_contactCount;
@@ -74,6 +74,12 @@ b2World::b2World(const b2Vec2& gravity) {
 
     m_contactManager.m_allocator = &m_blockAllocator;
 
+    m_parallelFor = nullptr;
+    m_parallelUserData = nullptr;
+    m_parallelTaskCount = 0;
+    m_taskAllocators = nullptr;
+    m_parallelStep = nullptr;
+
     memset(&m_profile, 0, sizeof(b2Profile));
 }
 
@@ -101,6 +107,25 @@ b2World::~b2World() {
         DestroyParticleSystem(m_particleSystemList);
     }
 #endif  // ENABLE_LIQUID
+
+    delete[] m_taskAllocators;
+}
+
+void b2World::SetParallelSolve(b2ParallelForCallback* callback, int32 taskCount, void* userData) {
+    b2Assert(IsLocked() == false);
+
+    if (taskCount != m_parallelTaskCount || callback == nullptr) {
+        delete[] m_taskAllocators;
+        m_taskAllocators = nullptr;
+    }
+
+    m_parallelFor = callback;
+    m_parallelUserData = userData;
+    m_parallelTaskCount = callback != nullptr ? b2Max(taskCount, 1) : 0;
+
+    if (m_parallelTaskCount > 0 && m_taskAllocators == nullptr) {
+        m_taskAllocators = new b2StackAllocator[m_parallelTaskCount];
+    }
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener) { m_destructionListener = listener; }
@@ -440,10 +465,7 @@ void b2World::SetAllowSleeping(bool flag) {
 }
 
 // Find islands, integrate and solve constraints, solve position constraints
-void b2World::Solve(const b2TimeStep& step) {
-    // Size the island for the worst case.
-    b2Island island(m_bodyCount, m_contactManager.m_contactCount, m_jointCount, &m_stackAllocator, m_contactManager.m_contactListener);
-
+void b2World::ResetIslandFlags() {
     // Clear all the island flags.
     for (b2Body* b = m_bodyListHead; b; b = b->m_next) {
         b->m_xf0 = b->m_xf;
@@ -464,6 +486,106 @@ void b2World::Solve(const b2TimeStep& step) {
     for (b2Joint* j = m_jointList; j; j = j->m_next) {
         j->m_islandFlag = false;
     }
+}
+
+void b2World::FloodIsland(b2Island& island, b2Body* seed, b2Body** stack, int32 stackSize) {
+    // Reset island and stack.
+    island.Clear();
+    int32 stackCount = 0;
+    stack[stackCount++] = seed;
+    seed->m_flags |= b2Body::e_islandFlag;
+
+    // Perform a depth first search (DFS) on the constraint graph.
+    while (stackCount > 0) {
+        // Grab the next body off the stack and add it to the island.
+        b2Body* b = stack[--stackCount];
+        b2Assert(b->IsEnabled() == true);
+        island.Add(b);
+
+        // To keep islands as small as possible, we don't
+        // propagate islands across static bodies.
+        if (b->GetType() == b2_staticBody) {
+            continue;
+        }
+
+        // Make sure the body is awake (without resetting sleep timer).
+        b->m_flags |= b2Body::e_awakeFlag;
+
+        // Search all contacts connected to this body.
+        for (int32 i = 0; i < b->GetContactCount(); ++i) {
+            b2Contact* contact = b->GetContact(i);
+
+            // Has this contact already been added to an island?
+            if (contact->m_flags & b2Contact::e_islandFlag) {
+                continue;
+            }
+
+            // Is this contact solid and touching?
+            if (contact->IsEnabled() == false || contact->IsTouching() == false) {
+                continue;
+            }
+
+            // Skip sensors.
+            bool sensorA = contact->m_fixtureA->m_isSensor;
+            bool sensorB = contact->m_fixtureB->m_isSensor;
+            if (sensorA || sensorB) {
+                continue;
+            }
+
+            island.Add(contact);
+            contact->m_flags |= b2Contact::e_islandFlag;
+
+            b2Body* bA = contact->GetFixtureA()->GetBody();
+            b2Body* bB = contact->GetFixtureB()->GetBody();
+            b2Body* other = (bA == b) ? bB : bA;
+
+            // Was the other body already added to this island?
+            if (other->m_flags & b2Body::e_islandFlag) {
+                continue;
+            }
+
+            b2Assert(stackCount < stackSize);
+            stack[stackCount++] = other;
+            other->m_flags |= b2Body::e_islandFlag;
+        }
+
+        // Search all joints connect to this body.
+        for (b2JointEdge* je = b->m_jointList; je; je = je->next) {
+            if (je->joint->m_islandFlag == true) {
+                continue;
+            }
+
+            b2Body* other = je->other;
+
+            // Don't simulate joints connected to diabled bodies.
+            if (other->IsEnabled() == false) {
+                continue;
+            }
+
+            island.Add(je->joint);
+            je->joint->m_islandFlag = true;
+
+            if (other->m_flags & b2Body::e_islandFlag) {
+                continue;
+            }
+
+            b2Assert(stackCount < stackSize);
+            stack[stackCount++] = other;
+            other->m_flags |= b2Body::e_islandFlag;
+        }
+    }
+}
+
+void b2World::Solve(const b2TimeStep& step) {
+    if (m_parallelFor != nullptr && m_parallelTaskCount > 1) {
+        SolveParallel(step);
+        return;
+    }
+
+    // Size the island for the worst case.
+    b2Island island(m_bodyCount, m_contactManager.m_contactCount, m_jointCount, &m_stackAllocator, m_contactManager.m_contactListener);
+
+    ResetIslandFlags();
 
     // Build and simulate all awake islands.
     // at this point all contacts have the e_islandFlag cleared by b2ContactManager::Collide;
@@ -496,97 +618,95 @@ void b2World::Solve(const b2TimeStep& step) {
             continue;
         }
 
-        // Reset island and stack.
-        island.Clear();
-        int32 stackCount = 0;
-        stack[stackCount++] = seed;
-        seed->m_flags |= b2Body::e_islandFlag;
-
-        // Perform a depth first search (DFS) on the constraint graph.
-        while (stackCount > 0) {
-            // Grab the next body off the stack and add it to the island.
-            b2Body* b = stack[--stackCount];
-            b2Assert(b->IsEnabled() == true);
-            island.Add(b);
-
-            // To keep islands as small as possible, we don't
-            // propagate islands across static bodies.
-            if (b->GetType() == b2_staticBody) {
-                continue;
-            }
-
-            // Make sure the body is awake (without resetting sleep timer).
-            b->m_flags |= b2Body::e_awakeFlag;
+        FloodIsland(island, seed, stack, stackSize);
 
-            // Search all contacts connected to this body.
-            for (int32 i = 0; i < b->GetContactCount(); ++i) {
-                b2Contact* contact = b->GetContact(i);
+        island.Solve(step, m_gravity, m_allowSleep);
 
-                // Has this contact already been added to an island?
-                if (contact->m_flags & b2Contact::e_islandFlag) {
-                    continue;
-                }
+        // Post solve cleanup.
+        for (int32 i = 0; i < island.m_bodyCount; ++i) {
+            // Allow static bodies to participate in other islands.
+            b2Body* b = island.m_bodies[i];
+            if (b->GetType() == b2_staticBody) {
+                b->m_flags &= ~b2Body::e_islandFlag;
+            }
+        }
+    }
 
-                // Is this contact solid and touching?
-                if (contact->IsEnabled() == false || contact->IsTouching() == false) {
-                    continue;
-                }
+    m_stackAllocator.Free(stack);
 
-                // Skip sensors.
-                bool sensorA = contact->m_fixtureA->m_isSensor;
-                bool sensorB = contact->m_fixtureB->m_isSensor;
-                if (sensorA || sensorB) {
-                    continue;
-                }
+    {
+        b2Timer timer;
+        // Look for new contacts.
+        m_contactManager.FindNewContacts();
+        RemoveDeadContacts();
+        m_profile.broadphase = timer.GetMilliseconds();
+    }
+}
 
-                island.Add(contact);
-                contact->m_flags |= b2Contact::e_islandFlag;
+void b2World::SolveParallel(const b2TimeStep& step) {
+    // Islands never share dynamic bodies or contacts, and static bodies are read only while solving,
+    // so islands can be solved in any order and on any thread with the same result.
+    // The graph search stays serial: it only records the islands, then the batches are solved in parallel.
+    b2Island island(m_bodyCount, m_contactManager.m_contactCount, m_jointCount, &m_stackAllocator, m_contactManager.m_contactListener);
 
-                b2Body* bA = contact->GetFixtureA()->GetBody();
-                b2Body* bB = contact->GetFixtureB()->GetBody();
-                b2Body* other = (bA == b) ? bB : bA;
+    ResetIslandFlags();
 
-                // Was the other body already added to this island?
-                if (other->m_flags & b2Body::e_islandFlag) {
-                    continue;
-                }
+    m_islandRanges.clear();
+    m_islandBodies.clear();
+    m_islandContacts.clear();
+    m_islandContactIndices.clear();
 
-                b2Assert(stackCount < stackSize);
-                stack[stackCount++] = other;
-                other->m_flags |= b2Body::e_islandFlag;
-            }
+    int32 stackSize = m_bodyCount;
+    b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
+    for (b2Body* seed = m_bodyListHead; seed; seed = seed->m_next) {
+        if (seed->m_flags & b2Body::e_islandFlag) {
+            continue;
+        }
 
-            // Search all joints connect to this body.
-            for (b2JointEdge* je = b->m_jointList; je; je = je->next) {
-                if (je->joint->m_islandFlag == true) {
-                    continue;
-                }
+        if (seed->IsEnabled() == false) {
+            continue;
+        }
 
-                b2Body* other = je->other;
+#ifdef ENABLE_SLEEPING
+        if (seed->IsAwake() == false) {
+            continue;
+        }
+#endif  // ENABLE_SLEEPING
 
-                // Don't simulate joints connected to diabled bodies.
-                if (other->IsEnabled() == false) {
-                    continue;
-                }
+        if (seed->GetType() == b2_staticBody) {
+            break;
+        }
 
-                island.Add(je->joint);
-                je->joint->m_islandFlag = true;
+        if (seed->GetContactCount() == 0 && seed->GetJointList() == nullptr) {
+            island.SolveOrphan(seed, step, m_gravity, m_allowSleep);
+            seed->m_flags |= (b2Body::e_islandFlag | b2Body::e_awakeFlag);
+            continue;
+        }
 
-                if (other->m_flags & b2Body::e_islandFlag) {
-                    continue;
-                }
+        FloodIsland(island, seed, stack, stackSize);
 
-                b2Assert(stackCount < stackSize);
-                stack[stackCount++] = other;
-                other->m_flags |= b2Body::e_islandFlag;
+        if (island.m_jointCount > 0) {
+            // Joints read m_islandIndex of their bodies while solving, keep these islands serial.
+            island.Solve(step, m_gravity, m_allowSleep);
+        } else {
+            IslandRange range;
+            range.bodyStart = (int32)m_islandBodies.size();
+            range.bodyCount = island.m_bodyCount;
+            range.contactStart = (int32)m_islandContacts.size();
+            range.contactCount = island.m_contactCount;
+            m_islandRanges.push_back(range);
+
+            m_islandBodies.insert(m_islandBodies.end(), island.m_bodies, island.m_bodies + island.m_bodyCount);
+            for (int32 i = 0; i < island.m_contactCount; ++i) {
+                b2Contact* c = island.m_contacts[i];
+                m_islandContacts.push_back(c);
+                // Valid right now: static bodies get a new index in every island they join.
+                m_islandContactIndices.push_back(c->GetFixtureA()->GetBody()->m_islandIndex);
+                m_islandContactIndices.push_back(c->GetFixtureB()->GetBody()->m_islandIndex);
             }
         }
 
-        island.Solve(step, m_gravity, m_allowSleep);
-
-        // Post solve cleanup.
         for (int32 i = 0; i < island.m_bodyCount; ++i) {
-            // Allow static bodies to participate in other islands.
             b2Body* b = island.m_bodies[i];
             if (b->GetType() == b2_staticBody) {
                 b->m_flags &= ~b2Body::e_islandFlag;
@@ -596,6 +716,17 @@ void b2World::Solve(const b2TimeStep& step) {
 
     m_stackAllocator.Free(stack);
 
+    if (!m_islandRanges.empty()) {
+        int32 count = b2Min(m_parallelTaskCount, (int32)m_islandRanges.size());
+        m_parallelStep = &step;
+        if (count > 1) {
+            m_parallelFor(count, &b2World::SolveIslandBatch, this, m_parallelUserData);
+        } else {
+            SolveIslandBatch(0, this);
+        }
+        m_parallelStep = nullptr;
+    }
+
     {
         b2Timer timer;
         // Look for new contacts.
@@ -605,6 +736,26 @@ void b2World::Solve(const b2TimeStep& step) {
     }
 }
 
+void b2World::SolveIslandBatch(int32 index, void* context) {
+    b2World* world = (b2World*)context;
+    int32 count = b2Min(world->m_parallelTaskCount, (int32)world->m_islandRanges.size());
+    b2StackAllocator* allocator = world->m_taskAllocators + index;
+
+    // Fixed round robin assignment, independent of which thread runs the batch.
+    for (int32 r = index; r < (int32)world->m_islandRanges.size(); r += count) {
+        const IslandRange& range = world->m_islandRanges[r];
+
+        b2Island island(range.bodyCount, range.contactCount, 0, allocator, world->m_contactManager.m_contactListener);
+        memcpy(island.m_bodies, world->m_islandBodies.data() + range.bodyStart, range.bodyCount * sizeof(b2Body*));
+        memcpy(island.m_contacts, world->m_islandContacts.data() + range.contactStart, range.contactCount * sizeof(b2Contact*));
+        island.m_bodyCount = range.bodyCount;
+        island.m_contactCount = range.contactCount;
+        island.m_contactIndices = world->m_islandContactIndices.data() + 2 * range.contactStart;
+
+        island.Solve(*world->m_parallelStep, world->m_gravity, world->m_allowSleep);
+    }
+}
+
 struct b2HeapNode {
     float toi;
     int toiCount;
@@ -37,6 +37,8 @@
 #include "b2_time_step.h"
 #include "b2_world_callbacks.h"
 
+#include <vector>
+
 struct b2AABB;
 struct b2BodyDef;
 struct b2JointDef;
@@ -50,6 +52,11 @@ struct MEcolor;
 }  // namespace ME
 
 class b2ParticleGroup;
+class b2Island;
+
+/// Runs count tasks, possibly in parallel, and returns once all of them have finished.
+/// task(i, context) must be called exactly once for every i in [0, count).
+typedef void b2ParallelForCallback(int32 count, void (*task)(int32 index, void* context), void* context, void* userData);
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -190,6 +197,14 @@ public:
     b2Contact* GetContactListEnd();
     const b2Contact* GetContactListEnd() const;
 
+    /// Solve independent islands through an external scheduler. Islands are handed out to
+    /// taskCount batches in body list order, and every island only touches its own bodies and
+    /// contacts, so the result is the same as the serial solver for any thread count.
+    /// Islands that contain joints and bodies without contacts are still solved on the calling thread.
+    /// Pass nullptr to go back to the serial solver.
+    /// @warning b2ContactListener::PostSolve may be called from worker threads.
+    void SetParallelSolve(b2ParallelForCallback* callback, int32 taskCount, void* userData);
+
     /// Enable/disable sleep.
     void SetAllowSleeping(bool flag);
     bool GetAllowSleeping() const { return m_allowSleep; }
@@ -262,6 +277,10 @@ private:
     void RemoveDeadContacts();
 
     void Solve(const b2TimeStep& step);
+    void SolveParallel(const b2TimeStep& step);
+    void ResetIslandFlags();
+    void FloodIsland(b2Island& island, b2Body* seed, b2Body** stack, int32 stackSize);
+    static void SolveIslandBatch(int32 index, void* context);
     void SolveTOI(const b2TimeStep& step);
     float CalculateTOI(b2Contact* c);
 
@@ -305,6 +324,24 @@ private:
     bool m_stepComplete;
 
     b2Profile m_profile;
+
+    // Parallel island solving. Islands are recorded as ranges into the flat arrays below
+    // and each batch gets its own stack allocator.
+    struct IslandRange {
+        int32 bodyStart, bodyCount;
+        int32 contactStart, contactCount;
+    };
+
+    b2ParallelForCallback* m_parallelFor;
+    void* m_parallelUserData;
+    int32 m_parallelTaskCount;
+    b2StackAllocator* m_taskAllocators;
+    const b2TimeStep* m_parallelStep;
+
+    std::vector<IslandRange> m_islandRanges;
+    std::vector<b2Body*> m_islandBodies;
+    std::vector<b2Contact*> m_islandContacts;
+    std::vector<int32> m_islandContactIndices;
 };
 
 inline b2Body* b2World::GetBodyList() { return m_bodyListHead; }
@@ -5,6 +5,7 @@
 #include <string.h>
 
 #include "engine/core/base_memory.h"
+#include "engine/core/const.h"
 #include "engine/core/core.hpp"
 #include "engine/core/io/filesystem.h"
 #include "engine/core/sdl_wrapper.h"
@@ -43,33 +44,49 @@ Texture::~Texture() {
     // SDL_FreeSurface(m_surface);
 }
 
-void InitTexture(TexturePack &tex) {
-    tex.testTexture = LoadTexture("data/assets/textures/test.png");
-    tex.dirt1Texture = LoadTexture("data/assets/textures/testDirt.png");
-    tex.stone1Texture = LoadTexture("data/assets/textures/testStone.png");
-    tex.smoothStone = LoadTexture("data/assets/textures/smooth_stone.png");
-    tex.cobbleStone = LoadTexture("data/assets/textures/cobble_stone.png");
-    tex.flatCobbleStone = LoadTexture("data/assets/textures/flat_cobble_stone.png");
-    tex.smoothDirt = LoadTexture("data/assets/textures/smooth_dirt.png");
-    tex.cobbleDirt = LoadTexture("data/assets/textures/cobble_dirt.png");
-    tex.flatCobbleDirt = LoadTexture("data/assets/textures/flat_cobble_dirt.png");
-    tex.softDirt = LoadTexture("data/assets/textures/soft_dirt.png");
-    tex.cloud = LoadTexture("data/assets/textures/cloud.png");
-    tex.gold = LoadTexture("data/assets/textures/gold.png");
-    tex.goldMolten = LoadTexture("data/assets/textures/moltenGold.png");
-    tex.goldSolid = LoadTexture("data/assets/textures/solidGold.png");
-    tex.iron = LoadTexture("data/assets/textures/iron.png");
-    tex.obsidian = LoadTexture("data/assets/textures/obsidian.png");
+void TiledTexture::build(C_Surface *src, int pad) {
+    w = src->w;
+    h = src->h;
+    stride = w + pad;
+    pixels.resize(stride * h);
+    for (int y = 0; y < h; y++) {
+        u32 *row = pixels.data() + y * stride;
+        const u32 *srcRow = (const u32 *)((const u8 *)src->pixels + y * src->pitch);
+        for (int x = 0; x < stride; x++) row[x] = srcRow[x % w];
+    }
+}
+
+void InitTexture(TexturePack &tex, bool init_image) {
+    // 无窗口模式下只保留 surface 不创建 GPU 图像
+    auto load = [init_image](const std::string &path) { return LoadTextureInternal(path, SDL_PIXELFORMAT_ARGB8888, init_image); };
+
+    tex.testTexture = load("data/assets/textures/test.png");
+    tex.dirt1Texture = load("data/assets/textures/testDirt.png");
+    tex.stone1Texture = load("data/assets/textures/testStone.png");
+    tex.smoothStone = load("data/assets/textures/smooth_stone.png");
+    tex.cobbleStone = load("data/assets/textures/cobble_stone.png");
+    tex.flatCobbleStone = load("data/assets/textures/flat_cobble_stone.png");
+    tex.smoothDirt = load("data/assets/textures/smooth_dirt.png");
+    tex.cobbleDirt = load("data/assets/textures/cobble_dirt.png");
+    tex.flatCobbleDirt = load("data/assets/textures/flat_cobble_dirt.png");
+    tex.softDirt = load("data/assets/textures/soft_dirt.png");
+    tex.cloud = load("data/assets/textures/cloud.png");
+    tex.gold = load("data/assets/textures/gold.png");
+    tex.goldMolten = load("data/assets/textures/moltenGold.png");
+    tex.goldSolid = load("data/assets/textures/solidGold.png");
+    tex.iron = load("data/assets/textures/iron.png");
+    tex.obsidian = load("data/assets/textures/obsidian.png");
     tex.caveBG = LoadTextureInternal("data/assets/backgrounds/testCave.png", SDL_PIXELFORMAT_ARGB8888, false);
+    tex.caveBGTiled.build(tex.caveBG->surface(), CHUNK_W);
 
     // Test aseprite
     tex.testAse = LoadAsepriteTexture("data/assets/textures/Sprite-0003.ase", false);
 
-    tex.testVacuum = LoadTexture("data/assets/objects/testVacuum.png");
-    tex.testBucket = LoadTexture("data/assets/objects/testBucket.png");
-    tex.testBucketFilled = LoadTexture("data/assets/objects/testBucket_fill.png");
-    tex.testPickaxe = LoadTexture("data/assets/objects/testPickaxe.png");
-    tex.testHammer = LoadTexture("data/assets/objects/testHammer.png");
+    tex.testVacuum = load("data/assets/objects/testVacuum.png");
+    tex.testBucket = load("data/assets/objects/testBucket.png");
+    tex.testBucketFilled = load("data/assets/objects/testBucket_fill.png");
+    tex.testPickaxe = load("data/assets/objects/testPickaxe.png");
+    tex.testHammer = load("data/assets/objects/testHammer.png");
 }
 
 void EndTexture(TexturePack &tex) {
@@ -90,6 +107,7 @@ void EndTexture(TexturePack &tex) {
     tex.iron.reset();
     tex.obsidian.reset();
     tex.caveBG.reset();
+    tex.caveBGTiled = {};
 
     tex.testAse.reset();
 
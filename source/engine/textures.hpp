@@ -3,6 +3,8 @@
 #ifndef ME_TEXTURES_HPP
 #define ME_TEXTURES_HPP
 
+#include <vector>
+
 #include "engine/core/core.hpp"
 #include "engine/core/sdl_wrapper.h"
 #include "engine/engine.hpp"
@@ -28,6 +30,25 @@ public:
 // 贴图引用
 using TextureRef = ref<Texture>;
 
+// 预先平铺的贴图 像素格式与源 surface 相同(u32)
+// 每行末尾重复 pad 个像素 从任意环绕起点开始的 pad 长度行段都是连续内存 可以直接 memcpy
+struct TiledTexture {
+    int w = 0;
+    int h = 0;
+    int stride = 0;
+    std::vector<u32> pixels;
+
+    void build(C_Surface *src, int pad);
+    bool valid() const { return w > 0 && h > 0; }
+
+    // 环绕后的 (x, y) 开始的行段
+    const u32 *span(int x, int y) const {
+        x = ((x % w) + w) % w;
+        y = ((y % h) + h) % h;
+        return pixels.data() + y * stride + x;
+    }
+};
+
 struct TexturePack {
     TextureRef testTexture;
     TextureRef dirt1Texture;
@@ -46,6 +67,7 @@ struct TexturePack {
     TextureRef iron;
     TextureRef obsidian;
     TextureRef caveBG;
+    TiledTexture caveBGTiled;  // 区块生成按行拷贝洞穴背景
     TextureRef testAse;
 
     TextureRef testVacuum;
@@ -55,7 +77,7 @@ struct TexturePack {
     TextureRef testBucketFilled;
 };
 
-void InitTexture(TexturePack &tex);
+void InitTexture(TexturePack &tex, bool init_image = true);
 void EndTexture(TexturePack &tex);
 
 TextureRef LoadTexture(const std::string &path);
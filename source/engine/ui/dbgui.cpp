@@ -37,6 +37,7 @@
 #include "engine/ui/imgui_impl.hpp"
 #include "engine/ui/ui.hpp"
 #include "engine/utils/utility.hpp"
+#include "engine/world_bench.hpp"
 #include "game/items.hpp"
 #include "game/player.hpp"
 #include "libs/glad/glad.h"
@@ -547,6 +548,8 @@ void console::init() {
     // });
 
     convar.Value("game_scale", the<engine>().eng()->render_scale);
+
+    bench::register_commands(convar);
 }
 
 void console::end() {}
@@ -1858,7 +1861,7 @@ void dbgui::Update() {
                 if (CollapsingHeader(LANG("ui_entities"))) {
 
                     ImGui::Indent();
-                    ImGui::Auto(global.game->Iso.world->rigidBodies, "刚体");
+                    ImGui::Auto(global.game->Iso.world->rigidBodies.items(), "刚体");
                     ImGui::Auto(global.game->Iso.world->worldRigidBodies, "世界刚体");
 
                     ImGui::Text("ECS: %lu %lu", global.game->Iso.world->Reg().memory_usage().entities, global.game->Iso.world->Reg().memory_usage().components);
@@ -3,10 +3,13 @@
 #include "world.hpp"
 
 #include <algorithm>
+#include <bit>
+#include <climits>
 #include <cstdio>
 #include <future>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <string>
 #include <thread>
 #include <typeinfo>
@@ -78,7 +81,11 @@ void world::init(std::string worldPath, u16 w, u16 h, R_Target *target, Audio *a
     this->target = target;
     loadZone = {0, 0, (float)w, (float)h};
 
-    noise.SetSeed(RNG_Next(global.game->RNG));
+    if (!metadata.hasNoiseSeed) {
+        metadata.noiseSeed = (int)RNG_Next(global.game->RNG);
+        metadata.hasNoiseSeed = true;
+    }
+    noise.SetSeed(metadata.noiseSeed);
     noise.SetNoiseType(FastNoise::Perlin);
 
     auto ha = phmap::flat_hash_map<int, phmap::flat_hash_map<int, Chunk *>>();
@@ -103,8 +110,6 @@ void world::init(std::string worldPath, u16 w, u16 h, R_Target *target, Audio *a
     tooClose : {}
     }
 
-    rigidBodies.reserve(1);
-
     // 重置为世界大小
 
     dirty = new bool[width * height];
@@ -125,6 +130,9 @@ void world::init(std::string worldPath, u16 w, u16 h, R_Target *target, Audio *a
     }
 
     real_tiles.resize(width * height);
+    solidStride = (width + 63) / 64 + 1;  // 多一个字 区块取字时可以越过行尾
+    solidBits.assign((size_t)solidStride * height, 0);
+    collideBits.assign((size_t)solidStride * height, 0);
     flowX = new f32[width * height];
     flowY = new f32[width * height];
     prevFlowX = new f32[width * height];
@@ -143,9 +151,11 @@ void world::init(std::string worldPath, u16 w, u16 h, R_Target *target, Audio *a
             // cells.push_back(new CellData(x, y, 0, 0, 0, 0.1, 0xffff00));
         }
     }
+    rebuildChunkStats();
 
     gravity = b2Vec2(0, 20);
     b2world = ME::create_scope<b2World>(gravity);
+    b2world->SetParallelSolve(&PhysicsParallelFor, world_sys.updateRigidBodyHitboxPool->size(), world_sys.updateRigidBodyHitboxPool.get());
 
     struct gameplay_feature {};
     registry.assign_feature<gameplay_feature>().add_system<ControableSystem>().add_system<NpcSystem>().add_system<WorldEntitySystem>();
@@ -171,6 +181,40 @@ void world::init(std::string worldPath, u16 w, u16 h, R_Target *target, Audio *a
     // updateRigidBodyHitbox(rb2);
 }
 
+void world::initHeadless(std::string worldPath, u16 w, u16 h, WorldGenerator *generator) {
+
+    this->worldName = worldPath;
+
+    std::filesystem::create_directories(worldPath);
+    std::filesystem::create_directories(worldPath + "/chunks");
+
+    metadata = WorldMeta::loadWorldMeta(this->worldName, false);
+
+    // 生成器会用到世界高度 需与游戏内世界保持一致
+    width = w;
+    height = h;
+
+    gen = generator;
+    populators = gen->getPopulators();
+
+    hasPopulator = new bool[6];
+    for (int i = 0; i < 6; i++) hasPopulator[i] = false;
+    for (int i = 0; i < populators.size(); i++) {
+        hasPopulator[populators[i]->getPhase()] = true;
+        if (populators[i]->getPhase() > highestPopulator) highestPopulator = populators[i]->getPhase();
+    }
+
+    loadZone = {0, 0, (float)w, (float)h};
+
+    if (!metadata.hasNoiseSeed) {
+        metadata.noiseSeed = (int)RNG_Next(global.game->RNG);
+        metadata.hasNoiseSeed = true;
+        metadata.save(this->worldName);
+    }
+    noise.SetSeed(metadata.noiseSeed);
+    noise.SetNoiseType(FastNoise::Perlin);
+}
+
 RigidBody *world::makeRigidBody(b2BodyType type, f32 x, f32 y, f32 angle, b2PolygonShape shape, f32 density, f32 friction, TextureRef texture) {
 
     b2BodyDef bodyDef;
@@ -187,6 +231,7 @@ RigidBody *world::makeRigidBody(b2BodyType type, f32 x, f32 y, f32 angle, b2Poly
     body->CreateFixture(&fixtureDef);
 
     RigidBody *rb = new RigidBody(body);
+    body->GetUserData().pointer = (uintptr_t)rb;
     rb->setTexture(texture);
     if (texture != NULL) {
         rb->matWidth = rb->get_surface()->w;
@@ -219,6 +264,7 @@ RigidBody *world::makeRigidBody(b2BodyType type, f32 x, f32 y, f32 angle, b2Poly
 
         // rb->set_texture(R_CopyImageFromSurface(rb->get_surface()));
         // R_SetImageFilter(rb->get_texture(), R_FILTER_NEAREST);
+        rb->buildMask();
         rb->updateImage({});
     }
     // rigidBodies.push_back(rb);
@@ -245,6 +291,7 @@ RigidBody *world::makeRigidBodyMulti(b2BodyType type, f32 x, f32 y, f32 angle, s
     }
 
     RigidBody *rb = new RigidBody(body);
+    body->GetUserData().pointer = (uintptr_t)rb;
     rb->setTexture(texture);
     if (texture != NULL) {
         rb->matWidth = rb->get_surface()->w;
@@ -278,6 +325,7 @@ RigidBody *world::makeRigidBodyMulti(b2BodyType type, f32 x, f32 y, f32 angle, s
         // rb->set_texture(R_CopyImageFromSurface(rb->get_surface()));
         // R_SetImageFilter(rb->get_texture(), R_FILTER_NEAREST);
 
+        rb->buildMask();
         rb->updateImage({});
     }
     // rigidBodies.push_back(rb);
@@ -285,110 +333,91 @@ RigidBody *world::makeRigidBodyMulti(b2BodyType type, f32 x, f32 y, f32 angle, s
 #endif
 }
 
-void world::updateRigidBodyHitbox(RigidBody *rb) {
+RigidBody *world::updateRigidBodyHitbox(RigidBody *rb) {
 
     C_Surface *sfc = rb->get_surface();
 
-    if (static_cast<bool>(sfc)) return;
-
-    for (int x = 0; x < sfc->w; x++) {
-        for (int y = 0; y < sfc->h; y++) {
-            MaterialInstance mat = rb->tiles[x + y * sfc->w];
-            if (mat.mat->id == GAME()->materials_list.GENERIC_AIR.id) {
-                ME_get_pixel(sfc, x, y) = 0x00000000;
-            } else {
-                ME_get_pixel(sfc, x, y) = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
-            }
-        }
-    }
-
-    int minX = sfc->w;
-    int maxX = 0;
-    int minY = sfc->h;
-    int maxY = 0;
-    for (int x = 0; x < sfc->w; x++) {
-        for (int y = 0; y < sfc->h; y++) {
-            if (((ME_get_pixel(sfc, x, y) >> 24) & 0xff) != 0x00) {
-                if (x < minX) minX = x;
-                if (x > maxX) maxX = x;
-                if (y < minY) minY = y;
-                if (y > maxY) maxY = y;
-            }
-        }
+    if (!static_cast<bool>(sfc)) return rb;
+
+    rb->needsUpdate = false;
+    rbStats.updates++;
+
+    // tiles 是材质来源 只把修改过的行写回 surface
+    if (rb->mask.empty()) rb->buildMask();
+    int rows = rb->syncSurface(!rbIncremental);
+    rbStats.rowsSynced += rows;
+    if (rows > 0) rb->texNeedsUpdate = true;
+
+    // 实心位图没有变化 碰撞体与轮廓都不需要重建
+    if (rbIncremental && !rb->maskChanged) return rb;
+    rb->maskChanged = false;
+
+    int minX, minY, maxX, maxY;
+    if (!rb->maskBounds(minX, minY, maxX, maxY) || maxX - minX <= 1 || maxY - minY <= 1) {
+        // 已被挖空或只剩单行/单列像素
+        b2world->DestroyBody(rb->body);
+        rigidBodies.erase(rb);
+        rb->clean();
+        delete rb;
+        return nullptr;
     }
-    maxX++;
-    maxY++;
 
-    if (static_cast<bool>(sfc)) {
-        // TODO: 23/7/15 修复
+    // 包围盒缩小时才重新分配 surface
+    if (!rbIncremental || minX > 0 || minY > 0 || maxX < sfc->w || maxY < sfc->h) {
         C_Surface *sf = SDL_CreateRGBSurfaceWithFormat(sfc->flags, maxX - minX, maxY - minY, sfc->format->BitsPerPixel, sfc->format->format);
         C_Rect src = {minX, minY, maxX - minX, maxY - minY};
         SDL_SetSurfaceBlendMode(sfc, SDL_BlendMode::SDL_BLENDMODE_NONE);
         SDL_BlitSurface(sfc, &src, sf, NULL);
-        SDL_FreeSurface(sfc);
 
-        if (static_cast<bool>(rb->get_surface())) {
-            if (rb->get_surface()->w <= 1 || rb->get_surface()->h <= 1) {
-                b2world->DestroyBody(rb->body);
-                rigidBodies.erase(std::remove(rigidBodies.begin(), rigidBodies.end(), rb), rigidBodies.end());
-                return;
-            }
+        // 贴图可能与物品共享 只有刚体独占时才释放旧 surface
+        TextureRef old = rb->texture();
+        auto tex = create_ref<Texture>(sf);
+        rb->setTexture(tex);
+        if (old.use_count() == 1) SDL_FreeSurface(sfc);
+        rb->cropTiles(minX, minY, maxX - minX, maxY - minY);
+        sfc = rb->get_surface();
+        rbStats.reallocs++;
 
-            // rb->set_surface(sf);
+        f32 s = sin(rb->body->GetAngle());
+        f32 c = cos(rb->body->GetAngle());
 
-            auto tex = create_ref<Texture>(sf);
-            rb->setTexture(tex);
-            sfc = rb->get_surface();
+        // 按旋转后的裁剪偏移平移刚体
+        f32 xnew = minX * c - minY * s;
+        f32 ynew = minX * s + minY * c;
 
-        } else {
-            ME_ASSERT(0);
-        }
-    } else {
-        return;
+        rb->body->SetTransform(b2Vec2(rb->body->GetPosition().x + xnew, rb->body->GetPosition().y + ynew), rb->body->GetAngle());
     }
 
-    f32 s = sin(rb->body->GetAngle());
-    f32 c = cos(rb->body->GetAngle());
-
-    // translate point back to origin:
-    minX -= 0;
-    minY -= 0;
-
-    // rotate point
-    f32 xnew = minX * c - minY * s;
-    f32 ynew = minX * s + minY * c;
-
-    // translate point back:
-    rb->body->SetTransform(b2Vec2(rb->body->GetPosition().x + xnew, rb->body->GetPosition().y + ynew), rb->body->GetAngle());
-
-    // If it is a single pixel rigid body, it will be deconstructed.
-    if (maxX == 1 || maxY == 1) return;
-
-    if (!static_cast<bool>(sfc) && !static_cast<bool>(rb->get_surface()) &&
-        // !static_cast<bool>(xnew) &&
-        // !static_cast<bool>(ynew) &&
-        1)
-        return;
-
-    bool foundAnything = false;
-    for (int x = 0; x < sfc->w; x++)
-        for (int y = 0; y < sfc->h; y++) {
-            bool f = ((ME_get_pixel(sfc, x, y) >> 24) & 0xff) == 0x00 ? 0 : 1;
-            foundAnything = foundAnything || f;
-        }
-
-    if (!foundAnything) return;
+    int size = sfc->w * sfc->h;
+    int stride = rb->maskStride;
 
-    u8 *data = new u8[sfc->w * sfc->h];
-    bool *edgeSeen = new bool[sfc->w * sfc->h];
+    u8 *data = new u8[size];
+    bool *edgeSeen = new bool[size];
 
     for (int y = 0; y < sfc->h; y++) {
         for (int x = 0; x < sfc->w; x++) {
-            data[x + y * sfc->w] = ((ME_get_pixel(sfc, x, y) >> 24) & 0xff) == 0x00 ? 0 : 1;
+            data[x + y * sfc->w] = rb->solidAt(x, y);
             edgeSeen[x + y * sfc->w] = false;
         }
     }
 
+    // 轮廓起点候选: 实心且右/下/右下不全为实心 与逐像素搜索的 numBorders != 3 等价
+    std::vector<u64> cand(rb->mask.size());
+    for (int y = 0; y < sfc->h; y++) {
+        const u64 *row = &rb->mask[y * stride];
+        const u64 *below = y + 1 < sfc->h ? row + stride : nullptr;
+        for (int k = 0; k < stride; k++) {
+            u64 right = (row[k] >> 1) | (k + 1 < stride ? row[k + 1] << 63 : 0);
+            u64 down = 0;
+            u64 downRight = 0;
+            if (below) {
+                down = below[k];
+                downRight = (below[k] >> 1) | (k + 1 < stride ? below[k + 1] << 63 : 0);
+            }
+            cand[y * stride + k] = row[k] & ~(right & down & downRight);
+        }
+    }
+
     std::vector<std::vector<MEvec2>> meshes = {};
 
     std::list<TPPLPoly> shapes;
@@ -408,22 +437,37 @@ void world::updateRigidBodyHitbox(RigidBody *rb) {
 
         int edgeX = -1;
         int edgeY = -1;
-        int size = sfc->w * sfc->h;
-        for (int i = lookIndex; i < size; i++) {
-            if (data[i] != 0) {
-
-                int numBorders = 0;
-                // if (i % texture->w - 1 >= 0) numBorders += data[(i % texture->w - 1) + i / texture->w * texture->w];
-                // if (i / texture->w - 1 >= 0) numBorders += data[(i % texture->w)+(i / texture->w - 1) * texture->w];
-                if (i % sfc->w + 1 < sfc->w) numBorders += data[(i % sfc->w + 1) + i / sfc->w * sfc->w];
-                if (i / sfc->w + 1 < sfc->h) numBorders += data[(i % sfc->w) + (i / sfc->w + 1) * sfc->w];
-                if (i / sfc->w + 1 < sfc->h && i % sfc->w + 1 < sfc->w) numBorders += data[(i % sfc->w + 1) + (i / sfc->w + 1) * sfc->w];
-
-                // int val = value(i % texture->w, i / texture->w, texture->w, height, data);
-                if (numBorders != 3) {
-                    edgeX = i % sfc->w;
-                    edgeY = i / sfc->w;
-                    break;
+        if (rbIncremental) {
+            // 从 lookIndex 开始按字找下一个候选位
+            for (int y = lookIndex / sfc->w, x = lookIndex % sfc->w; y < sfc->h && edgeX == -1; y++, x = 0) {
+                const u64 *row = &cand[y * stride];
+                for (int k = x >> 6; k < stride; k++) {
+                    u64 word = row[k];
+                    if (k == x >> 6) word &= ~0ull << (x & 63);
+                    if (word != 0) {
+                        edgeX = k * 64 + std::countr_zero(word);
+                        edgeY = y;
+                        break;
+                    }
+                }
+            }
+        } else {
+            for (int i = lookIndex; i < size; i++) {
+                if (data[i] != 0) {
+
+                    int numBorders = 0;
+                    // if (i % texture->w - 1 >= 0) numBorders += data[(i % texture->w - 1) + i / texture->w * texture->w];
+                    // if (i / texture->w - 1 >= 0) numBorders += data[(i % texture->w)+(i / texture->w - 1) * texture->w];
+                    if (i % sfc->w + 1 < sfc->w) numBorders += data[(i % sfc->w + 1) + i / sfc->w * sfc->w];
+                    if (i / sfc->w + 1 < sfc->h) numBorders += data[(i % sfc->w) + (i / sfc->w + 1) * sfc->w];
+                    if (i / sfc->w + 1 < sfc->h && i % sfc->w + 1 < sfc->w) numBorders += data[(i % sfc->w + 1) + (i / sfc->w + 1) * sfc->w];
+
+                    // int val = value(i % texture->w, i / texture->w, texture->w, height, data);
+                    if (numBorders != 3) {
+                        edgeX = i % sfc->w;
+                        edgeY = i / sfc->w;
+                        break;
+                    }
                 }
             }
         }
@@ -555,11 +599,41 @@ void world::updateRigidBodyHitbox(RigidBody *rb) {
 
         if (polys2.size() > 0) {
             polys2s.push_back(polys2);
+        }
+    }
 
-            polys2sSfcs.push_back(SDL_CreateRGBSurfaceWithFormat(sfc->flags, sfc->w, sfc->h, sfc->format->BitsPerPixel, sfc->format->format));
-
-            polys2sWeld.push_back(false);
+    // 没有分裂且没有焊接 直接替换原刚体的夹具 不再分配 surface 与重建刚体
+    if (rbIncremental && polys2s.size() == 1 && rb->weldX == -1) {
+        b2Fixture *f0 = rb->body->GetFixtureList();
+        f32 density = f0->GetDensity();
+        f32 friction = f0->GetFriction();
+        b2Filter filter = f0->GetFilterData();
+
+        while (b2Fixture *f = rb->body->GetFixtureList()) rb->body->DestroyFixture(f);
+
+        for (auto &sh : polys2s[0]) {
+            b2FixtureDef fixtureDef;
+            fixtureDef.shape = &sh;
+            fixtureDef.density = density;
+            fixtureDef.friction = friction;
+            fixtureDef.filter = filter;
+            rb->body->CreateFixture(&fixtureDef);
         }
+
+        rb->outline = shapes;
+        rb->texNeedsUpdate = true;
+        return rb;
+    }
+
+    rbStats.recreated++;
+    RigidBody *first = nullptr;
+
+    // 先移出列表 新刚体依次追加在末尾
+    rigidBodies.erase(rb);
+
+    for (int b = 0; b < polys2s.size(); b++) {
+        polys2sSfcs.push_back(SDL_CreateRGBSurfaceWithFormat(sfc->flags, sfc->w, sfc->h, sfc->format->BitsPerPixel, sfc->format->format));
+        polys2sWeld.push_back(false);
     }
 
     if (polys2s.size() > 0) {
@@ -701,73 +775,222 @@ void world::updateRigidBodyHitbox(RigidBody *rb) {
                     // weird edge case that causes infinite recursion
                     // TODO: actually figure out why that happens
                 } else {
-                    updateRigidBodyHitbox(rbn);
+                    rbn = updateRigidBodyHitbox(rbn);
                 }
             }
+            if (first == nullptr) first = rbn;
         }
     }
 
     b2world->DestroyBody(rb->body);
 
-    rigidBodies.erase(std::remove(rigidBodies.begin(), rigidBodies.end(), rb), rigidBodies.end());
-
     // delete[] rb->tiles;
     // R_FreeImage(rb->get_texture());
     // SDL_FreeSurface(rb->get_surface());
     // delete rb;
     rb->clean();
     delete rb;
+    return first;
 }
 
-void world::updateChunkMesh(Chunk *chunk) {
+RigidBodyHandle RigidBodyList::push_back(RigidBody *rb) {
+    if (contains(rb)) return handle(rb);
 
-    std::lock_guard<std::mutex> locker(g_mutex_updatechunkmesh);
+    u32 slot;
+    if (freeSlots.empty()) {
+        slot = (u32)slots.size();
+        slots.emplace_back();
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    slots[slot].index = (u32)dense.size();
+    dense.push_back(rb);
+    rb->listSlot = slot;
+    return {slot, slots[slot].generation};
+}
+
+void RigidBodyList::erase(RigidBody *rb) {
+    if (!contains(rb)) return;
+
+    u32 slot = rb->listSlot;
+    u32 index = slots[slot].index;
+    RigidBody *moved = dense.back();
+    dense[index] = moved;
+    slots[moved->listSlot].index = index;
+    dense.pop_back();
+
+    slots[slot].generation++;
+    slots[slot].index = UINT32_MAX;
+    freeSlots.push_back(slot);
+    rb->listSlot = UINT32_MAX;
+}
+
+void RigidBodyList::clear() {
+    for (RigidBody *rb : dense) rb->listSlot = UINT32_MAX;
+    for (u32 i = 0; i < slots.size(); i++) {
+        if (slots[i].index == UINT32_MAX) continue;
+        slots[i].generation++;
+        slots[i].index = UINT32_MAX;
+        freeSlots.push_back(i);
+    }
+    dense.clear();
+}
+
+void world::queryRigidBodies(f32 x0, f32 y0, f32 x1, f32 y1, std::vector<RigidBody *> &out) {
+    struct Query : b2QueryCallback {
+        RigidBodyList *list;
+        std::vector<RigidBody *> *out;
+        u32 stamp;
+        bool ReportFixture(b2Fixture *fixture) override {
+            RigidBody *rb = (RigidBody *)fixture->GetBody()->GetUserData().pointer;
+            // 区块网格/实体的刚体不在 rigidBodies 中
+            if (rb == nullptr || rb->queryStamp == stamp || !list->contains(rb)) return true;
+            rb->queryStamp = stamp;
+            out->push_back(rb);
+            return true;
+        }
+    } q;
+    q.list = &rigidBodies;
+    q.out = &out;
+    q.stamp = ++rigidBodyQueryStamp;
+
+    out.clear();
+    b2AABB aabb;
+    aabb.lowerBound.Set(x0, y0);
+    aabb.upperBound.Set(x1, y1);
+    b2world->QueryAABB(&q, aabb);
+}
+
+RigidBody *world::rigidBodyAt(int x, int y) {
+    queryRigidBodies((f32)x - 3, (f32)y - 3, (f32)x + 3, (f32)y + 3, rigidBodyQueryHits);
+    for (RigidBody *cur : rigidBodyQueryHits) {
+        if (cur->mask.empty()) continue;
+        f32 s = sin(-cur->body->GetAngle());
+        f32 c = cos(-cur->body->GetAngle());
+        for (f32 xx = -3; xx <= 3; xx += 0.5) {
+            for (f32 yy = -3; yy <= 3; yy += 0.5) {
+                if (abs(xx) + abs(yy) == 6) continue;
+                // rotate point
+
+                f32 tx = x + xx - cur->body->GetPosition().x;
+                f32 ty = y + yy - cur->body->GetPosition().y;
+
+                int ntx = (int)(tx * c - ty * s);
+                int nty = (int)(tx * s + ty * c);
+
+                if (ntx >= 0 && nty >= 0 && ntx < cur->matWidth && nty < cur->matHeight && cur->solidAt(ntx, nty)) return cur;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void PhysicsParallelFor(int32 count, void (*task)(int32 index, void *context), void *context, void *userData) {
+    thread_pool *pool = (thread_pool *)userData;
+    std::vector<std::future<void>> results;
+    for (int32 i = 1; i < count; i++) {
+        results.push_back(pool->push([=](int id) { task(i, context); }));
+    }
+    // 调用线程执行第 0 批
+    task(0, context);
+    for (auto &r : results) r.get();
+}
+
+static inline u64 mixMaskHash(u64 h, u64 word) {
+    h ^= word;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
 
-    /*
-    if (chunk->rb != nullptr) b2world->DestroyBody(chunk->rb->body);
-    */
+// 全空区块位图的哈希 与 chunkSolidMask 对全 0 位图的结果相同
+static u64 emptyChunkMaskHash() {
+    static const u64 hash = [] {
+        u64 h = 0xcbf29ce484222325ull;
+        for (int k = 0; k < CHUNK_H * ChunkSolidMask::ROW_WORDS; k++) h = mixMaskHash(h, 0);
+        return h;
+    }();
+    return hash;
+}
+
+// 返回 true 表示需要重新生成几何 此时 mask 中是区块的实心位图
+bool world::prepareChunkMesh(Chunk *chunk, u64 *mask) {
 
     // 区块坐标转化为世界坐标
     int chTx = chunk->x * CHUNK_W + loadZone.x;
     int chTy = chunk->y * CHUNK_H + loadZone.y;
 
     if (chTx < 0 || chTy < 0 || chTx + CHUNK_W >= width || chTy + CHUNK_H >= height) {
-        return;
+        return false;
     }
 
-#pragma region
+    // 还未经过画面 dirty 处理的改动
+    syncSolidBitsDirty(chTx, chTy, CHUNK_W, CHUNK_H);
 
     bool foundAnything = false;
-    for (int x = 0; x < CHUNK_W; x++) {
-        for (int y = 0; y < CHUNK_H; y++) {
-
-            Material *mat = real_tiles[(x + chTx) + (y + chTy) * width].mat;
-            if (mat != nullptr && mat->physicsType == PhysicsType::SOLID) {
-                foundAnything = true;
-                goto found;
-            }
+    u64 hash;
+    // 覆盖区块的统计块都没有实心格子时不必取位图 返回 false 时 mask 不会被使用
+    bool stats = statsSkip && !chunkStats.blocks.empty();
+    if (stats) syncChunkStatsDirty(chTx, chTy, CHUNK_W, CHUNK_H);
+    if (stats && solidCellsIn(chTx, chTy, CHUNK_W, CHUNK_H) == 0) {
+        hash = emptyChunkMaskHash();
+    } else {
+        hash = chunkSolidMask(chTx, chTy, mask, foundAnything);
+    }
 
-            // bool f = tiles[(x + meshZone.x) + (y + meshZone.y) * width].mat->physicsType == PhysicsType::SOLID;
-            // foundAnything = foundAnything || f;
+    // 实心格子没有变化 只需按当前 loadZone 移动并启用已有刚体
+    if (chunk->meshCached && chunk->meshHash == hash) {
+        if (chunk->rb) {
+            chunk->rb->body->SetTransform(b2Vec2((f32)chTx, (f32)chTy), 0);
+            chunk->rb->body->SetEnabled(true);
+            worldRigidBodies.push_back(chunk->rb);
         }
+        meshStats.reused++;
+        return false;
     }
-found : {};
 
-    if (!foundAnything) {
-        return;
-    }
+    releaseChunkMesh(chunk);
+    chunk->polys.clear();
+    chunk->meshCached = true;
+    chunk->meshHash = hash;
+    meshStats.rebuilt++;
 
-    unsigned char *data = new unsigned char[CHUNK_W * CHUNK_H];
+    return foundAnything;
+}
 
-    bool *edgeSeen = new bool[CHUNK_W * CHUNK_H];
+// 几何阶段: 轮廓追踪 简化 三角化 只读 mask 不接触 box2d 与世界状态 可在工作线程执行
+// wordParallel 为 false 时使用原先逐格邻居求和的起点搜索 供正确性对比
+void world::buildChunkMeshPolys(const u64 *mask, std::vector<b2PolygonShape> &polys, bool wordParallel) {
+
+    constexpr int W = ChunkSolidMask::ROW_WORDS;
 
+    // FindPerimeter 按字节读取
+    unsigned char *data = new unsigned char[CHUNK_W * CHUNK_H];
     for (int y = 0; y < CHUNK_H; y++) {
         for (int x = 0; x < CHUNK_W; x++) {
-            data[x + y * CHUNK_W] = real_tiles[(x + chTx) + (y + chTy) * width].mat->physicsType == PhysicsType::SOLID;
-            edgeSeen[x + y * CHUNK_W] = false;
+            data[x + y * CHUNK_W] = (mask[y * W + x / 64] >> (x % 64)) & 1;
+        }
+    }
+
+    // 轮廓起点: 自身实心 且 右/下/右下 不全是实心
+    // 按字计算 每次 64 格 右移一位即右侧邻居 最后一列右侧视为空
+    u64 edges[CHUNK_H * W];
+    if (wordParallel) {
+        for (int y = 0; y < CHUNK_H; y++) {
+            const u64 *row = &mask[y * W];
+            const u64 *below = y + 1 < CHUNK_H ? &mask[(y + 1) * W] : nullptr;
+            for (int k = 0; k < W; k++) {
+                u64 right = (row[k] >> 1) | (k + 1 < W ? row[k + 1] << 63 : 0);
+                u64 down = below ? below[k] : 0;
+                u64 downRight = below ? (below[k] >> 1) | (k + 1 < W ? below[k + 1] << 63 : 0) : 0;
+                edges[y * W + k] = row[k] & ~(right & down & downRight);
+            }
         }
     }
 
+    bool *edgeSeen = new bool[CHUNK_W * CHUNK_H];
+    memset(edgeSeen, false, CHUNK_W * CHUNK_H);
+
     std::vector<std::vector<MEvec2>> worldMeshes = {};
     std::list<TPPLPoly> shapes;
     std::list<MarchingSquares::Result> results;
@@ -788,23 +1011,37 @@ found : {};
         int edgeY = -1;
         int size = CHUNK_W * CHUNK_H;
 
-        for (int i = lookIndex; i < size; i++) {
-            if (data[i] != 0) {
-
-                int numBorders = 0;
-                // if (i % CHUNK_W - 1 >= 0) numBorders += data[(i % CHUNK_W - 1) + i / CHUNK_W * CHUNK_W];
-                // if (i / CHUNK_W - 1 >= 0) numBorders += data[(i % CHUNK_W)+(i / CHUNK_W - 1) * CHUNK_W];
-                if (i % CHUNK_W + 1 < CHUNK_W) numBorders += data[(i % CHUNK_W + 1) + i / CHUNK_W * CHUNK_W];
-                if (i / CHUNK_W + 1 < CHUNK_H) numBorders += data[(i % CHUNK_W) + (i / CHUNK_W + 1) * CHUNK_W];
-                if (i / CHUNK_W + 1 < CHUNK_H && i % CHUNK_W + 1 < CHUNK_W) numBorders += data[(i % CHUNK_W + 1) + (i / CHUNK_W + 1) * CHUNK_W];
-
-                // int val = value(i % CHUNK_W, i / CHUNK_W, CHUNK_W, height, data);
-                if (numBorders != 3) {
+        if (wordParallel) {
+            // 从 lookIndex 开始找下一个置位 bit
+            for (int wi = lookIndex / 64; wi < CHUNK_H * W; wi++) {
+                u64 bits = edges[wi];
+                if (wi == lookIndex / 64) bits &= ~0ull << (lookIndex % 64);
+                if (bits) {
+                    int i = wi * 64 + std::countr_zero(bits);
                     edgeX = i % CHUNK_W;
                     edgeY = i / CHUNK_W;
                     break;
                 }
             }
+        } else {
+            for (int i = lookIndex; i < size; i++) {
+                if (data[i] != 0) {
+
+                    int numBorders = 0;
+                    // if (i % CHUNK_W - 1 >= 0) numBorders += data[(i % CHUNK_W - 1) + i / CHUNK_W * CHUNK_W];
+                    // if (i / CHUNK_W - 1 >= 0) numBorders += data[(i % CHUNK_W)+(i / CHUNK_W - 1) * CHUNK_W];
+                    if (i % CHUNK_W + 1 < CHUNK_W) numBorders += data[(i % CHUNK_W + 1) + i / CHUNK_W * CHUNK_W];
+                    if (i / CHUNK_W + 1 < CHUNK_H) numBorders += data[(i % CHUNK_W) + (i / CHUNK_W + 1) * CHUNK_W];
+                    if (i / CHUNK_W + 1 < CHUNK_H && i % CHUNK_W + 1 < CHUNK_W) numBorders += data[(i % CHUNK_W + 1) + (i / CHUNK_W + 1) * CHUNK_W];
+
+                    // int val = value(i % CHUNK_W, i / CHUNK_W, CHUNK_W, height, data);
+                    if (numBorders != 3) {
+                        edgeX = i % CHUNK_W;
+                        edgeY = i / CHUNK_W;
+                        break;
+                    }
+                }
+            }
         }
 
         if (edgeX == -1) {
@@ -915,7 +1152,7 @@ found : {};
     // Ps::MarchingSquares ms = Ps::MarchingSquares(texture);
     // worldMesh = ms.extract_simple(2);
 
-    chunk->polys.clear();
+    polys.clear();
 
     std::for_each(result.begin(), result.end(), [&](TPPLPoly cur) {
         if (cur[0].x == cur[1].x && cur[1].x == cur[2].x) {
@@ -931,23 +1168,82 @@ found : {};
         b2PolygonShape sh;
         sh.Set(&vec[0], 3);
 
-        chunk->polys.push_back(sh);
+        polys.push_back(sh);
     });
+}
 
-#pragma endregion
+// 几何阶段的另一种实现: 在实心位图上贪心合并矩形
+// 每行按字取出连续实心段 与上一行 [x0, x1) 完全相同的段延伸为同一个矩形 其余的矩形封闭输出
+// 像素 (x, y) 覆盖 [x, x + 1) x [y, y + 1) 与轮廓追踪的坐标一致 覆盖范围与位图逐格相同
+void world::buildChunkMeshRects(const u64 *mask, std::vector<b2PolygonShape> &polys) {
 
-    // TODO: 世界区块的box2d碰撞
+    constexpr int W = ChunkSolidMask::ROW_WORDS;
 
-    auto texture = LoadTexture("data/assets/objects/testObject3.png");
+    struct Span {
+        int x0, x1, y0;
+    };
+
+    polys.clear();
+
+    auto emit = [&](const Span &s, int y1) {
+        b2PolygonShape sh;
+        sh.SetAsBox((s.x1 - s.x0) / 2.0f, (y1 - s.y0) / 2.0f, b2Vec2((s.x0 + s.x1) / 2.0f, (s.y0 + y1) / 2.0f), 0);
+        polys.push_back(sh);
+    };
 
-    if (chunk->rb) {
-        delete[] chunk->rb->tiles;
+    // 两行的段都按 x0 升序
+    std::vector<Span> open, row;
+    open.reserve(CHUNK_W / 2);
+    row.reserve(CHUNK_W / 2);
+
+    for (int y = 0; y <= CHUNK_H; y++) {
+        row.clear();
+        if (y < CHUNK_H) {
+            for (int k = 0; k < W; k++) {
+                u64 bits = mask[y * W + k];
+                while (bits) {
+                    int s = std::countr_zero(bits);
+                    int e = s + std::countr_zero(~(bits >> s));
+                    // 段跨越字边界时接上前一个字的段
+                    if (s == 0 && !row.empty() && row.back().x1 == k * 64) {
+                        row.back().x1 = k * 64 + e;
+                    } else {
+                        row.push_back({k * 64 + s, k * 64 + e, y});
+                    }
+                    bits = e >= 64 ? 0 : bits & (~0ull << e);
+                }
+            }
+        }
 
-        chunk->rb->chunk_clean();
+        // 两个有序列表归并 相同区间继承上一行的起始 y
+        size_t j = 0;
+        for (auto &r : row) {
+            while (j < open.size() && open[j].x0 < r.x0) emit(open[j++], y);
+            if (j < open.size() && open[j].x0 == r.x0) {
+                if (open[j].x1 == r.x1) {
+                    r.y0 = open[j].y0;
+                } else {
+                    emit(open[j], y);
+                }
+                j++;
+            }
+        }
+        while (j < open.size()) emit(open[j++], y);
 
-        delete chunk->rb;
+        open.swap(row);
     }
-    chunk->rb = makeRigidBodyMulti(b2_staticBody, chunk->x * CHUNK_W + loadZone.x, chunk->y * CHUNK_H + loadZone.y, 0, chunk->polys, 1, 0.3, texture);
+}
+
+// 提交阶段: 由多边形创建静态刚体 box2d 不是线程安全的 只能在主线程执行
+void world::commitChunkMesh(Chunk *chunk) {
+
+    if (chunk->polys.empty()) return;
+
+    // TODO: 世界区块的box2d碰撞
+
+    if (!chunkMeshTexture) chunkMeshTexture = LoadTexture("data/assets/objects/testObject3.png");
+
+    chunk->rb = makeRigidBodyMulti(b2_staticBody, chunk->x * CHUNK_W + loadZone.x, chunk->y * CHUNK_H + loadZone.y, 0, chunk->polys, 1, 0.3, chunkMeshTexture);
 
     for (b2Fixture *f = chunk->rb->body->GetFixtureList(); f; f = f->GetNext()) {
         b2Filter bf = {};
@@ -958,6 +1254,38 @@ found : {};
     worldRigidBodies.push_back(chunk->rb);
 }
 
+void world::buildChunkMeshGeometry(const u64 *mask, std::vector<b2PolygonShape> &polys) const {
+    if (meshRects) {
+        buildChunkMeshRects(mask, polys);
+    } else {
+        buildChunkMeshPolys(mask, polys);
+    }
+}
+
+void world::setMeshRects(bool rects) {
+    if (meshRects == rects) return;
+    meshRects = rects;
+
+    // 已缓存的网格按另一种方式生成 全部作废 下次 updateWorldMesh 重建
+    for (auto &p : chunkCache) {
+        for (auto &p2 : p.second) {
+            p2.second->meshCached = false;
+        }
+    }
+    lastMeshZone = {};
+}
+
+void world::updateChunkMesh(Chunk *chunk) {
+
+    std::lock_guard<std::mutex> locker(g_mutex_updatechunkmesh);
+
+    ChunkSolidMask mask;
+    if (prepareChunkMesh(chunk, mask.words)) {
+        buildChunkMeshGeometry(mask.words, chunk->polys);
+        commitChunkMesh(chunk);
+    }
+}
+
 void world::updateWorldMesh() {
 
     if (lastMeshZone.x == meshZone.x && lastMeshZone.y == meshZone.y && lastMeshZone.w == meshZone.w && lastMeshZone.h == meshZone.h) {
@@ -976,8 +1304,22 @@ void world::updateWorldMesh() {
     int maxChX = (int)std::ceil((meshZone.x + meshZone.w - loadZone.x) / CHUNK_W);
     int maxChY = (int)std::ceil((meshZone.y + meshZone.h - loadZone.y) / CHUNK_H);
 
+    Timer timer;
+    timer.start();
+    meshStats.rebuilt = 0;
+    meshStats.reused = 0;
+
+    // 加载中的临时区块不在 chunkCache 中 其网格不缓存
+    for (Chunk *ch : tempMeshChunks) {
+        releaseChunkMesh(ch);
+        ch->ChunkDelete();
+        delete ch;
+    }
+    tempMeshChunks.clear();
+
+    // 离开范围的区块刚体只禁用不销毁 回到范围内且实心格子未变时直接复用
     for (int i = 0; i < worldRigidBodies.size(); i++) {
-        b2world->DestroyBody(worldRigidBodies[i]->body);
+        worldRigidBodies[i]->body->SetEnabled(false);
     }
     worldRigidBodies.clear();
 
@@ -985,15 +1327,238 @@ void world::updateWorldMesh() {
 
     // METADOT_BUG(std::format("updateWorldMesh {0}/{1} {2}/{3}", minChX, maxChX, minChY, maxChY).c_str());
 
+    std::lock_guard<std::mutex> locker(g_mutex_updatechunkmesh);
+
+    // 主线程: 判断缓存 复制需要重建区块的实心掩码
+    struct MeshJob {
+        Chunk *chunk;
+        ChunkSolidMask mask;
+    };
+    std::vector<MeshJob> jobs;
+    ChunkSolidMask mask;
+
     for (int cx = minChX; cx <= maxChX; cx++) {
         for (int cy = minChY; cy <= maxChY; cy++) {
-            updateChunkMesh(getChunk(cx, cy));
+            Chunk *ch = getChunk(cx, cy);
+            if (ch->pleaseDelete) tempMeshChunks.push_back(ch);
+            if (!prepareChunkMesh(ch, mask.words)) continue;
+            if (meshParallel) {
+                jobs.push_back({ch, mask});
+            } else {
+                buildChunkMeshGeometry(mask.words, ch->polys);
+                commitChunkMesh(ch);
+            }
         }
     }
 
+    // 工作线程: 各区块几何互不依赖
+    std::vector<std::future<void>> results;
+    for (auto &job : jobs) {
+        results.push_back(world_sys.updateRigidBodyHitboxPool->push([this, &job](int id) { buildChunkMeshGeometry(job.mask.words, job.chunk->polys); }));
+    }
+    for (auto &r : results) r.get();
+
+    // 主线程: 按区块顺序创建刚体 与串行结果一致
+    for (auto &job : jobs) commitChunkMesh(job.chunk);
+
     // 更新区块mesh后同步
     lastMeshZone = meshZone;
     lastMeshLoadZone = loadZone;
+
+    timer.stop();
+    meshStats.lastMs = timer.get();
+    meshStats.avgMs = meshStats.avgMs * 0.9 + meshStats.lastMs * 0.1;
+}
+
+u64 world::chunkSolidMask(int chTx, int chTy, u64 *mask, bool &any) {
+    // 从世界位图中按字取出区块的实心位图 chTx 不一定按 64 对齐
+    constexpr int W = ChunkSolidMask::ROW_WORDS;
+    int off = chTx / 64;
+    int shift = chTx % 64;
+    u64 h = 0xcbf29ce484222325ull;
+    u64 acc = 0;
+    for (int y = 0; y < CHUNK_H; y++) {
+        const u64 *row = &solidBits[off + (y + chTy) * solidStride];
+        for (int k = 0; k < W; k++) {
+            u64 word = shift ? (row[k] >> shift) | (row[k + 1] << (64 - shift)) : row[k];
+            mask[y * W + k] = word;
+            acc |= word;
+            h = mixMaskHash(h, word);
+        }
+    }
+    any = acc != 0;
+    return h;
+}
+
+void world::syncSolidBits(int x, int y, int w, int h) {
+    if (solidBits.empty()) return;
+    int x0 = std::max(x, 0), x1 = std::min(x + w, (int)width);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, (int)height);
+    for (int ty = y0; ty < y1; ty++) {
+        for (int tx = x0; tx < x1; tx++) {
+            setTileBits(tx, ty, real_tiles[tx + ty * width].mat);
+        }
+    }
+}
+
+void world::syncSolidBitsDirty(int x, int y, int w, int h) {
+    if (solidBits.empty()) return;
+    int x0 = std::max(x, 0), x1 = std::min(x + w, (int)width);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, (int)height);
+    for (int ty = y0; ty < y1; ty++) {
+        int tx = x0;
+        // 8 个 dirty 标记一起判断 大部分为 0
+        for (; tx + 8 <= x1; tx += 8) {
+            u64 d;
+            memcpy(&d, &dirty[tx + ty * width], sizeof(d));
+            if (d == 0) continue;
+            for (int i = tx; i < tx + 8; i++) {
+                if (dirty[i + ty * width]) setTileBits(i, ty, real_tiles[i + ty * width].mat);
+            }
+        }
+        for (; tx < x1; tx++) {
+            if (dirty[tx + ty * width]) setTileBits(tx, ty, real_tiles[tx + ty * width].mat);
+        }
+    }
+}
+
+void world::rebuildChunkStats() {
+    ChunkStatsGrid &g = chunkStats;
+    if (real_tiles.empty()) return;
+    g.cols = (width + CHUNK_W - 1) / CHUNK_W;
+    g.rows = (height + CHUNK_H - 1) / CHUNK_H;
+    g.fire = GAME()->materials_list.FIRE.id;
+    g.blocks.assign((size_t)g.cols * g.rows, ChunkStats{});
+    for (auto &s : g.blocks) s.hist.assign(std::max(GAME()->materials_count, 1), 0);
+    size_t n = (size_t)width * height;
+    g.mat.resize(n);
+    g.fluid.resize(n);
+    g.temp.resize(n);
+    g.flags.resize(n);
+
+    for (int by = 0; by < g.rows; by++) {
+        for (int bx = 0; bx < g.cols; bx++) {
+            ChunkStats &s = g.blocks[bx + by * g.cols];
+            int x0 = bx * CHUNK_W, x1 = std::min(x0 + CHUNK_W, (int)width);
+            int y0 = by * CHUNK_H, y1 = std::min(y0 + CHUNK_H, (int)height);
+            s.minTemp = std::numeric_limits<mat_temperature>::max();
+            s.maxTemp = std::numeric_limits<mat_temperature>::min();
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) {
+                    int i = x + y * width;
+                    const MaterialInstance &t = real_tiles[i];
+                    mat_id m = t.mat != nullptr ? t.mat->id : 0;
+                    if (m >= s.hist.size()) s.hist.resize(m + 1, 0);
+                    s.hist[m]++;
+                    u8 f = g.flagsOf(t.mat);
+                    if (f & ChunkStatsGrid::ACTIVE) s.active++;
+                    if (f & ChunkStatsGrid::SOLID) s.solid++;
+                    if (f & ChunkStatsGrid::HEAT) s.heat++;
+                    f32 fl = t.mat != nullptr && t.mat->physicsType == PhysicsType::SOUP ? t.fluidAmount : 0;
+                    s.fluid += fl;
+                    s.minTemp = std::min(s.minTemp, t.temperature);
+                    s.maxTemp = std::max(s.maxTemp, t.temperature);
+                    g.mat[i] = m;
+                    g.fluid[i] = fl;
+                    g.temp[i] = t.temperature;
+                    g.flags[i] = f;
+                }
+            }
+        }
+    }
+}
+
+void world::syncChunkStats(int x, int y, int w, int h) {
+    if (chunkStats.blocks.empty()) return;
+    int x0 = std::max(x, 0), x1 = std::min(x + w, (int)width);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, (int)height);
+    for (int ty = y0; ty < y1; ty++) {
+        for (int tx = x0; tx < x1; tx++) noteTile(tx + ty * width);
+    }
+}
+
+void world::syncChunkStatsDirty(int x, int y, int w, int h) {
+    if (chunkStats.blocks.empty()) return;
+    int x0 = std::max(x, 0), x1 = std::min(x + w, (int)width);
+    int y0 = std::max(y, 0), y1 = std::min(y + h, (int)height);
+    for (int ty = y0; ty < y1; ty++) {
+        int tx = x0;
+        for (; tx + 8 <= x1; tx += 8) {
+            u64 d;
+            memcpy(&d, &dirty[tx + ty * width], sizeof(d));
+            if (d == 0) continue;
+            for (int i = tx; i < tx + 8; i++) {
+                if (dirty[i + ty * width]) noteTile(i + ty * width);
+            }
+        }
+        for (; tx < x1; tx++) {
+            if (dirty[tx + ty * width]) noteTile(tx + ty * width);
+        }
+    }
+}
+
+const ChunkStats &world::chunkStatsBlock(int bx, int by) {
+    ChunkStatsGrid &g = chunkStats;
+    ChunkStats &s = g.blocks[bx + by * g.cols];
+    if (s.tempStale) {
+        int x0 = bx * CHUNK_W, x1 = std::min(x0 + CHUNK_W, (int)width);
+        int y0 = by * CHUNK_H, y1 = std::min(y0 + CHUNK_H, (int)height);
+        s.minTemp = std::numeric_limits<mat_temperature>::max();
+        s.maxTemp = std::numeric_limits<mat_temperature>::min();
+        for (int y = y0; y < y1; y++) {
+            for (int x = x0; x < x1; x++) {
+                s.minTemp = std::min(s.minTemp, g.temp[x + y * width]);
+                s.maxTemp = std::max(s.maxTemp, g.temp[x + y * width]);
+            }
+        }
+        s.tempStale = false;
+    }
+    return s;
+}
+
+u32 world::activeCellsIn(int x, int y, int w, int h) {
+    u32 n = 0;
+    forChunkStats(x, y, w, h, [&](const ChunkStats &s) { n += s.active; });
+    return n;
+}
+
+u32 world::solidCellsIn(int x, int y, int w, int h) {
+    u32 n = 0;
+    forChunkStats(x, y, w, h, [&](const ChunkStats &s) { n += s.solid; });
+    return n;
+}
+
+u32 world::materialCellsIn(int x, int y, int w, int h, mat_id id) {
+    u32 n = 0;
+    forChunkStats(x, y, w, h, [&](const ChunkStats &s) { n += id < s.hist.size() ? s.hist[id] : 0; });
+    return n;
+}
+
+f64 world::fluidIn(int x, int y, int w, int h) {
+    f64 sum = 0;
+    forChunkStats(x, y, w, h, [&](const ChunkStats &s) { sum += s.fluid; });
+    return sum;
+}
+
+bool world::temperatureIn(int x, int y, int w, int h, mat_temperature &lo, mat_temperature &hi) {
+    bool any = false;
+    forChunkStats(x, y, w, h, [&](const ChunkStats &s) {
+        lo = any ? std::min(lo, s.minTemp) : s.minTemp;
+        hi = any ? std::max(hi, s.maxTemp) : s.maxTemp;
+        any = true;
+    });
+    return any;
+}
+
+void world::releaseChunkMesh(Chunk *chunk) {
+    if (!chunk->rb) return;
+    b2world->DestroyBody(chunk->rb->body);
+    std::erase(worldRigidBodies, chunk->rb);
+    delete[] chunk->rb->tiles;
+    chunk->rb->chunk_clean();
+    delete chunk->rb;
+    chunk->rb = nullptr;
+    chunk->meshCached = false;
 }
 
 MaterialInstance world::getTile(int x, int y) {
@@ -1005,6 +1570,14 @@ void world::setTile(int x, int y, MaterialInstance type) {
     if (x < 0 || x >= width || y < 0 || y >= height) return;
     real_tiles[x + y * width] = type;
     dirty[x + y * width] = true;
+    if (!solidBits.empty()) setTileBits(x, y, type.mat);
+    noteTile(x + y * width);
+}
+
+void world::setTileDirty(int x, int y, MaterialInstance type) {
+    if (x < 0 || x >= width || y < 0 || y >= height) return;
+    real_tiles[x + y * width] = type;
+    dirty[x + y * width] = true;
 }
 
 MaterialInstance world::getTileLayer2(int x, int y) {
@@ -1033,11 +1606,213 @@ f32 CalculateVerticalFlowValue(f32 remainingLiquid, f32 destLiquid) {
     return value;
 }
 
-void world::tick() {
+void world::planTick() {
+    TickBudget &b = tickBudget;
+    const TickLod &lod = tickLod;
+    int cellIter = std::clamp(global.game->Iso.globaldef.cell_iter, 0, 255);
+    b.cols = ((int)tickZone.w + CHUNK_W - 1) / CHUNK_W;
+    b.rows = ((int)tickZone.h + CHUNK_H - 1) / CHUNK_H;
+    int n = b.cols * b.rows;
+    b.iters.assign(n, (u8)cellIter);
+    b.scale.assign(n, 1);
+    b.ring.assign(n, 0);
+    b.workMs.assign(n, 0);
+    b.keys.resize(n);
+    b.maxIters = cellIter;
+    b.ticked = n;
+    b.deferred = 0;
+    b.reduced = 0;
+    b.sleeping = 0;
+    b.idle = 0;
+    b.skipped = 0;
+    if (n == 0 || cellIter == 0) return;
+
+    // 世界块坐标与到最近焦点的块距离 (切比雪夫)
+    std::vector<int> dist(n, 0);
+    for (int row = 0; row < b.rows; row++) {
+        for (int col = 0; col < b.cols; col++) {
+            int i = col + row * b.cols;
+            int bx = (int)std::floor(((int)tickZone.x + col * CHUNK_W - loadZone.x) / (f64)CHUNK_W);
+            int by = (int)std::floor(((int)tickZone.y + row * CHUNK_H - loadZone.y) / (f64)CHUNK_H);
+            b.keys[i] = ((u64)(u32)bx << 32) | (u32)by;
+            int cx = (int)tickZone.x + col * CHUNK_W + CHUNK_W / 2;
+            int cy = (int)tickZone.y + row * CHUNK_H + CHUNK_H / 2;
+            dist[i] = b.focus.empty() ? 0 : INT_MAX;
+            for (auto &[fx, fy] : b.focus) dist[i] = std::min(dist[i], std::max(std::abs(fx - cx) / CHUNK_W, std::abs(fy - cy) / CHUNK_H));
+        }
+    }
 
-// TODO: 如果我们只检查最后标记为dirty的tiles会怎么样
+    // 细节层次: 中环/远环按周期错开更新 更新时迭代次数乘以周期 静止的块休眠
+    if (lod.enabled && !b.focus.empty()) {
+        for (int row = 0; row < b.rows; row++) {
+            for (int col = 0; col < b.cols; col++) {
+                int i = col + row * b.cols;
+                if (dist[i] <= lod.nearRadius) continue;
+                b.ring[i] = dist[i] <= lod.midRadius ? 1 : 2;
+                int period = std::max(b.ring[i] == 1 ? lod.midPeriod : lod.farPeriod, 1);
+                int sleep = b.ring[i] == 1 ? lod.midSleep : lod.farSleep;
+
+                auto it = b.blocks.find(b.keys[i]);
+                if (sleep > 0 && it != b.blocks.end() && it->second.quiet >= sleep) {
+                    b.iters[i] = 0;
+                    b.sleeping++;
+                } else if ((tickCt + col + row) % period != 0) {
+                    b.iters[i] = 0;
+                    b.skipped++;
+                } else {
+                    b.iters[i] = (u8)std::min(cellIter * period, 255);
+                    b.scale[i] = (u8)period;
+                }
+            }
+        }
+    }
 
-// #define DEBUG_FRICTION
+    // 统计缓存: 本块与相邻的块 (外扩 1 格后相交的块) 都没有活动格子时 本块的格子扫描什么也不会做
+    // 只看本块会漏掉同一帧里后面的迭代才从邻块移进来的格子
+    if (statsSkip && !chunkStats.blocks.empty()) {
+        for (int row = 0; row < b.rows; row++) {
+            for (int col = 0; col < b.cols; col++) {
+                int i = col + row * b.cols;
+                if (b.iters[i] == 0) continue;
+                if (activeCellsIn((int)tickZone.x + col * CHUNK_W - 1, (int)tickZone.y + row * CHUNK_H - 1, CHUNK_W + 2, CHUNK_H + 2) == 0) {
+                    b.iters[i] = 0;
+                    b.idle++;
+                }
+            }
+        }
+    }
+
+    f64 threads = std::max((int)world_sys.tickPool->size(), 1);
+    std::vector<f64> cost(n);
+    f64 full = b.fixedMs;
+    for (int i = 0; i < n; i++) {
+        auto it = b.blocks.find(b.keys[i]);
+        f64 per = it != b.blocks.end() && it->second.msPerIter >= 0 ? it->second.msPerIter : b.avgMsPerIter;
+        cost[i] = per * b.iters[i] / threads;
+        full += cost[i];
+    }
+
+    auto commit = [&]() {
+        b.ticked = 0;
+        for (int i = 0; i < n; i++) {
+            if (b.iters[i] == 0) continue;
+            b.blocks[b.keys[i]].lastTick = tickCt;
+            b.ticked++;
+        }
+        b.maxIters = *std::max_element(b.iters.begin(), b.iters.end());
+        // 离开 tickZone 的块不再保留
+        if (b.blocks.size() > (size_t)n * 4) {
+            phmap::flat_hash_map<u64, TickBudget::Block> keep;
+            for (int i = 0; i < n; i++) {
+                auto it = b.blocks.find(b.keys[i]);
+                if (it != b.blocks.end()) keep.emplace(it->first, it->second);
+            }
+            b.blocks.swap(keep);
+        }
+    };
+
+    // 空闲时全部更新
+    if (b.budgetMs <= 0 || full <= b.budgetMs) {
+        commit();
+        return;
+    }
+
+    auto isNear = [&](int i) { return !b.focus.empty() && dist[i] <= b.nearRadius; };
+    int nearCount = 0;
+    f64 nearCost = 0;
+    for (int i = 0; i < n; i++) {
+        if (b.iters[i] > 0 && isNear(i)) {
+            nearCount++;
+            nearCost += cost[i];
+        }
+    }
+
+    // 近处也超预算时按比例减少迭代次数
+    int nearIters = cellIter;
+    while (nearCount > 0 && nearIters > 1 && b.fixedMs + nearCost * nearIters / cellIter > b.budgetMs) nearIters--;
+    f64 used = b.fixedMs + nearCost * nearIters / cellIter;
+    auto reduce = [&](int i) {
+        if (nearIters == cellIter) return;
+        b.iters[i] = (u8)std::max(b.iters[i] * nearIters / cellIter, 1);
+        b.reduced++;
+    };
+
+    // 远处按距上次更新的帧数从久到近 同样久的先更新离焦点近的
+    // 最久没更新的一块总会更新 保证远处在持续过载时也能轮到
+    std::vector<std::tuple<int, int, int>> far;
+    for (int i = 0; i < n; i++) {
+        if (b.iters[i] == 0) continue;
+        if (isNear(i)) {
+            reduce(i);
+            continue;
+        }
+        auto it = b.blocks.find(b.keys[i]);
+        int age = it != b.blocks.end() ? tickCt - it->second.lastTick : INT_MAX;
+        far.emplace_back(-age, dist[i], i);
+    }
+    std::sort(far.begin(), far.end());
+    for (size_t k = 0; k < far.size(); k++) {
+        int i = std::get<2>(far[k]);
+        if (k == 0) {
+            used += cost[i] * nearIters / cellIter;
+            reduce(i);
+        } else if (nearIters == cellIter && used + cost[i] <= b.budgetMs) {
+            used += cost[i];
+        } else {
+            b.iters[i] = 0;
+            b.deferred++;
+        }
+    }
+    commit();
+}
+
+void world::finishTick(f64 ms) {
+    TickBudget &b = tickBudget;
+    b.usedMs = (f32)ms;
+
+    f64 work = 0;
+    int blockIters = 0;
+    for (int i = 0; i < (int)b.iters.size(); i++) {
+        if (b.iters[i] == 0) continue;
+        f32 per = b.workMs[i] / b.iters[i];
+        TickBudget::Block &blk = b.blocks[b.keys[i]];
+        blk.msPerIter = blk.msPerIter < 0 ? per : blk.msPerIter * 0.7f + per * 0.3f;
+        work += b.workMs[i];
+        blockIters += b.iters[i];
+    }
+
+    // 中环/远环的休眠判断: 块内或边上一格有 dirty 即为有改动
+    // 更新过且没有改动时静止计数加一 有改动时清零
+    if (tickLod.enabled) {
+        for (int row = 0; row < b.rows; row++) {
+            for (int col = 0; col < b.cols; col++) {
+                int i = col + row * b.cols;
+                if (b.ring[i] == 0) continue;
+                int x0 = std::max((int)tickZone.x + col * CHUNK_W - 1, 0), x1 = std::min((int)tickZone.x + (col + 1) * CHUNK_W + 1, (int)width);
+                int y0 = std::max((int)tickZone.y + row * CHUNK_H - 1, 0), y1 = std::min((int)tickZone.y + (row + 1) * CHUNK_H + 1, (int)height);
+                bool changed = false;
+                for (int y = y0; y < y1 && !changed; y++) {
+                    changed = memchr(&dirty[x0 + y * width], true, x1 - x0) != nullptr;
+                }
+                TickBudget::Block &blk = b.blocks[b.keys[i]];
+                if (changed) blk.quiet = 0;
+                else if (b.iters[i] > 0) blk.quiet++;
+            }
+        }
+    }
+
+    if (blockIters == 0) return;
+
+    f64 threads = std::max((int)world_sys.tickPool->size(), 1);
+    b.avgMsPerIter = b.avgMsPerIter * 0.9 + work / blockIters * 0.1;
+    b.fixedMs = b.fixedMs * 0.9 + std::max(ms - work / threads, 0.0) * 0.1;
+}
+
+void world::tick() {
+
+// TODO: 如果我们只检查最后标记为dirty的tiles会怎么样
+
+// #define DEBUG_FRICTION
 // #define DO_REVERSE
 #define DO_MULTITHREADING 1
 
@@ -1046,865 +1821,1047 @@ void world::tick() {
     memset(tickVisited1, false, (size_t)width * height);
 #endif
 
-    // TODO: 尝试找到一种方法来优化这个循环，因为液体需要高迭代次数
-    for (int iter = 0; iter < global.game->Iso.globaldef.cell_iter; iter++) {
-
-#ifdef DO_REVERSE
-        bool reverseX = (tickCt + iter) % 2 == 0;
-#else
-        bool reverseX = false;
-#endif
-        for (int tk = 0; tk < 4; tk++) {
-
-            int chOfsX = tk % 2;              // 0 1 0 1
-            int chOfsY = 1 - ((tk % 4) / 2);  // 1 1 0 0
+    const MaterialInteractionTable &interactions = GAME()->materials_interactions;
+
+    Timer tickTimer;
+    tickTimer.start();
+    // 上一次画面 dirty 处理之后直接写入 real_tiles 的改动 休眠判断前计入统计缓存
+    // planTick 只看 tickZone 外扩 1 格相交的统计块 同步 tickZone 外扩一块就够 其余的 dirty 留给画面 dirty 处理
+    syncChunkStatsDirty((int)tickZone.x - CHUNK_W, (int)tickZone.y - CHUNK_H, (int)tickZone.w + 2 * CHUNK_W, (int)tickZone.h + 2 * CHUNK_H);
+    planTick();
+    TickBudget &budget = tickBudget;
+
+    // 边带宽度 取 tickBlock 内部格子读写的最远距离 保证所有块内部同时扫描时不读写到相邻块的内部
+    // 左右/向上: 火焰读写 ±2 格 向下: 沙子摩擦柱检查读 y+1..y+10 (下方块内部最多写到它的第 0 行)
+    // 相互作用范围更大时放宽 块内部放不下时退回 4 相棋盘
+    TickExchange &ex = tickExchange;
+    ex.side = std::max(2, interactions.reach);
+    ex.top = std::max(2, interactions.reach);
+    ex.bottom = std::max(11, interactions.reach);
+    const bool exchange = DO_MULTITHREADING && borderExchange && ex.side * 2 < CHUNK_W && ex.top + ex.bottom < CHUNK_H;
+    ex.outbox.resize(budget.iters.size());
+    ex.cells.assign(budget.iters.size(), 0);
+    ex.deferred = 0;
+    f64 mergeMs = 0;
+
+    // 液体平面要在世界内留出 2 格墙
+    const bool fluids = fluidPass && budget.cols > 0 && budget.rows > 0 && tickZone.x >= 2 && tickZone.y >= 2 && (int)tickZone.x + budget.cols * CHUNK_W + 2 <= width &&
+                        (int)tickZone.y + budget.rows * CHUNK_H + 2 <= height && GAME()->materials_container.size() < FluidPlanes::WALL;
+
+    // 空气/固体等格子扫描时什么也不做 不必进 outbox
+    auto needsTick = [&](const MaterialInstance &t) {
+        int type = t.mat->physicsType;
+        return type == PhysicsType::SAND || type == PhysicsType::SOUP || type == PhysicsType::GAS || t.mat->id == GAME()->materials_list.FIRE.id;
+    };
 
-#if DO_MULTITHREADING
-            std::vector<std::future<std::vector<CellData *>>> results = {};
-#endif
-#if DO_MULTITHREADING
-            bool *tickVisited = whichTickVisited ? tickVisited2 : tickVisited1;
-            std::future<void> tickVisitedDone = world_sys.tickVisitedPool->push([&](int id) { memset(whichTickVisited ? tickVisited1 : tickVisited2, false, (size_t)width * height); });
-#else
-            bool *tickVisited = tickVisited1;
-            memset(tickVisited1, false, width * height);
-#endif
+    // 块 [cx, cx + CHUNK_W) x [cy, cy + CHUNK_H) 去掉边带后的行段 从下往上 边带为 0 时是整块
+    auto blockSegs = [&](int cx, int cy, int side, int top, int bottom) {
+        std::vector<TickExchange::Seg> segs;
+        segs.reserve(CHUNK_H);
+        for (int y = cy + CHUNK_H - 1 - bottom; y >= cy + top; y--) segs.push_back({y, cx + side, cx + CHUNK_W - side});
+        return segs;
+    };
 
-            for (int cx = tickZone.x + chOfsX * CHUNK_W; cx < (tickZone.x + tickZone.w); cx += CHUNK_W * 2) {
-                for (int cy = tickZone.y + chOfsY * CHUNK_H; cy < (tickZone.y + tickZone.h); cy += CHUNK_H * 2) {
+    // 内部扫描之后 边带里需要更新且本次迭代还没动过的格子按扫描顺序合成行段
+    auto fillOutbox = [&](int cx, int cy, int block, bool *tickVisited) {
+        std::vector<TickExchange::Seg> &out = ex.outbox[block];
+        int n = 0;
+        auto add = [&](int y, int x0, int x1) {
+            for (int x = x0; x < x1; x++) {
+                int index = x + y * width;
+                if (tickVisited[index] || !needsTick(real_tiles[index])) continue;
+                if (!out.empty() && out.back().y == y && out.back().x1 == x) {
+                    out.back().x1++;
+                } else {
+                    out.push_back({y, x, x + 1});
+                }
+                n++;
+            }
+        };
+        for (int y = cy + CHUNK_H - 1; y >= cy; y--) {
+            if (y >= cy + CHUNK_H - ex.bottom || y < cy + ex.top) {
+                add(y, cx, cx + CHUNK_W);
+            } else {
+                add(y, cx, cx + ex.side);
+                add(y, cx + CHUNK_W - ex.side, cx + CHUNK_W);
+            }
+        }
+        ex.cells[block] = n;
+    };
 
-#if DO_MULTITHREADING
-                    results.push_back(world_sys.tickPool->push([&, cx, cy](int id) {
-                        std::vector<CellData *> parts = {};
+    // 按 segs 扫描一个块 segs 中的行段按原先整块扫描的顺序排列
+    // 水落在岩浆上: 水变蒸汽 下方 3x3 范围的岩浆变黑曜石 液体平面开启时也在格子扫描里处理
+    auto quenchLava = [&](int x, int y, const MaterialInstance &tile, const MaterialInstance &belowTile, bool *tickVisited) {
+        if (tile.mat->id != GAME()->materials_list.WATER.id || belowTile.mat->id != GAME()->materials_list.LAVA.id) return false;
+        int index = x + y * width;
+        real_tiles[index] = TilesCreateSteam();
+        dirty[index] = true;
+        real_tiles[(x) + (y + 1) * width] = TilesCreateObsidian(x, y + 1);
+        dirty[(x) + (y + 1) * width] = true;
+        tickVisited[(x) + (y + 1) * width] = true;
+
+        for (int xx = -1; xx <= 1; xx++) {
+            for (int yy = 0; yy <= 2; yy++) {
+                if (real_tiles[(x + xx) + (y + yy) * width].mat->id == GAME()->materials_list.LAVA.id) {
+                    real_tiles[(x + xx) + (y + yy) * width] = TilesCreateObsidian(x + xx, y + yy);
+                    dirty[(x + xx) + (y + yy) * width] = true;
+                    tickVisited[(x + xx) + (y + yy) * width] = true;
+                }
+            }
+        }
+        return true;
+    };
 
+    // 整块扫描 (4 相棋盘) 内部扫描与 outbox 合并都走这里
+    auto tickBlock = [&](int block, int iter, bool *tickVisited, const std::vector<TickExchange::Seg> &segs) {
+        std::vector<CellData> parts = {};
+        Timer blockTimer;
+        blockTimer.start();
+        // 低细节层次的块隔几帧更新一次 材料迭代上限按周期放大
+        const int iterScale = budget.scale[block];
+#ifdef DO_REVERSE
+        bool reverseX = (tickCt + iter) % 2 == 0;
 #else
-
+        bool reverseX = false;
 #endif
 
-                        for (int dy = CHUNK_H - 1; dy >= 0; dy--) {
-                            int y = cy + dy;
-                            for (int dxf = 0; dxf < CHUNK_W; dxf++) {
-                                int dx = reverseX ? (CHUNK_W - 1) - dxf : dxf;
-                                int x = cx + dx;
-                                int index = x + y * width;
+        for (const TickExchange::Seg &seg : segs) {
+            int y = seg.y;
+            for (int xf = seg.x0; xf < seg.x1; xf++) {
+                int x = reverseX ? seg.x0 + seg.x1 - 1 - xf : xf;
+                int index = x + y * width;
 
-                                if (tickVisited[index]) continue;
+                if (tickVisited[index]) continue;
 
-                                if (iter >= real_tiles[index].mat->iterations) {
-                                    tickVisited[index] = true;
-                                    continue;
-                                }
-                                MaterialInstance tile = real_tiles[index];
+                if (iter >= real_tiles[index].mat->iterations * iterScale) {
+                    tickVisited[index] = true;
+                    continue;
+                }
+                MaterialInstance tile = real_tiles[index];
 
-                                int type = tile.mat->physicsType;
+                int type = tile.mat->physicsType;
 
-                                if (tile.mat->id == GAME()->materials_list.FIRE.id) {
-                                    if (rand() % 10 == 0) {
-                                        u32 rgb = 255;
-                                        rgb = (rgb << 8) + 100 + rand() % 50;
-                                        rgb = (rgb << 8) + 50;
-                                        tile.color = rgb;
-                                    }
+                if (tile.mat->id == GAME()->materials_list.FIRE.id) {
+                    if (rand() % 10 == 0) {
+                        u32 rgb = 255;
+                        rgb = (rgb << 8) + 100 + rand() % 50;
+                        rgb = (rgb << 8) + 50;
+                        tile.color = rgb;
+                    }
 
-                                    if (rand() % 10 == 0) {
-                                        CellData *p = new CellData(tile, x, y - 1, (rand() % 10 - 5) / 20.0f, -((rand() % 10) / 10.0f) / 3.0f + -0.5f, 0, 0.01f);
-                                        p->temporary = true;
-                                        p->lifetime = 30;
-                                        p->fadeTime = 10;
+                    if (rand() % 10 == 0) {
+                        CellData p(tile, x, y - 1, (rand() % 10 - 5) / 20.0f, -((rand() % 10) / 10.0f) / 3.0f + -0.5f, 0, 0.01f);
+                        p.temporary = true;
+                        p.lifetime = 30;
+                        p.fadeTime = 10;
 #if DO_MULTITHREADING
-                                        parts.push_back(p);
+                        parts.push_back(p);
 #else
-                                    cells.push_back(p);
+                    cells.add(p);
 #endif
-                                    }
+                    }
 
-                                    if (rand() % 150 == 0) {
-                                        // tiles[index] = TilesCreateSteam();
-                                        real_tiles[index] = Tiles_NOTHING;
-                                        dirty[index] = true;
-                                        tickVisited[index] = true;
-                                    } else {
-                                        bool foundAny = false;
-                                        for (int xx = -2; xx <= 2; xx++) {
-                                            for (int yy = -2; yy <= 2; yy++) {
-                                                if (real_tiles[(x + xx) + (y + yy) * width].mat->physicsType == PhysicsType::SOLID) {
-                                                    foundAny = true;
-                                                    if (rand() % 500 == 0) {
-                                                        real_tiles[(x + xx) + (y + yy) * width] = TilesCreateFire();
-                                                        dirty[(x + xx) + (y + yy) * width] = true;
-                                                        tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        if (!foundAny && rand() % 120 == 0) {
-                                            real_tiles[index] = Tiles_NOTHING;
-                                            dirty[index] = true;
-                                            tickVisited[index] = true;
-                                        }
+                    if (rand() % 150 == 0) {
+                        // tiles[index] = TilesCreateSteam();
+                        real_tiles[index] = Tiles_NOTHING;
+                        dirty[index] = true;
+                        tickVisited[index] = true;
+                    } else {
+                        bool foundAny = false;
+                        for (int xx = -2; xx <= 2; xx++) {
+                            for (int yy = -2; yy <= 2; yy++) {
+                                if (real_tiles[(x + xx) + (y + yy) * width].mat->physicsType == PhysicsType::SOLID) {
+                                    foundAny = true;
+                                    if (rand() % 500 == 0) {
+                                        real_tiles[(x + xx) + (y + yy) * width] = TilesCreateFire();
+                                        dirty[(x + xx) + (y + yy) * width] = true;
+                                        tickVisited[(x + xx) + (y + yy) * width] = true;
                                     }
                                 }
+                            }
+                        }
+                        if (!foundAny && rand() % 120 == 0) {
+                            real_tiles[index] = Tiles_NOTHING;
+                            dirty[index] = true;
+                            tickVisited[index] = true;
+                        }
+                    }
+                }
 
-                                if (type == PhysicsType::SAND) {
-                                    // active[index] = true;
-                                    MaterialInstance belowTile = real_tiles[x + (y + 1) * width];
-                                    int below = belowTile.mat->physicsType;
-
-                                    if (tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < GAME()->materials_count && tile.mat->nInteractions[belowTile.mat->id] > 0) {
-                                        for (int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
-                                            MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
-                                            if (in.type == INTERACT_TRANSFORM_MATERIAL) {
-                                                for (int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                                    for (int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                                        if (real_tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
-                                                            real_tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1]->id, x + xx, y + yy);
-                                                            dirty[(x + xx) + (y + yy) * width] = true;
-                                                            tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                        }
-                                                    }
-                                                }
-                                            } else if (in.type == INTERACT_SPAWN_MATERIAL) {
-                                                for (int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                                    for (int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                                        if ((xx == 0 && yy == 0) || real_tiles[(x + xx) + (y + yy) * width].mat->id == Tiles_NOTHING.mat->id) {
-                                                            real_tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1]->id, x + xx, y + yy);
-                                                            dirty[(x + xx) + (y + yy) * width] = true;
-                                                            tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                        }
-                                                    }
-                                                }
-                                            }
-                                        }
-                                        continue;
+                if (type == PhysicsType::SAND) {
+                    // active[index] = true;
+                    MaterialInstance belowTile = real_tiles[x + (y + 1) * width];
+                    int below = belowTile.mat->physicsType;
+
+                    auto interact = [&](const MaterialInteraction &in) {
+                        if (in.type == INTERACT_TRANSFORM_MATERIAL) {
+                            for (int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                                for (int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                                    if (real_tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
+                                        real_tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1]->id, x + xx, y + yy);
+                                        dirty[(x + xx) + (y + yy) * width] = true;
+                                        tickVisited[(x + xx) + (y + yy) * width] = true;
                                     }
-
-                                    if (tile.mat->react && tile.mat->nReactions > 0) {
-                                        bool react = false;
-                                        for (int i = 0; i < tile.mat->nReactions; i++) {
-                                            MaterialInteraction in = tile.mat->reactions[i];
-                                            if (in.type == REACT_TEMPERATURE_BELOW) {
-                                                if (tile.temperature < in.data1) {
-                                                    real_tiles[index] = TilesCreate(GAME()->materials_container[in.data2]->id, x, y);
-                                                    real_tiles[index].temperature = tile.temperature;
-                                                    dirty[index] = true;
-                                                    tickVisited[index] = true;
-                                                    react = true;
-                                                }
-                                            } else if (in.type == REACT_TEMPERATURE_ABOVE) {
-                                                if (tile.temperature > in.data1) {
-                                                    real_tiles[index] = TilesCreate(GAME()->materials_container[in.data2]->id, x, y);
-                                                    real_tiles[index].temperature = tile.temperature;
-                                                    dirty[index] = true;
-                                                    tickVisited[index] = true;
-                                                    react = true;
-                                                }
-                                            }
-                                        }
-                                        if (react) continue;
+                                }
+                            }
+                        } else if (in.type == INTERACT_SPAWN_MATERIAL) {
+                            for (int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                                for (int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                                    if ((xx == 0 && yy == 0) || real_tiles[(x + xx) + (y + yy) * width].mat->id == Tiles_NOTHING.mat->id) {
+                                        real_tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1]->id, x + xx, y + yy);
+                                        dirty[(x + xx) + (y + yy) * width] = true;
+                                        tickVisited[(x + xx) + (y + yy) * width] = true;
                                     }
+                                }
+                            }
+                        }
+                    };
 
-                                    bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
-                                    if (!canMoveBelow) continue;
+                    if (interactTable) {
+                        if (interactions.has(tile.mat->id, belowTile.mat->id)) {
+                            for (const MaterialInteraction *in = interactions.begin(tile.mat->id, belowTile.mat->id); in != interactions.end(tile.mat->id, belowTile.mat->id); in++) interact(*in);
+                            continue;
+                        }
+                    } else if (tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < GAME()->materials_count && tile.mat->nInteractions[belowTile.mat->id] > 0) {
+                        for (int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
+                            MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
+                            interact(in);
+                        }
+                        continue;
+                    }
 
-                                    MaterialInstance belowLTile = real_tiles[(x - 1) + (y + 1) * width];
-                                    int belowL = belowLTile.mat->physicsType;
-                                    MaterialInstance belowRTile = real_tiles[(x + 1) + (y + 1) * width];
-                                    int belowR = belowRTile.mat->physicsType;
+                    if (tile.mat->react && tile.mat->nReactions > 0) {
+                        bool react = false;
+                        for (int i = 0; i < tile.mat->nReactions; i++) {
+                            MaterialInteraction in = tile.mat->reactions[i];
+                            if (in.type == REACT_TEMPERATURE_BELOW) {
+                                if (tile.temperature < in.data1) {
+                                    real_tiles[index] = TilesCreate(GAME()->materials_container[in.data2]->id, x, y);
+                                    real_tiles[index].temperature = tile.temperature;
+                                    dirty[index] = true;
+                                    tickVisited[index] = true;
+                                    react = true;
+                                }
+                            } else if (in.type == REACT_TEMPERATURE_ABOVE) {
+                                if (tile.temperature > in.data1) {
+                                    real_tiles[index] = TilesCreate(GAME()->materials_container[in.data2]->id, x, y);
+                                    real_tiles[index].temperature = tile.temperature;
+                                    dirty[index] = true;
+                                    tickVisited[index] = true;
+                                    react = true;
+                                }
+                            }
+                        }
+                        if (react) continue;
+                    }
+
+                    bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
+                    if (!canMoveBelow) continue;
+
+                    MaterialInstance belowLTile = real_tiles[(x - 1) + (y + 1) * width];
+                    int belowL = belowLTile.mat->physicsType;
+                    MaterialInstance belowRTile = real_tiles[(x + 1) + (y + 1) * width];
+                    int belowR = belowRTile.mat->physicsType;
 
-                                    bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                    bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+                    bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                    bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
 
-                                    if (canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 20 == 0)) {
-                                        if (belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR &&
-                                            getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
-                                            setTile(x, y, belowTile);
+                    if (canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 20 == 0)) {
+                        if (belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR &&
+                            getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
+                            setTileDirty(x, y, belowTile);
 #if DO_MULTITHREADING
-                                            parts.push_back(new CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                            parts.emplace_back(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f);
 #else
-                                        cells.push_back(new CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                        cells.add(CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
 #endif
-                                        } else {
-                                            real_tiles[index] = belowTile;
-                                            dirty[index] = true;
-                                            // setTile(x, y, belowTile);
-                                            // setTile(x, y + 1, tile);
-                                            if (rand() % 2 == 0) {
-                                                tile.moved = true;
+                        } else {
+                            real_tiles[index] = belowTile;
+                            dirty[index] = true;
+                            // setTile(x, y, belowTile);
+                            // setTile(x, y + 1, tile);
+                            if (rand() % 2 == 0) {
+                                tile.moved = true;
 #ifdef DEBUG_FRICTION
-                                                tile.color = 0xffffffff;
+                                tile.color = 0xffffffff;
 #endif
-                                            }
-                                            real_tiles[(x) + (y + 1) * width] = tile;
-                                            dirty[(x) + (y + 1) * width] = true;
-                                            tickVisited[x + (y + 1) * width] = true;
-                                        }
-
-                                        int selfTrasmitMovementChance = 2;
-
-                                        if (rand() % selfTrasmitMovementChance == 0) {
-                                            if (x > 0 && real_tiles[(x - 1) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
-                                                int otherTransmitMovementChance = 2;
-                                                if (rand() % otherTransmitMovementChance == 0) {
-                                                    real_tiles[(x - 1) + (y + 1) * width].moved = true;
+                            }
+                            real_tiles[(x) + (y + 1) * width] = tile;
+                            dirty[(x) + (y + 1) * width] = true;
+                            tickVisited[x + (y + 1) * width] = true;
+                        }
+
+                        int selfTrasmitMovementChance = 2;
+
+                        if (rand() % selfTrasmitMovementChance == 0) {
+                            if (x > 0 && real_tiles[(x - 1) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
+                                int otherTransmitMovementChance = 2;
+                                if (rand() % otherTransmitMovementChance == 0) {
+                                    real_tiles[(x - 1) + (y + 1) * width].moved = true;
 #ifdef DEBUG_FRICTION
-                                                    real_tiles[(x - 1) + (y + 1) * width].color = 0xff00ffff;
-                                                    dirty[(x - 1) + (y + 1) * width] = true;
+                                    real_tiles[(x - 1) + (y + 1) * width].color = 0xff00ffff;
+                                    dirty[(x - 1) + (y + 1) * width] = true;
 #endif
-                                                }
-                                            }
+                                }
+                            }
 
-                                            if (x < width - 1 && real_tiles[(x + 1) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
-                                                int otherTransmitMovementChance = 2;
-                                                if (rand() % otherTransmitMovementChance == 0) {
-                                                    real_tiles[(x + 1) + (y + 1) * width].moved = true;
+                            if (x < width - 1 && real_tiles[(x + 1) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
+                                int otherTransmitMovementChance = 2;
+                                if (rand() % otherTransmitMovementChance == 0) {
+                                    real_tiles[(x + 1) + (y + 1) * width].moved = true;
 #ifdef DEBUG_FRICTION
-                                                    real_tiles[(x + 1) + (y + 1) * width].color = 0xff00ffff;
-                                                    dirty[(x + 1) + (y + 1) * width] = true;
+                                    real_tiles[(x + 1) + (y + 1) * width].color = 0xff00ffff;
+                                    dirty[(x + 1) + (y + 1) * width] = true;
 #endif
-                                                }
-                                            }
-                                        }
-                                    }
+                                }
+                            }
+                        }
+                    }
 
-                                } else if (type == PhysicsType::SOUP) {
+                } else if (type == PhysicsType::SOUP) {
 
-                                    // based on https://github.com/jongallant/LiquidSimulator (MIT License)
+                    // based on https://github.com/jongallant/LiquidSimulator (MIT License)
 
-                                    // NOTE: for liquids, tile.moved is tile.settled in the original algorithm
+                    // NOTE: for liquids, tile.moved is tile.settled in the original algorithm
 
-                                    if (tile.fluidAmount == 0.0f) continue;
+                    if (tile.fluidAmount == 0.0f) continue;
 
-                                    if (tile.fluidAmount < FLUID_MinValue) {
-                                        tile.fluidAmount = 0.0f;
-                                        real_tiles[index] = tile;
-                                        continue;
-                                    }
+                    if (tile.fluidAmount < FLUID_MinValue) {
+                        tile.fluidAmount = 0.0f;
+                        real_tiles[index] = tile;
+                        continue;
+                    }
 
-                                    if (tile.fluidAmount > 0.005 && getTile(x, y + 1).mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR &&
-                                        getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
-                                        setTile(x, y, Tiles_NOTHING);
+                    if (tile.fluidAmount > 0.005 && getTile(x, y + 1).mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR &&
+                        getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
+                        setTileDirty(x, y, Tiles_NOTHING);
 
-                                        int n = tile.fluidAmount / 4;
-                                        if (n < 1) n = 1;
+                        int n = tile.fluidAmount / 4;
+                        if (n < 1) n = 1;
 
-                                        for (int i = 0; i < n; i++) {
-                                            f32 amt = tile.fluidAmount / n;
+                        for (int i = 0; i < n; i++) {
+                            f32 amt = tile.fluidAmount / n;
 
-                                            MaterialInstance nt = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                            nt.fluidAmount = amt;
-                                            nt.fluidAmountDiff = 0;
-                                            nt.moved = false;
+                            MaterialInstance nt = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                            nt.fluidAmount = amt;
+                            nt.fluidAmountDiff = 0;
+                            nt.moved = false;
 #if DO_MULTITHREADING
-                                            parts.push_back(new CellData(nt, x, y + 1, (rand() % 10 - 5) / 30.0f, -((rand() % 2) + 3) / 10.0f + 1.0f, 0, 0.1f));
+                            parts.emplace_back(nt, x, y + 1, (rand() % 10 - 5) / 30.0f, -((rand() % 2) + 3) / 10.0f + 1.0f, 0, 0.1f);
 #else
-                                        cells.push_back(new CellData(nt, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                        cells.add(CellData(nt, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
 #endif
-                                        }
+                        }
 
-                                        continue;
-                                    }
+                        continue;
+                    }
 
-                                    if (tile.moved) continue;
-
-                                    f32 startValue = tile.fluidAmount;
-                                    f32 remainingValue = tile.fluidAmount;
-
-                                    MaterialInstance bottom = real_tiles[(x) + (y + 1) * width];
-
-                                    bool airBelow = bottom.mat->physicsType == PhysicsType::AIR;
-                                    if ((airBelow && iter <= 2) || (bottom.mat->id == tile.mat->id)) {
-                                        f32 dstFl = bottom.mat->physicsType == PhysicsType::SOUP ? bottom.fluidAmount : 0.0f;
-
-                                        f32 flow = CalculateVerticalFlowValue(startValue, dstFl) - dstFl;
-                                        if (bottom.fluidAmount > 0 && flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
-
-                                        flow = std::max(flow, 0.0f);
-                                        if (flow > std::min(FLUID_MaxFlow, startValue)) flow = std::min(FLUID_MaxFlow, startValue);
-
-                                        if (flow != 0) {
-                                            remainingValue -= flow;
-                                            tile.fluidAmountDiff -= flow;
-                                            if (bottom.mat->physicsType == PhysicsType::AIR) {
-                                                real_tiles[(x) + (y + 1) * width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                                real_tiles[(x) + (y + 1) * width].fluidAmount = 0.0f;
-                                            }
-                                            real_tiles[(x) + (y + 1) * width].fluidAmountDiff += flow;
-                                            // tiles[(x)+(y + 1) * width].moved = true;
-                                        }
-                                        flowY[index] += flow;
-                                    } else if (iter == 0 && bottom.mat->physicsType == PhysicsType::SOUP && (bottom.mat->id != tile.mat->id)) {
-                                        if (rand() % 10 == 0) {
-                                            real_tiles[index] = bottom;
-                                            real_tiles[(x) + (y + 1) * width] = tile;
-                                            continue;
-                                        }
-                                    }
+                    // 液量交换由 tickFluids 处理 这里只保留不同液体的上下交换与水/岩浆反应
+                    // 交换要标记 dirty 统计缓存在 tick 末尾按 dirty 同步 (合并阶段上下两块可能同时写中间块 不能在这里直接计入)
+                    if (fluids) {
+                        MaterialInstance bottom = real_tiles[(x) + (y + 1) * width];
+                        if (iter == 0) {
+                            MaterialInstance top = real_tiles[(x) + (y - 1) * width];
+                            if (bottom.mat->physicsType == PhysicsType::SOUP && bottom.mat->id != tile.mat->id && rand() % 10 == 0) {
+                                real_tiles[index] = bottom;
+                                real_tiles[(x) + (y + 1) * width] = tile;
+                                dirty[index] = true;
+                                dirty[(x) + (y + 1) * width] = true;
+                                continue;
+                            } else if (top.mat->physicsType == PhysicsType::SOUP && top.mat->id != tile.mat->id && rand() % 10 == 0) {
+                                real_tiles[index] = top;
+                                real_tiles[(x) + (y - 1) * width] = tile;
+                                dirty[index] = true;
+                                dirty[(x) + (y - 1) * width] = true;
+                                continue;
+                            }
+                        }
+                        quenchLava(x, y, tile, bottom, tickVisited);
+                        continue;
+                    }
 
-                                    if (remainingValue < FLUID_MinValue) {
-                                        tile.fluidAmountDiff -= remainingValue;
-                                        real_tiles[index] = tile;
-                                        continue;
-                                    }
+                    if (tile.moved) continue;
 
-                                    MaterialInstance left = real_tiles[(x - 1) + (y)*width];
-                                    bool canMoveLeft = (left.mat->physicsType == PhysicsType::AIR || (left.mat->id == tile.mat->id)) && !airBelow;
+                    f32 startValue = tile.fluidAmount;
+                    f32 remainingValue = tile.fluidAmount;
 
-                                    MaterialInstance right = real_tiles[(x + 1) + (y)*width];
-                                    bool canMoveRight = (right.mat->physicsType == PhysicsType::AIR || (right.mat->id == tile.mat->id)) && !airBelow;
+                    MaterialInstance bottom = real_tiles[(x) + (y + 1) * width];
 
-                                    if (canMoveLeft) {
-                                        f32 dstFl = left.mat->physicsType == PhysicsType::SOUP ? left.fluidAmount : 0.0f;
+                    bool airBelow = bottom.mat->physicsType == PhysicsType::AIR;
+                    if ((airBelow && iter <= 2) || (bottom.mat->id == tile.mat->id)) {
+                        f32 dstFl = bottom.mat->physicsType == PhysicsType::SOUP ? bottom.fluidAmount : 0.0f;
 
-                                        f32 flow = (remainingValue - dstFl) / (canMoveRight ? 3.0f : 2.0f);
-                                        if (flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
+                        f32 flow = CalculateVerticalFlowValue(startValue, dstFl) - dstFl;
+                        if (bottom.fluidAmount > 0 && flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
 
-                                        flow = std::max(flow, 0.0f);
-                                        if (flow > std::min(FLUID_MaxFlow, remainingValue)) flow = std::min(FLUID_MaxFlow, remainingValue);
+                        flow = std::max(flow, 0.0f);
+                        if (flow > std::min(FLUID_MaxFlow, startValue)) flow = std::min(FLUID_MaxFlow, startValue);
 
-                                        if (flow != 0) {
-                                            remainingValue -= flow;
-                                            tile.fluidAmountDiff -= flow;
-                                            if (left.mat->physicsType == PhysicsType::AIR) {
-                                                real_tiles[(x - 1) + (y)*width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                                real_tiles[(x - 1) + (y)*width].fluidAmount = 0.0f;
-                                            }
-                                            real_tiles[(x - 1) + (y)*width].fluidAmountDiff += flow;
-                                            // tiles[(x - 1) + (y)*width].moved = true;
-                                        }
-                                        flowX[index] -= flow;
-                                    }
+                        if (flow != 0) {
+                            remainingValue -= flow;
+                            tile.fluidAmountDiff -= flow;
+                            if (bottom.mat->physicsType == PhysicsType::AIR) {
+                                real_tiles[(x) + (y + 1) * width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                                real_tiles[(x) + (y + 1) * width].fluidAmount = 0.0f;
+                            }
+                            real_tiles[(x) + (y + 1) * width].fluidAmountDiff += flow;
+                            // tiles[(x)+(y + 1) * width].moved = true;
+                        }
+                        flowY[index] += flow;
+                    } else if (iter == 0 && bottom.mat->physicsType == PhysicsType::SOUP && (bottom.mat->id != tile.mat->id)) {
+                        if (rand() % 10 == 0) {
+                            real_tiles[index] = bottom;
+                            real_tiles[(x) + (y + 1) * width] = tile;
+                            dirty[index] = true;
+                            dirty[(x) + (y + 1) * width] = true;
+                            continue;
+                        }
+                    }
 
-                                    if (remainingValue < FLUID_MinValue) {
-                                        tile.fluidAmountDiff -= remainingValue;
-                                        real_tiles[index] = tile;
-                                        continue;
-                                    }
+                    if (remainingValue < FLUID_MinValue) {
+                        tile.fluidAmountDiff -= remainingValue;
+                        real_tiles[index] = tile;
+                        continue;
+                    }
 
-                                    if (canMoveRight) {
-                                        f32 dstFl = right.mat->physicsType == PhysicsType::SOUP ? right.fluidAmount : 0.0f;
-
-                                        f32 flow = (remainingValue - dstFl) / (canMoveLeft ? 2.0f : 2.0f);
-                                        if (flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
-
-                                        flow = std::max(flow, 0.0f);
-                                        if (flow > std::min(FLUID_MaxFlow, remainingValue)) flow = std::min(FLUID_MaxFlow, remainingValue);
-
-                                        if (flow != 0) {
-                                            remainingValue -= flow;
-                                            tile.fluidAmountDiff -= flow;
-                                            if (right.mat->physicsType == PhysicsType::AIR) {
-                                                real_tiles[(x + 1) + (y)*width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                                real_tiles[(x + 1) + (y)*width].fluidAmount = 0.0f;
-                                            }
-                                            real_tiles[(x + 1) + (y)*width].fluidAmountDiff += flow;
-                                            // tiles[(x + 1) + (y)*width].moved = true;
-                                        }
-                                        flowX[index] += flow;
-                                    }
+                    MaterialInstance left = real_tiles[(x - 1) + (y)*width];
+                    bool canMoveLeft = (left.mat->physicsType == PhysicsType::AIR || (left.mat->id == tile.mat->id)) && !airBelow;
 
-                                    if (remainingValue < FLUID_MinValue) {
-                                        tile.fluidAmountDiff -= remainingValue;
-                                        real_tiles[index] = tile;
-                                        continue;
-                                    }
+                    MaterialInstance right = real_tiles[(x + 1) + (y)*width];
+                    bool canMoveRight = (right.mat->physicsType == PhysicsType::AIR || (right.mat->id == tile.mat->id)) && !airBelow;
 
-                                    MaterialInstance top = real_tiles[(x) + (y - 1) * width];
-
-                                    if (top.mat->physicsType == PhysicsType::AIR || (top.mat->id == tile.mat->id)) {
-                                        f32 dstFl = top.mat->physicsType == PhysicsType::SOUP ? top.fluidAmount : 0.0f;
-
-                                        f32 flow = remainingValue - CalculateVerticalFlowValue(remainingValue, dstFl);
-                                        if (flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
-
-                                        flow = std::max(flow, 0.0f);
-                                        if (flow > std::min(FLUID_MaxFlow, remainingValue)) flow = std::min(FLUID_MaxFlow, remainingValue);
-
-                                        if (flow != 0) {
-                                            remainingValue -= flow;
-                                            tile.fluidAmountDiff -= flow;
-                                            if (top.mat->physicsType == PhysicsType::AIR) {
-                                                real_tiles[(x) + (y - 1) * width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                                real_tiles[(x) + (y - 1) * width].fluidAmount = 0.0f;
-                                            }
-                                            real_tiles[(x) + (y - 1) * width].fluidAmountDiff += flow;
-                                            // tiles[(x)+(y - 1) * width].moved = true;
-                                        }
-                                        flowY[index] -= flow;
-                                    } else if (iter == 0 && top.mat->physicsType == PhysicsType::SOUP && (top.mat->id != tile.mat->id)) {
-                                        if (rand() % 10 == 0) {
-                                            real_tiles[index] = top;
-                                            real_tiles[(x) + (y - 1) * width] = tile;
-                                            continue;
-                                        }
-                                    }
+                    if (canMoveLeft) {
+                        f32 dstFl = left.mat->physicsType == PhysicsType::SOUP ? left.fluidAmount : 0.0f;
 
-                                    if (remainingValue < FLUID_MinValue) {
-                                        tile.fluidAmountDiff -= remainingValue;
-                                        real_tiles[index] = tile;
-                                        continue;
-                                    }
+                        f32 flow = (remainingValue - dstFl) / (canMoveRight ? 3.0f : 2.0f);
+                        if (flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
 
-                                    if (startValue == remainingValue) {
-                                        tile.settleCount++;
-                                        if (tile.settleCount >= 10) {
-                                            tile.moved = true;
-                                        }
-                                    } else {
-                                        dirty[index] = true;
-                                        if (top.mat->physicsType == PhysicsType::SOUP) real_tiles[(x) + (y - 1) * width].moved = false;
-                                        if (bottom.mat->physicsType == PhysicsType::SOUP) real_tiles[(x) + (y + 1) * width].moved = false;
-                                        if (left.mat->physicsType == PhysicsType::SOUP) real_tiles[(x - 1) + (y)*width].moved = false;
-                                        if (right.mat->physicsType == PhysicsType::SOUP) real_tiles[(x + 1) + (y)*width].moved = false;
-                                    }
+                        flow = std::max(flow, 0.0f);
+                        if (flow > std::min(FLUID_MaxFlow, remainingValue)) flow = std::min(FLUID_MaxFlow, remainingValue);
 
-                                    real_tiles[index] = tile;
-
-                                    // active[index] = true;
-                                    MaterialInstance belowTile = real_tiles[(x) + (y + 1) * width];
-                                    int below = belowTile.mat->physicsType;
-
-                                    // if(tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < GAME()->materials_count && tile.mat->nInteractions[belowTile.mat->id] > 0) {
-                                    //     for(int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
-                                    //         MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
-                                    //         if(in.type == INTERACT_TRANSFORM_MATERIAL) {
-                                    //             for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                    //                 for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                    //                     if(tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
-                                    //                         tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1], x + xx, y + yy);
-                                    //                         dirty[(x + xx) + (y + yy) * width] = true;
-                                    //                         tickVisited[(x + xx) + (y + yy) * width] = true;
-                                    //                     }
-                                    //                 }
-                                    //             }
-                                    //         } else if(in.type == INTERACT_SPAWN_MATERIAL) {
-                                    //             for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                    //                 for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                    //                     if((xx == 0 && yy == 0) || tiles[(x + xx) + (y + yy) * width].mat->id == Tiles_NOTHING.mat->id) {
-                                    //                         tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1], x + xx, y + yy);
-                                    //                         dirty[(x + xx) + (y + yy) * width] = true;
-                                    //                         tickVisited[(x + xx) + (y + yy) * width] = true;
-                                    //                     }
-                                    //                 }
-                                    //             }
-                                    //         }
-                                    //     }
-                                    //     continue;
-                                    // }
-
-                                    // if(tile.mat->react && tile.mat->nReactions > 0) {
-                                    //     bool react = false;
-                                    //     for(int i = 0; i < tile.mat->nReactions; i++) {
-                                    //         MaterialInteraction in = tile.mat->reactions[i];
-                                    //         if(in.type == REACT_TEMPERATURE_BELOW) {
-                                    //             if(tile.temperature < in.data1) {
-                                    //                 tiles[index] = TilesCreate(GAME()->materials_container[in.data2], x, y);
-                                    //                 tiles[index].temperature = tile.temperature;
-                                    //                 dirty[index] = true;
-                                    //                 tickVisited[index] = true;
-                                    //                 react = true;
-                                    //             }
-                                    //         } else if(in.type == REACT_TEMPERATURE_ABOVE) {
-                                    //             if(tile.temperature > in.data1) {
-                                    //                 tiles[index] = TilesCreate(GAME()->materials_container[in.data2], x, y);
-                                    //                 tiles[index].temperature = tile.temperature;
-                                    //                 dirty[index] = true;
-                                    //                 tickVisited[index] = true;
-                                    //                 react = true;
-                                    //             }
-                                    //         }
-                                    //     }
-                                    //     if(react) continue;
-                                    // }
-
-                                    if (tile.mat->id == GAME()->materials_list.WATER.id && belowTile.mat->id == GAME()->materials_list.LAVA.id) {
-                                        real_tiles[index] = TilesCreateSteam();
-                                        dirty[index] = true;
-                                        real_tiles[(x) + (y + 1) * width] = TilesCreateObsidian(x, y + 1);
-                                        dirty[(x) + (y + 1) * width] = true;
-                                        tickVisited[(x) + (y + 1) * width] = true;
-
-                                        for (int xx = -1; xx <= 1; xx++) {
-                                            for (int yy = 0; yy <= 2; yy++) {
-                                                if (real_tiles[(x + xx) + (y + yy) * width].mat->id == GAME()->materials_list.LAVA.id) {
-                                                    real_tiles[(x + xx) + (y + yy) * width] = TilesCreateObsidian(x + xx, y + yy);
-                                                    dirty[(x + xx) + (y + yy) * width] = true;
-                                                    tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                }
-                                            }
-                                        }
-
-                                        continue;
-                                    }
+                        if (flow != 0) {
+                            remainingValue -= flow;
+                            tile.fluidAmountDiff -= flow;
+                            if (left.mat->physicsType == PhysicsType::AIR) {
+                                real_tiles[(x - 1) + (y)*width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                                real_tiles[(x - 1) + (y)*width].fluidAmount = 0.0f;
+                            }
+                            real_tiles[(x - 1) + (y)*width].fluidAmountDiff += flow;
+                            // tiles[(x - 1) + (y)*width].moved = true;
+                        }
+                        flowX[index] -= flow;
+                    }
 
-                                    // bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
-                                    // if(!canMoveBelow) continue;
-
-                                    // MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
-                                    // int belowL = belowLTile.mat->physicsType;
-                                    // MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
-                                    // int belowR = belowRTile.mat->physicsType;
-
-                                    // bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                    // bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
-
-                                    // if(canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 10 == 0)) {
-                                    //     if(belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR && getTile(x, y + 3).mat->physicsType ==
-                                    //     PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
-                                    //         setTile(x, y, belowTile);
-                                    //         #if DO_MULTITHREADING
-                                    //         parts.push_back(new CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
-                                    //         #else
-                                    //         cells.push_back(new CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
-                                    //         #endif
-                                    //     } else {
-                                    //         tiles[index] = belowTile;
-                                    //         dirty[index] = true;
-                                    //         //setTile(x, y, belowTile);
-                                    //         //setTile(x, y + 1, tile);
-                                    //         tiles[(x)+(y + 1) * width] = tile;
-                                    //         dirty[(x)+(y + 1) * width] = true;
-                                    //         tickVisited[x + (y + 1) * width] = true;
-                                    //     }
-                                    // }
-                                } else if (type == PhysicsType::GAS) {
-                                    // active[index] = true;
-                                    int above = real_tiles[(x) + (y - 1) * width].mat->physicsType;
-
-                                    int aboveL = real_tiles[(x - 1) + (y - 1) * width].mat->physicsType;
-                                    int aboveR = real_tiles[(x + 1) + (y - 1) * width].mat->physicsType;
-
-                                    if (above == 0 && !((aboveL == 0 || aboveR == 0) && rand() % 2 == 0)) {
-                                        real_tiles[index] = getTile(x, y - 1);
-                                        dirty[index] = true;
-
-                                        real_tiles[(x) + (y - 1) * width] = tile;
-                                        dirty[(x) + (y - 1) * width] = true;
-
-                                        tickVisited[(x) + (y - 1) * width] = true;
-                                    }
-                                }
+                    if (remainingValue < FLUID_MinValue) {
+                        tile.fluidAmountDiff -= remainingValue;
+                        real_tiles[index] = tile;
+                        continue;
+                    }
+
+                    if (canMoveRight) {
+                        f32 dstFl = right.mat->physicsType == PhysicsType::SOUP ? right.fluidAmount : 0.0f;
+
+                        f32 flow = (remainingValue - dstFl) / (canMoveLeft ? 2.0f : 2.0f);
+                        if (flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
+
+                        flow = std::max(flow, 0.0f);
+                        if (flow > std::min(FLUID_MaxFlow, remainingValue)) flow = std::min(FLUID_MaxFlow, remainingValue);
+
+                        if (flow != 0) {
+                            remainingValue -= flow;
+                            tile.fluidAmountDiff -= flow;
+                            if (right.mat->physicsType == PhysicsType::AIR) {
+                                real_tiles[(x + 1) + (y)*width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                                real_tiles[(x + 1) + (y)*width].fluidAmount = 0.0f;
+                            }
+                            real_tiles[(x + 1) + (y)*width].fluidAmountDiff += flow;
+                            // tiles[(x + 1) + (y)*width].moved = true;
+                        }
+                        flowX[index] += flow;
+                    }
+
+                    if (remainingValue < FLUID_MinValue) {
+                        tile.fluidAmountDiff -= remainingValue;
+                        real_tiles[index] = tile;
+                        continue;
+                    }
+
+                    MaterialInstance top = real_tiles[(x) + (y - 1) * width];
+
+                    if (top.mat->physicsType == PhysicsType::AIR || (top.mat->id == tile.mat->id)) {
+                        f32 dstFl = top.mat->physicsType == PhysicsType::SOUP ? top.fluidAmount : 0.0f;
+
+                        f32 flow = remainingValue - CalculateVerticalFlowValue(remainingValue, dstFl);
+                        if (flow > FLUID_MinFlow) flow *= FLUID_FlowSpeed;
+
+                        flow = std::max(flow, 0.0f);
+                        if (flow > std::min(FLUID_MaxFlow, remainingValue)) flow = std::min(FLUID_MaxFlow, remainingValue);
+
+                        if (flow != 0) {
+                            remainingValue -= flow;
+                            tile.fluidAmountDiff -= flow;
+                            if (top.mat->physicsType == PhysicsType::AIR) {
+                                real_tiles[(x) + (y - 1) * width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                                real_tiles[(x) + (y - 1) * width].fluidAmount = 0.0f;
                             }
+                            real_tiles[(x) + (y - 1) * width].fluidAmountDiff += flow;
+                            // tiles[(x)+(y - 1) * width].moved = true;
+                        }
+                        flowY[index] -= flow;
+                    } else if (iter == 0 && top.mat->physicsType == PhysicsType::SOUP && (top.mat->id != tile.mat->id)) {
+                        if (rand() % 10 == 0) {
+                            real_tiles[index] = top;
+                            real_tiles[(x) + (y - 1) * width] = tile;
+                            dirty[index] = true;
+                            dirty[(x) + (y - 1) * width] = true;
+                            continue;
+                        }
+                    }
+
+                    if (remainingValue < FLUID_MinValue) {
+                        tile.fluidAmountDiff -= remainingValue;
+                        real_tiles[index] = tile;
+                        continue;
+                    }
+
+                    if (startValue == remainingValue) {
+                        tile.settleCount++;
+                        if (tile.settleCount >= 10) {
+                            tile.moved = true;
                         }
+                    } else {
+                        dirty[index] = true;
+                        if (top.mat->physicsType == PhysicsType::SOUP) real_tiles[(x) + (y - 1) * width].moved = false;
+                        if (bottom.mat->physicsType == PhysicsType::SOUP) real_tiles[(x) + (y + 1) * width].moved = false;
+                        if (left.mat->physicsType == PhysicsType::SOUP) real_tiles[(x - 1) + (y)*width].moved = false;
+                        if (right.mat->physicsType == PhysicsType::SOUP) real_tiles[(x + 1) + (y)*width].moved = false;
+                    }
 
-                        for (int dy = CHUNK_H - 1; dy >= 0; dy--) {
-                            int y = cy + dy;
-                            for (int dxf = 0; dxf < CHUNK_W; dxf++) {
-                                int dx = reverseX ? (CHUNK_W - 1) - dxf : dxf;
-                                int x = cx + dx;
-                                int index = x + y * width;
+                    real_tiles[index] = tile;
+
+                    // active[index] = true;
+                    MaterialInstance belowTile = real_tiles[(x) + (y + 1) * width];
+                    int below = belowTile.mat->physicsType;
+
+                    // if(tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < GAME()->materials_count && tile.mat->nInteractions[belowTile.mat->id] > 0) {
+                    //     for(int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
+                    //         MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
+                    //         if(in.type == INTERACT_TRANSFORM_MATERIAL) {
+                    //             for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                    //                 for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                    //                     if(tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
+                    //                         tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1], x + xx, y + yy);
+                    //                         dirty[(x + xx) + (y + yy) * width] = true;
+                    //                         tickVisited[(x + xx) + (y + yy) * width] = true;
+                    //                     }
+                    //                 }
+                    //             }
+                    //         } else if(in.type == INTERACT_SPAWN_MATERIAL) {
+                    //             for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                    //                 for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                    //                     if((xx == 0 && yy == 0) || tiles[(x + xx) + (y + yy) * width].mat->id == Tiles_NOTHING.mat->id) {
+                    //                         tiles[(x + xx) + (y + yy) * width] = TilesCreate(GAME()->materials_container[in.data1], x + xx, y + yy);
+                    //                         dirty[(x + xx) + (y + yy) * width] = true;
+                    //                         tickVisited[(x + xx) + (y + yy) * width] = true;
+                    //                     }
+                    //                 }
+                    //             }
+                    //         }
+                    //     }
+                    //     continue;
+                    // }
+
+                    // if(tile.mat->react && tile.mat->nReactions > 0) {
+                    //     bool react = false;
+                    //     for(int i = 0; i < tile.mat->nReactions; i++) {
+                    //         MaterialInteraction in = tile.mat->reactions[i];
+                    //         if(in.type == REACT_TEMPERATURE_BELOW) {
+                    //             if(tile.temperature < in.data1) {
+                    //                 tiles[index] = TilesCreate(GAME()->materials_container[in.data2], x, y);
+                    //                 tiles[index].temperature = tile.temperature;
+                    //                 dirty[index] = true;
+                    //                 tickVisited[index] = true;
+                    //                 react = true;
+                    //             }
+                    //         } else if(in.type == REACT_TEMPERATURE_ABOVE) {
+                    //             if(tile.temperature > in.data1) {
+                    //                 tiles[index] = TilesCreate(GAME()->materials_container[in.data2], x, y);
+                    //                 tiles[index].temperature = tile.temperature;
+                    //                 dirty[index] = true;
+                    //                 tickVisited[index] = true;
+                    //                 react = true;
+                    //             }
+                    //         }
+                    //     }
+                    //     if(react) continue;
+                    // }
+
+                    if (quenchLava(x, y, tile, belowTile, tickVisited)) continue;
+
+                    // bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
+                    // if(!canMoveBelow) continue;
+
+                    // MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+                    // int belowL = belowLTile.mat->physicsType;
+                    // MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+                    // int belowR = belowRTile.mat->physicsType;
+
+                    // bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                    // bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+
+                    // if(canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 10 == 0)) {
+                    //     if(belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR && getTile(x, y + 3).mat->physicsType ==
+                    //     PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
+                    //         setTile(x, y, belowTile);
+                    //         #if DO_MULTITHREADING
+                    //         parts.push_back(new CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                    //         #else
+                    //         cells.push_back(new CellData(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                    //         #endif
+                    //     } else {
+                    //         tiles[index] = belowTile;
+                    //         dirty[index] = true;
+                    //         //setTile(x, y, belowTile);
+                    //         //setTile(x, y + 1, tile);
+                    //         tiles[(x)+(y + 1) * width] = tile;
+                    //         dirty[(x)+(y + 1) * width] = true;
+                    //         tickVisited[x + (y + 1) * width] = true;
+                    //     }
+                    // }
+                } else if (type == PhysicsType::GAS) {
+                    // active[index] = true;
+                    int above = real_tiles[(x) + (y - 1) * width].mat->physicsType;
+
+                    int aboveL = real_tiles[(x - 1) + (y - 1) * width].mat->physicsType;
+                    int aboveR = real_tiles[(x + 1) + (y - 1) * width].mat->physicsType;
+
+                    if (above == 0 && !((aboveL == 0 || aboveR == 0) && rand() % 2 == 0)) {
+                        real_tiles[index] = getTile(x, y - 1);
+                        dirty[index] = true;
+
+                        real_tiles[(x) + (y - 1) * width] = tile;
+                        dirty[(x) + (y - 1) * width] = true;
+
+                        tickVisited[(x) + (y - 1) * width] = true;
+                    }
+                }
+            }
+        }
 
-                                if (tickVisited[index]) continue;
+        for (const TickExchange::Seg &seg : segs) {
+            int y = seg.y;
+            for (int xf = seg.x0; xf < seg.x1; xf++) {
+                int x = reverseX ? seg.x0 + seg.x1 - 1 - xf : xf;
+                int index = x + y * width;
 
-                                MaterialInstance tile = real_tiles[index];
+                if (tickVisited[index]) continue;
 
-                                int type = tile.mat->physicsType;
+                MaterialInstance tile = real_tiles[index];
 
-                                if (type == PhysicsType::SAND) {
-                                    // active[index] = true;
-                                    MaterialInstance belowLTile = real_tiles[(x - 1) + (y + 1) * width];
-                                    int belowL = belowLTile.mat->physicsType;
-                                    MaterialInstance belowRTile = real_tiles[(x + 1) + (y + 1) * width];
-                                    int belowR = belowRTile.mat->physicsType;
+                int type = tile.mat->physicsType;
 
-                                    bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                    bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+                if (type == PhysicsType::SAND) {
+                    // active[index] = true;
+                    MaterialInstance belowLTile = real_tiles[(x - 1) + (y + 1) * width];
+                    int belowL = belowLTile.mat->physicsType;
+                    MaterialInstance belowRTile = real_tiles[(x + 1) + (y + 1) * width];
+                    int belowR = belowRTile.mat->physicsType;
 
-                                    bool stoppedByFriction = !tile.moved;
+                    bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                    bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
 
-                                    // 1 to ~127
-                                    int slipperyness = tile.mat->slipperyness;
+                    bool stoppedByFriction = !tile.moved;
 
-                                    if (stoppedByFriction) {
-                                        int drop = 0;
+                    // 1 to ~127
+                    int slipperyness = tile.mat->slipperyness;
 
-                                        for (int pil = 0; pil < 10; pil++) {
-                                            int pilChL = real_tiles[(x - 1) + (y + 1 + pil) * width].mat->physicsType;
-                                            int pilChR = real_tiles[(x + 1) + (y + 1 + pil) * width].mat->physicsType;
+                    if (stoppedByFriction) {
+                        int drop = 0;
 
-                                            if (pilChL == PhysicsType::AIR || pilChR == PhysicsType::AIR) {
-                                                drop++;
-                                            }
-                                        }
+                        for (int pil = 0; pil < 10; pil++) {
+                            int pilChL = real_tiles[(x - 1) + (y + 1 + pil) * width].mat->physicsType;
+                            int pilChR = real_tiles[(x + 1) + (y + 1 + pil) * width].mat->physicsType;
+
+                            if (pilChL == PhysicsType::AIR || pilChR == PhysicsType::AIR) {
+                                drop++;
+                            }
+                        }
 
-                                        // max number of pixels tall a pillar can be before being unstable
-                                        int maxStability = 8 / sqrt(slipperyness) + 1;
+                        // max number of pixels tall a pillar can be before being unstable
+                        int maxStability = 8 / sqrt(slipperyness) + 1;
 
-                                        if (drop + 1 - maxStability > 0) {
-                                            int chance = 1000 / (drop + 1 - maxStability);
-                                            if (chance < 1000) {
-                                                if (rand() % chance == 0) {
-                                                    stoppedByFriction = false;
-                                                    real_tiles[(x) + (y)*width].moved = true;
+                        if (drop + 1 - maxStability > 0) {
+                            int chance = 1000 / (drop + 1 - maxStability);
+                            if (chance < 1000) {
+                                if (rand() % chance == 0) {
+                                    stoppedByFriction = false;
+                                    real_tiles[(x) + (y)*width].moved = true;
 #ifdef DEBUG_FRICTION
-                                                    real_tiles[(x) + (y)*width].color = 0xff0000ff;
-                                                    dirty[(x) + (y)*width] = true;
+                                    real_tiles[(x) + (y)*width].color = 0xff0000ff;
+                                    dirty[(x) + (y)*width] = true;
 #endif
-                                                }
-                                            }
-                                        }
-                                    }
+                                }
+                            }
+                        }
+                    }
 
-                                    if (stoppedByFriction || !(canMoveBelowL || canMoveBelowR)) {
-                                        real_tiles[(x) + (y)*width].moved = false;
+                    if (stoppedByFriction || !(canMoveBelowL || canMoveBelowR)) {
+                        real_tiles[(x) + (y)*width].moved = false;
 #ifdef DEBUG_FRICTION
-                                        real_tiles[(x) + (y)*width].color = 0xff000000;
-                                        dirty[(x) + (y)*width] = true;
+                        real_tiles[(x) + (y)*width].color = 0xff000000;
+                        dirty[(x) + (y)*width] = true;
 #endif
-                                        continue;
-                                    }
+                        continue;
+                    }
 
-                                    bool shouldMove = rand() % (2 * slipperyness) != 0;
+                    bool shouldMove = rand() % (2 * slipperyness) != 0;
 
-                                    if (shouldMove && (canMoveBelowL || canMoveBelowR)) {
-                                        int selfTrasmitMovementChance = 2;
+                    if (shouldMove && (canMoveBelowL || canMoveBelowR)) {
+                        int selfTrasmitMovementChance = 2;
 
-                                        if (rand() % selfTrasmitMovementChance == 0) {
-                                            if (real_tiles[(x) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
-                                                int otherTransmitMovementChance = 2;
-                                                if (rand() % otherTransmitMovementChance == 0) {
-                                                    real_tiles[(x) + (y + 1) * width].moved = true;
+                        if (rand() % selfTrasmitMovementChance == 0) {
+                            if (real_tiles[(x) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
+                                int otherTransmitMovementChance = 2;
+                                if (rand() % otherTransmitMovementChance == 0) {
+                                    real_tiles[(x) + (y + 1) * width].moved = true;
 #ifdef DEBUG_FRICTION
-                                                    real_tiles[(x) + (y + 1) * width].color = 0xffff00ff;
-                                                    dirty[(x) + (y + 1) * width] = true;
+                                    real_tiles[(x) + (y + 1) * width].color = 0xffff00ff;
+                                    dirty[(x) + (y + 1) * width] = true;
 #endif
-                                                }
-                                            }
-                                        }
-                                    }
+                                }
+                            }
+                        }
+                    }
 
-                                    if (shouldMove && canMoveBelowL && (!canMoveBelowR || rand() % 2 == 0)) {
-                                        if (real_tiles[(x - 1) + y * width].mat->physicsType == PhysicsType::AIR) {
-                                            real_tiles[(x - 1) + y * width] = belowLTile;
-                                            dirty[(x - 1) + y * width] = true;
-                                            tickVisited[(x - 1) + (y)*width] = true;
-                                            real_tiles[index] = Tiles_NOTHING;
-                                            dirty[index] = true;
-                                        } else {
-                                            real_tiles[index] = belowLTile;
-                                            dirty[index] = true;
-                                            tickVisited[index] = true;
-                                        }
-
-                                        if (rand() % (20 * slipperyness) == 0) {
-                                            tile.moved = false;
+                    if (shouldMove && canMoveBelowL && (!canMoveBelowR || rand() % 2 == 0)) {
+                        if (real_tiles[(x - 1) + y * width].mat->physicsType == PhysicsType::AIR) {
+                            real_tiles[(x - 1) + y * width] = belowLTile;
+                            dirty[(x - 1) + y * width] = true;
+                            tickVisited[(x - 1) + (y)*width] = true;
+                            real_tiles[index] = Tiles_NOTHING;
+                            dirty[index] = true;
+                        } else {
+                            real_tiles[index] = belowLTile;
+                            dirty[index] = true;
+                            tickVisited[index] = true;
+                        }
+
+                        if (rand() % (20 * slipperyness) == 0) {
+                            tile.moved = false;
 #ifdef DEBUG_FRICTION
-                                            tile.color = 0xff000000;
+                            tile.color = 0xff000000;
 #endif
-                                        }
-                                        real_tiles[(x - 1) + (y + 1) * width] = tile;
-                                        dirty[(x - 1) + (y + 1) * width] = true;
-                                        tickVisited[(x - 1) + (y + 1) * width] = true;
-
-                                    } else if (shouldMove && canMoveBelowR) {
-
-                                        if (real_tiles[(x + 1) + y * width].mat->physicsType == PhysicsType::AIR) {
-                                            real_tiles[(x + 1) + y * width] = belowRTile;
-                                            dirty[(x + 1) + y * width] = true;
-                                            real_tiles[index] = Tiles_NOTHING;
-                                            dirty[index] = true;
-                                        } else {
-                                            real_tiles[index] = belowRTile;
-                                            dirty[index] = true;
-                                            tickVisited[index] = true;
-                                        }
-
-                                        if (rand() % (20 * slipperyness) == 0) {
-                                            tile.moved = false;
+                        }
+                        real_tiles[(x - 1) + (y + 1) * width] = tile;
+                        dirty[(x - 1) + (y + 1) * width] = true;
+                        tickVisited[(x - 1) + (y + 1) * width] = true;
+
+                    } else if (shouldMove && canMoveBelowR) {
+
+                        if (real_tiles[(x + 1) + y * width].mat->physicsType == PhysicsType::AIR) {
+                            real_tiles[(x + 1) + y * width] = belowRTile;
+                            dirty[(x + 1) + y * width] = true;
+                            real_tiles[index] = Tiles_NOTHING;
+                            dirty[index] = true;
+                        } else {
+                            real_tiles[index] = belowRTile;
+                            dirty[index] = true;
+                            tickVisited[index] = true;
+                        }
+
+                        if (rand() % (20 * slipperyness) == 0) {
+                            tile.moved = false;
 #ifdef DEBUG_FRICTION
-                                            tile.color = 0xff000000;
+                            tile.color = 0xff000000;
 #endif
-                                        }
-                                        real_tiles[(x + 1) + (y + 1) * width] = tile;
-                                        dirty[(x + 1) + (y + 1) * width] = true;
-                                        tickVisited[(x + 1) + (y + 1) * width] = true;
+                        }
+                        real_tiles[(x + 1) + (y + 1) * width] = tile;
+                        dirty[(x + 1) + (y + 1) * width] = true;
+                        tickVisited[(x + 1) + (y + 1) * width] = true;
 
-                                    } else {
-                                        real_tiles[(x) + (y)*width].moved = false;
+                    } else {
+                        real_tiles[(x) + (y)*width].moved = false;
 #ifdef DEBUG_FRICTION
-                                        real_tiles[(x) + (y)*width].color = 0xff000000;
-                                        dirty[(x) + (y)*width] = true;
+                        real_tiles[(x) + (y)*width].color = 0xff000000;
+                        dirty[(x) + (y)*width] = true;
 #endif
-                                    }
-                                } else if (type == PhysicsType::SOUP) {
-
-                                    tile.fluidAmount += tile.fluidAmountDiff;
-                                    tile.fluidAmountDiff = 0.0f;
-                                    if (tile.fluidAmount < FLUID_MinValue) {
-                                        real_tiles[index] = Tiles_NOTHING;
-                                        dirty[index] = true;
-                                        tickVisited[index] = true;
-                                    } else {
-                                        real_tiles[index] = tile;
-                                        /*uint8_t c = (1.0f - tile.fluidAmount / 8.0f) * 255;
-                                    int rgb = c;
-                                    rgb = (rgb << 8) + c;
-                                    rgb = (rgb << 8) + c;
-                                    tiles[index].color = rgb;*/
-                                        dirty[index] = true;
-                                        tickVisited[index] = true;
-                                    }
+                    }
+                } else if (type == PhysicsType::SOUP) {
+                    if (fluids) continue;
+
+                    tile.fluidAmount += tile.fluidAmountDiff;
+                    tile.fluidAmountDiff = 0.0f;
+                    if (tile.fluidAmount < FLUID_MinValue) {
+                        real_tiles[index] = Tiles_NOTHING;
+                        dirty[index] = true;
+                        tickVisited[index] = true;
+                    } else {
+                        real_tiles[index] = tile;
+                        /*uint8_t c = (1.0f - tile.fluidAmount / 8.0f) * 255;
+                    int rgb = c;
+                    rgb = (rgb << 8) + c;
+                    rgb = (rgb << 8) + c;
+                    tiles[index].color = rgb;*/
+                        dirty[index] = true;
+                        tickVisited[index] = true;
+                    }
 
-                                    // OLD:
-
-                                    // active[index] = true;
-                                    /*MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
-                                int belowL = belowLTile.mat->physicsType;
-                                MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
-                                int belowR = belowRTile.mat->physicsType;
-
-                                bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
-
-                                if(!(canMoveBelowL || canMoveBelowR)) continue;
-
-                                MaterialInstance lTile = tiles[(x - 1) + (y)* width];
-                                int l = lTile.mat->physicsType;
-                                MaterialInstance rTile = tiles[(x + 1) + (y)* width];
-                                int r = rTile.mat->physicsType;
-
-                                bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
-                                bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
-
-                                if(!((canMoveL || canMoveR) && rand() % 10 == 0)) {
-                                    if(canMoveBelowL && !(canMoveBelowR && rand() % 2 == 0)) {
-                                        if(tiles[(x - 1) + y * width].mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x - 1) + y * width] = belowLTile;
-                                            dirty[(x - 1) + y * width] = true;
-                                            tiles[index] = Tiles_NOTHING;
-                                            dirty[index] = true;
-                                        } else {
-                                            tiles[index] = belowLTile;
-                                            dirty[index] = true;
-                                        }
-
-                                        tiles[(x - 1) + (y + 1) * width] = tile;
-                                        dirty[(x - 1) + (y + 1) * width] = true;
-                                        tickVisited[(x - 1) + (y + 1) * width] = true;
-                                    } else if(canMoveBelowR) {
-                                        if(tiles[(x + 1) + y * width].mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x + 1) + y * width] = belowRTile;
-                                            dirty[(x + 1) + y * width] = true;
-                                            tiles[index] = Tiles_NOTHING;
-                                            dirty[index] = true;
-                                        } else {
-                                            tiles[index] = belowRTile;
-                                            dirty[index] = true;
-                                        }
-
-                                        tiles[(x + 1) + (y + 1) * width] = tile;
-                                        dirty[(x + 1) + (y + 1) * width] = true;
-                                        tickVisited[(x + 1) + (y + 1) * width] = true;
-                                    }
-                                }*/
-                                } else if (type == PhysicsType::GAS) {
-                                    // active[index] = true;
-                                    int aboveL = real_tiles[(x - 1) + (y - 1) * width].mat->physicsType;
-                                    int aboveR = real_tiles[(x + 1) + (y - 1) * width].mat->physicsType;
-
-                                    if (aboveL == 0 && !(aboveR == 0 && rand() % 2 == 0)) {
-                                        real_tiles[index] = real_tiles[(x - 1) + (y - 1) * width];
-                                        dirty[index] = true;
-
-                                        real_tiles[(x - 1) + (y - 1) * width] = tile;
-                                        dirty[(x - 1) + (y - 1) * width] = true;
-                                        tickVisited[(x - 1) + (y - 1) * width] = true;
-                                    } else if (aboveR == 0) {
-                                        real_tiles[index] = real_tiles[(x + 1) + (y - 1) * width];
-                                        dirty[index] = true;
-
-                                        real_tiles[(x + 1) + (y - 1) * width] = tile;
-                                        dirty[(x + 1) + (y - 1) * width] = true;
-                                        tickVisited[(x + 1) + (y - 1) * width] = true;
-                                    }
-                                }
-                            }
+                    // OLD:
+
+                    // active[index] = true;
+                    /*MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+                int belowL = belowLTile.mat->physicsType;
+                MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+                int belowR = belowRTile.mat->physicsType;
+
+                bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+
+                if(!(canMoveBelowL || canMoveBelowR)) continue;
+
+                MaterialInstance lTile = tiles[(x - 1) + (y)* width];
+                int l = lTile.mat->physicsType;
+                MaterialInstance rTile = tiles[(x + 1) + (y)* width];
+                int r = rTile.mat->physicsType;
+
+                bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
+                bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
+
+                if(!((canMoveL || canMoveR) && rand() % 10 == 0)) {
+                    if(canMoveBelowL && !(canMoveBelowR && rand() % 2 == 0)) {
+                        if(tiles[(x - 1) + y * width].mat->physicsType == PhysicsType::AIR) {
+                            tiles[(x - 1) + y * width] = belowLTile;
+                            dirty[(x - 1) + y * width] = true;
+                            tiles[index] = Tiles_NOTHING;
+                            dirty[index] = true;
+                        } else {
+                            tiles[index] = belowLTile;
+                            dirty[index] = true;
+                        }
+
+                        tiles[(x - 1) + (y + 1) * width] = tile;
+                        dirty[(x - 1) + (y + 1) * width] = true;
+                        tickVisited[(x - 1) + (y + 1) * width] = true;
+                    } else if(canMoveBelowR) {
+                        if(tiles[(x + 1) + y * width].mat->physicsType == PhysicsType::AIR) {
+                            tiles[(x + 1) + y * width] = belowRTile;
+                            dirty[(x + 1) + y * width] = true;
+                            tiles[index] = Tiles_NOTHING;
+                            dirty[index] = true;
+                        } else {
+                            tiles[index] = belowRTile;
+                            dirty[index] = true;
                         }
 
-                        for (int dy = CHUNK_H - 1; dy >= 0; dy--) {
-                            int y = cy + dy;
-                            for (int dxf = 0; dxf < CHUNK_W; dxf++) {
-                                int dx = reverseX ? (CHUNK_W - 1) - dxf : dxf;
-                                int x = cx + dx;
-                                int index = x + y * width;
+                        tiles[(x + 1) + (y + 1) * width] = tile;
+                        dirty[(x + 1) + (y + 1) * width] = true;
+                        tickVisited[(x + 1) + (y + 1) * width] = true;
+                    }
+                }*/
+                } else if (type == PhysicsType::GAS) {
+                    // active[index] = true;
+                    int aboveL = real_tiles[(x - 1) + (y - 1) * width].mat->physicsType;
+                    int aboveR = real_tiles[(x + 1) + (y - 1) * width].mat->physicsType;
+
+                    if (aboveL == 0 && !(aboveR == 0 && rand() % 2 == 0)) {
+                        real_tiles[index] = real_tiles[(x - 1) + (y - 1) * width];
+                        dirty[index] = true;
+
+                        real_tiles[(x - 1) + (y - 1) * width] = tile;
+                        dirty[(x - 1) + (y - 1) * width] = true;
+                        tickVisited[(x - 1) + (y - 1) * width] = true;
+                    } else if (aboveR == 0) {
+                        real_tiles[index] = real_tiles[(x + 1) + (y - 1) * width];
+                        dirty[index] = true;
+
+                        real_tiles[(x + 1) + (y - 1) * width] = tile;
+                        dirty[(x + 1) + (y - 1) * width] = true;
+                        tickVisited[(x + 1) + (y - 1) * width] = true;
+                    }
+                }
+            }
+        }
+
+        for (const TickExchange::Seg &seg : segs) {
+            int y = seg.y;
+            for (int xf = seg.x0; xf < seg.x1; xf++) {
+                int x = reverseX ? seg.x0 + seg.x1 - 1 - xf : xf;
+                int index = x + y * width;
 
-                                if (tickVisited[index]) continue;
+                if (tickVisited[index]) continue;
 
-                                MaterialInstance tile = real_tiles[index];
+                MaterialInstance tile = real_tiles[index];
 
-                                int type = tile.mat->physicsType;
+                int type = tile.mat->physicsType;
 
-                                if (type == PhysicsType::SOUP) {
-                                    // active[index] = true;
+                if (type == PhysicsType::SOUP) {
+                    // active[index] = true;
 
-                                    /*MaterialInstance lTile = tiles[(x - 1) + (y)* width];
-                                int l = lTile.mat->physicsType;
-                                MaterialInstance rTile = tiles[(x + 1) + (y)* width];
-                                int r = rTile.mat->physicsType;
+                    /*MaterialInstance lTile = tiles[(x - 1) + (y)* width];
+                int l = lTile.mat->physicsType;
+                MaterialInstance rTile = tiles[(x + 1) + (y)* width];
+                int r = rTile.mat->physicsType;
 
-                                bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
-                                bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
+                bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
+                bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
 
-                                if(canMoveL && !(canMoveR && rand() % 2 == 5)) {
-                                    tiles[index] = lTile;
-                                    dirty[index] = true;
+                if(canMoveL && !(canMoveR && rand() % 2 == 5)) {
+                    tiles[index] = lTile;
+                    dirty[index] = true;
 
-                                    tiles[(x - 1) + (y)* width] = tile;
-                                    dirty[(x - 1) + (y)* width] = true;
-                                    tickVisited[(x - 1) + (y)* width] = true;
-                                } else if(canMoveR) {
-                                    tiles[index] = rTile;
-                                    dirty[index] = true;
+                    tiles[(x - 1) + (y)* width] = tile;
+                    dirty[(x - 1) + (y)* width] = true;
+                    tickVisited[(x - 1) + (y)* width] = true;
+                } else if(canMoveR) {
+                    tiles[index] = rTile;
+                    dirty[index] = true;
 
-                                    tiles[(x + 1) + (y)* width] = tile;
-                                    dirty[(x + 1) + (y)* width] = true;
-                                    tickVisited[(x + 1) + (y)* width] = true;
-                                }*/
-                                } else if (type == PhysicsType::GAS) {
-                                    // active[index] = true;
-
-                                    int l = real_tiles[(x - 1) + (y)*width].mat->physicsType;
-                                    int r = real_tiles[(x + 1) + (y)*width].mat->physicsType;
-
-                                    if (l == 0 && !(r == 0 && rand() % 2 == 0)) {
-                                        real_tiles[index] = getTile(x - 1, y);
-                                        dirty[index] = true;
-
-                                        real_tiles[(x - 1) + (y)*width] = tile;
-                                        dirty[(x - 1) + (y)*width] = true;
-                                        tickVisited[(x - 1) + (y)*width] = true;
-                                    } else if (r == 0) {
-                                        real_tiles[index] = getTile(x + 1, y);
-                                        dirty[index] = true;
-
-                                        real_tiles[(x + 1) + (y)*width] = tile;
-                                        dirty[(x + 1) + (y)*width] = true;
-                                        tickVisited[(x + 1) + (y)*width] = true;
-                                    } else {
-                                        if (tile.mat->id == GAME()->materials_list.STEAM.id) {
-                                            if (rand() % 10 == 0) {
-                                                real_tiles[index] = TilesCreateWater();
-                                                dirty[index] = true;
-                                            }
-                                        }
-                                    }
-                                }
+                    tiles[(x + 1) + (y)* width] = tile;
+                    dirty[(x + 1) + (y)* width] = true;
+                    tickVisited[(x + 1) + (y)* width] = true;
+                }*/
+                } else if (type == PhysicsType::GAS) {
+                    // active[index] = true;
+
+                    int l = real_tiles[(x - 1) + (y)*width].mat->physicsType;
+                    int r = real_tiles[(x + 1) + (y)*width].mat->physicsType;
+
+                    if (l == 0 && !(r == 0 && rand() % 2 == 0)) {
+                        real_tiles[index] = getTile(x - 1, y);
+                        dirty[index] = true;
+
+                        real_tiles[(x - 1) + (y)*width] = tile;
+                        dirty[(x - 1) + (y)*width] = true;
+                        tickVisited[(x - 1) + (y)*width] = true;
+                    } else if (r == 0) {
+                        real_tiles[index] = getTile(x + 1, y);
+                        dirty[index] = true;
+
+                        real_tiles[(x + 1) + (y)*width] = tile;
+                        dirty[(x + 1) + (y)*width] = true;
+                        tickVisited[(x + 1) + (y)*width] = true;
+                    } else {
+                        if (tile.mat->id == GAME()->materials_list.STEAM.id) {
+                            if (rand() % 10 == 0) {
+                                real_tiles[index] = TilesCreateWater();
+                                dirty[index] = true;
                             }
                         }
+                    }
+                }
+            }
+        }
+
+        blockTimer.stop();
+        budget.workMs[block] += (f32)blockTimer.get();
+        return parts;
+    };
+
+    // TODO: 尝试找到一种方法来优化这个循环，因为液体需要高迭代次数
+    for (int iter = 0; iter < budget.maxIters; iter++) {
 
 #if DO_MULTITHREADING
+        if (exchange) {
+            bool *tickVisited = whichTickVisited ? tickVisited2 : tickVisited1;
+            std::future<void> tickVisitedDone = world_sys.tickVisitedPool->push([&](int id) { memset(whichTickVisited ? tickVisited1 : tickVisited2, false, (size_t)width * height); });
+
+            // 所有块的内部一起扫描
+            std::vector<std::future<std::vector<CellData>>> results = {};
+            for (int cx = tickZone.x; cx < (tickZone.x + tickZone.w); cx += CHUNK_W) {
+                for (int cy = tickZone.y; cy < (tickZone.y + tickZone.h); cy += CHUNK_H) {
+                    int block = (cx - (int)tickZone.x) / CHUNK_W + (cy - (int)tickZone.y) / CHUNK_H * budget.cols;
+                    ex.outbox[block].clear();
+                    ex.cells[block] = 0;
+                    if (iter >= budget.iters[block]) continue;
+
+                    results.push_back(world_sys.tickPool->push([&, cx, cy, block](int id) {
+                        std::vector<CellData> parts = tickBlock(block, iter, tickVisited, blockSegs(cx, cy, ex.side, ex.top, ex.bottom));
+                        fillOutbox(cx, cy, block, tickVisited);
                         return parts;
                     }));
+                }
+            }
+            for (auto &r : results) {
+                for (const CellData &p : r.get()) cells.add(p);
+            }
+
+            // 按 4 相棋盘合并各块的 outbox
+            Timer mergeTimer;
+            mergeTimer.start();
+            for (int tk = 0; tk < 4; tk++) {
+                int chOfsX = tk % 2;
+                int chOfsY = 1 - ((tk % 4) / 2);
+
+                std::vector<int> group;
+                int groupCells = 0;
+                for (int cx = tickZone.x + chOfsX * CHUNK_W; cx < (tickZone.x + tickZone.w); cx += CHUNK_W * 2) {
+                    for (int cy = tickZone.y + chOfsY * CHUNK_H; cy < (tickZone.y + tickZone.h); cy += CHUNK_H * 2) {
+                        int block = (cx - (int)tickZone.x) / CHUNK_W + (cy - (int)tickZone.y) / CHUNK_H * budget.cols;
+                        if (ex.cells[block] == 0) continue;
+                        group.push_back(block);
+                        groupCells += ex.cells[block];
+                    }
+                }
+                ex.deferred += groupCells;
+
+                if (groupCells <= ex.inlineCells) {
+                    for (int block : group) {
+                        for (const CellData &p : tickBlock(block, iter, tickVisited, ex.outbox[block])) cells.add(p);
+                    }
+                } else {
+                    results.clear();
+                    for (int block : group) results.push_back(world_sys.tickPool->push([&, block](int id) { return tickBlock(block, iter, tickVisited, ex.outbox[block]); }));
+                    for (auto &r : results) {
+                        for (const CellData &p : r.get()) cells.add(p);
+                    }
+                }
+            }
+            mergeTimer.stop();
+            mergeMs += mergeTimer.get();
+
+            tickVisitedDone.get();
+            whichTickVisited = !whichTickVisited;
+            continue;
+        }
+#endif
+
+        for (int tk = 0; tk < 4; tk++) {
+
+            int chOfsX = tk % 2;              // 0 1 0 1
+            int chOfsY = 1 - ((tk % 4) / 2);  // 1 1 0 0
+
+#if DO_MULTITHREADING
+            std::vector<std::future<std::vector<CellData>>> results = {};
+#endif
+#if DO_MULTITHREADING
+            bool *tickVisited = whichTickVisited ? tickVisited2 : tickVisited1;
+            std::future<void> tickVisitedDone = world_sys.tickVisitedPool->push([&](int id) { memset(whichTickVisited ? tickVisited1 : tickVisited2, false, (size_t)width * height); });
+#else
+            bool *tickVisited = tickVisited1;
+            memset(tickVisited1, false, width * height);
+#endif
+
+            for (int cx = tickZone.x + chOfsX * CHUNK_W; cx < (tickZone.x + tickZone.w); cx += CHUNK_W * 2) {
+                for (int cy = tickZone.y + chOfsY * CHUNK_H; cy < (tickZone.y + tickZone.h); cy += CHUNK_H * 2) {
+                    int block = (cx - (int)tickZone.x) / CHUNK_W + (cy - (int)tickZone.y) / CHUNK_H * budget.cols;
+                    if (iter >= budget.iters[block]) continue;
+
+#if DO_MULTITHREADING
+                    results.push_back(world_sys.tickPool->push([&, cx, cy, block](int id) { return tickBlock(block, iter, tickVisited, blockSegs(cx, cy, 0, 0, 0)); }));
+#else
+                    for (const CellData &p : tickBlock(block, iter, tickVisited, blockSegs(cx, cy, 0, 0, 0))) cells.add(p);
 #endif
                 }
             }
 
+
 #if DO_MULTITHREADING
 
             for (int i = 0; i < results.size(); i++) {
 
-                std::vector<CellData *> pts = results[i].get();
+                std::vector<CellData> pts = results[i].get();
 
-                cells.insert(cells.end(), pts.begin(), pts.end());
+                for (const CellData &p : pts) cells.add(p);
             }
             tickVisitedDone.get();
 
@@ -1924,6 +2881,15 @@ void world::tick() {
 #undef DO_MULTITHREADING
 #undef DO_REVERSE
 
+    if (fluids) tickFluids();
+
+    // 本次移动过的格子 (只在 tickZone 附近)
+    syncChunkStatsDirty((int)tickZone.x - CHUNK_W, (int)tickZone.y - CHUNK_H, (int)tickZone.w + 2 * CHUNK_W, (int)tickZone.h + 2 * CHUNK_H);
+
+    tickTimer.stop();
+    ex.mergeMs = (f32)mergeMs;
+    finishTick(tickTimer.get());
+
     tickCt++;
 
     for (int i = 0; i < 1; i++) {
@@ -1947,57 +2913,414 @@ for (int x = 0; x < width; x++) {
 }*/
 }
 
+void world::tickFluids() {
+    FluidPlanes &fp = fluidPlanes;
+    const TickBudget &budget = tickBudget;
+
+    Timer timer;
+    timer.start();
+
+    const int cols = budget.cols, rows = budget.rows;
+    const int nb = cols * rows;
+    const int pw = cols * CHUNK_W + 4, ph = rows * CHUNK_H + 4;
+    const int ox = (int)tickZone.x - 2, oy = (int)tickZone.y - 2;
+    if (fp.pw != pw || fp.ph != ph || fp.ox != ox || fp.oy != oy) {
+        size_t n = (size_t)pw * ph;
+        fp.pw = pw, fp.ph = ph, fp.ox = ox, fp.oy = oy;
+        fp.amount.assign(n, 0.0f);
+        fp.mat.assign(n, FluidPlanes::WALL);
+        fp.claim.assign(n, FluidPlanes::WALL);
+        fp.outD.assign(n, 0.0f);
+        fp.outL.assign(n, 0.0f);
+        fp.outR.assign(n, 0.0f);
+        fp.outU.assign(n, 0.0f);
+        fp.settled.assign(nb, 0);
+    }
+    fp.cols = cols, fp.rows = rows;
+    fp.awake.assign(nb, 0);
+    fp.limit.assign(nb, 0);
+    fp.delta.assign(nb, 0.0f);
+
+    // 材料表: fluidIter 为液体每帧的迭代次数 (非液体为 0)
+    const u16 nMat = (u16)std::min<size_t>(GAME()->materials_container.size(), FluidPlanes::WALL);
+    std::vector<u8> fluidIter(nMat, 0), isAir(nMat, 0);
+    for (u16 m = 0; m < nMat; m++) {
+        const Material *mat = GAME()->materials_container[m];
+        if (mat->physicsType == PhysicsType::SOUP) fluidIter[m] = (u8)std::clamp(mat->iterations, 1, 255);
+        if (mat->physicsType == PhysicsType::AIR) isAir[m] = 1;
+    }
+    const u16 airId = (u16)Tiles_NOTHING.mat->id;
+    auto fluidAt = [&](u16 m) { return m < nMat && fluidIter[m] > 0; };
+    auto airAt = [&](u16 m) { return m < nMat && isAir[m]; };
+
+    auto forBlocks = [&](const std::vector<int> &list, auto &&fn) {
+        std::vector<std::future<void>> done;
+        done.reserve(list.size());
+        for (int b : list) done.push_back(world_sys.tickPool->push([&, b](int id) { fn(b); }));
+        for (auto &f : done) f.get();
+    };
+    auto origin = [&](int b, int &px, int &py) {
+        px = (b % cols) * CHUNK_W + 2;
+        py = (b / cols) * CHUNK_H + 2;
+    };
+
+    // 收集本帧更新的块 与平面不一致的块不再静止
+    std::vector<int> ticked;
+    for (int b = 0; b < nb; b++) {
+        if (budget.iters[b] > 0) ticked.push_back(b);
+    }
+    forBlocks(ticked, [&](int b) {
+        int px, py;
+        origin(b, px, py);
+        bool changed = false;
+        u8 lim = 0;
+        for (int dy = 0; dy < CHUNK_H; dy++) {
+            const MaterialInstance *t = &real_tiles[(ox + px) + (oy + py + dy) * width];
+            int p0 = px + (py + dy) * pw;
+            for (int i = 0; i < CHUNK_W; i++) {
+                u16 m = (u16)t[i].mat->id;
+                f32 a = fluidAt(m) ? t[i].fluidAmount : 0.0f;
+                changed |= fp.mat[p0 + i] != m || fp.amount[p0 + i] != a;
+                fp.mat[p0 + i] = m;
+                fp.amount[p0 + i] = a;
+                if (fluidAt(m)) lim = std::max(lim, fluidIter[m]);
+            }
+        }
+        fp.limit[b] = (u8)std::min({(int)lim * budget.scale[b], (int)budget.iters[b], 255});
+        if (changed) fp.settled[b] = 0;
+    });
+
+    // 未静止的块与其四邻参与迭代
+    auto activeAt = [&](int col, int row) { return col >= 0 && row >= 0 && col < cols && row < rows && !fp.settled[col + row * cols]; };
+    std::vector<int> active;
+    int iters = 0;
+    for (int b : ticked) {
+        int col = b % cols, row = b / cols;
+        if (activeAt(col, row) || activeAt(col - 1, row) || activeAt(col + 1, row) || activeAt(col, row - 1) || activeAt(col, row + 1)) {
+            fp.awake[b] = 1;
+            active.push_back(b);
+            iters = std::max(iters, (int)fp.limit[b]);
+        }
+    }
+    auto awakeAt = [&](int col, int row) { return col >= 0 && row >= 0 && col < cols && row < rows && fp.awake[col + row * cols]; };
+
+    // 不参与的块边上的流量可能是之前留下的 清零后邻块的第二阶段可以直接读
+    for (int b = 0; b < nb; b++) {
+        if (fp.awake[b]) continue;
+        int px, py;
+        origin(b, px, py);
+        std::fill_n(&fp.outU[px + py * pw], CHUNK_W, 0.0f);
+        std::fill_n(&fp.outD[px + (py + CHUNK_H - 1) * pw], CHUNK_W, 0.0f);
+        for (int dy = 0; dy < CHUNK_H; dy++) {
+            fp.outL[px + (py + dy) * pw] = 0.0f;
+            fp.outR[px + CHUNK_W - 1 + (py + dy) * pw] = 0.0f;
+        }
+    }
+
+    // 空气格接受上/左/右/下第一个液体邻居的材料
+    auto claimOf = [&](int q) {
+        for (int d : {-pw, -1, 1, pw}) {
+            u16 n = fp.mat[q + d];
+            if (fluidAt(n)) return n;
+        }
+        return FluidPlanes::WALL;
+    };
+    auto accepts = [&](int q, u16 m) {
+        u16 n = fp.mat[q];
+        return n == m || (airAt(n) && claimOf(q) == m);
+    };
+
+    for (int it = 0; it < iters; it++) {
+        // 第一阶段: 各格流向四邻的流量
+        forBlocks(active, [&](int b) {
+            int px, py;
+            origin(b, px, py);
+            int col = b % cols, row = b / cols;
+            bool wl = awakeAt(col - 1, row), wr = awakeAt(col + 1, row), wu = awakeAt(col, row - 1), wd = awakeAt(col, row + 1);
+            int scale = budget.scale[b];
+            bool open = it < budget.iters[b];
+
+            f32 a[CHUNK_W], vd[CHUNK_W], vl[CHUNK_W], vr[CHUNK_W], vu[CHUNK_W];
+            f32 cd[CHUNK_W], cl[CHUNK_W], cr[CHUNK_W], cu[CHUNK_W];
+            for (int dy = 0; dy < CHUNK_H; dy++) {
+                int p0 = px + (py + dy) * pw;
+
+                // 逐格分类 不能流动的方向记 0
+                for (int i = 0; i < CHUNK_W; i++) {
+                    int p = p0 + i;
+                    u16 m = fp.mat[p];
+                    if (airAt(m)) fp.claim[p] = claimOf(p);
+                    a[i] = vd[i] = vl[i] = vr[i] = vu[i] = 0.0f;
+                    cd[i] = cl[i] = cr[i] = cu[i] = 0.0f;
+                    if (!open || !fluidAt(m) || it >= fluidIter[m] * scale || fp.amount[p] < FLUID_MinValue) continue;
+
+                    a[i] = fp.amount[p];
+                    bool airBelow = airAt(fp.mat[p + pw]);
+                    cd[i] = accepts(p + pw, m) && (!airBelow || it <= 2) && (dy < CHUNK_H - 1 || wd);
+                    cl[i] = accepts(p - 1, m) && !airBelow && (i > 0 || wl);
+                    cr[i] = accepts(p + 1, m) && !airBelow && (i < CHUNK_W - 1 || wr);
+                    cu[i] = accepts(p - pw, m) && (dy > 0 || wu);
+                    vd[i] = fp.amount[p + pw];
+                    vl[i] = fp.amount[p - 1];
+                    vr[i] = fp.amount[p + 1];
+                    vu[i] = fp.amount[p - pw];
+                }
+
+                // 整行的流量 与原先逐格的顺序一致: 下 左 右 上 剩余不足 FLUID_MinValue 时停止
+                f32 *oD = &fp.outD[p0], *oL = &fp.outL[p0], *oR = &fp.outR[p0], *oU = &fp.outU[p0];
+                for (int i = 0; i < CHUNK_W; i++) {
+                    f32 r = a[i];
+
+                    f32 fD = CalculateVerticalFlowValue(r, vd[i]) - vd[i];
+                    fD = fD > FLUID_MinFlow ? fD * FLUID_FlowSpeed : fD;
+                    fD = std::clamp(fD, 0.0f, std::min(FLUID_MaxFlow, r)) * cd[i];
+                    r -= fD;
+                    f32 live = r >= FLUID_MinValue ? 1.0f : 0.0f;
+
+                    f32 fL = (r - vl[i]) / (cr[i] > 0.0f ? 3.0f : 2.0f);
+                    fL = fL > FLUID_MinFlow ? fL * FLUID_FlowSpeed : fL;
+                    fL = std::clamp(fL, 0.0f, std::min(FLUID_MaxFlow, r)) * cl[i] * live;
+                    r -= fL;
+                    live *= r >= FLUID_MinValue ? 1.0f : 0.0f;
+
+                    f32 fR = (r - vr[i]) / 2.0f;
+                    fR = fR > FLUID_MinFlow ? fR * FLUID_FlowSpeed : fR;
+                    fR = std::clamp(fR, 0.0f, std::min(FLUID_MaxFlow, r)) * cr[i] * live;
+                    r -= fR;
+                    live *= r >= FLUID_MinValue ? 1.0f : 0.0f;
+
+                    f32 fU = r - CalculateVerticalFlowValue(r, vu[i]);
+                    fU = fU > FLUID_MinFlow ? fU * FLUID_FlowSpeed : fU;
+                    fU = std::clamp(fU, 0.0f, std::min(FLUID_MaxFlow, r)) * cu[i] * live;
+
+                    oD[i] = fD;
+                    oL[i] = fL;
+                    oR[i] = fR;
+                    oU[i] = fU;
+                }
+
+                f32 *fx = &flowX[(ox + px) + (oy + py + dy) * width], *fy = &flowY[(ox + px) + (oy + py + dy) * width];
+                for (int i = 0; i < CHUNK_W; i++) {
+                    fx[i] += oR[i] - oL[i];
+                    fy[i] += oD[i] - oU[i];
+                }
+            }
+        });
+
+        // 第二阶段: 按四个方向的流量更新液量 空气格得到液体后换成接受的材料
+        forBlocks(active, [&](int b) {
+            int px, py;
+            origin(b, px, py);
+            f32 delta = fp.delta[b];
+            for (int dy = 0; dy < CHUNK_H; dy++) {
+                int p0 = px + (py + dy) * pw;
+                f32 na[CHUNK_W];
+                for (int i = 0; i < CHUNK_W; i++) {
+                    int p = p0 + i;
+                    na[i] = fp.amount[p] - (fp.outD[p] + fp.outL[p] + fp.outR[p] + fp.outU[p]) + fp.outD[p - pw] + fp.outU[p + pw] + fp.outR[p - 1] + fp.outL[p + 1];
+                    delta = std::max(delta, std::abs(na[i] - fp.amount[p]));
+                }
+                for (int i = 0; i < CHUNK_W; i++) {
+                    int p = p0 + i;
+                    u16 m = fp.mat[p];
+                    if (fluidAt(m)) {
+                        if (na[i] < FLUID_MinValue) {
+                            fp.mat[p] = airId;
+                            na[i] = 0.0f;
+                            delta = std::max(delta, FLUID_MinValue);
+                        }
+                    } else if (airAt(m) && na[i] >= FLUID_MinValue) {
+                        fp.mat[p] = fp.claim[p];
+                        delta = std::max(delta, FLUID_MinValue);
+                    } else {
+                        na[i] = 0.0f;
+                    }
+                    fp.amount[p] = na[i];
+                }
+            }
+            fp.delta[b] = delta;
+        });
+    }
+
+    // 写回 real_tiles 新出现的液体格沿用块内同材料邻居的颜色与温度
+    // 液量的小变化不标记 dirty 统计缓存在这里直接计入 块与统计块对齐时各块只写自己的统计块 可以并行
+    const bool stats = !chunkStats.blocks.empty();
+    const bool statsAligned = (ox + 2) % CHUNK_W == 0 && (oy + 2) % CHUNK_H == 0;
+    forBlocks(active, [&](int b) {
+        int px, py;
+        origin(b, px, py);
+        int x0 = ox + px, y0 = oy + py;
+        for (int dy = 0; dy < CHUNK_H; dy++) {
+            int y = y0 + dy;
+            for (int i = 0; i < CHUNK_W; i++) {
+                int x = x0 + i;
+                int wi = x + y * width;
+                int p = px + i + (py + dy) * pw;
+                MaterialInstance &t = real_tiles[wi];
+                u16 m = fp.mat[p];
+                if (t.mat->id != m) {
+                    if (airAt(m)) {
+                        t = Tiles_NOTHING;
+                    } else {
+                        const MaterialInstance *src = nullptr;
+                        if (dy > 0 && real_tiles[wi - width].mat->id == m) src = &real_tiles[wi - width];
+                        else if (i > 0 && real_tiles[wi - 1].mat->id == m) src = &real_tiles[wi - 1];
+                        else if (i < CHUNK_W - 1 && real_tiles[wi + 1].mat->id == m) src = &real_tiles[wi + 1];
+                        else if (dy < CHUNK_H - 1 && real_tiles[wi + width].mat->id == m) src = &real_tiles[wi + width];
+                        t = src ? MaterialInstance(src->mat, src->color, src->temperature) : TilesCreate(m, x, y);
+                        t.fluidAmount = fp.amount[p];
+                    }
+                    dirty[wi] = true;
+                } else if (fluidAt(m) && t.fluidAmount != fp.amount[p]) {
+                    if (std::abs(t.fluidAmount - fp.amount[p]) >= FLUID_MinValue) dirty[wi] = true;
+                    t.fluidAmount = fp.amount[p];
+                    if (stats && statsAligned) noteTile(wi);
+                }
+            }
+        }
+        fp.settled[b] = fp.delta[b] < FLUID_MinValue;
+    });
+    if (stats && !statsAligned) {
+        for (int b : active) {
+            int px, py;
+            origin(b, px, py);
+            syncChunkStats(ox + px, oy + py, CHUNK_W, CHUNK_H);
+        }
+    }
+
+    fp.active = (int)active.size();
+    fp.resting = 0;
+    for (int b : ticked) fp.resting += fp.settled[b];
+    fp.iters = iters;
+    timer.stop();
+    fp.ms = (f32)timer.get();
+}
+
 void world::tickTemperature() {
     // TODO: multithread
 
-    for (int y = (tickZone.y + tickZone.h) - 1; y >= tickZone.y; y--) {
-        for (int x = tickZone.x; x < (tickZone.x + tickZone.w); x++) {
-            f32 n = 0.01;
-            f32 v = 0;
-            // for (int xx = -1; xx <= 1; xx++) {
-            //  for (int yy = -1; yy <= 1; yy++) {
-            //      f32 factor = abs(tiles[(x + xx) + (y + yy) * width].temperature) / 64 * tiles[(x + xx) + (y + yy) * width].mat->conductionOther;
-            //      //factor = fmax(-1, fmin(factor, 1));
-
-            //      v += tiles[(x + xx) + (y + yy) * width].temperature * factor;
-            //      n += factor;
-
-            //      // ((v1 * f1) + (v2 * f2)) / (f1 + f2)
-            //      //=(v1 * f1) + (v2 * f2)
-            //  }
-            //}
-            f32 factor = 0;
+    // 细节层次: 中环/远环的块每 period 次调用更新一次 一次走 period 步
+    // 邻居平均温度视为不变时 period 步的结果为 old + period * addTemp + (1 - (1 - conductionSelf)^period) * (avg - old)
+    const TickBudget &b = tickBudget;
+    bool lod = tickLod.enabled && b.ring.size() == (size_t)b.cols * b.rows && b.cols * CHUNK_W >= tickZone.w && b.rows * CHUNK_H >= tickZone.h;
+    int ct = temperatureCt++;
+
+    auto periodOf = [&](int col, int row) {
+        if (!lod) return 1;
+        int ring = b.ring[col + row * b.cols];
+        return ring == 0 ? 1 : std::max(ring == 1 ? tickLod.midPeriod : tickLod.farPeriod, 1);
+    };
+
+    int cols = ((int)tickZone.w + CHUNK_W - 1) / CHUNK_W;
+    int rows = ((int)tickZone.h + CHUNK_H - 1) / CHUNK_H;
+    int zx1 = tickZone.x + tickZone.w, zy1 = tickZone.y + tickZone.h;
+
+    // 统计缓存: 外扩 1 格后相交的块温度全为 0 且本块没有发热材料时 结果仍全为 0 整块跳过
+    ChunkStatsGrid &g = chunkStats;
+    const bool stats = !g.blocks.empty();
+    std::vector<u8> update((size_t)cols * rows, 0);
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            if ((ct + col + row) % periodOf(col, row) != 0) continue;
+            int bx0 = (int)tickZone.x + col * CHUNK_W, by0 = (int)tickZone.y + row * CHUNK_H;
+            if (statsSkip && stats) {
+                mat_temperature lo = 0, hi = 0;
+                bool cold = temperatureIn(bx0 - 1, by0 - 1, CHUNK_W + 2, CHUNK_H + 2, lo, hi) && lo == 0 && hi == 0;
+                u32 heat = 0;
+                forChunkStats(bx0, by0, CHUNK_W, CHUNK_H, [&](const ChunkStats &st) { heat += st.heat; });
+                if (cold && heat == 0) continue;
+            }
+            update[col + row * cols] = 1;
+        }
+    }
+
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            int period = periodOf(col, row);
+            if (!update[col + row * cols]) continue;
+
+            int bx0 = (int)tickZone.x + col * CHUNK_W, bx1 = std::min(bx0 + CHUNK_W, zx1);
+            int by0 = (int)tickZone.y + row * CHUNK_H, by1 = std::min(by0 + CHUNK_H, zy1);
+            for (int y = by1 - 1; y >= by0; y--) {
+                for (int x = bx0; x < bx1; x++) {
+                    f32 n = 0.01;
+                    f32 v = 0;
+                    // for (int xx = -1; xx <= 1; xx++) {
+                    //  for (int yy = -1; yy <= 1; yy++) {
+                    //      f32 factor = abs(tiles[(x + xx) + (y + yy) * width].temperature) / 64 * tiles[(x + xx) + (y + yy) * width].mat->conductionOther;
+                    //      //factor = fmax(-1, fmin(factor, 1));
+
+                    //      v += tiles[(x + xx) + (y + yy) * width].temperature * factor;
+                    //      n += factor;
+
+                    //      // ((v1 * f1) + (v2 * f2)) / (f1 + f2)
+                    //      //=(v1 * f1) + (v2 * f2)
+                    //  }
+                    //}
+                    f32 factor = 0;
 #define FN(xa, ya)                                                                                                                             \
     if (real_tiles[(x + xa) + (y + ya) * width].temperature != 0) {                                                                            \
         factor = abs(real_tiles[(x + xa) + (y + ya) * width].temperature) / 64 * real_tiles[(x + xa) + (y + ya) * width].mat->conductionOther; \
         v += real_tiles[(x + xa) + (y + ya) * width].temperature * factor;                                                                     \
         n += factor;                                                                                                                           \
     }
-            FN(-1, -1);
-            FN(-1, 0);
-            FN(-1, 1);
-            FN(0, -1);
-            FN(0, 0);
-            FN(0, 1);
-            FN(1, -1);
-            FN(1, 0);
-            FN(1, 1);
+                    FN(-1, -1);
+                    FN(-1, 0);
+                    FN(-1, 1);
+                    FN(0, -1);
+                    FN(0, 0);
+                    FN(0, 1);
+                    FN(1, -1);
+                    FN(1, 0);
+                    FN(1, 1);
 
 #undef FN
 
-            if (v != 0) {
-                newTemps[x + y * width] = real_tiles[x + y * width].mat->addTemp + (v / n * real_tiles[x + y * width].mat->conductionSelf) +
-                                          (real_tiles[x + y * width].temperature * (1 - real_tiles[x + y * width].mat->conductionSelf));
-            } else {
-                newTemps[x + y * width] = real_tiles[x + y * width].mat->addTemp + real_tiles[x + y * width].temperature;
+                    const MaterialInstance &t = real_tiles[x + y * width];
+                    if (period == 1) {
+                        if (v != 0) {
+                            newTemps[x + y * width] = t.mat->addTemp + (v / n * t.mat->conductionSelf) + (t.temperature * (1 - t.mat->conductionSelf));
+                        } else {
+                            newTemps[x + y * width] = t.mat->addTemp + t.temperature;
+                        }
+                    } else {
+                        f32 keep = 1;
+                        for (int s = 0; s < period; s++) keep *= 1 - t.mat->conductionSelf;
+                        newTemps[x + y * width] = t.temperature + period * t.mat->addTemp + (v != 0 ? (1 - keep) * (v / n - t.temperature) : 0);
+                    }
+                }
             }
         }
     }
     // iterate
 
-    for (int y = (tickZone.y + tickZone.h) - 1; y >= tickZone.y; y--) {
-        for (int x = tickZone.x; x < (tickZone.x + tickZone.w); x++) {
-            real_tiles[x + y * width].temperature = newTemps[x + y * width];
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            if (!update[col + row * cols]) continue;
+            int bx0 = (int)tickZone.x + col * CHUNK_W, bx1 = std::min(bx0 + CHUNK_W, zx1);
+            int by0 = (int)tickZone.y + row * CHUNK_H, by1 = std::min(by0 + CHUNK_H, zy1);
+            mat_temperature lo = std::numeric_limits<mat_temperature>::max(), hi = std::numeric_limits<mat_temperature>::min();
+            for (int y = by0; y < by1; y++) {
+                for (int x = bx0; x < bx1; x++) {
+                    mat_temperature t = (mat_temperature)newTemps[x + y * width];
+                    real_tiles[x + y * width].temperature = t;
+                    if (stats) g.temp[x + y * width] = t;
+                    lo = std::min(lo, t);
+                    hi = std::max(hi, t);
+                }
+            }
+            if (!stats) continue;
+            // 正好是一整个统计块时直接得到温度范围 否则查询时重新扫描
+            if (bx0 % CHUNK_W == 0 && by0 % CHUNK_H == 0 && bx1 - bx0 == CHUNK_W && by1 - by0 == CHUNK_H) {
+                ChunkStats &st = g.blocks[bx0 / CHUNK_W + by0 / CHUNK_H * g.cols];
+                st.minTemp = lo;
+                st.maxTemp = hi;
+                st.tempStale = false;
+            } else {
+                for (int r = by0 / CHUNK_H; r <= (by1 - 1) / CHUNK_H; r++) {
+                    for (int c = bx0 / CHUNK_W; c <= (bx1 - 1) / CHUNK_W; c++) g.blocks[c + r * g.cols].tempStale = true;
+                }
+            }
         }
     }
     // copy
@@ -2005,227 +3328,437 @@ void world::tickTemperature() {
 
 void world::renderCells(unsigned char **texture) {
 
-    for (auto &cur : cells) {
-        if (cur->x < 0 || cur->x >= width || cur->y < 0 || cur->y >= height) continue;
+    const CellPool &P = cells;
+    for (u32 i = 0; i < P.capacity(); i++) {
+        if (!P.alive[i]) continue;
+        if (P.x[i] < 0 || P.x[i] >= width || P.y[i] < 0 || P.y[i] >= height) continue;
 
         f32 alphaMod = 1;
-        if (cur->temporary) {
-            if (cur->lifetime < cur->fadeTime) {
-                alphaMod = (cur->lifetime / (f32)cur->fadeTime);
+        if (P.temporary[i]) {
+            if (P.lifetime[i] < P.fadeTime[i]) {
+                alphaMod = (P.lifetime[i] / (f32)P.fadeTime[i]);
             }
         }
-        // f32 alphaMod = 1;
 
-        const unsigned int offset = (width * 4 * (int)cur->y) + (int)cur->x * 4;
-        u32 color = cur->tile.color;
-        (*texture)[offset + 2] = (color >> 0) & 0xff;                    // b
-        (*texture)[offset + 1] = (color >> 8) & 0xff;                    // g
-        (*texture)[offset + 0] = (color >> 16) & 0xff;                   // r
-        (*texture)[offset + 3] = (u8)(cur->tile.mat->alpha * alphaMod);  // a
-        // SDL_SetRenderDrawColor(renderer, (cur->tile.color >> 16) & 0xff, (cur->tile.color >> 8) & 0xff, (cur->tile.color >> 0) & 0xff, (u8)(cur->tile.mat->alpha * alphaMod));
-        // SDL_RenderDrawPoint(renderer, (int)cur->x, (int)cur->y);
+        const unsigned int offset = (width * 4 * (int)P.y[i]) + (int)P.x[i] * 4;
+        u32 color = P.tile[i].color;
+        (*texture)[offset + 2] = (color >> 0) & 0xff;                   // b
+        (*texture)[offset + 1] = (color >> 8) & 0xff;                   // g
+        (*texture)[offset + 0] = (color >> 16) & 0xff;                  // r
+        (*texture)[offset + 3] = (u8)(P.tile[i].mat->alpha * alphaMod);  // a
     }
 }
 
+// 粒子分两个阶段更新
+// 运动阶段: 只读 real_tiles 只写粒子自身字段 按所在区块分桶后放到 tickPool 并行
+// 落地阶段: 按目标格子与槽位确定写入顺序 再按槽位回收死亡粒子 结果与线程数无关
 void world::tickCells() {
 
-    auto func = [&](CellData *cur) {
-        if (cur->temporary && cur->lifetime <= 0) {
-            cur->killCallback();
-            delete cur;
-            return true;
-        }
+    CellPool &P = cells;
+    CellTickScratch &S = cellScratch;
+    P.deaths.clear();
+
+    const u32 cap = P.capacity();
+    S.outcome.assign(cap, CellTickScratch::KEEP);
+    S.landAt.resize(cap);
+
+    auto move = [&](u32 i) -> u8 {
+        if (P.temporary[i] && P.lifetime[i] <= 0) return CellTickScratch::KILL;
 
-        if (cur->targetForce != 0) {
-            f32 tdx = cur->targetX - cur->x;
-            f32 tdy = cur->targetY - cur->y;
+        if (P.targetForce[i] != 0) {
+            f32 tdx = P.targetX[i] - P.x[i];
+            f32 tdy = P.targetY[i] - P.y[i];
             f32 normFac = sqrtf(tdx * tdx + tdy * tdy);
 
-            cur->vx += tdx / normFac * cur->targetForce;
-            cur->vy += tdy / normFac * cur->targetForce;
+            P.vx[i] += tdx / normFac * P.targetForce[i];
+            P.vy[i] += tdy / normFac * P.targetForce[i];
+
+            if (normFac < 100) {
+                P.vx[i] *= 0.95f;
+                P.vy[i] *= 0.95f;
+            }
+        }
+
+        int lx = P.x[i];
+        int ly = P.y[i];
+
+        if ((P.x[i] < 0 || (int)(P.x[i]) >= width || P.y[i] < 0 || (int)(P.y[i]) >= height)) return CellTickScratch::KILL;
+
+        if (!(lx >= tickZone.x && ly >= tickZone.y && lx < tickZone.x + tickZone.w && ly < tickZone.y + tickZone.h)) return CellTickScratch::KEEP;
+
+        P.vx[i] += P.ax[i];
+        P.vy[i] += P.ay[i];
+
+        int div = (int)((abs(P.vx[i]) + abs(P.vy[i])) + 1);
+
+        f32 dvx = P.vx[i] / div;
+        f32 dvy = P.vy[i] / div;
+
+        for (int k = 0; k < div; k++) {
+            P.x[i] += dvx;
+            P.y[i] += dvy;
+
+            if ((P.x[i] < 0 || (int)(P.x[i]) >= width || P.y[i] < 0 || (int)(P.y[i]) >= height)) return CellTickScratch::KILL;
+
+            if (P.phase[i]) continue;
+
+            int type = real_tiles[(int)(P.x[i]) + (int)(P.y[i]) * width].mat->physicsType;
+            if (type == PhysicsType::AIR) continue;
+
+            bool isObject = type == PhysicsType::OBJECT;
+
+            switch (P.inObjectState[i]) {
+                case 0:  // first frame of particle's life
+                    P.inObjectState[i] = isObject ? 1 : 2;
+                    break;
+                case 1:  // particle spawned in object and was in object last tick
+                    if (!isObject) P.inObjectState[i] = 2;
+                    break;
+            }
+
+            if (!isObject || P.inObjectState[i] == 2) {
+                if (P.temporary[i]) return CellTickScratch::KILL;
+                S.landAt[i] = lx + ly * width;
+                return CellTickScratch::LAND;
+            }
+        }
+
+        if (P.lifetime[i] > 0) {
+            P.lifetime[i]--;
+        }
+
+        return CellTickScratch::KEEP;
+    };
+
+    // 按所在区块计数排序 最后一个桶放越界粒子
+    // 排序后 buckets[b] 是第 b 个桶在 order 中的终点
+    int chW = (width + CHUNK_W - 1) / CHUNK_W;
+    int chH = (height + CHUNK_H - 1) / CHUNK_H;
+    u32 nb = (u32)(chW * chH) + 1;
+    auto bucketOf = [&](u32 i) -> u32 {
+        if (P.x[i] < 0 || (int)P.x[i] >= width || P.y[i] < 0 || (int)P.y[i] >= height) return nb - 1;
+        return (int)P.x[i] / CHUNK_W + (int)P.y[i] / CHUNK_H * chW;
+    };
+
+    S.buckets.assign(nb + 1, 0);
+    for (u32 i = 0; i < cap; i++)
+        if (P.alive[i]) S.buckets[bucketOf(i) + 1]++;
+    for (u32 b = 0; b < nb; b++) S.buckets[b + 1] += S.buckets[b];
+    S.order.resize(P.size());
+    for (u32 i = 0; i < cap; i++)
+        if (P.alive[i]) S.order[S.buckets[bucketOf(i)]++] = i;
+
+    const u32 n = (u32)S.order.size();
+    thread_pool *pool = world_sys.tickPool.get();
+
+    if (cellsParallel && pool != nullptr && n >= 4096) {
+        // 相邻的整桶合并成大小相近的任务
+        u32 target = std::max(n / (u32)(pool->size() * 2), 1u);
+        std::vector<std::future<void>> results;
+        u32 begin = 0;
+        for (u32 b = 0; b < nb; b++) {
+            u32 end = S.buckets[b];
+            if (end - begin >= target || (b == nb - 1 && end > begin)) {
+                results.push_back(pool->push([&, begin, end](int id) {
+                    for (u32 k = begin; k < end; k++) S.outcome[S.order[k]] = move(S.order[k]);
+                }));
+                begin = end;
+            }
+        }
+        for (auto &r : results) r.get();
+    } else {
+        for (u32 k = 0; k < n; k++) S.outcome[S.order[k]] = move(S.order[k]);
+    }
+
+    // 落地: 按 (目标格子, 槽位) 排序 每个目标格子由槽位最小的粒子占据
+    // 各组写入的格子互不相同 可以并行 目标已被占用或同格的其余粒子按槽位顺序串行螺旋搜索
+    S.lands.clear();
+    S.overflow.clear();
+    for (u32 i = 0; i < cap; i++)
+        if (P.alive[i] && S.outcome[i] == CellTickScratch::LAND) S.lands.push_back({S.landAt[i], i});
+    std::sort(S.lands.begin(), S.lands.end());
+
+    auto settle = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; k++) {
+            auto [at, i] = S.lands[k];
+            if (k > 0 && S.lands[k - 1].first == at) continue;
+            if (real_tiles[at].mat->physicsType != PhysicsType::AIR) continue;
+            real_tiles[at] = P.tile[i];
+            dirty[at] = true;
+            S.outcome[i] = CellTickScratch::KILL;
+        }
+    };
+
+    const size_t nl = S.lands.size();
+    if (cellsParallel && pool != nullptr && nl >= 4096) {
+        size_t target = std::max(nl / (size_t)(pool->size() * 2), (size_t)1);
+        std::vector<std::future<void>> results;
+        size_t begin = 0;
+        while (begin < nl) {
+            // 切分点不落在同一个目标格子中间
+            size_t end = std::min(begin + target, nl);
+            while (end < nl && S.lands[end].first == S.lands[end - 1].first) end++;
+            results.push_back(pool->push([&, begin, end](int id) { settle(begin, end); }));
+            begin = end;
+        }
+        for (auto &r : results) r.get();
+    } else {
+        settle(0, nl);
+    }
+
+    for (auto [at, i] : S.lands)
+        if (S.outcome[i] == CellTickScratch::LAND) S.overflow.push_back(i);
+    std::sort(S.overflow.begin(), S.overflow.end());
+
+    for (u32 i : S.overflow) {
+        // 原位置已被占用 螺旋搜索附近的空位
+        bool succeeded = false;
+        {
+            int X = 32;
+            int Y = 32;
+            int x = 0, y = 0, dx = 0, dy = -1;
+            int t = std::max(X, Y);
+            int maxI = t * t;
+
+            for (int j = 0; j < maxI; j++) {
+                if ((-X / 2 <= x) && (x <= X / 2) && (-Y / 2 <= y) && (y <= Y / 2)) {
+                    int idx = (int)(P.x[i] + x) + (int)(P.y[i] + y) * width;
+                    if (real_tiles[idx].mat->physicsType == PhysicsType::AIR) {
+                        real_tiles[idx] = P.tile[i];
+                        dirty[idx] = true;
+                        succeeded = true;
+                        break;
+                    } else if (P.tile[i].mat->physicsType == PhysicsType::SOUP && P.tile[i].mat == real_tiles[idx].mat) {
+                        real_tiles[idx].fluidAmount += P.tile[i].fluidAmount;
+                        dirty[idx] = true;
+                        succeeded = true;
+                        break;
+                    }
+                }
+
+                if ((x == y) || ((x < 0) && (x == -y)) || ((x > 0) && (x == 1 - y))) {
+                    t = dx;
+                    dx = -dy;
+                    dy = t;
+                }
+                x += dx;
+                y += dy;
+            }
+        }
+
+        if (succeeded) {
+            S.outcome[i] = CellTickScratch::KILL;
+        } else {
+            P.vy[i] = -4;
+            P.y[i] -= 16;
+        }
+    }
+
+    // 按槽位顺序回收 空闲链表的顺序与线程数无关
+    for (u32 i = 0; i < cap; i++)
+        if (P.alive[i] && S.outcome[i] == CellTickScratch::KILL) P.kill(i);
+}
+
+void world::tickObjectsMesh() {
+
+    for (int i = 0; i < rigidBodies.size(); i++) {
+        RigidBody *cur = rigidBodies[i];
+        if (!static_cast<bool>(cur->get_surface())) {
+            rigidBodies.erase(cur);
+            i--;
+            continue;
+        };
+        if (cur->needsUpdate && cur->body->IsEnabled()) {
+            updateRigidBodyHitbox(cur);
+            // cur 被移除时末尾元素换到了 i
+            if (i < rigidBodies.size() && rigidBodies[i] != cur) i--;
+        }
+    }
+}
+
+// 世界坐标 v 所在的区块坐标 与 chunkSaveCache 中 tx = cx * CHUNK_W + loadZone.x 对应
+static ME_INLINE int chunk_coord(f32 v, f32 zone, int size) { return (int)std::floor((v - zone) / size); }
 
-            if (normFac < 100) {
-                cur->vx *= 0.95f;
-                cur->vy *= 0.95f;
-            }
-        }
+static ME_INLINE bool in_zone(const MErect &zone, f32 x, f32 y, f32 margin) {
+    return x >= zone.x - margin && y >= zone.y - margin && x < zone.x + zone.w + margin && y < zone.y + zone.h + margin;
+}
 
-        int lx = cur->x;
-        int ly = cur->y;
+void world::tickObjectBounds() {
 
-        if ((cur->x < 0 || (int)(cur->x) >= width || cur->y < 0 || (int)(cur->y) >= height)) {
-            cur->killCallback();
-            return true;
-        }
+    // 确定那些物体需要物理运算
+    // 这里只收集状态变化 由 applyObjectBounds 在主线程统一修改宽相位
 
-        if (!(lx >= tickZone.x && ly >= tickZone.y && lx < tickZone.x + tickZone.w && ly < tickZone.y + tickZone.h)) return false;
+    boundsEnable.clear();
+    boundsDisable.clear();
+    boundsFreeze.clear();
 
-        cur->vx += cur->ax;
-        cur->vy += cur->ay;
+    int dormant = 0;
+    for (RigidBody *cur : rigidBodies) {
+        if (cur->is_cleaned) continue;
 
-        int div = (int)((abs(cur->vx) + abs(cur->vy)) + 1);
+        b2Body *body = cur->body;
+        f32 x = body->GetWorldCenter().x;
+        f32 y = body->GetWorldCenter().y;
 
-        f32 dvx = cur->vx / div;
-        f32 dvy = cur->vy / div;
+        if (body->IsEnabled()) {
+            // box2d 编译时未开启休眠 按速度判断是否静止
+            bool resting = body->GetLinearVelocity().LengthSquared() < 0.01f && std::abs(body->GetAngularVelocity()) < 0.01f;
+            cur->restTicks = resting ? (u16)std::min(cur->restTicks + 1, 0xffff) : 0;
+            cur->offZoneTicks = 0;
 
-        for (int i = 0; i < div; i++) {
-            cur->x += dvx;
-            cur->y += dvy;
+            // 边带内运动中的刚体保持启用 越过外缘或已静止才停用 避免在 tickZone 边缘反复切换
+            bool inside = in_zone(tickZone, x, y, 0);
+            if (!in_zone(tickZone, x, y, rbBoundsMargin) || (!inside && cur->restTicks >= rbRestTicks)) boundsDisable.push_back(cur);
+            continue;
+        }
 
-            if ((cur->x < 0 || (int)(cur->x) >= width || cur->y < 0 || (int)(cur->y) >= height)) {
-                cur->killCallback();
-                return true;
-            }
+        // 停用前已静止的刚体不会自己移动 需深入 tickZone rbBoundsMargin 才重新启用
+        f32 enter = cur->restTicks >= rbRestTicks ? -rbBoundsMargin : 0.0f;
+        if (in_zone(tickZone, x, y, enter)) {
+            boundsEnable.push_back(cur);
+            continue;
+        }
+        dormant++;
 
-            if (!cur->phase && real_tiles[(int)(cur->x) + (int)(cur->y) * width].mat->physicsType != PhysicsType::AIR) {
-                bool allowCollision = true;
-                bool isObject = real_tiles[(int)(cur->x) + (int)(cur->y) * width].mat->physicsType == PhysicsType::OBJECT;
+        // 物品与非动态刚体只停用 不冻结
+        if (rbFreeze && cur->item == nullptr && body->GetType() == b2_dynamicBody && !in_zone(tickZone, x, y, rbFreezeMargin)) {
+            cur->offZoneTicks = (u16)std::min(cur->offZoneTicks + 1, 0xffff);
+            if (cur->offZoneTicks >= rbFreezeTicks) boundsFreeze.push_back(cur);
+        } else {
+            cur->offZoneTicks = 0;
+        }
+    }
+    boundsStats.dormant = dormant;
+}
 
-                switch (cur->inObjectState) {
-                    case 0:  // first frame of particle's life
-                        if (isObject) {
-                            cur->inObjectState = 1;
-                        } else {
-                            cur->inObjectState = 2;
-                        }
-                        break;
-                    case 1:  // particle spawned in object and was in object last tick
-                        if (!isObject) cur->inObjectState = 2;
-                        break;
-                }
+void world::applyObjectBounds() {
 
-                if (!isObject || cur->inObjectState == 2) {
-                    if (cur->temporary) {
-                        cur->killCallback();
-                        delete cur;
-                        return true;
-                    }
+    Timer timer;
+    timer.start();
 
-                    if (real_tiles[(int)(lx) + (int)(ly)*width].mat->physicsType != PhysicsType::AIR) {
-                        /*for (int y = 0; y < 40; y++) {
-                            if (tiles[(int)(cur->x) + (int)(cur->y - y) * width].mat->physicsType == PhysicsType::AIR) {
-                                tiles[(int)(cur->x) + (int)(cur->y - y) * width] = cur->tile;
-                                dirty[(int)(cur->x) + (int)(cur->y - y) * width] = true;
-                                break;
-                            }
-                        }*/
-
-                        bool succeeded = false;
-                        {
-                            // printf("=========");
-                            int X = 32;
-                            int Y = 32;
-                            int x = 0, y = 0, dx = 0, dy = -1;
-                            int t = std::max(X, Y);
-                            int maxI = t * t;
-
-                            for (int j = 0; j < maxI; j++) {
-                                if ((-X / 2 <= x) && (x <= X / 2) && (-Y / 2 <= y) && (y <= Y / 2)) {
-                                    // printf("%d, %d", x, y);
-                                    // DO STUFF
-                                    if (real_tiles[(int)(cur->x + x) + (int)(cur->y + y) * width].mat->physicsType == PhysicsType::AIR) {
-                                        real_tiles[(int)(cur->x + x) + (int)(cur->y + y) * width] = cur->tile;
-                                        dirty[(int)(cur->x + x) + (int)(cur->y + y) * width] = true;
-                                        succeeded = true;
-                                        break;
-                                    } else if (cur->tile.mat->physicsType == PhysicsType::SOUP && cur->tile.mat == real_tiles[(int)(cur->x + x) + (int)(cur->y + y) * width].mat) {
-
-                                        real_tiles[(int)(cur->x + x) + (int)(cur->y + y) * width].fluidAmount += cur->tile.fluidAmount;
-                                        dirty[(int)(cur->x + x) + (int)(cur->y + y) * width] = true;
-                                        succeeded = true;
-                                        break;
-                                    }
-                                }
+    // 宽相位在 Add/Remove 时只标记重建 一批状态变化在下一次 Step 中只重建一次
+    for (RigidBody *cur : boundsDisable) cur->body->SetEnabled(false);
+    for (RigidBody *cur : boundsEnable) {
+        cur->body->SetEnabled(true);
+        cur->restTicks = 0;
+    }
 
-                                if ((x == y) || ((x < 0) && (x == -y)) || ((x > 0) && (x == 1 - y))) {
-                                    t = dx;
-                                    dx = -dy;
-                                    dy = t;
-                                }
-                                x += dx;
-                                y += dy;
-                            }
-                        }
+    int frozen = 0;
+    for (RigidBody *cur : boundsFreeze) {
+        if (freezeRigidBody(cur)) frozen++;
+    }
 
-                        if (succeeded) {
-                            cur->killCallback();
-                            delete cur;
-                            return true;
-                        } else {
-                            cur->vy = -4;
-                            cur->y -= 16;
-                            return false;
-                        }
-                    } else {
-                        real_tiles[(int)(lx) + (int)(ly)*width] = cur->tile;
-                        dirty[(int)(lx) + (int)(ly)*width] = true;
-                        cur->killCallback();
-                        delete cur;
-                        return true;
-                    }
+    // 冻结刚体的质心回到 tickZone 时解冻 每帧最多 rbThawBudget 个
+    int thawed = 0;
+    for (auto &p : chunkCache) {
+        if (p.first == INT_MIN) continue;
+        for (auto &p2 : p.second) {
+            if (p2.first == INT_MIN) continue;
+            Chunk *ch = p2.second;
+            if (!ch->hasTileCache || ch->frozenBodies.empty()) continue;
+
+            f32 ox = (f32)(ch->x * CHUNK_W + loadZone.x);
+            f32 oy = (f32)(ch->y * CHUNK_H + loadZone.y);
+            std::vector<FrozenBody> &list = ch->frozenBodies;
+            for (size_t i = 0; i < list.size() && thawed < rbThawBudget;) {
+                if (!in_zone(tickZone, ox + list[i].cx, oy + list[i].cy, 0)) {
+                    i++;
+                    continue;
                 }
+                thawRigidBody(ch, list[i]);
+                thawed++;
+                list[i] = std::move(list.back());
+                list.pop_back();
             }
         }
+    }
 
-        if (cur->lifetime > 0) {
-            cur->lifetime--;
-        }
-
-        return false;
-    };
-
-    // cells.erase(std::remove_if(cells.begin(), cells.end(), func), cells.end());
+    timer.stop();
+    boundsStats.lastMs = timer.get();
+    boundsStats.enabled = (int)boundsEnable.size();
+    boundsStats.disabled = (int)boundsDisable.size();
+    boundsStats.frozen = frozen;
+    boundsStats.thawed = thawed;
 
-    std::erase_if(cells, func);
+    boundsEnable.clear();
+    boundsDisable.clear();
+    boundsFreeze.clear();
+}
 
-    // // Better cells removal effects
-    // std::for_each(cells.begin(), cells.end(), [](CellData *cur) {
-    //     cur->vx += cur->ax;
-    //     cur->vy += cur->ay;
-    //     cur->x += cur->vx;
-    //     cur->y += cur->vy;
-    //     // return cur->y > height;
-    // });
+bool world::freezeRigidBody(RigidBody *rb) {
 
-    std::erase_if(cells, [&](auto c) { return c->y > height; });
+    b2Body *body = rb->body;
+    if (rb->tiles == nullptr || body == nullptr) return false;
 
-    // std::remove_if(cells.begin(), cells.end(), [&](CellData* cur) {
-    //  return cur->y > height;
-    // });
-}
+    b2Vec2 center = body->GetWorldCenter();
+    auto xx = chunkCache.find(chunk_coord(center.x, (f32)loadZone.x, CHUNK_W));
+    if (xx == chunkCache.end()) return false;
+    auto yy = xx->second.find(chunk_coord(center.y, (f32)loadZone.y, CHUNK_H));
+    if (yy == xx->second.end() || !yy->second->hasTileCache) return false;
+    Chunk *ch = yy->second;
 
-void world::tickObjectsMesh() {
+    f32 ox = (f32)(ch->x * CHUNK_W + loadZone.x);
+    f32 oy = (f32)(ch->y * CHUNK_H + loadZone.y);
 
-    std::vector<RigidBody *> *rbs = &rigidBodies;
-    for (int i = 0; i < rbs->size(); i++) {
-        RigidBody *cur = (*rbs)[i];
-        if (!static_cast<bool>(cur->get_surface())) {
-            // rigidBodies.erase(std::remove(rigidBodies.begin(), rigidBodies.end(), cur), rigidBodies.end());
-            std::erase_if(rigidBodies, [&](auto c) { return cur == c; });
-            continue;
-        };
-        if (cur->needsUpdate && cur->body->IsEnabled()) {
-            updateRigidBodyHitbox(cur);
-        }
+    FrozenBody fb;
+    for (b2Fixture *f = body->GetFixtureList(); f; f = f->GetNext()) {
+        if (f->GetType() != b2Shape::e_polygon) continue;
+        fb.shapes.push_back(*(b2PolygonShape *)f->GetShape());
+        fb.density = f->GetDensity();
+        fb.friction = f->GetFriction();
     }
+    if (fb.shapes.empty()) return false;
+
+    fb.x = body->GetPosition().x - ox;
+    fb.y = body->GetPosition().y - oy;
+    fb.cx = center.x - ox;
+    fb.cy = center.y - oy;
+    fb.angle = body->GetAngle();
+    fb.vx = body->GetLinearVelocity().x;
+    fb.vy = body->GetLinearVelocity().y;
+    fb.av = body->GetAngularVelocity();
+    fb.needsUpdate = rb->needsUpdate;
+    fb.w = rb->matWidth;
+    fb.h = rb->matHeight;
+    fb.tiles.resize((size_t)fb.w * fb.h);
+    for (int i = 0; i < fb.w * fb.h; i++) fb.tiles[i] = {(mat_instance_id)rb->tiles[i].mat->id, rb->tiles[i].color, rb->tiles[i].temperature};
+
+    ch->frozenBodies.push_back(std::move(fb));
+    // 区块内容已不能由种子重现
+    ch->pristine = false;
+
+    b2world->DestroyBody(body);
+    rigidBodies.erase(rb);
+    rb->clean();
+    delete rb;
+    return true;
 }
 
-void world::tickObjectBounds() {
-
-    std::vector<RigidBody *> rbs = rigidBodies;
+RigidBody *world::thawRigidBody(Chunk *ch, const FrozenBody &fb) {
 
-    // 确定那些物体需要物理运算
-    // 这一部分在物理引擎部分计算了 到时候只需要确定chunk就行了
-
-    for (int i = 0; i < rbs.size(); i++) {
-        RigidBody *cur = rbs[i];
+    f32 ox = (f32)(ch->x * CHUNK_W + loadZone.x);
+    f32 oy = (f32)(ch->y * CHUNK_H + loadZone.y);
 
-        if (cur->is_cleaned) continue;
+    // surface 由 tiles 写回 makeRigidBodyMulti 从透明 surface 得到的全是空气
+    C_Surface *sfc = SDL_CreateRGBSurfaceWithFormat(0, fb.w, fb.h, 32, SDL_PIXELFORMAT_ARGB8888);
+    RigidBody *rb = makeRigidBodyMulti(b2_dynamicBody, ox + fb.x, oy + fb.y, fb.angle * 180 / PI, fb.shapes, fb.density, fb.friction, create_ref<Texture>(sfc));
 
-        f32 x = cur->body->GetWorldCenter().x;
-        f32 y = cur->body->GetWorldCenter().y;
-        cur->body->SetEnabled(x >= tickZone.x && y >= tickZone.y && x < tickZone.x + tickZone.w && y < tickZone.y + tickZone.h);
+    for (int i = 0; i < fb.w * fb.h; i++) {
+        MaterialInstance &t = rb->tiles[i];
+        t.mat = GAME()->materials_array[fb.tiles[i].index];
+        t.color = fb.tiles[i].color;
+        t.temperature = fb.tiles[i].temperature;
     }
+    rb->buildMask();
+    rb->syncSurface();
+    rb->maskChanged = fb.needsUpdate;
+    rb->needsUpdate = fb.needsUpdate;
+    rb->texNeedsUpdate = true;
+
+    rb->body->SetLinearVelocity({fb.vx, fb.vy});
+    rb->body->SetAngularVelocity(fb.av);
+    rigidBodies.push_back(rb);
+    return rb;
 }
 
 void world::tickObjects() {
@@ -2235,10 +3768,7 @@ void world::tickObjects() {
     int maxX = 0;
     int maxY = 0;
 
-    std::vector<RigidBody *> rbs = rigidBodies;
-    for (int i = 0; i < rbs.size(); i++) {
-        RigidBody *cur = rbs[i];
-
+    for (RigidBody *cur : rigidBodies) {
         f32 x = cur->body->GetWorldCenter().x;
         f32 y = cur->body->GetWorldCenter().y;
 
@@ -2289,46 +3819,142 @@ void world::tickObjects() {
 #endif
 }
 
-void world::addCell(CellData *cell) { cells.push_back(cell); }
+CellHandle world::addCell(const CellData &cell) { return cells.add(cell); }
 
-void world::explosion(int cx, int cy, int radius) {
-    audioEngine->PlayEvent("event:/Explode");
+void world::explosion(int cx, int cy, int radius) { explosionQueue.push_back({cx, cy, radius}); }
 
-    int outerRadius = radius * 2;
-    for (int x = cx - outerRadius; x < cx + outerRadius; x++) {
-        for (int y = cy - outerRadius; y < cy + outerRadius; y++) {
-            MaterialInstance tile = getTile(x, y);
-            if (tile.mat->physicsType == PhysicsType::AIR) continue;
-
-            int dx = x - cx;
-            int dy = y - cy;
-            if (dx * dx + dy * dy < radius * radius) {
-                if (tile.mat->physicsType == PhysicsType::SOLID || rand() % 10 < 6) {
-                    setTile(x, y, Tiles_NOTHING);
-                } else {
-
-                    int r = (tile.color >> 16) & 0xFF;
-                    int g = (tile.color >> 8) & 0xFF;
-                    int b = (tile.color >> 0) & 0xFF;
+// 按格子与爆炸中心取随机数 与处理顺序和线程无关
+static ME_INLINE u32 explosion_hash(int x, int y, int cx, int cy) {
+    u32 h = (u32)x * 73856093u ^ (u32)y * 19349663u ^ (u32)cx * 83492791u ^ (u32)cy * 2654435761u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return h;
+}
 
-                    u32 rgb = r / 4;
-                    rgb = (rgb << 8) + g / 4;
-                    rgb = (rgb << 8) + b / 4;
+std::vector<std::pair<int, int>> world::applyExplosions(const std::vector<Explosion> &batch) {
 
-                    tile.color = rgb;
+    // 区块与 solidBits/collideBits 的字对齐 各区块任务写入的格子与字互不重叠
+    struct Region {
+        int cx, cy;
+        std::vector<int> hits;
+        std::vector<CellData> cells;
+    };
+    std::vector<Region> regions;
+    phmap::flat_hash_map<u64, int> regionIndex;
+
+    for (int i = 0; i < batch.size(); i++) {
+        const Explosion &e = batch[i];
+        int outer = e.radius * 2;
+        int x0 = std::max(e.x - outer, 0), x1 = std::min(e.x + outer, (int)width);
+        int y0 = std::max(e.y - outer, 0), y1 = std::min(e.y + outer, (int)height);
+        if (x0 >= x1 || y0 >= y1) continue;
+        for (int cx = x0 / CHUNK_W; cx <= (x1 - 1) / CHUNK_W; cx++) {
+            for (int cy = y0 / CHUNK_H; cy <= (y1 - 1) / CHUNK_H; cy++) {
+                u64 key = ((u64)(u32)cx << 32) | (u32)cy;
+                auto it = regionIndex.find(key);
+                if (it == regionIndex.end()) {
+                    it = regionIndex.emplace(key, (int)regions.size()).first;
+                    regions.push_back({cx, cy});
+                }
+                regions[it->second].hits.push_back(i);
+            }
+        }
+    }
 
-                    cells.push_back(new CellData(tile, x, y + 1, dx / 10.0f + (rand() % 10 - 5) / 10.0f, dy / 6.0f + (rand() % 10 - 5) / 10.0f, 0, 0.1f));
-                    setTile(x, y, Tiles_NOTHING);
+    auto run = [&](Region &r) {
+        int rx0 = r.cx * CHUNK_W, rx1 = std::min(rx0 + CHUNK_W, (int)width);
+        int ry0 = r.cy * CHUNK_H, ry1 = std::min(ry0 + CHUNK_H, (int)height);
+        for (int i : r.hits) {
+            const Explosion &e = batch[i];
+            int radius = e.radius;
+            int outerRadius = radius * 2;
+            int x0 = std::max(e.x - outerRadius, rx0), x1 = std::min(e.x + outerRadius, rx1);
+            int y0 = std::max(e.y - outerRadius, ry0), y1 = std::min(e.y + outerRadius, ry1);
+            for (int x = x0; x < x1; x++) {
+                for (int y = y0; y < y1; y++) {
+                    MaterialInstance tile = real_tiles[x + y * width];
+                    if (tile.mat->physicsType == PhysicsType::AIR) continue;
+
+                    int dx = x - e.x;
+                    int dy = y - e.y;
+                    u32 h = explosion_hash(x, y, e.x, e.y);
+                    f32 vx = dx / 10.0f + ((int)((h >> 8) % 10) - 5) / 10.0f;
+                    f32 vy = dy / 6.0f + ((int)((h >> 16) % 10) - 5) / 10.0f;
+                    if (dx * dx + dy * dy < radius * radius) {
+                        if (tile.mat->physicsType != PhysicsType::SOLID && h % 10 >= 6) {
+                            int cr = (tile.color >> 16) & 0xFF;
+                            int cg = (tile.color >> 8) & 0xFF;
+                            int cb = (tile.color >> 0) & 0xFF;
+
+                            u32 rgb = cr / 4;
+                            rgb = (rgb << 8) + cg / 4;
+                            rgb = (rgb << 8) + cb / 4;
+
+                            tile.color = rgb;
+
+                            r.cells.emplace_back(tile, x, y + 1, vx, vy, 0, 0.1f);
+                        }
+                    } else if (dx * dx + dy * dy < outerRadius * outerRadius && tile.mat->physicsType != PhysicsType::SOLID) {
+                        r.cells.emplace_back(tile, x, y, vx, vy, 0, 0.1f);
+                    } else {
+                        continue;
+                    }
+                    real_tiles[x + y * width] = Tiles_NOTHING;
+                    dirty[x + y * width] = true;
+                    if (!solidBits.empty()) setTileBits(x, y, Tiles_NOTHING.mat);
                 }
-            } else if (dx * dx + dy * dy < outerRadius * outerRadius && tile.mat->physicsType != PhysicsType::SOLID) {
-                cells.push_back(new CellData(tile, x, y, dx / 10.0f + (rand() % 10 - 5) / 10.0f, dy / 6.0f + (rand() % 10 - 5) / 10.0f, 0, 0.1f));
-                setTile(x, y, Tiles_NOTHING);
             }
         }
+    };
+
+    if (regions.size() > 1) {
+        std::vector<std::future<void>> results;
+        for (Region &r : regions) results.push_back(world_sys.tickPool->push([&run, &r](int id) { run(r); }));
+        for (auto &f : results) f.get();
+    } else {
+        for (Region &r : regions) run(r);
+    }
+
+    for (Region &r : regions)
+        for (const CellData &c : r.cells) cells.add(c);
+    explosionStats.regions = (int)regions.size();
+
+    // 爆炸边缘一圈的实心格子作为种子
+    std::vector<std::pair<int, int>> seeds;
+    for (const Explosion &e : batch) {
+        int ring = e.radius + 1;
+        int n = std::max(8, (int)(2 * PI * ring / 4));
+        for (int i = 0; i < n; i++) {
+            f32 a = 2 * PI * i / n;
+            seeds.emplace_back(e.x + (int)(cos(a) * ring), e.y + (int)(sin(a) * ring));
+        }
     }
+    return seeds;
+}
+
+void world::tickExplosions() {
+    if (explosionQueue.empty()) return;
+
+    Timer timer;
+    timer.start();
+
+    std::vector<Explosion> batch;
+    batch.swap(explosionQueue);
+
+    // 连锁爆炸只播放一次音效
+    if (audioEngine) audioEngine->PlayEvent("event:/Explode");
+
+    // 所有爆炸的种子一起标记 被炸断的碎块只分离一次 地形网格只重建一次
+    std::vector<RigidBody *> bodies = physicsCheckBatch(applyExplosions(batch));
 
     // 预计在下一个世界tick重新计算mesh
     lastMeshZone = {};
+
+    timer.stop();
+    explosionStats.lastMs = timer.get();
+    explosionStats.explosions = (int)batch.size();
+    explosionStats.bodies = (int)bodies.size();
 }
 
 void world::frame() {
@@ -2479,6 +4105,10 @@ void world::tickChunks() {
                 }
             }
 
+            // 平移不一定按 64 对齐 直接整体重建位图
+            syncSolidBits(0, 0, width, height);
+            rebuildChunkStats();
+
             if (changeX < 0) {
                 for (int i = 0; i < abs(changeX); i++) {
                     if ((((int)loadZone.x - changeX - i) + (int)loadZone.w) % CHUNK_W == 0) {
@@ -2575,13 +4205,13 @@ void world::tickChunks() {
                 }
             }
 
-            for (int i = 0; i < cells.size(); i++) {
-                cells[i]->x += changeX;
-                cells[i]->y += changeY;
+            for (u32 i = 0; i < cells.capacity(); i++) {
+                cells.x[i] += changeX;
+                cells.y[i] += changeY;
             }
 
             for (int i = 0; i < rigidBodies.size(); i++) {
-                RigidBody cur = *rigidBodies[i];
+                RigidBody &cur = *rigidBodies[i];
                 cur.body->SetTransform(b2Vec2(cur.body->GetPosition().x + changeX, cur.body->GetPosition().y + changeY), cur.body->GetAngle());
             }
         }
@@ -2663,6 +4293,8 @@ void world::queueLoadChunk(int cx, int cy, bool populate, bool render) {
             // dirty[tx + ty * width] = true;
         }
     }
+    syncSolidBits(cx * CHUNK_W + loadZone.x, cy * CHUNK_H + loadZone.y, CHUNK_W, CHUNK_H);
+    syncChunkStats(cx * CHUNK_W + loadZone.x, cy * CHUNK_H + loadZone.y, CHUNK_W, CHUNK_H);
 
     // loadChunk(cx, cy, populate);
 }
@@ -2675,11 +4307,22 @@ Chunk *world::loadChunk(Chunk *ch, bool populate, bool render) {
 
     ch->pleaseDelete = false;
 
-    auto generate_chunk_func = [this](Chunk *chunk) {
+    // 滑动平均
+    auto update_avg = [](f64 &avg, f64 v) { avg = avg == 0.0 ? v : avg * 0.9 + v * 0.1; };
+
+    auto generate_chunk_func = [this, &update_avg](Chunk *chunk) {
+        Timer timer;
+        timer.start();
         this->generateChunk(chunk);
         chunk->generationPhase = 0;
         chunk->hasTileCache = true;
         this->populateChunk(chunk, 0, false);
+        timer.stop();
+        update_avg(chunkGenAvgMs, timer.get());
+
+        // 刚生成的区块可以由种子重现 除非重新生成比读盘更慢
+        chunk->pristine = preferRegenerate();
+        chunk->pristineHash = chunk->pristine ? chunk->ChunkContentHash() : 0;
         if (!noSaveLoad) chunk->ChunkWrite(chunk->tiles, chunk->layer2, chunk->background);
     };
 
@@ -2687,7 +4330,12 @@ Chunk *world::loadChunk(Chunk *ch, bool populate, bool render) {
         // prop = ch->tiles;
     } else if (ch->ChunkHasFile() && !noSaveLoad) {
         try {
+            Timer timer;
+            timer.start();
             ch->ChunkRead();
+            timer.stop();
+            update_avg(chunkReadAvgMs, timer.get());
+            ch->pristine = false;
         } catch (...) {
             METADOT_BUG(std::format("Failed to read chunk {0} {1} so regenerate it", ch->x, ch->y).c_str());
             generate_chunk_func(ch);
@@ -2763,9 +4411,23 @@ void world::unloadChunk(Chunk *ch) {
     // }
     // ch->write(data, layer2);
 
+    // 质心在该区块内的刚体随区块写入 重新加载后回到 tickZone 时解冻
+    if (rbFreeze && b2world) {
+        for (int i = 0; i < rigidBodies.size(); i++) {
+            RigidBody *cur = rigidBodies[i];
+            if (cur->is_cleaned || cur->item != nullptr || cur->body->GetType() != b2_dynamicBody) continue;
+            b2Vec2 c = cur->body->GetWorldCenter();
+            if (chunk_coord(c.x, (f32)loadZone.x, CHUNK_W) != ch->x || chunk_coord(c.y, (f32)loadZone.y, CHUNK_H) != ch->y) continue;
+            // 末尾元素换到了 i
+            if (freezeRigidBody(cur)) i--;
+        }
+    }
+
     chunkSaveCache(ch);
     if (!noSaveLoad) writeChunkToDisk(ch);
 
+    releaseChunkMesh(ch);
+
     if (chunkCache[ch->x].contains(ch->y)) {
         chunkCache[ch->x].erase(ch->y);
     }
@@ -2789,9 +4451,25 @@ void world::chunkSaveCache(Chunk *ch) {
             ch->background[x + y * CHUNK_W] = background[tx + ty * width];
         }
     }
+
+    // 内容与生成时不一致 说明区块被修改过 之后需要写盘
+    if (ch->pristine && ch->ChunkContentHash() != ch->pristineHash) ch->pristine = false;
+}
+
+void world::generateChunk(Chunk *ch) {
+    // 按世界种子与区块坐标播种 重新生成同一区块时结果一致
+    u32 seed = (u32)noise.GetSeed();
+    seed ^= (u32)ch->x * 0x8DA6B343u;
+    seed ^= (u32)ch->y * 0xD8163841u;
+    TilesSeedRand(seed);
+    gen->generateChunk(this, ch);
 }
 
-void world::generateChunk(Chunk *ch) { gen->generateChunk(this, ch); }
+bool world::preferRegenerate() const {
+    // 还没有读盘数据时默认重新生成
+    if (chunkReadAvgMs == 0.0) return true;
+    return chunkGenAvgMs <= chunkReadAvgMs;
+}
 
 int world::getBiomeAt(Chunk *ch, int x, int y) {
 
@@ -2858,19 +4536,9 @@ int world::getBiomeAt(int x, int y) {
 void world::addStructure(PlacedStructure str) {
     structures.push_back(str);
 
-    for (int x = 0; x < str.base.w; x++) {
-        for (int y = 0; y < str.base.h; y++) {
-            int dx = x + loadZone.x + str.x;
-            int dy = y + loadZone.y + str.y;
-            Chunk *ch = new Chunk;
-            ch->ChunkInit(floor(dx / CHUNK_W), floor(dy / CHUNK_H), worldName);
-            // if(ch.e)
-            if (dx >= 0 && dy >= 0 && dx < width && dy < height) {
-                real_tiles[dx + dy * width] = str.base.tiles[x + y * str.base.w];
-                dirty[dx + dy * width] = true;
-            }
-        }
-    }
+    // 按预编译的行段写入 只拷贝非空气格子
+    if (!str.base.compiled()) str.base.compile();
+    str.base.stamp(real_tiles.data(), width, height, loadZone.x + str.x, loadZone.y + str.y, dirty);
 }
 
 MEvec2 world::getNearestPoint(f32 x, f32 y) {
@@ -2966,25 +4634,28 @@ void world::populateChunk(Chunk *ch, int phase, bool render) {
         if (populators[i]->getPhase() == phase) {
             std::vector<PlacedStructure> strs = populators[i]->apply(ch->tiles, ch->layer2, chs, dirtyChunk, ax * CHUNK_W, ay * CHUNK_H, aw * CHUNK_W, ah * CHUNK_H, ch, this);
             for (int j = 0; j < strs.size(); j++) {
-                for (int tx = 0; tx < strs[j].base.w; tx++) {
-                    for (int ty = 0; ty < strs[j].base.h; ty++) {
-                        int chx = (int)floor((tx + strs[j].x) / (f32)CHUNK_W) + 1 - ch->x;
-                        int chy = (int)floor((ty + strs[j].y) / (f32)CHUNK_H) + 1 - ch->y;
-                        int dxx = (CHUNK_W + ((tx + strs[j].x) % CHUNK_W)) % CHUNK_W;
-                        int dyy = (CHUNK_H + ((ty + strs[j].y) % CHUNK_H)) % CHUNK_H;
-                        if (strs[j].base.tiles[tx + ty * strs[j].base.w].mat->physicsType != PhysicsType::AIR) {
-                            chs[chx + chy * aw]->tiles[dxx + dyy * CHUNK_W] = strs[j].base.tiles[tx + ty * strs[j].base.w];
-                            dirtyChunk[chx + chy * aw] = true;
-                        }
+                // 每个区块只做几次行段拷贝 不再逐格计算 floor/取模
+                for (const StructureChunkRect &r : strs[j].splitChunks()) {
+                    int chx = r.cx - ax;
+                    int chy = r.cy - ay;
+                    if (chx < 0 || chy < 0 || chx >= aw || chy >= ah) continue;
+                    int ox = strs[j].x - r.cx * CHUNK_W;
+                    int oy = strs[j].y - r.cy * CHUNK_H;
+                    if (strs[j].base.stampRect(chs[chx + chy * aw]->tiles, CHUNK_W, ox, oy, r.x0, r.y0, r.x1, r.y1) > 0) {
+                        dirtyChunk[chx + chy * aw] = true;
                     }
                 }
             }
         }
     }
 
+    // 1 阶段以后的填充依赖周围区块当时的状态 无法单独重现
+    if (phase > 0) ch->pristine = false;
+
     for (int x = 0; x < aw; x++) {
         for (int y = 0; y < ah; y++) {
             if (dirtyChunk[x + y * aw]) {
+                chs[x + y * aw]->pristine = false;
                 if (x != aw / 2 && y != ah / 2) {
                     chs[x + y * aw]->ChunkWrite(chs[x + y * aw]->tiles, chs[x + y * aw]->layer2, chs[x + y * aw]->background);
                     if (render) {
@@ -3007,222 +4678,203 @@ void world::populateChunk(Chunk *ch, int phase, bool render) {
     }
 }
 
-void world::tickEntities(R_Target *t) {
-
-    auto func = [&](WorldEntity *cur) {
-        int nIntersect = 0;
-        int avInX = 0;
-        int avInY = 0;
-        for (int xx = 0; xx < cur->hw; xx++) {
-            for (int yy = 0; yy < cur->hh; yy++) {
-                int sx = (cur->x + xx) + loadZone.x;
-                int sy = (cur->y + yy) + loadZone.y;
-                if (sx < 0 || sy < 0 || sx >= width || sy >= height) continue;
-
-                if (real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND ||
-                    real_tiles[sx + sy * width].mat->physicsType == PhysicsType::OBJECT) {
-                    nIntersect++;
-                    avInX += (xx - cur->hw / 2);
-                    avInY += (yy - cur->hh / 2);
+int world::collideBox(f32 nx, f32 ny, int hw, int hh, int *sumX, int *sumY) const {
+    // 格子坐标与逐格循环一样由浮点截断得到 盒跨过负坐标时列不连续 退回逐格判断
+    auto col = [&](int xx) -> int { return (nx + xx) + loadZone.x; };
+    int c0 = col(0);
+    bool rows = entityBits && !collideBits.empty() && hw > 0 && (nx + loadZone.x) >= 0 && col(hw - 1) - c0 == hw - 1;
+
+    int n = 0, ax = 0, ay = 0;
+    for (int yy = 0; yy < hh; yy++) {
+        int sy = (ny + yy) + loadZone.y;
+        if (sy < 0 || sy >= height) continue;
+
+        if (!rows) {
+            for (int xx = 0; xx < hw; xx++) {
+                int sx = col(xx);
+                if (sx < 0 || sx >= width) continue;
+                if (entityBits ? collideAt(sx, sy) : collides(real_tiles[sx + sy * width].mat)) {
+                    n++;
+                    ax += xx - hw / 2;
+                    ay += yy - hh / 2;
                 }
             }
+            continue;
         }
-        if (nIntersect > 0) {
-            cur->x += avInX > 0 ? -1 : (avInX < 0 ? 1 : 0);
-            cur->y += avInY > 0 ? -1 : (avInY < 0 ? 1 : 0);
-        }
-
-        cur->vy += 0.25;
-
-        if (cur->vx > 0.001) {
-            f32 stx = cur->x;
-            for (f32 dx = 0; dx < cur->vx; dx += cur->vx / 8.0) {
-                f32 nx = stx + dx;
-                f32 ny = cur->y;
-
-                bool collide = false;
-                for (int xx = 0; xx < cur->hw; xx++) {
-                    for (int yy = 0; yy < cur->hh; yy++) {
-                        int sx = (nx + xx) + loadZone.x;
-                        int sy = (ny + yy) + loadZone.y;
-                        if (sx >= 0 && sy >= 0 && sx < width && sy < height) {
-                            if (real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND ||
-                                real_tiles[sx + sy * width].mat->physicsType == PhysicsType::OBJECT) {
-                                if (yy == cur->hh - 1) {
-                                    for (int xx1 = 0; xx1 < cur->hw; xx1++) {
-                                        for (int yy1 = 0; yy1 < cur->hh; yy1++) {
-                                            int sx1 = (nx + xx1) + loadZone.x;
-                                            int sy1 = (ny + yy1) + loadZone.y - 1;
-                                            if (sx1 >= 0 && sy1 >= 0 && sx1 < width && sy1 < height) {
-                                                if (real_tiles[sx1 + sy1 * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx1 + sy1 * width].mat->physicsType == PhysicsType::SAND ||
-                                                    real_tiles[sx1 + sy1 * width].mat->physicsType == PhysicsType::OBJECT) {
-                                                    collide = true;
-                                                }
-                                            }
-                                        }
-                                    }
-                                    if (!collide) {
-                                        ny--;
-                                    }
-                                } else {
-                                    MaterialInstance tp = real_tiles[sx + sy * width];
-                                    if (tp.mat->physicsType == PhysicsType::SAND) {
-                                        addCell(new CellData(tp, sx, sy, (rand() % 10 - 5) / 10.0f + 0.5f, (rand() % 10 - 5) / 10.0f, 0, 0.1f));
-                                        real_tiles[sx + sy * width] = Tiles_NOTHING;
-                                        dirty[sx + sy * width] = true;
-
-                                        cur->vx *= 0.99;
-                                    } else {
-                                        collide = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
 
-                if (!collide) {
-                    cur->x = nx;
-                    cur->y = ny;
+        const u64 *row = &collideBits[sy * solidStride];
+        int x1 = std::min(c0 + hw, (int)width);
+        for (int x = c0; x < x1; x += 64) {
+            int len = std::min(64, x1 - x);
+            int off = x % 64;
+            u64 m = row[x / 64] >> off;
+            if (off != 0 && off + len > 64) m |= row[x / 64 + 1] << (64 - off);
+            if (len < 64) m &= (1ull << len) - 1;
+            if (m == 0) continue;
+
+            int c = std::popcount(m);
+            n += c;
+            if (sumX != nullptr) {
+                // 各位下标之和 按下标的每个二进制位分别计数
+                int pos = std::popcount(m & 0xaaaaaaaaaaaaaaaaull) + 2 * std::popcount(m & 0xccccccccccccccccull) + 4 * std::popcount(m & 0xf0f0f0f0f0f0f0f0ull) +
+                          8 * std::popcount(m & 0xff00ff00ff00ff00ull) + 16 * std::popcount(m & 0xffff0000ffff0000ull) + 32 * std::popcount(m & 0xffffffff00000000ull);
+                ax += pos + c * (x - c0 - hw / 2);
+            }
+            ay += c * (yy - hh / 2);
+        }
+    }
+    if (sumX != nullptr) *sumX += ax;
+    if (sumY != nullptr) *sumY += ay;
+    return n;
+}
+
+bool world::tickEntity(WorldEntity *cur) {
+
+    auto hit = [&](int sx, int sy) { return entityBits ? collideAt(sx, sy) : collides(real_tiles[sx + sy * width].mat); };
+
+    // 被实体推开的沙子变为粒子
+    auto knockSand = [&](int sx, int sy, f32 vx, f32 vy) {
+        addCell(CellData(real_tiles[sx + sy * width], sx, sy, vx, vy, 0, 0.1f));
+        real_tiles[sx + sy * width] = Tiles_NOTHING;
+        dirty[sx + sy * width] = true;
+        if (!collideBits.empty()) setTileBits(sx, sy, Tiles_NOTHING.mat);
+    };
+
+    // 水平移动一步 底行碰到的格子在上移一格无碰撞时上台阶 其余行碰到的沙子被推开
+    auto stepX = [&](f32 nx, f32 &ny, f32 push) {
+        if (entityBits && collideBox(nx, ny, cur->hw, cur->hh) == 0) return false;
+
+        bool collide = false;
+        for (int xx = 0; xx < cur->hw; xx++) {
+            for (int yy = 0; yy < cur->hh; yy++) {
+                int sx = (nx + xx) + loadZone.x;
+                int sy = (ny + yy) + loadZone.y;
+                if (sx < 0 || sy < 0 || sx >= width || sy >= height || !hit(sx, sy)) continue;
+
+                if (yy == cur->hh - 1) {
+                    if (collideBox(nx, ny - 1, cur->hw, cur->hh) > 0) collide = true;
+                    if (!collide) ny--;
+                } else if (real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND) {
+                    knockSand(sx, sy, (rand() % 10 - 5) / 10.0f + push, (rand() % 10 - 5) / 10.0f);
+                    cur->vx *= 0.99;
                 } else {
-                    cur->vx /= 2;
-                    break;
+                    collide = true;
                 }
             }
-        } else if (cur->vx < -0.001) {
-            f32 stx = cur->x;
-            for (f32 dx = 0; dx > cur->vx; dx += cur->vx / 8.0) {
-                f32 nx = stx + dx;
-                f32 ny = cur->y;
-
-                bool collide = false;
-                for (int xx = 0; xx < cur->hw; xx++) {
-                    for (int yy = 0; yy < cur->hh; yy++) {
-                        int sx = (nx + xx) + loadZone.x;
-                        int sy = (ny + yy) + loadZone.y;
-                        if (sx >= 0 && sy >= 0 && sx < width && sy < height) {
-                            if (real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND ||
-                                real_tiles[sx + sy * width].mat->physicsType == PhysicsType::OBJECT) {
-                                if (yy == cur->hh - 1) {
-                                    for (int xx1 = 0; xx1 < cur->hw; xx1++) {
-                                        for (int yy1 = 0; yy1 < cur->hh; yy1++) {
-                                            int sx1 = (nx + xx1) + loadZone.x;
-                                            int sy1 = (ny + yy1) + loadZone.y - 1;
-                                            if (sx1 >= 0 && sy1 >= 0 && sx1 < width && sy1 < height) {
-                                                if (real_tiles[sx1 + sy1 * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx1 + sy1 * width].mat->physicsType == PhysicsType::SAND ||
-                                                    real_tiles[sx1 + sy1 * width].mat->physicsType == PhysicsType::OBJECT) {
-                                                    collide = true;
-                                                }
-                                            }
-                                        }
-                                    }
-                                    if (!collide) {
-                                        ny--;
-                                    }
-                                } else {
-                                    MaterialInstance tp = real_tiles[sx + sy * width];
-                                    if (tp.mat->physicsType == PhysicsType::SAND) {
-                                        addCell(new CellData(tp, sx, sy, (rand() % 10 - 5) / 10.0f - 0.5f, (rand() % 10 - 5) / 10.0f, 0, 0.1f));
-                                        real_tiles[sx + sy * width] = Tiles_NOTHING;
-                                        dirty[sx + sy * width] = true;
-
-                                        cur->vx *= 0.99;
-                                    } else {
-                                        collide = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+        }
+        return collide;
+    };
+
+    // 垂直移动一步 向上时碰到的沙子被推开
+    auto stepY = [&](f32 nx, f32 ny, bool up) {
+        if (entityBits && collideBox(nx, ny, cur->hw, cur->hh) == 0) return false;
 
-                if (!collide) {
-                    cur->x = nx;
-                    cur->y = ny;
+        bool collide = false;
+        for (int xx = 0; xx < cur->hw; xx++) {
+            for (int yy = 0; yy < cur->hh; yy++) {
+                int sx = (nx + xx) + loadZone.x;
+                int sy = (ny + yy) + loadZone.y;
+                if (sx < 0 || sy < 0 || sx >= width || sy >= height || !hit(sx, sy)) continue;
+
+                if (up && real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND) {
+                    knockSand(sx, sy, (rand() % 10 - 5) / 10.0f, (rand() % 10 - 5) / 10.0f - 0.5f);
+                    cur->vy *= 0.99;
                 } else {
-                    cur->vx /= 2;
-                    break;
+                    collide = true;
                 }
             }
         }
+        return collide;
+    };
 
-        cur->ground = false;
+    int avInX = 0;
+    int avInY = 0;
+    if (collideBox(cur->x, cur->y, cur->hw, cur->hh, &avInX, &avInY) > 0) {
+        cur->x += avInX > 0 ? -1 : (avInX < 0 ? 1 : 0);
+        cur->y += avInY > 0 ? -1 : (avInY < 0 ? 1 : 0);
+    }
 
-        if (cur->vy > 0.001) {
-            f32 sty = cur->y;
-            for (f32 dy = 0; dy < cur->vy; dy += cur->vy / 8.0) {
-                f32 ny = sty + dy;
-                f32 nx = cur->x;
+    cur->vy += 0.25;
 
-                bool collide = false;
-                for (int xx = 0; xx < cur->hw; xx++) {
-                    for (int yy = 0; yy < cur->hh; yy++) {
-                        int sx = (nx + xx) + loadZone.x;
-                        int sy = (ny + yy) + loadZone.y;
-                        if (sx >= 0 && sy >= 0 && sx < width && sy < height) {
-                            if (real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND ||
-                                real_tiles[sx + sy * width].mat->physicsType == PhysicsType::OBJECT) {
-                                collide = true;
-                            }
-                        }
-                    }
-                }
+    if (cur->vx > 0.001) {
+        f32 stx = cur->x;
+        for (f32 dx = 0; dx < cur->vx; dx += cur->vx / 8.0) {
+            f32 nx = stx + dx;
+            f32 ny = cur->y;
 
-                if (!collide) {
-                    cur->y = ny;
-                } else {
-                    cur->vy /= 2;
-                    cur->ground = true;
-                    break;
-                }
+            if (!stepX(nx, ny, 0.5f)) {
+                cur->x = nx;
+                cur->y = ny;
+            } else {
+                cur->vx /= 2;
+                break;
             }
-        } else if (cur->vy < -0.001) {
-            f32 sty = cur->y;
-            for (f32 dy = 0; dy > cur->vy; dy += cur->vy / 8.0) {
-                f32 ny = sty + dy;
-                f32 nx = cur->x;
-
-                bool collide = false;
-                for (int xx = 0; xx < cur->hw; xx++) {
-                    for (int yy = 0; yy < cur->hh; yy++) {
-                        int sx = (nx + xx) + loadZone.x;
-                        int sy = (ny + yy) + loadZone.y;
-                        if (sx >= 0 && sy >= 0 && sx < width && sy < height) {
-                            if (real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SOLID || real_tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND ||
-                                real_tiles[sx + sy * width].mat->physicsType == PhysicsType::OBJECT) {
-                                MaterialInstance tp = real_tiles[sx + sy * width];
-                                if (tp.mat->physicsType == PhysicsType::SAND) {
-                                    addCell(new CellData(tp, sx, sy, (rand() % 10 - 5) / 10.0f, (rand() % 10 - 5) / 10.0f - 0.5f, 0, 0.1f));
-                                    real_tiles[sx + sy * width] = Tiles_NOTHING;
-                                    dirty[sx + sy * width] = true;
-
-                                    cur->vy *= 0.99;
-                                } else {
-                                    collide = true;
-                                }
-                            }
-                        }
-                    }
-                }
+        }
+    } else if (cur->vx < -0.001) {
+        f32 stx = cur->x;
+        for (f32 dx = 0; dx > cur->vx; dx += cur->vx / 8.0) {
+            f32 nx = stx + dx;
+            f32 ny = cur->y;
+
+            if (!stepX(nx, ny, -0.5f)) {
+                cur->x = nx;
+                cur->y = ny;
+            } else {
+                cur->vx /= 2;
+                break;
+            }
+        }
+    }
 
-                if (!collide) {
-                    cur->y = ny;
-                } else {
-                    cur->vy /= 2;
-                    cur->ground = true;
-                    break;
-                }
+    cur->ground = false;
+
+    if (cur->vy > 0.001) {
+        f32 sty = cur->y;
+        for (f32 dy = 0; dy < cur->vy; dy += cur->vy / 8.0) {
+            f32 ny = sty + dy;
+
+            if (!stepY(cur->x, ny, false)) {
+                cur->y = ny;
+            } else {
+                cur->vy /= 2;
+                cur->ground = true;
+                break;
             }
         }
+    } else if (cur->vy < -0.001) {
+        f32 sty = cur->y;
+        for (f32 dy = 0; dy > cur->vy; dy += cur->vy / 8.0) {
+            f32 ny = sty + dy;
 
-        // 速度过快
-        if (std::fabs(cur->vx) >= 1024.0f || std::fabs(cur->vy) >= 1024.0f) {
-            return true;
+            if (!stepY(cur->x, ny, true)) {
+                cur->y = ny;
+            } else {
+                cur->vy /= 2;
+                cur->ground = true;
+                break;
+            }
         }
+    }
+
+    // 速度过快
+    if (std::fabs(cur->vx) >= 1024.0f || std::fabs(cur->vy) >= 1024.0f) {
+        return true;
+    }
 
-        // 速度衰减
-        cur->vx *= 0.99;
-        cur->vy *= 0.99;
+    // 速度衰减
+    cur->vx *= 0.99;
+    cur->vy *= 0.99;
+
+    return false;
+}
+
+void world::tickEntities(R_Target *t) {
+
+    // 上一次画面 dirty 处理之后的改动 (区块加载 玩家操作等) 先同步到位图
+    if (entityBits) syncSolidBitsDirty(0, 0, width, height);
+
+    auto func = [&](WorldEntity *cur) {
+        if (tickEntity(cur)) return true;
 
         // cur->render(t, loadZone.x, loadZone.y);
 
@@ -3246,70 +4898,16 @@ void world::tickEntities(R_Target *t) {
     });
 }
 
-// Adapted from https://stackoverflow.com/a/52859805/8267529
-void world::forLine(int x0, int y0, int x1, int y1, std::function<bool(int)> fn) {
-    int dx = x1 - x0;
-    int dy = y1 - y0;
-
-    int dLong = abs(dx);
-    int dShort = abs(dy);
-
-    int offsetLong = dx > 0 ? 1 : -1;
-    int offsetShort = dy > 0 ? width : -width;
-
-    if (dLong < dShort) {
-        std::swap(dShort, dLong);
-        std::swap(offsetShort, offsetLong);
-    }
-
-    int error = dLong / 2;
-    int index = y0 * width + x0;
-    const int offset[] = {offsetLong, offsetLong + offsetShort};
-    const int abs_d[] = {dShort, dShort - dLong};
-    for (int i = 0; i <= dLong; ++i) {
-        if (fn(index)) return;
-        const int errorIsTooBig = error >= dLong;
-        index += offset[errorIsTooBig];
-        error += abs_d[errorIsTooBig];
-    }
-}
-
-// Adapted from https://gamedev.stackexchange.com/a/182143
-void world::forLineCornered(int x0, int y0, int x1, int y1, std::function<bool(int)> fn) {
-
-    f32 sx = x0;
-    f32 sy = y0;
-    f32 ex = x1;
-    f32 ey = y1;
-
-    f32 x = floor(sx);
-    f32 y = floor(sy);
-    f32 diffX = ex - sx;
-    f32 diffY = ey - sy;
-    f32 stepX = (diffX > 0) ? 1 : ((diffX < 0) ? -1 : 0);
-    f32 stepY = (diffY > 0) ? 1 : ((diffY < 0) ? -1 : 0);
-
-    f32 xOffset = ex > sx ? (ceil(sx) - sx) : (sx - floor(sx));
-    f32 yOffset = ey > sy ? (ceil(sy) - sy) : (sy - floor(sy));
-    f32 angle = atan2(-diffY, diffX);
-    f32 tMaxX = xOffset / cos(angle);
-    f32 tMaxY = yOffset / sin(angle);
-    f32 tDeltaX = 1.0 / cos(angle);
-    f32 tDeltaY = 1.0 / sin(angle);
-
-    f32 manhattanDistance = abs(floor(ex) - floor(sx)) + abs(floor(ey) - floor(sy));
-    std::vector<int> visited = {};
-    for (int t = 0; t <= manhattanDistance; ++t) {
-        if (std::find(visited.begin(), visited.end(), x + y * width) == visited.end() && fn(x + y * width)) return;
-        visited.push_back(x + y * width);
-        if (abs(tMaxX) < abs(tMaxY) || isnan(tMaxY)) {
-            tMaxX += tDeltaX;
-            x += stepX;
-        } else {
-            tMaxY += tDeltaY;
-            y += stepY;
+void world::traceRays(const Ray *rays, int n, const std::vector<u64> &bits, int *hits) const {
+    for (int i = 0; i < n; i++) hits[i] = -1;
+    forRaysXY(rays, n, [&](int ray, int x, int y) {
+        if (x < 0 || y < 0 || x >= width || y >= height) return true;
+        if ((bits[x / 64 + y * solidStride] >> (x % 64)) & 1) {
+            hits[ray] = x + y * width;
+            return true;
         }
-    }
+        return false;
+    });
 }
 
 bool world::isPlayerInWorld() { return player != 0; }
@@ -3327,107 +4925,218 @@ std::tuple<WorldEntity *, Player *> world::getHostPlayer() {
     return std::make_tuple(pl_we, pl);
 }
 
-RigidBody *world::physicsCheck(int x, int y) {
+#pragma region PhysicsCheck
 
-    if (getTile(x, y).mat->physicsType != PhysicsType::SOLID) return nullptr;
+void PhysicsCheckScratch::begin() {
+    if (keys.empty()) {
+        // 装载率保持在 1/2 以下
+        keys.assign(4096, 0);
+        stamps.assign(4096, 0);
+        owners.assign(4096, 0);
+        mask = 4095;
+    }
+    used = 0;
+    owner = 0;
+    // 代号回绕时才真正清空一次
+    if (++stamp == 0) {
+        std::fill(stamps.begin(), stamps.end(), 0);
+        stamp = 1;
+    }
+}
 
-    bool *visited = new bool[width * height];
+static ME_INLINE u32 physics_scratch_hash(u32 key) { return key * 2654435761u; }
+
+bool PhysicsCheckScratch::insert(u32 key) {
+    if ((used + 1) * 2 > (int)keys.size()) {
+        // 批量标记时可能超出容量 扩容后重新插入当前代的键
+        std::vector<u32> oldKeys = std::move(keys);
+        std::vector<u32> oldStamps = std::move(stamps);
+        std::vector<u32> oldOwners = std::move(owners);
+        keys.assign(oldKeys.size() * 2, 0);
+        stamps.assign(oldKeys.size() * 2, 0);
+        owners.assign(oldKeys.size() * 2, 0);
+        mask = (u32)keys.size() - 1;
+        used = 0;
+        u32 cur = owner;
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldStamps[i] != stamp) continue;
+            owner = oldOwners[i];
+            insert(oldKeys[i]);
+        }
+        owner = cur;
+    }
 
-    memset(visited, false, (size_t)width * height);
+    u32 i = physics_scratch_hash(key) & mask;
+    while (stamps[i] == stamp) {
+        if (keys[i] == key) return false;
+        i = (i + 1) & mask;
+    }
+    keys[i] = key;
+    stamps[i] = stamp;
+    owners[i] = owner;
+    used++;
+    return true;
+}
 
-    u32 *cols = new u32[width * height];
+u32 PhysicsCheckScratch::ownerOf(u32 key) const {
+    if (keys.empty()) return 0;
+    u32 i = physics_scratch_hash(key) & mask;
+    while (stamps[i] == stamp) {
+        if (keys[i] == key) return owners[i];
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
 
-    memset(cols, 0x00, (size_t)width * height * sizeof(u32));  // init to all 0s
+bool world::physicsCheck_label(int x, int y, int &minX, int &maxX, int &minY, int &maxY) {
+    PhysicsCheckScratch &S = physicsScratch;
+
+    // 碰到之前超过上限的连通块时 本连通块同样与地形相连 不能把那些格子当作墙
+    S.owner++;
+    bool attached = false;
+    auto open = [&](int xx, int yy) {
+        if (real_tiles[xx + yy * width].mat->physicsType != PhysicsType::SOLID) return false;
+        u32 o = S.ownerOf(xx + yy * width);
+        if (o != 0 && o != S.owner) attached = true;
+        return o == 0;
+    };
 
-    int count = 0;
-    int minX = width;
-    int maxX = 0;
-    int minY = height;
-    int maxY = 0;
+    S.cells.clear();
+    S.stack.clear();
+    S.stack.emplace_back(x, y);
+
+    minX = width;
+    maxX = 0;
+    minY = height;
+    maxY = 0;
+
+    while (!S.stack.empty()) {
+        auto [sx, sy] = S.stack.back();
+        S.stack.pop_back();
+        if (!open(sx, sy)) continue;
+
+        // 向左右扩展成一整段
+        int lx = sx;
+        int rx = sx;
+        while (lx > 0 && open(lx - 1, sy)) lx--;
+        while (rx < width - 1 && open(rx + 1, sy)) rx++;
+
+        for (int xx = lx; xx <= rx; xx++) {
+            S.insert(xx + sy * width);
+            S.cells.push_back(xx + sy * width);
+        }
+        // 超过上限的连通块视为与地形相连 已标记的格子保留本 owner
+        // 同一批次落在其中的种子直接跳过 之后的填充碰到它们时同样判为相连
+        if (attached || S.cells.size() > PhysicsCheckScratch::CAP) return false;
+
+        minX = std::min(minX, lx);
+        maxX = std::max(maxX, rx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+
+        // 上下两行中 每段连续的未标记实心格子只压入一个种子
+        for (int ny = sy - 1; ny <= sy + 1; ny += 2) {
+            if (ny < 0 || ny >= height) continue;
+            bool inSpan = false;
+            for (int xx = lx; xx <= rx; xx++) {
+                bool o = open(xx, ny);
+                if (o && !inSpan) S.stack.emplace_back(xx, ny);
+                inSpan = o;
+            }
+        }
+        if (attached) return false;
+    }
 
-    physicsCheck_flood(x, y, visited, &count, cols, &minX, &maxX, &minY, &maxY);
+    return true;
+}
 
-    if (count > 0 && count <= 1000) {
-        if (count > 10) {
+RigidBody *world::physicsCheck_detach(int minX, int maxX, int minY, int maxY) {
+    const std::vector<int> &cells = physicsScratch.cells;
 
-            C_Surface *sfc = SDL_CreateRGBSurfaceWithFormat(0, maxX - minX + 1, maxY - minY + 1, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (cells.size() <= 10) {
+        // 太小的碎块直接清除
+        for (int idx : cells) {
+            real_tiles[idx] = Tiles_NOTHING;
+            dirty[idx] = true;
+        }
+        return nullptr;
+    }
 
-            for (int yy = minY; yy <= maxY; yy++) {
-                for (int xx = minX; xx <= maxX; xx++) {
-                    if (visited[xx + yy * width]) {
-                        ME_get_pixel(sfc, (unsigned long long)(xx)-minX, yy - minY) = cols[xx + yy * width];
-                        real_tiles[xx + yy * width] = Tiles_NOTHING;
-                        dirty[xx + yy * width] = true;
-                    }
-                }
-            }
+    C_Surface *sfc = SDL_CreateRGBSurfaceWithFormat(0, maxX - minX + 1, maxY - minY + 1, 32, SDL_PIXELFORMAT_ARGB8888);
 
-            if (static_cast<bool>(visited)) delete[] visited;
-            if (static_cast<bool>(cols)) delete[] cols;
+    for (int idx : cells) {
+        int xx = idx % width;
+        int yy = idx / width;
+        ME_get_pixel(sfc, xx - minX, yy - minY) = real_tiles[idx].color;
+        real_tiles[idx] = Tiles_NOTHING;
+        dirty[idx] = true;
+    }
 
-            // audioEngine.PlayEvent("event:/Player/Impact");
+    // audioEngine.PlayEvent("event:/Player/Impact");
 
-            auto tex = create_ref<Texture>(sfc);
+    auto tex = create_ref<Texture>(sfc);
 
-            b2PolygonShape s;
-            s.SetAsBox(1, 1);
-            RigidBody *rb = makeRigidBody(b2_dynamicBody, (f32)minX, (f32)minY, 0, s, 1, (f32)0.3, tex);
-            b2Filter bf = {};
-            bf.categoryBits = 0x0001;
-            bf.maskBits = 0xffff;
-            rb->body->GetFixtureList()[0].SetFilterData(bf);
-            rb->body->SetLinearVelocity({(f32)((rand() % 100) / 100.0 - 0.5), (f32)((rand() % 100) / 100.0 - 0.5)});
+    b2PolygonShape s;
+    s.SetAsBox(1, 1);
+    RigidBody *rb = makeRigidBody(b2_dynamicBody, (f32)minX, (f32)minY, 0, s, 1, (f32)0.3, tex);
+    b2Filter bf = {};
+    bf.categoryBits = 0x0001;
+    bf.maskBits = 0xffff;
+    rb->body->GetFixtureList()[0].SetFilterData(bf);
+    rb->body->SetLinearVelocity({(f32)((rand() % 100) / 100.0 - 0.5), (f32)((rand() % 100) / 100.0 - 0.5)});
 
-            rigidBodies.push_back(rb);
-            updateRigidBodyHitbox(rb);
+    rigidBodies.push_back(rb);
+    return updateRigidBodyHitbox(rb);
+}
 
-            lastMeshLoadZone.x--;
-            updateWorldMesh();
+RigidBody *world::physicsCheck(int x, int y) {
 
-            return rb;
-        } else {
+    if (x < 0 || y < 0 || x >= width || y >= height) return nullptr;
+    if (real_tiles[x + y * width].mat->physicsType != PhysicsType::SOLID) return nullptr;
 
-            for (int yy = minY; yy <= maxY; yy++) {
-                for (int xx = minX; xx <= maxX; xx++) {
-                    if (visited[xx + yy * width]) {
-                        real_tiles[xx + yy * width] = Tiles_NOTHING;
-                        dirty[xx + yy * width] = true;
-                    }
-                }
-            }
+    int minX, maxX, minY, maxY;
+    physicsScratch.begin();
+    if (!physicsCheck_label(x, y, minX, maxX, minY, maxY)) return nullptr;
 
-            return nullptr;
-        }
-    } else {
-        delete[] visited;
-        delete[] cols;
+    RigidBody *rb = physicsCheck_detach(minX, maxX, minY, maxY);
+    if (rb) {
+        lastMeshLoadZone.x--;
+        updateWorldMesh();
     }
-
-    return nullptr;
+    return rb;
 }
 
-// Helper for World::physicsCheck that does the 4-way recursive flood fill
-void world::physicsCheck_flood(int x, int y, bool *visited, int *count, u32 *cols, int *minX, int *maxX, int *minY, int *maxY) {
-    if (*count > 1000 || x < 0 || x >= width || y < 0 || y >= height) return;
-    if (!visited[x + y * width] && getTile(x, y).mat->physicsType == PhysicsType::SOLID) {
-        if (x < *minX) *minX = x;
-        if (x > *maxX) *maxX = x;
-        if (y < *minY) *minY = y;
-        if (y > *maxY) *maxY = y;
+std::vector<RigidBody *> world::physicsCheckBatch(const std::vector<std::pair<int, int>> &seeds) {
 
-        visited[x + y * width] = true;
-        (*count)++;
-        // setTile(x, y, MaterialInstance(&Materials::GENERIC_SOLID, 0xff00ffff));
+    std::vector<RigidBody *> bodies;
 
-        cols[x + y * width] = real_tiles[x + y * width].color;
+    // 整个批次共用一个代号 落在已标记连通块内的种子直接跳过
+    physicsScratch.begin();
+
+    for (auto [x, y] : seeds) {
+        if (x < 0 || y < 0 || x >= width || y >= height) continue;
+        // 已被前面的种子分离出去的格子此时已经是空气
+        if (real_tiles[x + y * width].mat->physicsType != PhysicsType::SOLID) continue;
+        if (physicsScratch.contains(x + y * width)) continue;
+
+        int minX, maxX, minY, maxY;
+        if (!physicsCheck_label(x, y, minX, maxX, minY, maxY)) continue;
+
+        RigidBody *rb = physicsCheck_detach(minX, maxX, minY, maxY);
+        if (rb) bodies.push_back(rb);
+    }
 
-        physicsCheck_flood(x + 1, y, visited, count, cols, minX, maxX, minY, maxY);
-        physicsCheck_flood(x, y + 1, visited, count, cols, minX, maxX, minY, maxY);
-        physicsCheck_flood(x - 1, y, visited, count, cols, minX, maxX, minY, maxY);
-        physicsCheck_flood(x, y - 1, visited, count, cols, minX, maxX, minY, maxY);
+    // 所有连通块处理完后只重建一次地形网格
+    if (!bodies.empty()) {
+        lastMeshLoadZone.x--;
+        updateWorldMesh();
     }
+
+    return bodies;
 }
 
+#pragma endregion PhysicsCheck
+
 void world::saveWorld() {
 
     this->metadata.save(this->worldName);
@@ -3479,6 +5188,12 @@ WorldMeta WorldMeta::loadWorldMeta(std::string worldFileName, bool noSaveLoad) {
             meta.lastOpenedVersion = root["lastOpenedVersion"].to<std::string>();
             meta.lastOpenedTime = root["lastOpenedTime"].to<int>();
 
+            json seed = metafile["noise_seed"];
+            if (seed.isNumber()) {
+                meta.noiseSeed = seed.to<int>();
+                meta.hasNoiseSeed = true;
+            }
+
             METADOT_INFO(std::format("Load World ({0} {1} {2})", meta.worldName.c_str(), meta.lastOpenedVersion.c_str(), meta.lastOpenedTime).c_str());
         } else {
             METADOT_BUG("FP WAS NULL");
@@ -3516,6 +5231,7 @@ bool WorldMeta::save(std::string worldFileName) {
     // }
     metafile.add("metadata", root);
     metafile.add("root_seed", global.game->RNG->root_seed);
+    if (this->hasNoiseSeed) metafile.add("noise_seed", this->noiseSeed);
 
     // std::cout << metafile.print() << std::endl;
     // std::string worldMetaData = "LoadWorldMeta = function()\nsettings_data = {}\n";
@@ -3539,14 +5255,12 @@ world::~world() {
     real_layer2.clear();
     background.clear();
 
-    for (auto &v : cells) {
-        delete v;
-    }
     cells.clear();
 
-    world_sys.tickPool->clear_queue();
-    world_sys.tickVisitedPool->clear_queue();
-    world_sys.updateRigidBodyHitboxPool->clear_queue();
+    // 无窗口初始化的世界没有创建线程池与静态刚体
+    if (world_sys.tickPool) world_sys.tickPool->clear_queue();
+    if (world_sys.tickVisitedPool) world_sys.tickVisitedPool->clear_queue();
+    if (world_sys.updateRigidBodyHitboxPool) world_sys.updateRigidBodyHitboxPool->clear_queue();
 
     // tickPool->stop(false);
     // delete tickPool;
@@ -3565,6 +5279,15 @@ world::~world() {
     delete[] tickVisited1;
     delete[] tickVisited2;
 
+    // 区块刚体与其 tiles/纹理要在 b2world 之前释放
+    for (Chunk *ch : tempMeshChunks) releaseChunkMesh(ch);
+    for (auto &v : chunkCache) {
+        for (auto &v2 : v.second) {
+            if (abs(v2.first) >= 128) continue;
+            releaseChunkMesh(v2.second);
+        }
+    }
+
     auto b2world_ptr = b2world.release();
     delete b2world_ptr;
 
@@ -3573,8 +5296,10 @@ world::~world() {
     }
     rigidBodies.clear();
 
-    staticBody->clean();
-    delete staticBody;
+    if (staticBody) {
+        staticBody->clean();
+        delete staticBody;
+    }
 
     for (auto &v : polys2s) {
         for (auto &v1 : v) {
@@ -3587,11 +5312,15 @@ world::~world() {
     worldMeshes.clear();
     worldTris.clear();
 
-    for (auto &v : worldRigidBodies) {
-        delete v;
-    }
+    // 区块刚体随区块一起释放
     worldRigidBodies.clear();
 
+    for (Chunk *ch : tempMeshChunks) {
+        ch->ChunkDelete();
+        delete ch;
+    }
+    tempMeshChunks.clear();
+
     toLoad.clear();
 
     for (auto &ch : toLoadAsyncList) {
@@ -3,6 +3,8 @@
 #ifndef ME_WORLD_HPP
 #define ME_WORLD_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <deque>
 #include <future>
 #include <unordered_map>
@@ -13,6 +15,7 @@
 #include "engine/core/const.h"
 #include "engine/core/macros.hpp"
 #include "engine/ecs/ecs.hpp"
+#include "engine/game_utils/cells.h"
 #include "engine/physics/box2d/inc/box2d.h"
 #include "engine/utils/utility.hpp"
 #include "game/player.hpp"
@@ -26,7 +29,6 @@ namespace ME {
 class Populator;
 class WorldGenerator;
 class Player;
-struct CellData;
 
 class LoadChunkParams {
 public:
@@ -42,11 +44,250 @@ public:
     }
 };
 
+// physicsCheck 的连通块标记缓冲 跨调用复用
+// visited 是按代号(stamp)清空的开放寻址集合 容量随上限而不是世界大小
+// 每个格子记下标记它的连通块 (owner) 同一批次里分离成功的连通块已变成空气
+// 所以碰到其他 owner 的格子说明碰到了之前超过上限 (与地形相连) 的连通块
+struct PhysicsCheckScratch {
+    static constexpr int CAP = 1000;  // 超过此大小的连通块视为与地形相连
+
+    std::vector<u32> keys;
+    std::vector<u32> stamps;
+    std::vector<u32> owners;
+    u32 stamp = 0;
+    u32 mask = 0;
+    u32 owner = 0;  // 当前连通块 从 1 开始
+    int used = 0;
+
+    std::vector<std::pair<int, int>> stack;  // 扫描线待处理的种子
+    std::vector<int> cells;                  // 当前连通块的格子下标
+
+    void begin();
+    bool insert(u32 key);  // 以当前 owner 插入 新插入返回 true
+    u32 ownerOf(u32 key) const;  // 未标记返回 0
+    bool contains(u32 key) const { return ownerOf(key) != 0; }
+};
+
+// tickCells 的分桶与结果缓冲 跨帧复用
+struct CellTickScratch {
+    enum : u8 { KEEP = 0, KILL = 1, LAND = 2 };
+
+    std::vector<u32> order;    // 按区块分桶后的粒子槽位
+    std::vector<u32> buckets;  // 计数排序后为每个区块在 order 中的终点 最后一个桶放越界粒子
+    std::vector<u8> outcome;   // 按槽位 并行阶段的结果
+    std::vector<int> landAt;   // LAND 时碰撞前一步所在的格子
+    std::vector<std::pair<int, u32>> lands;  // (目标格子, 槽位)
+    std::vector<u32> overflow;               // 需要螺旋搜索空位的槽位
+};
+
+// world::tick 的时间预算调度 按 tickZone 内 CHUNK_W x CHUNK_H 的块安排每块本帧的迭代次数
+// 预计耗时 = 固定开销 + 各块每次迭代的耗时 x 迭代次数 / 线程数 各项由之前几帧的实测值估算
+// budgetMs <= 0 或预计全部更新也不超预算时 所有块按 cell_iter (或 TickLod 安排的次数) 更新
+// 否则相机/玩家 nearRadius 块以内的块每帧都更新 (近处已超预算时减少迭代次数 最少 1 次)
+// 其余块按距上次更新的帧数从久到近排队 用剩余预算更新 其余推迟到之后的帧
+struct TickBudget {
+    f32 budgetMs = 0;
+    int nearRadius = 2;
+    std::vector<std::pair<int, int>> focus;  // 相机与玩家 (real_tiles 坐标) 由 game 每帧设置
+
+    struct Block {
+        int lastTick = 0;
+        f32 msPerIter = -1;  // 小于 0 表示还没测过
+        int quiet = 0;       // 连续没有改动的更新次数 (细节层次休眠用)
+    };
+    phmap::flat_hash_map<u64, Block> blocks;  // 世界块坐标 -> 统计
+    f64 avgMsPerIter = 0.05;
+    f64 fixedMs = 0;  // 与块数无关的开销 (tickVisited 清零等)
+
+    // 本帧的安排 iters[col + row * cols] 为块的迭代次数 0 表示本帧不更新
+    // scale 为材料迭代上限的倍数 ring 为细节层次环 (0 近 1 中 2 远)
+    int cols = 0, rows = 0;
+    int maxIters = 0;
+    std::vector<u8> iters;
+    std::vector<u8> scale;
+    std::vector<u8> ring;
+    std::vector<u64> keys;
+    std::vector<f32> workMs;  // 各块在工作线程中的累计耗时 每块同一时刻只在一个任务中
+
+    // 上一帧的统计 (profiler 使用)
+    f32 usedMs = 0;
+    int ticked = 0;
+    int deferred = 0;
+    int reduced = 0;   // 减少了迭代次数的近处块
+    int sleeping = 0;  // 细节层次休眠的块
+    int idle = 0;      // 统计缓存中本块与相邻块都没有活动格子 不进 world::tick 的块
+    int skipped = 0;   // 细节层次不在本帧更新的块
+
+    int itersAt(int col, int row) const { return iters[col + row * cols]; }
+};
+
+// 模拟细节层次 以 TickBudget::focus 为中心按块距离分环 先于时间预算安排
+// 近环 (<= nearRadius) 与不开启时完全一样
+// 中环 (<= midRadius) 与远环每 midPeriod / farPeriod 帧更新一次 各块错开帧
+// 更新时迭代次数与材料迭代上限乘以周期补偿移动速度 温度一次走周期步
+// 中环/远环的块连续 midSleep / farSleep 次更新没有改动时休眠 块内或边上一格出现 dirty 时唤醒
+struct TickLod {
+    bool enabled = false;
+    int nearRadius = 2;
+    int midRadius = 4;
+    int midPeriod = 2;
+    int farPeriod = 4;
+    int midSleep = 8;
+    int farSleep = 2;
+};
+
+// world::tick 的边带交换 (tickExchange 开启时)
+// 每次迭代所有块先一起并行扫描内部 内部格子的读写不会越过块边
+// 边带 (左/右/上 side/top 格 下 bottom 格 摩擦柱检查读到 y + 10) 里需要更新的格子按行段记入本块 outbox
+// 之后按 4 相棋盘分组合并 同组的块相隔一整块 只有 outbox 的格子参与 格子少时在调用线程直接处理
+struct TickExchange {
+    struct Seg {
+        int y, x0, x1;  // real_tiles 坐标 [x0, x1)
+    };
+    int side = 2, top = 2, bottom = 11;
+    std::vector<std::vector<Seg>> outbox;  // 每块一个 下标同 TickBudget::iters
+    std::vector<int> cells;                // 各块 outbox 的格子数
+    int inlineCells = 1024;                // 一组 outbox 的格子总数不超过此值时在调用线程处理
+
+    // 上一帧的统计
+    int deferred = 0;  // 进入 outbox 的格子数 (各次迭代之和)
+    f32 mergeMs = 0;   // 合并阶段耗时
+};
+
+// 液体质量交换 (fluidPass 开启时代替 world::tick 格子扫描里的液体流动 其余规则不变)
+// 平面覆盖 tickZone 的各块 外加 2 格墙 按行存放 每帧收集/写回一次 中间跑各液体材料的迭代次数
+// 每次迭代两个并行阶段: 各格按 LiquidSimulator 的规则算出向下/左/右/上的流量 再按四个方向的流量更新液量
+// 同一次迭代只读上一次的液量 行内没有依赖 先逐格分类出各方向能否流动 再对整行做纯浮点运算
+// 空气格只接受上/左/右/下第一个液体邻居的材料 两种液体不会同时流进同一格
+// 块内每次迭代液量变化都小于 FLUID_MinValue 时静止 之后只在收集时发现 real_tiles 与平面不一致才唤醒
+// 活动块的四邻也参与本帧 与不参与的块之间视为墙
+struct FluidPlanes {
+    static constexpr u16 WALL = 0xffff;
+
+    int cols = 0, rows = 0;
+    int pw = 0, ph = 0;  // 平面宽高 (含墙)
+    int ox = 0, oy = 0;  // 平面 (0, 0) 对应的 real_tiles 坐标
+    std::vector<f32> amount;
+    std::vector<u16> mat;    // 材料 id 墙为 WALL
+    std::vector<u16> claim;  // 空气格本次迭代接受的材料
+    std::vector<f32> outD, outL, outR, outU;
+
+    // 每块 下标同 TickBudget::iters
+    std::vector<u8> settled;
+    std::vector<u8> awake;   // 本帧参与迭代
+    std::vector<u8> limit;   // 本帧块内液体的最大迭代次数
+    std::vector<f32> delta;  // 本帧块内液量的最大单次变化
+
+    // 上一帧的统计
+    int active = 0;   // 参与迭代的块
+    int resting = 0;  // 静止的块
+    int iters = 0;
+    f32 ms = 0;
+};
+
+// 一块的统计 (材料直方图 液量 活动格子 温度范围)
+struct ChunkStats {
+    std::vector<u32> hist;  // 各材料的格子数 下标为材料 id
+    f64 fluid = 0;          // SOUP 格子的液量之和
+    u32 active = 0;         // world::tick 会处理的格子 (SAND/SOUP/GAS 与火)
+    u32 solid = 0;          // SOLID 格子
+    u32 heat = 0;           // 材料 addTemp 不为 0 的格子
+    mat_temperature minTemp = 0, maxTemp = 0;
+    bool tempStale = false;  // 极值格子变化过 查询时重新扫描
+};
+
+// 统计缓存 按 real_tiles 的 CHUNK_W x CHUNK_H 块划分 (loadZone 平移不按区块对齐 所以不跟着区块走)
+// 每格在影子数组里记下上次计入的材料/液量/温度/标记 与 real_tiles 对比得到增量 重复同步同一格没有副作用
+// setTile 直接更新 其余写入 (包括 world::tick 扫描里的 setTileDirty) 按 dirty 在 world::tick 前后与画面 dirty 处理时同步 tickTemperature 自己更新温度
+// 平移与占位区块整段重建
+struct ChunkStatsGrid {
+    enum : u8 {
+        ACTIVE = 1,
+        SOLID = 2,
+        HEAT = 4,
+    };
+
+    int cols = 0, rows = 0;
+    mat_id fire = 0;  // 火的材料 id 计入活动格子
+    std::vector<ChunkStats> blocks;
+    std::vector<mat_id> mat;
+    std::vector<f32> fluid;
+    std::vector<mat_temperature> temp;
+    std::vector<u8> flags;
+
+    u8 flagsOf(const Material *m) const {
+        if (m == nullptr) return 0;
+        u8 f = 0;
+        if (m->physicsType == PhysicsType::SAND || m->physicsType == PhysicsType::SOUP || m->physicsType == PhysicsType::GAS || m->id == fire) f |= ACTIVE;
+        if (m->physicsType == PhysicsType::SOLID) f |= SOLID;
+        if (m->addTemp != 0) f |= HEAT;
+        return f;
+    }
+};
+
+// 区块实心位图 每行 CHUNK_W / 64 个字 bit x 对应第 x 列
+struct ChunkSolidMask {
+    static_assert(CHUNK_W % 64 == 0);
+    static constexpr int ROW_WORDS = CHUNK_W / 64;
+    u64 words[CHUNK_H * ROW_WORDS];
+};
+
+// forRays/traceRays 的一条射线 端点为 real_tiles 坐标 格子序列与 forLine 相同
+struct Ray {
+    int x0, y0, x1, y1;
+};
+
+// 刚体的稳定句柄 槽位复用时 generation 递增 旧句柄随之失效
+struct RigidBodyHandle {
+    u32 slot = UINT32_MAX;
+    u32 generation = 0;
+};
+
+// 刚体列表: 紧凑数组用于遍历 删除时与末尾元素交换 O(1)
+// 遍历中删除下标 i 的元素后 原末尾元素会移到 i
+// 空间查询见 world::queryRigidBodies
+class RigidBodyList {
+public:
+    RigidBodyHandle push_back(RigidBody *rb);
+    void erase(RigidBody *rb);  // 不在列表中时忽略
+    void clear();
+
+    bool contains(const RigidBody *rb) const { return rb->listSlot < slots.size() && slots[rb->listSlot].index < dense.size() && dense[slots[rb->listSlot].index] == rb; }
+    RigidBodyHandle handle(const RigidBody *rb) const { return contains(rb) ? RigidBodyHandle{rb->listSlot, slots[rb->listSlot].generation} : RigidBodyHandle{}; }
+    // 句柄已失效时返回 nullptr
+    RigidBody *get(RigidBodyHandle h) const { return h.slot < slots.size() && slots[h.slot].generation == h.generation && slots[h.slot].index < dense.size() ? dense[slots[h.slot].index] : nullptr; }
+
+    size_t size() const { return dense.size(); }
+    bool empty() const { return dense.empty(); }
+    RigidBody *operator[](size_t i) const { return dense[i]; }
+    RigidBody *back() const { return dense.back(); }
+    std::vector<RigidBody *>::const_iterator begin() const { return dense.begin(); }
+    std::vector<RigidBody *>::const_iterator end() const { return dense.end(); }
+    const std::vector<RigidBody *> &items() const { return dense; }
+
+private:
+    struct Slot {
+        u32 generation = 0;
+        u32 index = UINT32_MAX;  // 在 dense 中的下标
+    };
+    std::vector<RigidBody *> dense;
+    std::vector<Slot> slots;
+    std::vector<u32> freeSlots;
+};
+
+// b2World::SetParallelSolve 的回调 userData 为 thread_pool
+// 各批次分给线程池 调用线程执行第 0 批 全部完成后返回
+void PhysicsParallelFor(int32 count, void (*task)(int32 index, void *context), void *context, void *userData);
+
 struct WorldMeta {
     std::string worldName;
     std::string lastOpenedVersion;
     time_t lastOpenedTime = 0;
 
+    // 地形噪声种子 重新打开世界或预生成时保证结果一致
+    bool hasNoiseSeed = false;
+    int noiseSeed = 0;
+
     static WorldMeta loadWorldMeta(std::string worldFileName, bool noSaveLoad = false);
 
     bool save(std::string worldFileName);
@@ -73,8 +314,8 @@ public:
     ~world();
 
     struct {
-        std::vector<CellData *> cells;
-        std::vector<RigidBody *> rigidBodies;
+        CellPool cells;
+        RigidBodyList rigidBodies;
         std::vector<RigidBody *> worldRigidBodies;
         std::vector<std::vector<MEvec2>> worldMeshes;
         std::vector<std::vector<MEvec2>> worldTris;
@@ -109,6 +350,67 @@ public:
     // 这里应该不同于区块类储存的材料实例
     // 这里储存的应该是世界改变的材料实例
     std::vector<MaterialInstance> real_tiles{};
+
+    // 实心格子位图 每格 1 bit 与 real_tiles 同步
+    // setTile/画面 dirty 处理/区块网格更新时按 dirty 逐格更新 平移与占位区块整段重建
+    std::vector<u64> solidBits{};
+    int solidStride = 0;  // 每行的 u64 数
+
+    void setSolidBit(int x, int y, bool solid) {
+        u64 &w = solidBits[x / 64 + y * solidStride];
+        u64 b = 1ull << (x % 64);
+        w = solid ? (w | b) : (w & ~b);
+    }
+
+    // 实体碰撞位图 SOLID/SAND/OBJECT 格子为 1 布局与维护时机同 solidBits
+    // tickEntities 按行取位 用 popcount 统计盒内碰撞格子数
+    std::vector<u64> collideBits{};
+
+    static bool collides(const Material *mat) {
+        return mat != nullptr && (mat->physicsType == PhysicsType::SOLID || mat->physicsType == PhysicsType::SAND || mat->physicsType == PhysicsType::OBJECT);
+    }
+    void setTileBits(int x, int y, const Material *mat) {
+        setSolidBit(x, y, mat != nullptr && mat->physicsType == PhysicsType::SOLID);
+        u64 &w = collideBits[x / 64 + y * solidStride];
+        u64 b = 1ull << (x % 64);
+        w = collides(mat) ? (w | b) : (w & ~b);
+    }
+    bool collideAt(int x, int y) const { return (collideBits[x / 64 + y * solidStride] >> (x % 64)) & 1; }
+
+    ChunkStatsGrid chunkStats;
+
+    // 按影子数组把 real_tiles[i] 的变化计入所在块
+    void noteTile(int i) {
+        ChunkStatsGrid &g = chunkStats;
+        if (g.blocks.empty()) return;
+        const MaterialInstance &t = real_tiles[i];
+        mat_id m = t.mat != nullptr ? t.mat->id : 0;
+        f32 fl = t.mat != nullptr && t.mat->physicsType == PhysicsType::SOUP ? t.fluidAmount : 0;
+        mat_temperature temp = t.temperature;
+        if (m == g.mat[i] && fl == g.fluid[i] && temp == g.temp[i]) return;
+
+        ChunkStats &s = g.blocks[(i % width) / CHUNK_W + (i / width) / CHUNK_H * g.cols];
+        if (m != g.mat[i]) {
+            if (m >= s.hist.size()) s.hist.resize(m + 1, 0);
+            s.hist[g.mat[i]]--;
+            s.hist[m]++;
+            u8 f = g.flagsOf(t.mat), old = g.flags[i];
+            s.active += (f & ChunkStatsGrid::ACTIVE ? 1 : 0) - (old & ChunkStatsGrid::ACTIVE ? 1 : 0);
+            s.solid += (f & ChunkStatsGrid::SOLID ? 1 : 0) - (old & ChunkStatsGrid::SOLID ? 1 : 0);
+            s.heat += (f & ChunkStatsGrid::HEAT ? 1 : 0) - (old & ChunkStatsGrid::HEAT ? 1 : 0);
+            g.mat[i] = m;
+            g.flags[i] = f;
+        }
+        s.fluid += (f64)fl - g.fluid[i];
+        g.fluid[i] = fl;
+        if (temp != g.temp[i]) {
+            mat_temperature old = g.temp[i];
+            if ((old == s.minTemp && temp > old) || (old == s.maxTemp && temp < old)) s.tempStale = true;
+            s.minTemp = std::min(s.minTemp, temp);
+            s.maxTemp = std::max(s.maxTemp, temp);
+            g.temp[i] = temp;
+        }
+    }
     std::vector<MaterialInstance> real_layer2{};
 
     std::vector<u32> background{};
@@ -128,6 +430,11 @@ public:
     i32 *newTemps = nullptr;
     bool needToTickGeneration = false;
 
+    // 区块生成(含0阶段填充)与读盘的平均耗时 ms
+    // 只有重新生成比读盘便宜时 未修改的区块才跳过写盘
+    f64 chunkGenAvgMs = 0.0;
+    f64 chunkReadAvgMs = 0.0;
+
     bool *dirty = nullptr;
     bool *active = nullptr;
     bool *lastActive = nullptr;
@@ -145,29 +452,161 @@ public:
     RigidBody *staticBody = nullptr;
     WorldGenerator *gen = nullptr;
 
+    PhysicsCheckScratch physicsScratch;
+
+    // 地形碰撞网格的耗时与缓存命中 (调试信息中显示)
+    struct {
+        f64 lastMs = 0.0;
+        f64 avgMs = 0.0;
+        int rebuilt = 0;
+        int reused = 0;
+    } meshStats;
+    bool meshParallel = true;  // 区块网格几何阶段是否放到线程池
+    bool meshRects = false;    // 区块网格用实心位图矩形合并代替轮廓追踪+三角化 通过 setMeshRects 切换
+    std::vector<Chunk *> tempMeshChunks;  // 加载中的临时区块 网格不缓存 下次更新时销毁
+    TextureRef chunkMeshTexture;
+
+    bool cellsParallel = true;  // 粒子运动阶段按区块分桶放到线程池
+    CellTickScratch cellScratch;
+    TickBudget tickBudget;
+    TickLod tickLod;
+    TickExchange tickExchange;
+    FluidPlanes fluidPlanes;
+    bool fluidPass = true;  // 液体流动由 tickFluids 在紧凑平面上处理 false 时在格子扫描中逐格处理
+    bool borderExchange = true;  // world::tick 块内部一次并行扫描 + 边带 outbox 合并 false 时用原先的 4 相棋盘
+    int temperatureCt = 0;  // tickTemperature 调用次数 细节层次错开帧用
+    bool interactTable = true;  // 相互作用查 materials_interactions 表 false 时沿材料指针查找
+    bool entityBits = true;     // 实体碰撞查 collideBits 位图 false 时逐格读 real_tiles
+    bool statsSkip = true;      // 按统计缓存跳过没有活动格子的块 (world::tick) / 全为 0 度且不发热的块 (tickTemperature) / 没有实心格子的区块网格
+
+    // 刚体 hitbox 更新统计 (基准测试使用)
+    struct {
+        int updates = 0;
+        int rowsSynced = 0;  // 从 tiles 写回 surface 的行数
+        int reallocs = 0;    // 包围盒缩小导致的 surface 重新分配
+        int recreated = 0;   // 销毁并重建刚体的次数
+    } rbStats;
+    bool rbIncremental = true;  // 刚体只同步脏行 形状未分裂时复用原刚体
+    u32 rigidBodyQueryStamp = 0;                // queryRigidBodies 去重用
+    std::vector<RigidBody *> rigidBodyQueryHits;  // rigidBodyAt 的查询结果
+
+    // 刚体按 tickZone 启用/停用/冻结 (tickObjectBounds/applyObjectBounds)
+    // 停用: 质心离开 tickZone 超过 rbBoundsMargin 或在 tickZone 外静止 rbRestTicks 帧
+    // 启用: 质心回到 tickZone 内 停用前已静止的需深入 rbBoundsMargin
+    // 冻结: 停用且离开 tickZone 超过 rbFreezeMargin 持续 rbFreezeTicks 帧 tiles 写入所在区块
+    f32 rbBoundsMargin = 16.0f;
+    f32 rbFreezeMargin = CHUNK_W / 2.0f;
+    int rbFreezeTicks = 60;
+    int rbRestTicks = 30;
+    int rbThawBudget = 64;  // 每帧最多解冻的刚体数
+    bool rbFreeze = true;
+    std::vector<RigidBody *> boundsEnable;
+    std::vector<RigidBody *> boundsDisable;
+    std::vector<RigidBody *> boundsFreeze;
+    struct {
+        f64 lastMs = 0.0;
+        int enabled = 0;
+        int disabled = 0;
+        int frozen = 0;
+        int thawed = 0;
+        int dormant = 0;  // 已停用但未冻结的刚体
+    } boundsStats;
+
+    struct Explosion {
+        int x;
+        int y;
+        int radius;
+    };
+    std::vector<Explosion> explosionQueue;
+    // 上一批爆炸的耗时与规模 (调试信息中显示)
+    struct {
+        f64 lastMs = 0.0;
+        int explosions = 0;
+        int regions = 0;  // 并行处理的区块数
+        int bodies = 0;   // 分离出的碎块数
+    } explosionStats;
+
     void init(std::string worldPath, u16 w, u16 h, R_Target *renderer, Audio *audioEngine, WorldGenerator *generator);
     void init(std::string worldPath, u16 w, u16 h, R_Target *target, Audio *audioEngine);
+    // 无窗口初始化 只准备区块生成/填充/存盘所需的状态 供预生成工具使用
+    void initHeadless(std::string worldPath, u16 w, u16 h, WorldGenerator *generator);
     MaterialInstance getTile(int x, int y);
     void setTile(int x, int y, MaterialInstance type);
+    // 只写格子并标记 dirty 位图与统计缓存留给 dirty 同步 world::tick 并行扫描里用 (相邻块共用位图的字与统计块)
+    void setTileDirty(int x, int y, MaterialInstance type);
     MaterialInstance getTileLayer2(int x, int y);
     void setTileLayer2(int x, int y, MaterialInstance type);
     void tick();
+    // 按 tickBudget 安排本帧各块的迭代次数 / 用本帧耗时更新估算与统计
+    void planTick();
+    void finishTick(f64 ms);
+    void tickFluids();
     void tickTemperature();
     void frame();
     void tickCells();
     void renderCells(unsigned char **texture);
+    // 只计算启用状态的变化 可在工作线程执行
     void tickObjectBounds();
+    // 在主线程批量应用 tickObjectBounds 的结果 并冻结/解冻刚体
+    void applyObjectBounds();
+    // 把刚体写入其质心所在的已加载区块并销毁 区块未加载时返回 false
+    bool freezeRigidBody(RigidBody *rb);
+    RigidBody *thawRigidBody(Chunk *ch, const FrozenBody &fb);
     void tickObjects();
     void tickObjectsMesh();
     void tickChunks();
     void tickChunkGeneration();
-    void addCell(CellData *cell);
+    CellHandle addCell(const CellData &cell);
+    // 加入本帧的爆炸队列 地形在 tickExplosions 中统一破坏
     void explosion(int x, int y, int radius);
+    // 按区块并行破坏地形 同一区块内按排队顺序处理 返回碎块检测的种子
+    std::vector<std::pair<int, int>> applyExplosions(const std::vector<Explosion> &batch);
+    // 处理队列中所有爆炸 只做一次碎块检测与网格更新
+    void tickExplosions();
     RigidBody *makeRigidBody(b2BodyType type, f32 x, f32 y, f32 angle, b2PolygonShape shape, f32 density, f32 friction, TextureRef texture);
     RigidBody *makeRigidBodyMulti(b2BodyType type, f32 x, f32 y, f32 angle, std::vector<b2PolygonShape> shape, f32 density, f32 friction, TextureRef texture);
-    void updateRigidBodyHitbox(RigidBody *rb);
+    // 返回代替 rb 的刚体 (分裂时为第一块) 被挖空时返回 nullptr 返回值不是 rb 时 rb 已被释放
+    RigidBody *updateRigidBodyHitbox(RigidBody *rb);
+    // 与矩形相交的 rigidBodies 中已启用的刚体 由 box2d 宽相位查询 结果写入 out
+    void queryRigidBodies(f32 x0, f32 y0, f32 x1, f32 y1, std::vector<RigidBody *> &out);
+    // (x, y) 周围 3 像素内有实心像素的第一个刚体 用于悬停/拾取
+    RigidBody *rigidBodyAt(int x, int y);
     void updateChunkMesh(Chunk *chunk);
+    bool prepareChunkMesh(Chunk *chunk, u64 *mask);
+    static void buildChunkMeshPolys(const u64 *mask, std::vector<b2PolygonShape> &polys, bool wordParallel = true);
+    static void buildChunkMeshRects(const u64 *mask, std::vector<b2PolygonShape> &polys);
+    // 按 meshRects 选择 buildChunkMeshPolys 或 buildChunkMeshRects
+    void buildChunkMeshGeometry(const u64 *mask, std::vector<b2PolygonShape> &polys) const;
+    void setMeshRects(bool rects);
+    void commitChunkMesh(Chunk *chunk);
     void updateWorldMesh();
+    u64 chunkSolidMask(int chTx, int chTy, u64 *mask, bool &any);
+    void syncSolidBits(int x, int y, int w, int h);
+    void syncSolidBitsDirty(int x, int y, int w, int h);
+    // 统计缓存 重建/按区域同步/只同步区域内 dirty 的格子
+    void rebuildChunkStats();
+    void syncChunkStats(int x, int y, int w, int h);
+    void syncChunkStatsDirty(int x, int y, int w, int h);
+    // (bx, by) 块的统计 温度范围过期时先重新扫描
+    const ChunkStats &chunkStatsBlock(int bx, int by);
+    // 与矩形相交的各块的统计 按块粒度 结果可能多算矩形外同块的格子
+    template <typename F>
+    void forChunkStats(int x, int y, int w, int h, F &&fn) {
+        const ChunkStatsGrid &g = chunkStats;
+        if (g.blocks.empty() || w <= 0 || h <= 0) return;
+        int c0 = std::max(x, 0) / CHUNK_W, c1 = std::min((x + w - 1) / CHUNK_W, g.cols - 1);
+        int r0 = std::max(y, 0) / CHUNK_H, r1 = std::min((y + h - 1) / CHUNK_H, g.rows - 1);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) fn(chunkStatsBlock(c, r));
+        }
+    }
+    u32 activeCellsIn(int x, int y, int w, int h);
+    u32 solidCellsIn(int x, int y, int w, int h);
+    u32 materialCellsIn(int x, int y, int w, int h, mat_id id);
+    f64 fluidIn(int x, int y, int w, int h);
+    // 返回 false 表示矩形不在世界内
+    bool temperatureIn(int x, int y, int w, int h, mat_temperature &lo, mat_temperature &hi);
+    void releaseChunkMesh(Chunk *chunk);
     void queueLoadChunk(int cx, int cy, bool populate, bool render);
     Chunk *loadChunk(LoadChunkParams para);
     Chunk *loadChunk(Chunk *ch, bool populate, bool render);
@@ -175,6 +614,7 @@ public:
     void writeChunkToDisk(Chunk *ch);
     void chunkSaveCache(Chunk *ch);
     void generateChunk(Chunk *ch);
+    bool preferRegenerate() const;
     int getBiomeAt(int x, int y);             // 返回群系ID
     int getBiomeAt(Chunk *ch, int x, int y);  // 返回群系ID
     void addStructure(PlacedStructure str);
@@ -183,14 +623,170 @@ public:
     Chunk *getChunk(int cx, int cy);
     void populateChunk(Chunk *ch, int phase, bool render);
     void tickEntities(R_Target *target);
-    void forLine(int x0, int y0, int x1, int y1, std::function<bool(int)> fn);
-    void forLineCornered(int x0, int y0, int x1, int y1, std::function<bool(int)> fn);
+    // 单个实体一帧的碰撞与移动 返回 true 表示需要销毁
+    bool tickEntity(WorldEntity *cur);
+    // (nx, ny) 处 hw x hh 盒内 (相对 loadZone) 的碰撞格子数 sumX/sumY 非空时累加格子相对盒中心的偏移
+    int collideBox(f32 nx, f32 ny, int hw, int hh, int *sumX = nullptr, int *sumY = nullptr) const;
+    // 沿直线经过的格子下标调用 fn(index) 返回 true 时停止 不检查边界
+    // 模板参数直接接收 lambda 可以内联 不经过 std::function
+    template <typename F>
+    void forLine(int x0, int y0, int x1, int y1, F &&fn);
+    // 同 forLine 但相邻两格总是共边 (不走对角)
+    template <typename F>
+    void forLineCornered(int x0, int y0, int x1, int y1, F &&fn);
+    // 批量射线 每 RAY_BATCH 条交错前进 格子序列与 forLine 相同 fn(ray, index) 返回 true 时该射线停止
+    static constexpr int RAY_BATCH = 16;
+    template <typename F>
+    void forRays(const Ray *rays, int n, F &&fn);
+    // 同 forRays 但回调为 fn(ray, x, y)
+    template <typename F>
+    static void forRaysXY(const Ray *rays, int n, F &&fn);
+    // 只测位图 (solidBits 或 collideBits) 的批量射线
+    // hits[i] 为第 i 条射线第一个置位格子的下标 没有碰到或离开世界时为 -1
+    void traceRays(const Ray *rays, int n, const std::vector<u64> &bits, int *hits) const;
     RigidBody *physicsCheck(int x, int y);
-    void physicsCheck_flood(int x, int y, bool *visited, int *count, u32 *cols, int *minX, int *maxX, int *minY, int *maxY);
+    // 一次标记多个种子 (如一次爆炸) 所在的连通块 最后只重建一次地形网格
+    std::vector<RigidBody *> physicsCheckBatch(const std::vector<std::pair<int, int>> &seeds);
+    // 扫描线标记 (x, y) 所在的实心连通块到 physicsScratch.cells 超过上限或碰到之前超过上限的连通块时返回 false
+    bool physicsCheck_label(int x, int y, int &minX, int &maxX, int &minY, int &maxY);
+    RigidBody *physicsCheck_detach(int minX, int maxX, int minY, int maxY);
     void saveWorld();
     bool isPlayerInWorld();
     std::tuple<WorldEntity *, Player *> getHostPlayer();
 };
+
+#pragma region LineTraversal
+
+// Adapted from https://stackoverflow.com/a/52859805/8267529
+template <typename F>
+void world::forLine(int x0, int y0, int x1, int y1, F &&fn) {
+    int dx = x1 - x0;
+    int dy = y1 - y0;
+
+    int dLong = abs(dx);
+    int dShort = abs(dy);
+
+    int offsetLong = dx > 0 ? 1 : -1;
+    int offsetShort = dy > 0 ? width : -width;
+
+    if (dLong < dShort) {
+        std::swap(dShort, dLong);
+        std::swap(offsetShort, offsetLong);
+    }
+
+    int error = dLong / 2;
+    int index = y0 * width + x0;
+    const int offset[] = {offsetLong, offsetLong + offsetShort};
+    const int abs_d[] = {dShort, dShort - dLong};
+    for (int i = 0; i <= dLong; ++i) {
+        if (fn(index)) return;
+        const int errorIsTooBig = error >= dLong;
+        index += offset[errorIsTooBig];
+        error += abs_d[errorIsTooBig];
+    }
+}
+
+// Adapted from https://gamedev.stackexchange.com/a/182143
+template <typename F>
+void world::forLineCornered(int x0, int y0, int x1, int y1, F &&fn) {
+
+    f32 sx = x0;
+    f32 sy = y0;
+    f32 ex = x1;
+    f32 ey = y1;
+
+    f32 x = floor(sx);
+    f32 y = floor(sy);
+    f32 diffX = ex - sx;
+    f32 diffY = ey - sy;
+    f32 stepX = (diffX > 0) ? 1 : ((diffX < 0) ? -1 : 0);
+    f32 stepY = (diffY > 0) ? 1 : ((diffY < 0) ? -1 : 0);
+
+    f32 xOffset = ex > sx ? (ceil(sx) - sx) : (sx - floor(sx));
+    f32 yOffset = ey > sy ? (ceil(sy) - sy) : (sy - floor(sy));
+    f32 angle = atan2(-diffY, diffX);
+    f32 tMaxX = xOffset / cos(angle);
+    f32 tMaxY = yOffset / sin(angle);
+    f32 tDeltaX = 1.0 / cos(angle);
+    f32 tDeltaY = 1.0 / sin(angle);
+
+    // x y 各自只朝一个方向走 只有步长为 0 的轴走一步时才会停在原格子 所以只需和上一格比较
+    f32 manhattanDistance = abs(floor(ex) - floor(sx)) + abs(floor(ey) - floor(sy));
+    int last = -1;
+    for (int t = 0; t <= manhattanDistance; ++t) {
+        int index = (int)x + (int)y * width;
+        if (index != last && fn(index)) return;
+        last = index;
+        if (abs(tMaxX) < abs(tMaxY) || isnan(tMaxY)) {
+            tMaxX += tDeltaX;
+            x += stepX;
+        } else {
+            tMaxY += tDeltaY;
+            y += stepY;
+        }
+    }
+}
+
+template <typename F>
+void world::forRaysXY(const Ray *rays, int n, F &&fn) {
+    // 一批射线的状态放在栈上 逐步轮流推进 各射线的访存可以重叠
+    int x[RAY_BATCH], y[RAY_BATCH], error[RAY_BATCH], left[RAY_BATCH];
+    int dLong[RAY_BATCH], dShort[RAY_BATCH];
+    int longX[RAY_BATCH], longY[RAY_BATCH], shortX[RAY_BATCH], shortY[RAY_BATCH];
+    int active[RAY_BATCH];
+
+    for (int b = 0; b < n; b += RAY_BATCH) {
+        int m = std::min(RAY_BATCH, n - b);
+        int nActive = 0;
+        for (int i = 0; i < m; i++) {
+            const Ray &r = rays[b + i];
+            int dx = r.x1 - r.x0;
+            int dy = r.y1 - r.y0;
+            x[i] = r.x0;
+            y[i] = r.y0;
+            longX[i] = dx > 0 ? 1 : -1;
+            longY[i] = 0;
+            shortX[i] = 0;
+            shortY[i] = dy > 0 ? 1 : -1;
+            dLong[i] = abs(dx);
+            dShort[i] = abs(dy);
+            if (dLong[i] < dShort[i]) {
+                std::swap(dLong[i], dShort[i]);
+                std::swap(longX[i], shortX[i]);
+                std::swap(longY[i], shortY[i]);
+            }
+            error[i] = dLong[i] / 2;
+            left[i] = dLong[i];
+            active[nActive++] = i;
+        }
+
+        while (nActive > 0) {
+            int k = 0;
+            for (int j = 0; j < nActive; j++) {
+                int i = active[j];
+                if (fn(b + i, x[i], y[i]) || left[i]-- == 0) continue;
+                if (error[i] >= dLong[i]) {
+                    x[i] += longX[i] + shortX[i];
+                    y[i] += longY[i] + shortY[i];
+                    error[i] += dShort[i] - dLong[i];
+                } else {
+                    x[i] += longX[i];
+                    y[i] += longY[i];
+                    error[i] += dShort[i];
+                }
+                active[k++] = i;
+            }
+            nActive = k;
+        }
+    }
+}
+
+template <typename F>
+void world::forRays(const Ray *rays, int n, F &&fn) {
+    forRaysXY(rays, n, [&](int ray, int x, int y) { return fn(ray, x + y * width); });
+}
+
+#pragma endregion LineTraversal
 }  // namespace ME
 
 #endif
@@ -0,0 +1,2371 @@
+// Copyright(c) 2022-2023, KaoruXun All rights reserved.
+
+#include "world_bench.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "chunk.hpp"
+#include "engine/core/base_debug.hpp"
+#include "engine/core/const.h"
+#include "engine/core/global.hpp"
+#include "engine/utils/utility.hpp"
+#include "game.hpp"
+#include "game_datastruct.hpp"
+#include "world.hpp"
+#include "world_generator.h"
+
+namespace ME {
+
+namespace bench {
+
+#pragma region StructureStamp
+
+// 生成一个与 Structures::makeTree 形状相近的测试结构 不依赖 world 噪声
+static Structure make_bench_tree(int seed) {
+    int w = 50 + seed % 10;
+    int h = 80 + seed % 20;
+    MaterialInstance *tiles = new MaterialInstance[w * h];
+    std::fill(tiles, tiles + w * h, Tiles_NOTHING);
+
+    Material *mat = &GAME()->materials_list.GENERIC_PASSABLE;
+    int cx = w / 2;
+    for (int ty = h - 1; ty > 20; ty--) {
+        int bw = 3 + std::max((ty - h + 10) / 3, 0);
+        for (int xx = -bw; xx <= bw; xx++) tiles[(cx + xx) + ty * w] = MaterialInstance(mat, 0x7C4000);
+    }
+    for (int ty = 0; ty < 40; ty++) {
+        for (int tx = 0; tx < w; tx++) {
+            int dx = tx - cx, dy = ty - 20;
+            if (dx * dx + dy * dy < 18 * 18) tiles[tx + ty * w] = MaterialInstance(mat, 0x00ff00);
+        }
+    }
+    return Structure(w, h, tiles);
+}
+
+void structure_stamp(int n) {
+    if (n <= 0) n = 4096;
+
+    const int aw = 3, ah = 3;
+    std::vector<std::vector<MaterialInstance>> area(aw * ah, std::vector<MaterialInstance>(CHUNK_W * CHUNK_H, Tiles_NOTHING));
+
+    std::vector<PlacedStructure> strs;
+    strs.reserve(n);
+    for (int i = 0; i < n; i++) {
+        // 以中心区块 (1, 1) 为基准 允许跨越区块边界
+        int x = CHUNK_W / 2 + (rand() % (CHUNK_W * 2)) - CHUNK_W;
+        int y = CHUNK_H / 2 + (rand() % (CHUNK_H * 2)) - CHUNK_H;
+        strs.emplace_back(make_bench_tree(i), CHUNK_W + x, CHUNK_H + y);
+    }
+
+    Timer timer;
+
+    // 原 populateChunk 的逐格写入
+    timer.start();
+    long long written_cell = 0;
+    for (auto &s : strs) {
+        for (int tx = 0; tx < s.base.w; tx++) {
+            for (int ty = 0; ty < s.base.h; ty++) {
+                int chx = (int)floor((tx + s.x) / (f32)CHUNK_W);
+                int chy = (int)floor((ty + s.y) / (f32)CHUNK_H);
+                if (chx < 0 || chy < 0 || chx >= aw || chy >= ah) continue;
+                int dxx = (CHUNK_W + ((tx + s.x) % CHUNK_W)) % CHUNK_W;
+                int dyy = (CHUNK_H + ((ty + s.y) % CHUNK_H)) % CHUNK_H;
+                if (s.base.tiles[tx + ty * s.base.w].mat->physicsType != PhysicsType::AIR) {
+                    area[chx + chy * aw][dxx + dyy * CHUNK_W] = s.base.tiles[tx + ty * s.base.w];
+                    written_cell++;
+                }
+            }
+        }
+    }
+    timer.stop();
+    f64 t_cell = timer.get();
+
+    // 预编译行段写入
+    timer.start();
+    long long written_span = 0;
+    for (auto &s : strs) {
+        for (const StructureChunkRect &r : s.splitChunks()) {
+            if (r.cx < 0 || r.cy < 0 || r.cx >= aw || r.cy >= ah) continue;
+            written_span += s.base.stampRect(area[r.cx + r.cy * aw].data(), CHUNK_W, s.x - r.cx * CHUNK_W, s.y - r.cy * CHUNK_H, r.x0, r.y0, r.x1, r.y1);
+        }
+    }
+    timer.stop();
+    f64 t_span = timer.get();
+
+    METADOT_INFO(std::format("[bench] structure_stamp n={0} per-cell {1:.3f} ms ({2} tiles) span {3:.3f} ms ({4} tiles) x{5:.2f}", n, t_cell, written_cell, t_span, written_span,
+                             t_span > 0 ? t_cell / t_span : 0.0)
+                         .c_str());
+    if (written_cell != written_span) METADOT_ERROR(std::format("[bench] structure_stamp mismatch {0} != {1}", written_cell, written_span).c_str());
+
+    for (auto &s : strs) delete[] s.base.tiles;
+}
+
+#pragma endregion StructureStamp
+
+#pragma region WorldGen
+
+static f64 worldgen_run(world *w, WorldGenerator *gen, int n) {
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < n; i++) {
+        Chunk *ch = new Chunk;
+        ch->ChunkInit(i % 16 - 8, i / 16 % 8, w->worldName);
+        ch->biomes_id.assign(CHUNK_W * CHUNK_H, Biome::biomeGetID("DEFAULT"));
+        gen->generateChunk(w, ch);
+        ch->ChunkDelete();
+        delete ch;
+    }
+    timer.stop();
+    return timer.get();
+}
+
+void worldgen(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] worldgen needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 64;
+
+    DefaultGenerator native;
+    ScriptingWorldGenerator scripted;
+
+    f64 t_native = worldgen_run(w, &native, n);
+    f64 t_script = worldgen_run(w, &scripted, n);
+
+    METADOT_INFO(std::format("[bench] worldgen n={0} DefaultGenerator {1:.3f} ms ({2:.1f} chunks/s) ScriptingWorldGenerator {3:.3f} ms ({4:.1f} chunks/s)", n, t_native,
+                             n * 1000.0 / std::max(t_native, 0.001), t_script, n * 1000.0 / std::max(t_script, 0.001))
+                         .c_str());
+}
+
+#pragma endregion WorldGen
+
+#pragma region PristineRegen
+
+void pristine_regen(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr || w->noSaveLoad) {
+        METADOT_ERROR("[bench] pristine_regen needs a loaded world with saving enabled");
+        return;
+    }
+    if (n <= 0) n = 32;
+
+    // 使用远离玩家的区块坐标 避免覆盖真实存档
+    const int base = 1 << 20;
+
+    std::vector<Chunk *> chunks;
+    Timer timer;
+
+    timer.start();
+    for (int i = 0; i < n; i++) {
+        Chunk *ch = new Chunk;
+        ch->ChunkInit(base + i, 0, w->worldName);
+        ch->biomes_id.assign(CHUNK_W * CHUNK_H, Biome::biomeGetID("DEFAULT"));
+        w->generateChunk(ch);
+        w->populateChunk(ch, 0, false);
+        chunks.push_back(ch);
+    }
+    timer.stop();
+    f64 t_gen = timer.get();
+
+    // 两次生成同一区块 内容应当一致
+    int mismatch = 0;
+    for (int i = 0; i < n; i++) {
+        Chunk ch;
+        ch.ChunkInit(base + i, 0, w->worldName);
+        ch.biomes_id.assign(CHUNK_W * CHUNK_H, Biome::biomeGetID("DEFAULT"));
+        w->generateChunk(&ch);
+        w->populateChunk(&ch, 0, false);
+        if (ch.ChunkContentHash() != chunks[i]->ChunkContentHash()) mismatch++;
+        ch.ChunkDelete();
+    }
+
+    for (Chunk *ch : chunks) {
+        ch->pristine = false;
+        ch->ChunkWrite(ch->tiles, ch->layer2, ch->background);
+        ch->ChunkDelete();
+        ch->tiles = nullptr;
+        ch->layer2 = nullptr;
+        ch->background = nullptr;
+    }
+
+    timer.start();
+    for (Chunk *ch : chunks) ch->ChunkRead();
+    timer.stop();
+    f64 t_read = timer.get();
+
+    for (Chunk *ch : chunks) {
+        ch->ChunkDelete();
+        std::remove(ch->pack_filename.c_str());
+        delete ch;
+    }
+
+    METADOT_INFO(std::format("[bench] pristine_regen n={0} regenerate {1:.3f} ms/chunk read {2:.3f} ms/chunk -> {3} (world avg gen {4:.3f} read {5:.3f})", n, t_gen / n, t_read / n,
+                             t_gen <= t_read ? "regenerate" : "read", w->chunkGenAvgMs, w->chunkReadAvgMs)
+                         .c_str());
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] pristine_regen {0}/{1} chunks did not regenerate identically", mismatch, n).c_str());
+}
+
+#pragma endregion PristineRegen
+
+#pragma region CaveBG
+
+// 原 DefaultGenerator 的逐像素环绕采样 作为对照
+static void cavebg_reference(u32 *background, const u8 *mask, int cx, int cy) {
+    C_Surface *sur = global.game->Iso.texturepack.caveBG->surface();
+    for (int x = 0; x < CHUNK_W; x++) {
+        int px = x + cx * CHUNK_W;
+        for (int y = 0; y < CHUNK_H; y++) {
+            int py = y + cy * CHUNK_W;
+            background[x + y * CHUNK_W] = 0x00000000;
+            if (!mask[x + y * CHUNK_W]) continue;
+            int tx = (sur->w + (px % sur->w)) % sur->w;
+            int ty = (sur->h + (py % sur->h)) % sur->h;
+            background[x + y * CHUNK_W] = ME_get_pixel(sur, tx % sur->w, ty % sur->h);
+        }
+    }
+}
+
+void cavebg(int n) {
+    if (!global.game->Iso.texturepack.caveBG || !global.game->Iso.texturepack.caveBGTiled.valid()) {
+        METADOT_ERROR("[bench] cavebg needs textures to be initialized");
+        return;
+    }
+    if (n <= 0) n = 256;
+
+    // 掩码模拟地表: 每列随机高度以下为洞穴 包括负坐标区块以覆盖环绕
+    std::vector<u8> mask(CHUNK_W * CHUNK_H);
+    std::vector<u32> golden(CHUNK_W * CHUNK_H);
+    std::vector<u32> rows(CHUNK_W * CHUNK_H);
+    std::vector<std::pair<int, int>> coords;
+    for (int i = 0; i < n; i++) coords.emplace_back(rand() % 64 - 32, rand() % 64 - 32);
+    for (int x = 0; x < CHUNK_W; x++) {
+        int surf = rand() % (CHUNK_H + 1) - 1;
+        for (int y = 0; y < CHUNK_H; y++) mask[x + y * CHUNK_W] = y > surf;
+    }
+
+    // 与原逐像素输出逐格对比
+    int mismatch = 0;
+    for (auto [cx, cy] : coords) {
+        cavebg_reference(golden.data(), mask.data(), cx, cy);
+        CaveBGFillRows(rows.data(), mask.data(), cx, cy);
+        if (golden != rows) mismatch++;
+    }
+
+    Timer timer;
+    timer.start();
+    for (auto [cx, cy] : coords) cavebg_reference(golden.data(), mask.data(), cx, cy);
+    timer.stop();
+    f64 t_pixel = timer.get();
+
+    timer.start();
+    for (auto [cx, cy] : coords) CaveBGFillRows(rows.data(), mask.data(), cx, cy);
+    timer.stop();
+    f64 t_rows = timer.get();
+
+    METADOT_INFO(std::format("[bench] cavebg n={0} per-pixel {1:.3f} ms row-span {2:.3f} ms x{3:.2f}", n, t_pixel, t_rows, t_rows > 0 ? t_pixel / t_rows : 0.0).c_str());
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] cavebg {0}/{1} chunks differ from the per-pixel output", mismatch, n).c_str());
+}
+
+#pragma endregion CaveBG
+
+#pragma region PhysicsCheck
+
+// 原 physicsCheck 的做法: 每次分配并清零整个世界大小的数组 然后递归填充
+static void physics_check_flood_reference(world *w, int x, int y, bool *visited, int *count, u32 *cols) {
+    if (*count > PhysicsCheckScratch::CAP || x < 0 || x >= w->width || y < 0 || y >= w->height) return;
+    if (!visited[x + y * w->width] && w->real_tiles[x + y * w->width].mat->physicsType == PhysicsType::SOLID) {
+        visited[x + y * w->width] = true;
+        (*count)++;
+        cols[x + y * w->width] = w->real_tiles[x + y * w->width].color;
+        physics_check_flood_reference(w, x + 1, y, visited, count, cols);
+        physics_check_flood_reference(w, x, y + 1, visited, count, cols);
+        physics_check_flood_reference(w, x - 1, y, visited, count, cols);
+        physics_check_flood_reference(w, x, y - 1, visited, count, cols);
+    }
+}
+
+static int physics_check_reference(world *w, int x, int y) {
+    bool *visited = new bool[w->width * w->height];
+    memset(visited, false, (size_t)w->width * w->height);
+    u32 *cols = new u32[w->width * w->height];
+    memset(cols, 0x00, (size_t)w->width * w->height * sizeof(u32));
+    int count = 0;
+    physics_check_flood_reference(w, x, y, visited, &count, cols);
+    delete[] visited;
+    delete[] cols;
+    return count <= PhysicsCheckScratch::CAP ? count : -1;
+}
+
+void physics_check(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] physics_check needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 256;
+
+    // 只对世界做只读标记 不分离刚体
+    std::vector<std::pair<int, int>> seeds;
+    for (int i = 0; i < n * 20 && (int)seeds.size() < n; i++) {
+        int x = rand() % w->width;
+        int y = rand() % w->height;
+        if (w->real_tiles[x + y * w->width].mat->physicsType == PhysicsType::SOLID) seeds.emplace_back(x, y);
+    }
+    if (seeds.empty()) {
+        METADOT_ERROR("[bench] physics_check found no solid tiles");
+        return;
+    }
+
+    int minX, maxX, minY, maxY;
+    int mismatch = 0;
+    for (auto [x, y] : seeds) {
+        w->physicsScratch.begin();
+        int size = w->physicsCheck_label(x, y, minX, maxX, minY, maxY) ? (int)w->physicsScratch.cells.size() : -1;
+        if (size != physics_check_reference(w, x, y)) mismatch++;
+    }
+
+    Timer timer;
+    timer.start();
+    for (auto [x, y] : seeds) physics_check_reference(w, x, y);
+    timer.stop();
+    f64 t_ref = timer.get();
+
+    timer.start();
+    for (auto [x, y] : seeds) {
+        w->physicsScratch.begin();
+        w->physicsCheck_label(x, y, minX, maxX, minY, maxY);
+    }
+    timer.stop();
+    f64 t_scan = timer.get();
+
+    // 批量: 一个代号内标记全部种子 已标记的跳过
+    timer.start();
+    w->physicsScratch.begin();
+    for (auto [x, y] : seeds) {
+        if (!w->physicsScratch.contains(x + y * w->width)) w->physicsCheck_label(x, y, minX, maxX, minY, maxY);
+    }
+    timer.stop();
+    f64 t_batch = timer.get();
+
+    int m = (int)seeds.size();
+    METADOT_INFO(std::format("[bench] physics_check n={0} full-array recursive {1:.0f} calls/s scanline {2:.0f} calls/s batched {3:.0f} seeds/s", m, m * 1000.0 / std::max(t_ref, 0.001),
+                             m * 1000.0 / std::max(t_scan, 0.001), m * 1000.0 / std::max(t_batch, 0.001))
+                         .c_str());
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] physics_check {0}/{1} components differ from the recursive fill", mismatch, m).c_str());
+}
+
+#pragma endregion PhysicsCheck
+
+#pragma region ChunkMesh
+
+// 模拟挖掘: 每帧在 meshZone 中心附近挖一个小坑 然后强制更新地形碰撞网格
+static f64 chunk_mesh_run(world *w, int n, bool cached, int &rebuilt, int &reused) {
+    int cx = w->meshZone.x + w->meshZone.w / 2;
+    int cy = w->meshZone.y + w->meshZone.h / 2;
+    rebuilt = 0;
+    reused = 0;
+
+    Timer timer;
+    f64 total = 0.0;
+    for (int i = 0; i < n; i++) {
+        int bx = cx + (i * 7) % 96 - 48;
+        int by = cy + (i * 3) % 48 - 24;
+        for (int x = bx - 4; x <= bx + 4; x++) {
+            for (int y = by - 4; y <= by + 4; y++) {
+                if (x < 0 || y < 0 || x >= w->width || y >= w->height) continue;
+                if (w->real_tiles[x + y * w->width].mat->physicsType == PhysicsType::SOLID) w->real_tiles[x + y * w->width] = Tiles_NOTHING;
+            }
+        }
+        w->syncSolidBits(bx - 4, by - 4, 9, 9);
+        w->syncChunkStats(bx - 4, by - 4, 9, 9);
+
+        // 全量模式: 让所有缓存失效 相当于原先每次销毁重建
+        if (!cached) {
+            for (auto &p : w->chunkCache) {
+                if (p.first == INT_MIN) continue;
+                for (auto &p2 : p.second) {
+                    if (p2.first == INT_MIN) continue;
+                    p2.second->meshCached = false;
+                }
+            }
+        }
+
+        w->lastMeshZone.x--;
+        timer.start();
+        w->updateWorldMesh();
+        timer.stop();
+        total += timer.get();
+        rebuilt += w->meshStats.rebuilt;
+        reused += w->meshStats.reused;
+    }
+    return total;
+}
+
+void chunk_mesh(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] chunk_mesh needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 60;
+
+    // 两种模式从同一地形开始 结束后恢复
+    std::vector<MaterialInstance> saved = w->real_tiles;
+
+    int rb_full, ru_full, rb_cached, ru_cached;
+    f64 t_full = chunk_mesh_run(w, n, false, rb_full, ru_full);
+    w->real_tiles = saved;
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+    f64 t_cached = chunk_mesh_run(w, n, true, rb_cached, ru_cached);
+    w->real_tiles = saved;
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+
+    w->lastMeshZone.x--;
+    w->updateWorldMesh();
+
+    METADOT_INFO(std::format("[bench] chunk_mesh n={0} full rebuild {1:.3f} ms/frame ({2} rebuilt) cached {3:.3f} ms/frame ({4} rebuilt / {5} reused)", n, t_full / n, rb_full, t_cached / n,
+                             rb_cached, ru_cached)
+                         .c_str());
+}
+
+// 在整个 meshZone 铺满粗糙地形 (实心/空气交错的噪声) 对比串行与并行几何阶段的全量重建耗时
+void chunk_mesh_parallel(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] chunk_mesh_parallel needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 10;
+
+    std::vector<MaterialInstance> saved = w->real_tiles;
+
+    for (int y = std::max((int)w->meshZone.y, 0); y < std::min((int)(w->meshZone.y + w->meshZone.h), (int)w->height); y++) {
+        for (int x = std::max((int)w->meshZone.x, 0); x < std::min((int)(w->meshZone.x + w->meshZone.w), (int)w->width); x++) {
+            f32 v = sinf(x * 0.13f) + cosf(y * 0.11f) + sinf((x + y) * 0.05f) + (rand() % 100) / 100.0f - 0.5f;
+            w->real_tiles[x + y * w->width] = v > 0.0f ? Tiles_TEST_SOLID : Tiles_NOTHING;
+        }
+    }
+    w->syncSolidBits(w->meshZone.x, w->meshZone.y, w->meshZone.w, w->meshZone.h);
+    w->syncChunkStats(w->meshZone.x, w->meshZone.y, w->meshZone.w, w->meshZone.h);
+
+    auto run = [&](bool parallel, size_t &polys) {
+        w->meshParallel = parallel;
+        Timer timer;
+        f64 total = 0.0;
+        for (int i = 0; i < n; i++) {
+            for (auto &p : w->chunkCache) {
+                if (p.first == INT_MIN) continue;
+                for (auto &p2 : p.second) {
+                    if (p2.first == INT_MIN) continue;
+                    p2.second->meshCached = false;
+                }
+            }
+            w->lastMeshZone.x--;
+            timer.start();
+            w->updateWorldMesh();
+            timer.stop();
+            total += timer.get();
+        }
+        polys = 0;
+        for (RigidBody *rb : w->worldRigidBodies) {
+            for (b2Fixture *f = rb->body->GetFixtureList(); f; f = f->GetNext()) polys++;
+        }
+        return total / n;
+    };
+
+    size_t polys_serial, polys_parallel;
+    f64 t_serial = run(false, polys_serial);
+    f64 t_parallel = run(true, polys_parallel);
+    w->meshParallel = true;
+
+    w->real_tiles = saved;
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+    w->lastMeshZone.x--;
+    w->updateWorldMesh();
+
+    METADOT_INFO(std::format("[bench] chunk_mesh_parallel n={0} serial {1:.3f} ms parallel {2:.3f} ms ({3:.2f}x) fixtures {4}/{5}", n, t_serial, t_parallel, t_serial / std::max(t_parallel, 0.001),
+                             polys_serial, polys_parallel)
+                         .c_str());
+    if (polys_serial != polys_parallel) METADOT_ERROR("[bench] chunk_mesh_parallel fixture count differs between serial and parallel");
+}
+
+// 随机位图: 按密度撒点后做几轮多数平滑 得到大小不一的块与洞
+static void random_chunk_mask(ChunkSolidMask &m, int density, int smooth) {
+    constexpr int W = ChunkSolidMask::ROW_WORDS;
+    std::vector<u8> cells(CHUNK_W * CHUNK_H);
+    for (auto &c : cells) c = rand() % 100 < density;
+    for (int s = 0; s < smooth; s++) {
+        std::vector<u8> next(cells.size());
+        for (int y = 0; y < CHUNK_H; y++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                int n = 0;
+                for (int yy = -1; yy <= 1; yy++)
+                    for (int xx = -1; xx <= 1; xx++) {
+                        int sx = x + xx, sy = y + yy;
+                        if (sx >= 0 && sy >= 0 && sx < CHUNK_W && sy < CHUNK_H) n += cells[sx + sy * CHUNK_W];
+                    }
+                next[x + y * CHUNK_W] = n >= 5;
+            }
+        }
+        cells.swap(next);
+    }
+    memset(m.words, 0, sizeof(m.words));
+    for (int y = 0; y < CHUNK_H; y++)
+        for (int x = 0; x < CHUNK_W; x++)
+            if (cells[x + y * CHUNK_W]) m.words[y * W + x / 64] |= 1ull << (x % 64);
+}
+
+static bool same_polys(const std::vector<b2PolygonShape> &a, const std::vector<b2PolygonShape> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].m_count != b[i].m_count) return false;
+        for (int v = 0; v < a[i].m_count; v++) {
+            if (a[i].m_vertices[v].x != b[i].m_vertices[v].x || a[i].m_vertices[v].y != b[i].m_vertices[v].y) return false;
+        }
+    }
+    return true;
+}
+
+void chunk_mesh_bits(int n) {
+    if (n <= 0) n = 64;
+
+    // 随机位图上 按字起点搜索与逐格搜索生成的多边形必须完全一致
+    std::vector<ChunkSolidMask> masks(n);
+    int mismatch = 0;
+    size_t total = 0;
+    for (int i = 0; i < n; i++) {
+        random_chunk_mask(masks[i], i % 3 == 0 ? 50 : (i % 3 == 1 ? 20 : 80), i % 4);
+        std::vector<b2PolygonShape> ref, bits;
+        world::buildChunkMeshPolys(masks[i].words, ref, false);
+        world::buildChunkMeshPolys(masks[i].words, bits, true);
+        if (!same_polys(ref, bits)) mismatch++;
+        total += ref.size();
+    }
+
+    std::vector<b2PolygonShape> polys;
+    Timer timer;
+    timer.start();
+    for (auto &m : masks) world::buildChunkMeshPolys(m.words, polys, false);
+    timer.stop();
+    f64 t_ref = timer.get();
+    timer.start();
+    for (auto &m : masks) world::buildChunkMeshPolys(m.words, polys, true);
+    timer.stop();
+    f64 t_bits = timer.get();
+
+    METADOT_INFO(std::format("[bench] chunk_mesh_bits n={0} ({1} tris) per-cell scan {2:.3f} ms/chunk word scan {3:.3f} ms/chunk", n, total, t_ref / n, t_bits / n).c_str());
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] chunk_mesh_bits {0}/{1} masks produced different polygons", mismatch, n).c_str());
+
+    // 当前世界的增量位图与 real_tiles 重新统计比较
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr || w->solidBits.empty()) return;
+    w->syncSolidBitsDirty(0, 0, w->width, w->height);
+    int stale = 0;
+    for (int y = 0; y < w->height; y++) {
+        for (int x = 0; x < w->width; x++) {
+            bool solid = w->real_tiles[x + y * w->width].mat->physicsType == PhysicsType::SOLID;
+            bool bit = (w->solidBits[x / 64 + y * w->solidStride] >> (x % 64)) & 1;
+            if (solid != bit) stale++;
+        }
+    }
+    if (stale > 0) METADOT_ERROR(std::format("[bench] chunk_mesh_bits {0} cells of the world solid mask are stale", stale).c_str());
+    else
+        METADOT_INFO("[bench] chunk_mesh_bits world solid mask matches real_tiles");
+}
+
+// 以像素中心做点测试 统计每个像素被多少个形状覆盖
+static void mesh_coverage(const std::vector<b2PolygonShape> &polys, std::vector<u8> &cover) {
+    cover.assign(CHUNK_W * CHUNK_H, 0);
+    b2Transform xf;
+    xf.SetIdentity();
+    for (auto &sh : polys) {
+        b2AABB aabb;
+        sh.ComputeAABB(&aabb, xf, 0);
+        int x0 = std::max((int)std::floor(aabb.lowerBound.x), 0), x1 = std::min((int)std::ceil(aabb.upperBound.x), CHUNK_W);
+        int y0 = std::max((int)std::floor(aabb.lowerBound.y), 0), y1 = std::min((int)std::ceil(aabb.upperBound.y), CHUNK_H);
+        for (int y = y0; y < y1; y++)
+            for (int x = x0; x < x1; x++)
+                if (sh.TestPoint(xf, b2Vec2(x + 0.5f, y + 0.5f))) cover[x + y * CHUNK_W]++;
+    }
+}
+
+void chunk_mesh_rects(int n) {
+    if (n <= 0) n = 64;
+    constexpr int W = ChunkSolidMask::ROW_WORDS;
+
+    std::vector<ChunkSolidMask> masks(n);
+    for (int i = 0; i < n; i++) random_chunk_mask(masks[i], i % 3 == 0 ? 50 : (i % 3 == 1 ? 20 : 80), i % 4);
+    // 全实心与全空区块
+    if (n > 2) {
+        memset(masks[0].words, 0xff, sizeof(masks[0].words));
+        memset(masks[1].words, 0, sizeof(masks[1].words));
+    }
+
+    // 碰撞等价: 矩形合并的像素中心覆盖必须与位图逐格一致 且矩形互不重叠
+    // 轮廓追踪经过 simplify 与丢弃单像素 只统计其与位图的差异作为参考
+    size_t tris = 0, rects = 0;
+    int rectMiss = 0, rectExtra = 0, rectOverlap = 0;
+    int polyMiss = 0, polyExtra = 0, solid = 0;
+    std::vector<b2PolygonShape> polys;
+    std::vector<u8> cover;
+    for (auto &m : masks) {
+        world::buildChunkMeshRects(m.words, polys);
+        rects += polys.size();
+        mesh_coverage(polys, cover);
+        for (int y = 0; y < CHUNK_H; y++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                bool bit = (m.words[y * W + x / 64] >> (x % 64)) & 1;
+                u8 c = cover[x + y * CHUNK_W];
+                solid += bit;
+                if (bit && c == 0) rectMiss++;
+                if (!bit && c > 0) rectExtra++;
+                if (c > 1) rectOverlap++;
+            }
+        }
+
+        world::buildChunkMeshPolys(m.words, polys);
+        tris += polys.size();
+        mesh_coverage(polys, cover);
+        for (int y = 0; y < CHUNK_H; y++) {
+            for (int x = 0; x < CHUNK_W; x++) {
+                bool bit = (m.words[y * W + x / 64] >> (x % 64)) & 1;
+                if (bit && cover[x + y * CHUNK_W] == 0) polyMiss++;
+                if (!bit && cover[x + y * CHUNK_W] > 0) polyExtra++;
+            }
+        }
+    }
+
+    Timer timer;
+    timer.start();
+    for (auto &m : masks) world::buildChunkMeshPolys(m.words, polys);
+    timer.stop();
+    f64 t_poly = timer.get();
+    timer.start();
+    for (auto &m : masks) world::buildChunkMeshRects(m.words, polys);
+    timer.stop();
+    f64 t_rect = timer.get();
+
+    METADOT_INFO(std::format("[bench] chunk_mesh_rects n={0} outline+triangulate {1:.3f} ms/chunk ({2} tris) rect merge {3:.3f} ms/chunk ({4} rects) speedup {5:.1f}x", n, t_poly / n, tris, t_rect / n,
+                             rects, t_rect > 0 ? t_poly / t_rect : 0.0)
+                         .c_str());
+    METADOT_INFO(std::format("[bench] chunk_mesh_rects outline path differs from the mask on {0} missing / {1} extra of {2} solid pixels", polyMiss, polyExtra, solid).c_str());
+    if (rectMiss > 0 || rectExtra > 0 || rectOverlap > 0)
+        METADOT_ERROR(std::format("[bench] chunk_mesh_rects coverage mismatch: {0} missing {1} extra {2} overlapping pixels", rectMiss, rectExtra, rectOverlap).c_str());
+    else
+        METADOT_INFO("[bench] chunk_mesh_rects rect coverage matches the mask exactly");
+}
+
+#pragma endregion ChunkMesh
+
+#pragma region Box2DIslands
+
+// 无窗口的 box2d 压力场景: 地面加 n 个分列堆叠下落的方块 每列形成独立的岛
+static scope<b2World> box2d_stress_world(int n) {
+    scope<b2World> w = create_scope<b2World>(b2Vec2(0, 20));
+
+    int columns = std::max(n / 8, 1);
+
+    b2BodyDef groundDef;
+    groundDef.position.Set(columns * 1.5f, 100.0f);
+    b2Body *ground = w->CreateBody(&groundDef);
+    b2PolygonShape groundShape;
+    groundShape.SetAsBox(columns * 1.5f + 10.0f, 1.0f);
+    ground->CreateFixture(&groundShape, 0.0f);
+
+    b2PolygonShape box;
+    box.SetAsBox(0.5f, 0.5f);
+    for (int i = 0; i < n; i++) {
+        int col = i % columns;
+        int row = i / columns;
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position.Set(col * 3.0f + 0.05f * (row % 3), 95.0f - row * 1.2f);
+        def.angle = 0.1f * (i % 7);
+        b2Body *b = w->CreateBody(&def);
+        b->CreateFixture(&box, 1.0f);
+    }
+    return w;
+}
+
+static f64 box2d_stress_run(b2World *w, int steps) {
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < steps; i++) w->Step(33.0f / 1000.0f, 5, 2);
+    timer.stop();
+    return timer.get();
+}
+
+void box2d_islands(int n) {
+    if (n <= 0) n = 1000;
+    const int steps = 300;
+    int threads = std::max((int)std::thread::hardware_concurrency(), 2);
+
+    scope<b2World> serial = box2d_stress_world(n);
+    f64 t_serial = box2d_stress_run(serial.get(), steps);
+
+    thread_pool pool(threads);
+    scope<b2World> parallel = box2d_stress_world(n);
+    parallel->SetParallelSolve(&PhysicsParallelFor, threads, &pool);
+    f64 t_parallel = box2d_stress_run(parallel.get(), steps);
+
+    // 同一场景再跑一次 换一个批次数 结果也必须一致
+    scope<b2World> parallel2 = box2d_stress_world(n);
+    parallel2->SetParallelSolve(&PhysicsParallelFor, threads / 2 + 1, &pool);
+    box2d_stress_run(parallel2.get(), steps);
+
+    int mismatch = 0;
+    const b2Body *a = serial->GetBodyList(), *b = parallel->GetBodyList(), *c = parallel2->GetBodyList();
+    for (; a && b && c; a = a->GetNext(), b = b->GetNext(), c = c->GetNext()) {
+        if (memcmp(&a->GetTransform(), &b->GetTransform(), sizeof(b2Transform)) != 0 || memcmp(&a->GetTransform(), &c->GetTransform(), sizeof(b2Transform)) != 0) mismatch++;
+    }
+
+    METADOT_INFO(std::format("[bench] box2d_islands n={0} steps={1} serial {2:.3f} ms/step parallel({3}) {4:.3f} ms/step ({5:.2f}x)", n, steps, t_serial / steps, threads, t_parallel / steps,
+                             t_serial / std::max(t_parallel, 0.001))
+                         .c_str());
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] box2d_islands {0} bodies differ between serial and parallel solving", mismatch).c_str());
+
+    pool.stop(true);
+}
+
+#pragma endregion Box2DIslands
+
+#pragma region RigidBodyDig
+
+// 半径 r 的圆盘刚体 加入 rigidBodies 以便 hitbox 更新时被替换
+static RigidBody *rigidbody_dig_disc(world *wd, int r) {
+    C_Surface *sfc = SDL_CreateRGBSurfaceWithFormat(0, r * 2, r * 2, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int y = 0; y < sfc->h; y++) {
+        for (int x = 0; x < sfc->w; x++) {
+            int dx = x - r, dy = y - r;
+            ME_get_pixel(sfc, x, y) = dx * dx + dy * dy < r * r ? 0xff808080 : 0x00000000;
+        }
+    }
+    b2PolygonShape s;
+    s.SetAsBox(1, 1);
+    RigidBody *rb = wd->makeRigidBody(b2_dynamicBody, (f32)wd->tickZone.x, (f32)wd->tickZone.y, 0, s, 1, (f32)0.3, create_ref<Texture>(sfc));
+    wd->rigidBodies.push_back(rb);
+    return wd->updateRigidBodyHitbox(rb);
+}
+
+struct RigidBodyDigResult {
+    f64 ms = 0.0;
+    int frames = 0;
+    int solid = 0;
+    int mismatch = 0;
+};
+
+// 每帧在最上方的实心像素处挖掉 4x2 并立即更新 hitbox
+static RigidBodyDigResult rigidbody_dig_run(world *wd, int n, bool incremental) {
+    RigidBodyDigResult res;
+    wd->rbIncremental = incremental;
+    wd->rbStats = {};
+
+    RigidBody *rb = rigidbody_dig_disc(wd, 48);
+    if (rb == nullptr) return res;
+    Timer timer;
+    for (; res.frames < n; res.frames++) {
+        int minX, minY, maxX, maxY;
+        if (!rb->maskBounds(minX, minY, maxX, maxY)) break;
+        int sx = minX;
+        for (int x = minX; x < maxX; x++) {
+            if (rb->solidAt(x, minY)) {
+                sx = x;
+                break;
+            }
+        }
+        for (int y = minY; y < std::min(minY + 2, rb->matHeight); y++) {
+            for (int x = sx; x < std::min(sx + 4, rb->matWidth); x++) rb->setTile(x, y, Tiles_NOTHING);
+        }
+        rb->needsUpdate = true;
+
+        timer.start();
+        rb = wd->updateRigidBodyHitbox(rb);
+        timer.stop();
+        res.ms += timer.get();
+
+        // 重建时原刚体已被释放 返回的是新刚体
+        if (rb == nullptr) break;
+
+        // surface 与 tiles 必须一致
+        C_Surface *sfc = rb->get_surface();
+        if (sfc->w != rb->matWidth || sfc->h != rb->matHeight) {
+            res.mismatch++;
+            continue;
+        }
+        for (int y = 0; y < sfc->h; y++)
+            for (int x = 0; x < sfc->w; x++)
+                if ((((ME_get_pixel(sfc, x, y) >> 24) & 0xff) != 0) != rb->solidAt(x, y)) res.mismatch++;
+    }
+
+    if (rb != nullptr && wd->rigidBodies.contains(rb)) {
+        for (int i = 0; i < (int)rb->mask.size(); i++) res.solid += std::popcount(rb->mask[i]);
+        wd->b2world->DestroyBody(rb->body);
+        wd->rigidBodies.erase(rb);
+        rb->clean();
+        delete rb;
+    }
+    return res;
+}
+
+void rigidbody_dig(int n) {
+    if (n <= 0) n = 600;
+    world *wd = global.game->Iso.world.get();
+    bool prev = wd->rbIncremental;
+
+    RigidBodyDigResult full = rigidbody_dig_run(wd, n, false);
+    auto fullStats = wd->rbStats;
+    RigidBodyDigResult inc = rigidbody_dig_run(wd, n, true);
+    auto incStats = wd->rbStats;
+    wd->rbIncremental = prev;
+
+    METADOT_INFO(std::format("[bench] rigidbody_dig full: {0} frames {1:.3f} ms/update {2} rows synced {3} reallocs {4} recreated", full.frames, full.ms / std::max(full.frames, 1),
+                             fullStats.rowsSynced, fullStats.reallocs, fullStats.recreated)
+                         .c_str());
+    METADOT_INFO(std::format("[bench] rigidbody_dig dirty rows: {0} frames {1:.3f} ms/update {2} rows synced {3} reallocs {4} recreated ({5:.2f}x)", inc.frames, inc.ms / std::max(inc.frames, 1),
+                             incStats.rowsSynced, incStats.reallocs, incStats.recreated, (full.ms / std::max(full.frames, 1)) / std::max(inc.ms / std::max(inc.frames, 1), 0.0001))
+                         .c_str());
+    if (full.mismatch + inc.mismatch > 0) METADOT_ERROR(std::format("[bench] rigidbody_dig surface/mask mismatch full {0} dirty rows {1}", full.mismatch, inc.mismatch).c_str());
+    if (full.frames == inc.frames && full.solid != inc.solid) METADOT_ERROR(std::format("[bench] rigidbody_dig remaining pixels differ: full {0} dirty rows {1}", full.solid, inc.solid).c_str());
+}
+
+#pragma endregion RigidBodyDig
+
+#pragma region RigidBodyIndex
+
+// n 个 4x4 静态刚体排成网格 放在远离加载区的位置 不与游戏内物体接触
+static std::vector<RigidBody *> rigidbody_index_bodies(world *wd, int n) {
+    std::vector<RigidBody *> bodies;
+    int cols = (int)std::ceil(std::sqrt((f64)n));
+    b2PolygonShape box;
+    box.SetAsBox(2, 2, b2Vec2(2, 2), 0);
+    for (int i = 0; i < n; i++) {
+        b2BodyDef def;
+        def.type = b2_staticBody;
+        def.position.Set(-100000.0f + (i % cols) * 12.0f, -100000.0f + (i / cols) * 12.0f);
+        b2Body *body = wd->b2world->CreateBody(&def);
+        body->CreateFixture(&box, 1);
+        RigidBody *rb = new RigidBody(body, "bench");
+        body->GetUserData().pointer = (uintptr_t)rb;
+        bodies.push_back(rb);
+    }
+    return bodies;
+}
+
+static bool rigidbody_index_hit(RigidBody *rb, b2Vec2 p) {
+    for (b2Fixture *f = rb->body->GetFixtureList(); f; f = f->GetNext())
+        if (f->TestPoint(p)) return true;
+    return false;
+}
+
+// 原先的一帧: 复制列表 全量遍历边界与悬停 按值查找删除
+static int rigidbody_index_frame_linear(std::vector<RigidBody *> &list, const std::vector<b2Vec2> &probes, const std::vector<RigidBody *> &churn) {
+    int hits = 0;
+    std::vector<RigidBody *> rbs = list;
+    for (RigidBody *cur : rbs) cur->body->SetEnabled(cur->body->GetWorldCenter().x < 1e9f);
+    for (b2Vec2 p : probes) {
+        for (RigidBody *cur : rbs) {
+            if (cur->body->IsEnabled() && rigidbody_index_hit(cur, p)) {
+                hits++;
+                break;
+            }
+        }
+    }
+    for (RigidBody *rb : churn) {
+        list.erase(std::remove(list.begin(), list.end(), rb), list.end());
+        list.push_back(rb);
+    }
+    return hits;
+}
+
+// 现在的一帧: 直接遍历 宽相位查询 按槽位删除
+static int rigidbody_index_frame(world *wd, const std::vector<b2Vec2> &probes, const std::vector<RigidBody *> &churn) {
+    int hits = 0;
+    for (RigidBody *cur : wd->rigidBodies) cur->body->SetEnabled(cur->body->GetWorldCenter().x < 1e9f);
+    std::vector<RigidBody *> &found = wd->rigidBodyQueryHits;
+    for (b2Vec2 p : probes) {
+        wd->queryRigidBodies(p.x - 3, p.y - 3, p.x + 3, p.y + 3, found);
+        for (RigidBody *cur : found) {
+            if (rigidbody_index_hit(cur, p)) {
+                hits++;
+                break;
+            }
+        }
+    }
+    for (RigidBody *rb : churn) {
+        wd->rigidBodies.erase(rb);
+        wd->rigidBodies.push_back(rb);
+    }
+    return hits;
+}
+
+static void rigidbody_index_run(world *wd, int n) {
+    const int frames = 120;
+    std::vector<RigidBody *> bodies = rigidbody_index_bodies(wd, n);
+    for (RigidBody *rb : bodies) wd->rigidBodies.push_back(rb);
+    std::vector<RigidBody *> linear = wd->rigidBodies.items();
+
+    // 每帧 8 个悬停点与 32 个删除后重新加入的刚体 两种实现使用同一序列
+    int cols = (int)std::ceil(std::sqrt((f64)n));
+    std::vector<std::vector<b2Vec2>> probes(frames);
+    std::vector<std::vector<RigidBody *>> churn(frames);
+    srand(n);
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < 8; i++) probes[f].push_back({-100000.0f + (rand() % (cols * 12)), -100000.0f + (rand() % ((n / cols + 1) * 12))});
+        for (int i = 0; i < 32; i++) churn[f].push_back(bodies[rand() % n]);
+    }
+
+    Timer timer;
+    int hitsLinear = 0, hits = 0;
+    timer.start();
+    for (int f = 0; f < frames; f++) hitsLinear += rigidbody_index_frame_linear(linear, probes[f], churn[f]);
+    timer.stop();
+    f64 tLinear = timer.get();
+
+    timer.start();
+    for (int f = 0; f < frames; f++) hits += rigidbody_index_frame(wd, probes[f], churn[f]);
+    timer.stop();
+    f64 tIndex = timer.get();
+
+    // 删除后句柄必须失效 重新加入后得到新句柄
+    RigidBodyHandle h = wd->rigidBodies.handle(bodies[0]);
+    wd->rigidBodies.erase(bodies[0]);
+    bool stale = wd->rigidBodies.get(h) == nullptr;
+    wd->rigidBodies.push_back(bodies[0]);
+    stale = stale && wd->rigidBodies.get(h) == nullptr && wd->rigidBodies.get(wd->rigidBodies.handle(bodies[0])) == bodies[0];
+
+    METADOT_INFO(std::format("[bench] rigidbody_index n={0} linear {1:.3f} ms/frame index {2:.3f} ms/frame ({3:.2f}x) hits {4}/{5}", n, tLinear / frames, tIndex / frames,
+                             tLinear / std::max(tIndex, 0.001), hits, hitsLinear)
+                         .c_str());
+    if (hits != hitsLinear) METADOT_ERROR(std::format("[bench] rigidbody_index hover hits differ: linear {0} index {1}", hitsLinear, hits).c_str());
+    if (!stale) METADOT_ERROR("[bench] rigidbody_index stale handle still resolves after erase");
+
+    for (RigidBody *rb : bodies) {
+        wd->rigidBodies.erase(rb);
+        wd->b2world->DestroyBody(rb->body);
+        delete rb;
+    }
+}
+
+void rigidbody_index(int n) {
+    world *wd = global.game->Iso.world.get();
+    if (n > 0) {
+        rigidbody_index_run(wd, n);
+    } else {
+        rigidbody_index_run(wd, 1000);
+        rigidbody_index_run(wd, 5000);
+    }
+}
+
+#pragma endregion RigidBodyIndex
+
+#pragma region Explosions
+
+// meshZone 内随机分布的 n 个爆炸 半径 6~13 种子固定
+static std::vector<world::Explosion> explosions_batch(world *w, int n) {
+    srand(n);
+    std::vector<world::Explosion> batch;
+    int zx = std::max((int)w->meshZone.x, 0), zy = std::max((int)w->meshZone.y, 0);
+    int zw = std::max((int)w->meshZone.w, 1), zh = std::max((int)w->meshZone.h, 1);
+    for (int i = 0; i < n; i++) batch.push_back({zx + rand() % zw, zy + rand() % zh, 6 + rand() % 8});
+    return batch;
+}
+
+// 撤销一次运行: 恢复地形 删除运行中产生的粒子与碎块
+static void explosions_restore(world *w, const std::vector<MaterialInstance> &saved, const CellPool &savedCells, const std::vector<RigidBody *> &before) {
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+
+    w->cells = savedCells;
+
+    std::vector<RigidBody *> added;
+    for (RigidBody *rb : w->rigidBodies)
+        if (std::find(before.begin(), before.end(), rb) == before.end()) added.push_back(rb);
+    for (RigidBody *rb : added) {
+        w->rigidBodies.erase(rb);
+        w->b2world->DestroyBody(rb->body);
+        rb->clean();
+        delete rb;
+    }
+}
+
+void explosions(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] explosions needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 200;
+
+    std::vector<world::Explosion> batch = explosions_batch(w, n);
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    std::vector<RigidBody *> before = w->rigidBodies.items();
+    CellPool savedCells = w->cells;
+    Audio *audio = w->audioEngine;
+    w->audioEngine = nullptr;
+
+    // 地形破坏: 逐个处理与按区块并行批处理的结果必须一致
+    for (const world::Explosion &e : batch) w->applyExplosions({e});
+    std::vector<mat_id> serial(w->real_tiles.size());
+    for (size_t i = 0; i < serial.size(); i++) serial[i] = w->real_tiles[i].mat->id;
+    explosions_restore(w, saved, savedCells, before);
+
+    w->applyExplosions(batch);
+    int mismatch = 0;
+    for (size_t i = 0; i < serial.size(); i++)
+        if (serial[i] != w->real_tiles[i].mat->id) mismatch++;
+    explosions_restore(w, saved, savedCells, before);
+
+    // 原先的做法: 每个爆炸各自做一次碎块检测与网格更新
+    Timer timer;
+    timer.start();
+    for (const world::Explosion &e : batch) {
+        w->explosion(e.x, e.y, e.radius);
+        w->tickExplosions();
+    }
+    timer.stop();
+    f64 t_each = timer.get();
+    explosions_restore(w, saved, savedCells, before);
+
+    // 同一帧内排队 统一处理
+    timer.start();
+    for (const world::Explosion &e : batch) w->explosion(e.x, e.y, e.radius);
+    w->tickExplosions();
+    timer.stop();
+    f64 t_batch = timer.get();
+    auto stats = w->explosionStats;
+    explosions_restore(w, saved, savedCells, before);
+
+    w->audioEngine = audio;
+    w->lastMeshZone.x--;
+    w->updateWorldMesh();
+
+    METADOT_INFO(std::format("[bench] explosions n={0} one pass each {1:.3f} ms batched {2:.3f} ms ({3:.2f}x) {4} regions {5} fragments", n, t_each, t_batch, t_each / std::max(t_batch, 0.001),
+                             stats.regions, stats.bodies)
+                         .c_str());
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] explosions {0} tiles differ between serial and batched destruction", mismatch).c_str());
+}
+
+#pragma endregion Explosions
+
+#pragma region RigidBodyDormant
+
+struct RigidBodyDormantRun {
+    f64 boundsMs = 0.0;
+    f64 stepMs = 0.0;
+    int transitions = 0;
+    int frozen = 0;
+    int proxies = 0;
+};
+
+// 4x4 的动态方块 tiles 为黑曜石
+static RigidBody *rigidbody_dormant_box(world *wd, f32 x, f32 y) {
+    C_Surface *sfc = SDL_CreateRGBSurfaceWithFormat(0, 4, 4, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int i = 0; i < 16; i++) ME_get_pixel(sfc, i % 4, i / 4) = 0xff505060;
+    b2PolygonShape box;
+    box.SetAsBox(2, 2, b2Vec2(2, 2), 0);
+    RigidBody *rb = wd->makeRigidBody(b2_dynamicBody, x, y, 0, box, 1, (f32)0.3, create_ref<Texture>(sfc));
+    rb->name = "bench";
+    wd->rigidBodies.push_back(rb);
+    return rb;
+}
+
+// 原先的 tickObjectBounds: 每帧对每个刚体按质心是否在 tickZone 内调用 SetEnabled
+static int rigidbody_dormant_legacy(world *wd) {
+    int changed = 0;
+    const MErect &z = wd->tickZone;
+    for (RigidBody *cur : wd->rigidBodies) {
+        if (cur->is_cleaned) continue;
+        b2Vec2 c = cur->body->GetWorldCenter();
+        bool in = c.x >= z.x && c.y >= z.y && c.x < z.x + z.w && c.y < z.y + z.h;
+        if (cur->body->IsEnabled() != in) changed++;
+        cur->body->SetEnabled(in);
+    }
+    return changed;
+}
+
+// n 个停在 tickZone 左侧冻结带外的方块 + 64 个每帧跨越 tickZone 右缘来回移动的方块
+// mode 0: 原先的逐帧 SetEnabled  1: 滞后带 不冻结  2: 滞后带 + 冻结
+static RigidBodyDormantRun rigidbody_dormant_run(world *wd, int n, int frames, int mode) {
+    RigidBodyDormantRun res;
+    const MErect z = wd->tickZone;
+
+    // 运行前各区块的冻结刚体数 本次冻结的方块追加在末尾 结束时截掉
+    std::vector<std::tuple<Chunk *, size_t, bool>> chunks;
+    for (auto &p : wd->chunkCache)
+        for (auto &p2 : p.second) chunks.emplace_back(p2.second, p2.second->frozenBodies.size(), p2.second->pristine);
+
+    phmap::flat_hash_set<RigidBody *> bench;
+    for (int i = 0; i < n; i++) {
+        f32 x = z.x - wd->rbFreezeMargin - 8 - (i % 8) * 6;
+        f32 y = z.y + std::fmod((f32)(i / 8) * 6, std::max(z.h - 8, 8.0f));
+        bench.insert(rigidbody_dormant_box(wd, x, y));
+    }
+    std::vector<RigidBody *> edge;
+    for (int i = 0; i < 64; i++) {
+        edge.push_back(rigidbody_dormant_box(wd, z.x + z.w, z.y + 8 + i * std::max(z.h - 16, 64.0f) / 64));
+        bench.insert(edge.back());
+    }
+
+    bool freeze = wd->rbFreeze;
+    int thawBudget = wd->rbThawBudget;
+    wd->rbFreeze = mode == 2;
+    wd->rbThawBudget = 0;
+
+    // 冻结需要刚体先在冻结带外停留 rbFreezeTicks 帧 这些帧不计时
+    int warmup = wd->rbFreezeTicks + 1;
+    Timer timer;
+    for (int f = 0; f < warmup + frames; f++) {
+        bool timed = f >= warmup;
+        for (size_t i = 0; i < edge.size(); i++) {
+            RigidBody *rb = edge[i];
+            if (!wd->rigidBodies.contains(rb)) continue;
+            rb->body->SetTransform(b2Vec2(z.x + z.w - 2 + ((f + i) & 1 ? 3 : -3), rb->body->GetPosition().y), 0);
+            rb->body->SetLinearVelocity({0, 0});
+        }
+
+        timer.start();
+        if (mode == 0) {
+            int changed = rigidbody_dormant_legacy(wd);
+            if (timed) res.transitions += changed;
+        } else {
+            wd->tickObjectBounds();
+            // 游戏中原有的刚体不参与冻结
+            std::erase_if(wd->boundsFreeze, [&](RigidBody *rb) { return !bench.contains(rb); });
+            for (RigidBody *rb : wd->boundsFreeze) bench.erase(rb);
+            wd->applyObjectBounds();
+            if (timed) res.transitions += wd->boundsStats.enabled + wd->boundsStats.disabled;
+            res.frozen += wd->boundsStats.frozen;
+        }
+        timer.stop();
+        if (timed) res.boundsMs += timer.get();
+
+        timer.start();
+        wd->b2world->Step(33.0f / 1000.0f, 5, 2);
+        timer.stop();
+        if (timed) res.stepMs += timer.get();
+    }
+    res.proxies = wd->b2world->GetProxyCount();
+
+    for (RigidBody *rb : bench) {
+        if (!wd->rigidBodies.contains(rb)) continue;
+        wd->rigidBodies.erase(rb);
+        wd->b2world->DestroyBody(rb->body);
+        rb->clean();
+        delete rb;
+    }
+    for (auto &[ch, count, pristine] : chunks) {
+        ch->frozenBodies.resize(count);
+        ch->pristine = pristine;
+    }
+    wd->rbFreeze = freeze;
+    wd->rbThawBudget = thawBudget;
+    return res;
+}
+
+// 冻结后立即解冻 位置/角度/tiles 必须不变
+static int rigidbody_dormant_roundtrip(world *wd) {
+    const MErect z = wd->tickZone;
+    RigidBody *rb = rigidbody_dormant_box(wd, z.x + z.w / 2, z.y + z.h / 2);
+    rb->body->SetTransform(rb->body->GetPosition(), 0.5f);
+    rb->setTile(1, 1, Tiles_NOTHING);
+    rb->syncSurface();
+    rb->needsUpdate = true;
+    b2Vec2 pos = rb->body->GetPosition();
+    b2Vec2 center = rb->body->GetWorldCenter();
+    std::vector<mat_id> mats;
+    for (int i = 0; i < 16; i++) mats.push_back(rb->tiles[i].mat->id);
+
+    // 与 freezeRigidBody 相同: 质心所在的区块
+    Chunk *ch = nullptr;
+    auto xx = wd->chunkCache.find((int)std::floor((center.x - wd->loadZone.x) / CHUNK_W));
+    if (xx != wd->chunkCache.end()) {
+        auto yy = xx->second.find((int)std::floor((center.y - wd->loadZone.y) / CHUNK_H));
+        if (yy != xx->second.end()) ch = yy->second;
+    }
+    bool pristine = ch ? ch->pristine : false;
+    if (ch == nullptr || !wd->freezeRigidBody(rb)) {
+        wd->rigidBodies.erase(rb);
+        wd->b2world->DestroyBody(rb->body);
+        rb->clean();
+        delete rb;
+        return -1;
+    }
+
+    RigidBody *back = wd->thawRigidBody(ch, ch->frozenBodies.back());
+    ch->frozenBodies.pop_back();
+    ch->pristine = pristine;
+
+    int mismatch = 0;
+    if (!back->needsUpdate) mismatch++;
+    if (std::abs(back->body->GetPosition().x - pos.x) > 1e-3f || std::abs(back->body->GetPosition().y - pos.y) > 1e-3f) mismatch++;
+    if (std::abs(back->body->GetAngle() - 0.5f) > 1e-4f) mismatch++;
+    for (int i = 0; i < 16; i++)
+        if (back->tiles[i].mat->id != mats[i] || back->solidAt(i % 4, i / 4) != (mats[i] != GAME()->materials_list.GENERIC_AIR.id)) mismatch++;
+
+    wd->rigidBodies.erase(back);
+    wd->b2world->DestroyBody(back->body);
+    back->clean();
+    delete back;
+    return mismatch;
+}
+
+void rigidbody_dormant(int n) {
+    world *wd = global.game->Iso.world.get();
+    if (wd == nullptr) {
+        METADOT_ERROR("[bench] rigidbody_dormant needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 4000;
+    const int frames = 120;
+
+    const char *names[3] = {"per-tick SetEnabled", "hysteresis", "hysteresis+freeze"};
+    RigidBodyDormantRun runs[3];
+    for (int mode = 0; mode < 3; mode++) {
+        runs[mode] = rigidbody_dormant_run(wd, n, frames, mode);
+        const RigidBodyDormantRun &r = runs[mode];
+        METADOT_INFO(std::format("[bench] rigidbody_dormant n={0} {1}: bounds {2:.3f} ms/frame step {3:.3f} ms/frame total {4:.3f} ms/frame {5:.1f} transitions/frame {6} frozen {7} proxies",
+                                 n, names[mode], r.boundsMs / frames, r.stepMs / frames, (r.boundsMs + r.stepMs) / frames, (f64)r.transitions / frames, r.frozen, r.proxies)
+                             .c_str());
+    }
+    METADOT_INFO(std::format("[bench] rigidbody_dormant frame cost vs per-tick SetEnabled: hysteresis {0:.2f}x hysteresis+freeze {1:.2f}x",
+                             (runs[0].boundsMs + runs[0].stepMs) / std::max(runs[1].boundsMs + runs[1].stepMs, 0.001),
+                             (runs[0].boundsMs + runs[0].stepMs) / std::max(runs[2].boundsMs + runs[2].stepMs, 0.001))
+                         .c_str());
+    if (runs[2].frozen < n) METADOT_ERROR(std::format("[bench] rigidbody_dormant only {0}/{1} bodies were frozen (owning chunks not loaded?)", runs[2].frozen, n).c_str());
+
+    int mismatch = rigidbody_dormant_roundtrip(wd);
+    if (mismatch < 0) METADOT_ERROR("[bench] rigidbody_dormant freeze/thaw round trip found no loaded chunk");
+    if (mismatch > 0) METADOT_ERROR(std::format("[bench] rigidbody_dormant {0} differences after freeze/thaw round trip", mismatch).c_str());
+}
+
+#pragma endregion RigidBodyDormant
+
+#pragma region Particles
+
+// 原先的粒子表示: 每个粒子单独分配 带完整 MaterialInstance 与默认回调
+struct LegacyCell {
+    MaterialInstance tile{};
+    f32 x, y, vx, vy, ax, ay;
+    bool temporary = true;
+    int lifetime = 0;
+    u8 inObjectState = 0;
+    std::function<void()> killCallback = []() {};
+};
+
+// 原先 tickCells 中临时粒子会走到的分支 (运动 越界 碰撞即死亡)
+static void particles_tick_legacy(world *w, std::vector<LegacyCell *> &cells) {
+    std::erase_if(cells, [&](LegacyCell *cur) {
+        if (cur->temporary && cur->lifetime <= 0) {
+            cur->killCallback();
+            delete cur;
+            return true;
+        }
+        int lx = cur->x, ly = cur->y;
+        if (cur->x < 0 || (int)cur->x >= w->width || cur->y < 0 || (int)cur->y >= w->height) {
+            cur->killCallback();
+            delete cur;
+            return true;
+        }
+        if (!(lx >= w->tickZone.x && ly >= w->tickZone.y && lx < w->tickZone.x + w->tickZone.w && ly < w->tickZone.y + w->tickZone.h)) return false;
+
+        cur->vx += cur->ax;
+        cur->vy += cur->ay;
+        int div = (int)((abs(cur->vx) + abs(cur->vy)) + 1);
+        f32 dvx = cur->vx / div, dvy = cur->vy / div;
+        for (int i = 0; i < div; i++) {
+            cur->x += dvx;
+            cur->y += dvy;
+            if (cur->x < 0 || (int)cur->x >= w->width || cur->y < 0 || (int)cur->y >= w->height) {
+                cur->killCallback();
+                delete cur;
+                return true;
+            }
+            int type = w->real_tiles[(int)cur->x + (int)cur->y * w->width].mat->physicsType;
+            if (type != PhysicsType::AIR) {
+                bool isObject = type == PhysicsType::OBJECT;
+                if (cur->inObjectState == 0) cur->inObjectState = isObject ? 1 : 2;
+                else if (cur->inObjectState == 1 && !isObject) cur->inObjectState = 2;
+                if (!isObject || cur->inObjectState == 2) {
+                    cur->killCallback();
+                    delete cur;
+                    return true;
+                }
+            }
+        }
+        if (cur->lifetime > 0) cur->lifetime--;
+        return false;
+    });
+}
+
+// tickZone 内空气格子上的粒子 碰撞后消失 不改动地形
+static std::vector<CellData> particles_spawns(world *w, int count) {
+    std::vector<CellData> spawns;
+    spawns.reserve(count);
+    int zx = std::max((int)w->tickZone.x, 0), zy = std::max((int)w->tickZone.y, 0);
+    int zw = std::max((int)w->tickZone.w, 1), zh = std::max((int)w->tickZone.h, 1);
+    for (int i = 0; i < count; i++) {
+        int x = zx + rand() % zw, y = zy + rand() % zh;
+        for (int t = 0; t < 8 && w->real_tiles[x + y * w->width].mat->physicsType != PhysicsType::AIR; t++) x = zx + rand() % zw, y = zy + rand() % zh;
+        CellData c(TilesCreateLava(), x + 0.5f, y + 0.5f, (rand() % 20 - 10) / 10.0f, (rand() % 20 - 10) / 10.0f, 0, 0.05f);
+        c.temporary = true;
+        c.lifetime = 20 + rand() % 60;
+        spawns.push_back(c);
+    }
+    return spawns;
+}
+
+void particles(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] particles needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 100000;
+    const int frames = 60;
+
+    srand(n);
+    std::vector<CellData> spawns = particles_spawns(w, n * 2);
+    CellPool saved = w->cells;
+    bool savedParallel = w->cellsParallel;
+
+    // 每帧补充到 n 个存活粒子 三种方式使用相同的生成序列
+    f64 ms[3] = {};
+    size_t spawned[3] = {};
+    for (int mode = 0; mode < 3; mode++) {
+        size_t next = 0;
+        auto spawn = [&]() -> const CellData & { return spawns[next++ % spawns.size()]; };
+        Timer timer;
+        if (mode == 0) {
+            std::vector<LegacyCell *> cells;
+            timer.start();
+            for (int f = 0; f < frames; f++) {
+                while ((int)cells.size() < n) {
+                    const CellData &c = spawn();
+                    LegacyCell *p = new LegacyCell;
+                    p->tile = c.tile, p->x = c.x, p->y = c.y, p->vx = c.vx, p->vy = c.vy, p->ax = c.ax, p->ay = c.ay, p->lifetime = c.lifetime;
+                    cells.push_back(p);
+                }
+                particles_tick_legacy(w, cells);
+            }
+            timer.stop();
+            for (LegacyCell *p : cells) delete p;
+        } else {
+            w->cells.clear();
+            w->cellsParallel = mode == 2;
+            timer.start();
+            for (int f = 0; f < frames; f++) {
+                while ((int)w->cells.size() < n) w->addCell(spawn());
+                w->tickCells();
+            }
+            timer.stop();
+        }
+        ms[mode] = timer.get();
+        spawned[mode] = next;
+    }
+
+    METADOT_INFO(std::format("[bench] particles n={0} heap+std::function {1:.3f} ms/frame pool serial {2:.3f} ms/frame pool parallel {3:.3f} ms/frame ({4:.1f}x / {5:.1f}x)", n, ms[0] / frames,
+                             ms[1] / frames, ms[2] / frames, ms[0] / std::max(ms[1], 0.001), ms[0] / std::max(ms[2], 0.001))
+                         .c_str());
+    if (spawned[0] != spawned[1] || spawned[1] != spawned[2])
+        METADOT_ERROR(std::format("[bench] particles respawn counts differ: {0} / {1} / {2}", spawned[0], spawned[1], spawned[2]).c_str());
+
+    // 串行与并行各跑 30 帧 其中部分粒子会落地写入地形 粒子状态与地形必须完全一致
+    std::vector<MaterialInstance> tiles = w->real_tiles;
+    CellPool start;
+    for (int i = 0; i < std::min(n, 20000); i++) {
+        CellData c = spawns[i];
+        c.temporary = i % 10 != 0;
+        start.add(c);
+    }
+    CellPool result[2];
+    std::vector<mat_id> landed[2];
+    for (int mode = 0; mode < 2; mode++) {
+        w->real_tiles = tiles;
+        w->cells = start;
+        w->cellsParallel = mode == 1;
+        for (int f = 0; f < 30; f++) w->tickCells();
+        result[mode] = w->cells;
+        landed[mode].resize(w->real_tiles.size());
+        for (size_t i = 0; i < w->real_tiles.size(); i++) landed[mode][i] = w->real_tiles[i].mat->id;
+    }
+    int mismatch = 0;
+    for (size_t i = 0; i < landed[0].size(); i++)
+        if (landed[0][i] != landed[1][i]) mismatch++;
+    const CellPool &a = result[0], &b = result[1];
+    if (a.capacity() != b.capacity() || a.size() != b.size()) {
+        mismatch++;
+    } else {
+        for (u32 i = 0; i < a.capacity(); i++)
+            if (a.alive[i] != b.alive[i] || (a.alive[i] && (a.x[i] != b.x[i] || a.y[i] != b.y[i] || a.vx[i] != b.vx[i] || a.vy[i] != b.vy[i]))) mismatch++;
+    }
+
+    w->real_tiles = tiles;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = saved;
+    w->cellsParallel = savedParallel;
+
+    if (mismatch > 0)
+        METADOT_ERROR(std::format("[bench] particles serial and parallel ticks differ in {0} particles/tiles", mismatch).c_str());
+    else
+        METADOT_INFO(std::format("[bench] particles serial and parallel ticks match ({0} live after 30 frames)", a.size()).c_str());
+}
+
+
+// 把 tickCells 使用的线程池临时换成 threads 个线程 返回被换下的线程池
+static scope<thread_pool> particles_swap_pool(world *w, scope<thread_pool> pool) {
+    std::swap(w->world_sys.tickPool, pool);
+    return pool;
+}
+
+void particles_parallel(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] particles_parallel needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 100000;
+    const int frames = 30;
+
+    // 一成粒子会落地 其中一部分从同一位置以同一速度发射 落到同一格子上产生冲突
+    srand(n);
+    std::vector<CellData> spawns = particles_spawns(w, n);
+    CellPool start;
+    for (int i = 0; i < n; i++) {
+        CellData c = spawns[i];
+        if (i % 10 == 0) {
+            c.temporary = false;
+            if (i % 40 == 0) {
+                c = spawns[(i / 400) * 10];
+                c.temporary = false;
+            }
+        }
+        start.add(c);
+    }
+
+    std::vector<MaterialInstance> tiles = w->real_tiles;
+    CellPool saved = w->cells;
+    bool savedParallel = w->cellsParallel;
+    w->cellsParallel = true;
+
+    const int counts[] = {1, 2, 4, 8, 16};
+    f64 ms[5] = {};
+    CellPool ref;
+    std::vector<mat_id> refTiles;
+    int mismatch = 0;
+
+    for (int t = 0; t < 5; t++) {
+        scope<thread_pool> old = particles_swap_pool(w, create_scope<thread_pool>(counts[t]));
+
+        w->real_tiles = tiles;
+        w->cells = start;
+        Timer timer;
+        timer.start();
+        for (int f = 0; f < frames; f++) w->tickCells();
+        timer.stop();
+        ms[t] = timer.get();
+
+        particles_swap_pool(w, std::move(old));
+
+        // 与单线程结果逐个比较 包括空闲链表 (决定之后新粒子的槽位)
+        std::vector<mat_id> mats(w->real_tiles.size());
+        for (size_t i = 0; i < mats.size(); i++) mats[i] = w->real_tiles[i].mat->id;
+        if (t == 0) {
+            ref = w->cells;
+            refTiles = std::move(mats);
+            continue;
+        }
+        const CellPool &a = ref, &b = w->cells;
+        int diff = 0;
+        for (size_t i = 0; i < mats.size(); i++)
+            if (mats[i] != refTiles[i]) diff++;
+        if (a.capacity() != b.capacity() || a.freeList != b.freeList) {
+            diff++;
+        } else {
+            for (u32 i = 0; i < a.capacity(); i++)
+                if (a.alive[i] != b.alive[i] || (a.alive[i] && (a.x[i] != b.x[i] || a.y[i] != b.y[i] || a.vx[i] != b.vx[i] || a.vy[i] != b.vy[i]))) diff++;
+        }
+        if (diff > 0) METADOT_ERROR(std::format("[bench] particles_parallel {0} threads differ from 1 thread in {1} particles/tiles", counts[t], diff).c_str());
+        mismatch += diff;
+    }
+
+    w->real_tiles = tiles;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = saved;
+    w->cellsParallel = savedParallel;
+
+    METADOT_INFO(std::format("[bench] particles_parallel n={0} ms/frame 1t {1:.3f} 2t {2:.3f} 4t {3:.3f} 8t {4:.3f} 16t {5:.3f} (8t speedup {6:.2f}x) {7} live after {8} frames", n, ms[0] / frames,
+                             ms[1] / frames, ms[2] / frames, ms[3] / frames, ms[4] / frames, ms[0] / std::max(ms[3], 0.001), ref.size(), frames)
+                         .c_str());
+    if (mismatch == 0) METADOT_INFO("[bench] particles_parallel results are identical for every thread count");
+}
+#pragma endregion Particles
+
+#pragma region MaterialInteractions
+
+void material_interactions(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] material_interactions needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 30;
+
+    auto &mats = GAME()->materials_container;
+    MaterialInteractionTable &table = GAME()->materials_interactions;
+
+    // 有相互作用数据的材料 (InitMaterials 中的随机材料) 默认 interact 为 false 这里临时打开
+    std::vector<Material *> reactive;
+    std::vector<bool> savedInteract(mats.size());
+    for (size_t a = 0; a < mats.size(); a++) {
+        savedInteract[a] = mats[a]->interact;
+        if (mats[a]->nInteractions == nullptr) continue;
+        for (size_t b = 0; b < mats.size() && mats[b]->nInteractions != nullptr; b++) {
+            if (mats[a]->nInteractions[b] > 0) {
+                mats[a]->interact = true;
+                reactive.push_back(mats[a]);
+                break;
+            }
+        }
+    }
+    table.build(mats);
+
+    // 查找表与材料上的数组逐项一致
+    int tableMismatch = 0;
+    for (u32 a = 0; a < table.count; a++) {
+        for (u32 b = 0; b < table.count; b++) {
+            const Material *m = mats[a];
+            bool old = m->interact && m->nInteractions != nullptr && mats[b]->nInteractions != nullptr && m->nInteractions[b] > 0;
+            if (old != table.has(a, b)) {
+                tableMismatch++;
+                continue;
+            }
+            if (!old) continue;
+            if (table.end(a, b) - table.begin(a, b) != m->nInteractions[b]) {
+                tableMismatch++;
+                continue;
+            }
+            for (int i = 0; i < m->nInteractions[b]; i++) {
+                const MaterialInteraction &x = table.begin(a, b)[i], &y = m->interactions[b][i];
+                if (x.type != y.type || x.data1 != y.data1 || x.data2 != y.data2 || x.ofsX != y.ofsX || x.ofsY != y.ofsY) tableMismatch++;
+            }
+        }
+    }
+
+    // tickZone 内铺满反应材料 水 熔岩与空气
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    bool savedTable = w->interactTable;
+    int zx = std::max((int)w->tickZone.x, 1), zy = std::max((int)w->tickZone.y, 1);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    srand(n);
+    for (int y = zy; y < zy1; y++) {
+        for (int x = zx; x < zx1; x++) {
+            int r = rand() % 100;
+            mat_id id;
+            if (r < 45 && !reactive.empty()) id = reactive[rand() % reactive.size()]->id;
+            else if (r < 60) id = GAME()->materials_list.WATER.id;
+            else if (r < 70) id = GAME()->materials_list.LAVA.id;
+            else if (r < 80) id = GAME()->materials_list.GENERIC_SAND.id;
+            else id = GAME()->materials_list.GENERIC_AIR.id;
+            w->real_tiles[x + y * w->width] = TilesCreate(id, x, y);
+        }
+    }
+    std::vector<MaterialInstance> start = w->real_tiles;
+
+    f64 ms[2] = {};
+    for (int mode = 0; mode < 2; mode++) {
+        w->real_tiles = start;
+        w->rebuildChunkStats();
+        w->interactTable = mode == 1;
+        srand(n);
+        Timer timer;
+        timer.start();
+        for (int f = 0; f < n; f++) w->tick();
+        timer.stop();
+        ms[mode] = timer.get();
+    }
+
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->interactTable = savedTable;
+    for (size_t a = 0; a < mats.size(); a++) mats[a]->interact = savedInteract[a];
+    table.build(mats);
+
+    METADOT_INFO(std::format("[bench] material_interactions {0} ticks over {1}x{2} cells ({3} reactive materials) pointer chain {4:.3f} ms/tick table {5:.3f} ms/tick ({6:.2f}x)", n, zx1 - zx,
+                             zy1 - zy, reactive.size(), ms[0] / n, ms[1] / n, ms[0] / std::max(ms[1], 0.001))
+                         .c_str());
+    if (tableMismatch > 0)
+        METADOT_ERROR(std::format("[bench] material_interactions table differs from per-material arrays in {0} entries", tableMismatch).c_str());
+    else
+        METADOT_INFO(std::format("[bench] material_interactions table matches per-material arrays ({0} materials, {1} interactions)", table.count, table.list.size()).c_str());
+}
+
+#pragma endregion MaterialInteractions
+
+#pragma region EntityCollision
+
+struct EntityCollisionRun {
+    f64 ms = 0;
+    std::vector<WorldEntity> ents;
+    std::vector<MaterialInstance> tiles;
+    u32 cells = 0;
+};
+
+static EntityCollisionRun entity_collision_run(world *w, const std::vector<WorldEntity> &start, const std::vector<MaterialInstance> &tiles, int frames, bool bits) {
+    EntityCollisionRun r;
+    r.ents = start;
+    w->real_tiles = tiles;
+    w->cells.clear();
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+    std::fill(w->dirty, w->dirty + w->width * w->height, false);
+    w->entityBits = bits;
+    std::vector<u8> gone(r.ents.size(), 0);
+
+    srand(frames);
+    Timer timer;
+    timer.start();
+    for (int f = 0; f < frames; f++) {
+        // 与 tickEntities 一样每帧先同步 dirty
+        if (bits) w->syncSolidBitsDirty(0, 0, w->width, w->height);
+        for (size_t i = 0; i < r.ents.size(); i++) {
+            if (gone[i]) continue;
+            WorldEntity &e = r.ents[i];
+            // NPC 走到头就掉头 偶尔起跳
+            if (e.ground && rand() % 32 == 0) e.vy = -4;
+            if (std::fabs(e.vx) < 0.2f) e.vx = (rand() % 2 == 0 ? -2.0f : 2.0f);
+            gone[i] = w->tickEntity(&e);
+        }
+    }
+    timer.stop();
+    r.ms = timer.get();
+    r.tiles = w->real_tiles;
+    r.cells = w->cells.size();
+    return r;
+}
+
+void entity_collision(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr || w->collideBits.empty()) {
+        METADOT_ERROR("[bench] entity_collision needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 1000;
+    const int frames = 120;
+
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    bool savedBits = w->entityBits;
+
+    // tickZone 内起伏的沙层 下面是实心地面 散落一些实心柱子
+    int zx = std::max((int)w->tickZone.x, 0), zy = std::max((int)w->tickZone.y, 0);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height);
+    std::vector<MaterialInstance> tiles = w->real_tiles;
+    srand(n);
+    for (int x = zx; x < zx1; x++) {
+        int ground = zy + (zy1 - zy) * 3 / 5 + (int)(20 * std::sin(x * 0.05f));
+        bool pillar = rand() % 40 == 0;
+        for (int y = zy; y < zy1; y++) {
+            mat_id id = GAME()->materials_list.GENERIC_AIR.id;
+            if (y > ground + 12) id = GAME()->materials_list.GENERIC_SOLID.id;
+            else if (y > ground) id = GAME()->materials_list.GENERIC_SAND.id;
+            else if (pillar && y > ground - 30) id = GAME()->materials_list.GENERIC_SOLID.id;
+            tiles[x + y * w->width] = TilesCreate(id, x, y);
+        }
+    }
+
+    std::vector<WorldEntity> start;
+    start.reserve(n);
+    for (int i = 0; i < n; i++) {
+        f32 x = zx + rand() % std::max(zx1 - zx - 16, 1) - w->loadZone.x;
+        f32 y = zy + rand() % std::max((zy1 - zy) / 2, 1) - w->loadZone.y;
+        start.emplace_back(false, x, y, (rand() % 5 - 2) * 1.0f, 0.0f, 14, 26, nullptr, "npc");
+    }
+
+    EntityCollisionRun cell = entity_collision_run(w, start, tiles, frames, false);
+    EntityCollisionRun bits = entity_collision_run(w, start, tiles, frames, true);
+
+    int entMismatch = 0;
+    for (int i = 0; i < n; i++) {
+        const WorldEntity &a = cell.ents[i], &b = bits.ents[i];
+        if (a.x != b.x || a.y != b.y || a.vx != b.vx || a.vy != b.vy || a.ground != b.ground) entMismatch++;
+    }
+    int tileMismatch = 0;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (cell.tiles[i].mat != bits.tiles[i].mat) tileMismatch++;
+    }
+    // 推开沙子后位图仍与 real_tiles 一致
+    int bitMismatch = 0;
+    for (int y = 0; y < w->height; y++) {
+        for (int x = 0; x < w->width; x++) {
+            if (w->collideAt(x, y) != world::collides(w->real_tiles[x + y * w->width].mat)) bitMismatch++;
+        }
+    }
+
+    w->real_tiles = saved;
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->entityBits = savedBits;
+
+    METADOT_INFO(std::format("[bench] entity_collision {0} entities {1} frames per-cell {2:.3f} ms/frame bitmap {3:.3f} ms/frame ({4:.2f}x) {5} particles knocked", n, frames, cell.ms / frames,
+                             bits.ms / frames, cell.ms / std::max(bits.ms, 0.001), bits.cells)
+                         .c_str());
+    if (entMismatch > 0 || tileMismatch > 0 || bitMismatch > 0 || cell.cells != bits.cells)
+        METADOT_ERROR(std::format("[bench] entity_collision mismatch: {0} entities {1} tiles {2} bitmap cells particles {3}/{4}", entMismatch, tileMismatch, bitMismatch, cell.cells, bits.cells)
+                              .c_str());
+    else
+        METADOT_INFO("[bench] entity_collision per-cell and bitmap results match");
+}
+
+#pragma endregion EntityCollision
+
+#pragma region Rays
+
+// 原先以 std::function 为参数的 forLine/forLineCornered
+static void rays_forline_legacy(world *w, int x0, int y0, int x1, int y1, std::function<bool(int)> fn) { w->forLine(x0, y0, x1, y1, fn); }
+
+static void rays_cornered_legacy(world *w, int x0, int y0, int x1, int y1, std::function<bool(int)> fn) {
+    f32 sx = x0, sy = y0, ex = x1, ey = y1;
+    f32 x = floor(sx), y = floor(sy);
+    f32 diffX = ex - sx, diffY = ey - sy;
+    f32 stepX = (diffX > 0) ? 1 : ((diffX < 0) ? -1 : 0);
+    f32 stepY = (diffY > 0) ? 1 : ((diffY < 0) ? -1 : 0);
+    f32 xOffset = ex > sx ? (ceil(sx) - sx) : (sx - floor(sx));
+    f32 yOffset = ey > sy ? (ceil(sy) - sy) : (sy - floor(sy));
+    f32 angle = atan2(-diffY, diffX);
+    f32 tMaxX = xOffset / cos(angle), tMaxY = yOffset / sin(angle);
+    f32 tDeltaX = 1.0 / cos(angle), tDeltaY = 1.0 / sin(angle);
+    f32 manhattanDistance = abs(floor(ex) - floor(sx)) + abs(floor(ey) - floor(sy));
+    std::vector<int> visited = {};
+    for (int t = 0; t <= manhattanDistance; ++t) {
+        if (std::find(visited.begin(), visited.end(), x + y * w->width) == visited.end() && fn(x + y * w->width)) return;
+        visited.push_back(x + y * w->width);
+        if (abs(tMaxX) < abs(tMaxY) || isnan(tMaxY)) {
+            tMaxX += tDeltaX;
+            x += stepX;
+        } else {
+            tMaxY += tDeltaY;
+            y += stepY;
+        }
+    }
+}
+
+void rays(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr || w->collideBits.empty()) {
+        METADOT_ERROR("[bench] rays needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 100000;
+
+    // 从 tickZone 内 64 个爆炸中心向四周发出长度 <= 256 的射线
+    w->syncSolidBits(0, 0, w->width, w->height);
+    w->rebuildChunkStats();
+    int zx = std::max((int)w->tickZone.x, 0), zy = std::max((int)w->tickZone.y, 0);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    std::vector<Ray> rs(n);
+    srand(n);
+    for (int i = 0; i < n; i++) {
+        int c = i / std::max(n / 64, 1);
+        int cx = zx + (c * 7919) % std::max(zx1 - zx, 1), cy = zy + (c * 104729) % std::max(zy1 - zy, 1);
+        f32 a = (rand() % 3600) * (2 * 3.14159265f / 3600), len = 16 + rand() % 241;
+        rs[i] = {cx, cy, std::clamp((int)(cx + std::cos(a) * len), 0, w->width - 1), std::clamp((int)(cy + std::sin(a) * len), 0, w->height - 1)};
+    }
+
+    const MaterialInstance *tiles = w->real_tiles.data();
+    auto solid = [&](int index) { return world::collides(tiles[index].mat); };
+    std::vector<int> hits[4];
+    f64 ms[4] = {};
+    for (int mode = 0; mode < 4; mode++) {
+        std::vector<int> &h = hits[mode];
+        h.assign(n, -1);
+        Timer timer;
+        timer.start();
+        if (mode == 0) {
+            for (int i = 0; i < n; i++) rays_forline_legacy(w, rs[i].x0, rs[i].y0, rs[i].x1, rs[i].y1, [&](int index) { return solid(index) ? (h[i] = index, true) : false; });
+        } else if (mode == 1) {
+            for (int i = 0; i < n; i++) w->forLine(rs[i].x0, rs[i].y0, rs[i].x1, rs[i].y1, [&](int index) { return solid(index) ? (h[i] = index, true) : false; });
+        } else if (mode == 2) {
+            w->forRays(rs.data(), n, [&](int ray, int index) { return solid(index) ? (h[ray] = index, true) : false; });
+        } else {
+            w->traceRays(rs.data(), n, w->collideBits, h.data());
+        }
+        timer.stop();
+        ms[mode] = timer.get();
+    }
+
+    int mismatch = 0;
+    for (int mode = 1; mode < 4; mode++) {
+        for (int i = 0; i < n; i++) mismatch += hits[mode][i] != hits[0][i];
+    }
+    int blocked = 0;
+    for (int i = 0; i < n; i++) blocked += hits[0][i] >= 0;
+
+    // forLineCornered 原先用 visited 数组去重 每步线性查找
+    int m = std::min(n, 10000);
+    int cornerMismatch = 0;
+    f64 cornerMs[2] = {};
+    for (int mode = 0; mode < 2; mode++) {
+        Timer timer;
+        timer.start();
+        for (int i = 0; i < m; i++) {
+            u64 sum = 0;
+            auto fn = [&](int index) {
+                sum = sum * 31 + index;
+                return false;
+            };
+            if (mode == 0) rays_cornered_legacy(w, rs[i].x0, rs[i].y0, rs[i].x1, rs[i].y1, fn);
+            else w->forLineCornered(rs[i].x0, rs[i].y0, rs[i].x1, rs[i].y1, fn);
+            hits[mode][i] = (int)(sum ^ (sum >> 32));
+        }
+        timer.stop();
+        cornerMs[mode] = timer.get();
+    }
+    for (int i = 0; i < m; i++) cornerMismatch += hits[0][i] != hits[1][i];
+
+    auto mrays = [](int count, f64 t) { return count / std::max(t, 0.001) / 1000.0; };
+    METADOT_INFO(std::format("[bench] rays {0} rays ({1} blocked) std::function {2:.2f} Mrays/s template {3:.2f} Mrays/s batched {4:.2f} Mrays/s bitmap {5:.2f} Mrays/s", n, blocked,
+                             mrays(n, ms[0]), mrays(n, ms[1]), mrays(n, ms[2]), mrays(n, ms[3]))
+                         .c_str());
+    METADOT_INFO(std::format("[bench] rays forLineCornered {0} rays std::function+visited {1:.2f} Mrays/s template {2:.2f} Mrays/s", m, mrays(m, cornerMs[0]), mrays(m, cornerMs[1])).c_str());
+    if (mismatch > 0 || cornerMismatch > 0)
+        METADOT_ERROR(std::format("[bench] rays hit mismatch: {0} forLine {1} forLineCornered", mismatch, cornerMismatch).c_str());
+    else
+        METADOT_INFO("[bench] rays all paths hit the same cells");
+}
+
+#pragma endregion Rays
+
+#pragma region TickBudget
+
+void tick_budget(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] tick_budget needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 60;
+
+    // tickZone 上半部分灌满水和熔岩 模拟洪水
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    TickBudget savedBudget = w->tickBudget;
+    int zx = std::max((int)w->tickZone.x, 1), zy = std::max((int)w->tickZone.y, 1);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    srand(n);
+    for (int y = zy; y < zy1; y++) {
+        for (int x = zx; x < zx1; x++) {
+            mat_id id = GAME()->materials_list.GENERIC_AIR.id;
+            if (y < (zy + zy1) / 2) id = rand() % 4 == 0 ? GAME()->materials_list.LAVA.id : GAME()->materials_list.WATER.id;
+            w->real_tiles[x + y * w->width] = TilesCreate(id, x, y);
+        }
+    }
+    std::vector<MaterialInstance> start = w->real_tiles;
+    int fx = (zx + zx1) / 2, fy = (zy + zy1) / 2;
+
+    // 0: 不限预算 1: 预算为不限时平均耗时的一半
+    f64 ms[2] = {}, worst[2] = {};
+    int ticked = 0, deferred = 0, reduced = 0, maxAge = 0;
+    for (int mode = 0; mode < 2; mode++) {
+        w->real_tiles = start;
+        w->rebuildChunkStats();
+        w->cells.clear();
+        w->tickBudget = TickBudget{};
+        w->tickBudget.budgetMs = mode == 0 ? 0 : (f32)(ms[0] / n / 2);
+        w->tickBudget.focus = {{fx, fy}};
+        srand(n);
+        for (int f = 0; f < n; f++) {
+            Timer timer;
+            timer.start();
+            w->tick();
+            timer.stop();
+            ms[mode] += timer.get();
+            worst[mode] = std::max(worst[mode], timer.get());
+            if (mode == 1) {
+                ticked += w->tickBudget.ticked;
+                deferred += w->tickBudget.deferred;
+                reduced += w->tickBudget.reduced;
+                for (auto &[key, blk] : w->tickBudget.blocks) maxAge = std::max(maxAge, w->tickCt - 1 - blk.lastTick);
+            }
+        }
+    }
+    f32 budgetMs = w->tickBudget.budgetMs;
+
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->tickBudget = savedBudget;
+
+    METADOT_INFO(std::format("[bench] tick_budget {0} ticks full {1:.3f} ms/tick (worst {2:.3f}) budget {3:.3f} ms -> {4:.3f} ms/tick (worst {5:.3f})", n, ms[0] / n, worst[0], budgetMs, ms[1] / n, worst[1])
+                         .c_str());
+    METADOT_INFO(std::format("[bench] tick_budget per tick {0:.1f} blocks ticked {1:.1f} deferred {2:.1f} reduced, longest deferral {3} ticks", (f64)ticked / n, (f64)deferred / n, (f64)reduced / n, maxAge)
+                         .c_str());
+}
+
+#pragma endregion TickBudget
+
+#pragma region SimLod
+
+void sim_lod(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] sim_lod needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 120;
+
+    // 实心地面上堆着沙丘 一个水池与几处熔岩 上方留空让沙子下落
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    TickBudget savedBudget = w->tickBudget;
+    TickLod savedLod = w->tickLod;
+    int savedTempCt = w->temperatureCt;
+    int zx = std::max((int)w->tickZone.x, 1), zy = std::max((int)w->tickZone.y, 1);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    int zh = zy1 - zy;
+    srand(n);
+    for (int x = zx; x < zx1; x++) {
+        int ground = zy + zh * 3 / 4 + (int)(10 * std::sin(x * 0.02f));
+        int dune = ground - (int)(40 * std::max(std::sin(x * 0.013f), 0.0f));
+        for (int y = zy; y < zy1; y++) {
+            mat_id id = GAME()->materials_list.GENERIC_AIR.id;
+            if (y > ground) id = GAME()->materials_list.GENERIC_SOLID.id;
+            else if (y > dune) id = GAME()->materials_list.GENERIC_SAND.id;
+            else if (y > ground - 30 && (x / 97) % 5 == 0) id = GAME()->materials_list.WATER.id;
+            else if (y > ground - 6 && (x / 61) % 9 == 0) id = GAME()->materials_list.LAVA.id;
+            else if (y < zy + zh / 4 && rand() % 50 == 0) id = GAME()->materials_list.GENERIC_SAND.id;
+            w->real_tiles[x + y * w->width] = TilesCreate(id, x, y);
+        }
+    }
+    std::vector<MaterialInstance> start = w->real_tiles;
+
+    f64 ms[2] = {};
+    int sleeping = 0, skipped = 0, ticked = 0;
+    for (int mode = 0; mode < 2; mode++) {
+        w->real_tiles = start;
+        w->rebuildChunkStats();
+        w->cells.clear();
+        w->tickBudget = TickBudget{};
+        w->tickBudget.focus = {{(zx + zx1) / 2, (zy + zy1) / 2}};
+        w->tickLod = TickLod{};
+        w->tickLod.enabled = mode == 1;
+        w->tickLod.nearRadius = 1;
+        w->tickLod.midRadius = 2;
+        w->temperatureCt = 0;
+        std::fill(w->dirty, w->dirty + w->width * w->height, false);
+        srand(n);
+        Timer timer;
+        timer.start();
+        for (int f = 0; f < n; f++) {
+            w->tick();
+            w->tickTemperature();
+            // 与游戏一样每帧结束时清除 dirty
+            std::fill(w->dirty, w->dirty + w->width * w->height, false);
+            if (mode == 1) {
+                sleeping += w->tickBudget.sleeping;
+                skipped += w->tickBudget.skipped;
+                ticked += w->tickBudget.ticked;
+            }
+        }
+        timer.stop();
+        ms[mode] = timer.get();
+    }
+    int blocks = w->tickBudget.cols * w->tickBudget.rows;
+
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->tickBudget = savedBudget;
+    w->tickLod = savedLod;
+    w->temperatureCt = savedTempCt;
+
+    auto tps = [&](f64 t) { return n / std::max(t, 0.001) * 1000.0; };
+    METADOT_INFO(std::format("[bench] sim_lod {0} ticks over {1}x{2} cells ({3} blocks) full {4:.1f} TPS lod {5:.1f} TPS ({6:.2f}x)", n, zx1 - zx, zy1 - zy, blocks, tps(ms[0]), tps(ms[1]),
+                             ms[0] / std::max(ms[1], 0.001))
+                         .c_str());
+    METADOT_INFO(std::format("[bench] sim_lod per tick {0:.1f} blocks ticked {1:.1f} off-period {2:.1f} sleeping", (f64)ticked / n, (f64)skipped / n, (f64)sleeping / n).c_str());
+}
+
+#pragma endregion SimLod
+
+#pragma region TickExchange
+
+void tick_exchange(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] tick_exchange needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 60;
+
+    // tickZone 上部为水/熔岩 下面一层沙子 沙子只会交换位置或变成下落粒子 总数应保持不变
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    TickBudget savedBudget = w->tickBudget;
+    TickLod savedLod = w->tickLod;
+    bool savedExchange = w->borderExchange;
+    int zx = std::max((int)w->tickZone.x, 1), zy = std::max((int)w->tickZone.y, 1);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    int zh = zy1 - zy;
+    mat_id sand = GAME()->materials_list.GENERIC_SAND.id;
+    srand(n);
+    for (int y = zy; y < zy1; y++) {
+        for (int x = zx; x < zx1; x++) {
+            mat_id id = GAME()->materials_list.GENERIC_AIR.id;
+            if (y < zy + zh * 2 / 5) id = rand() % 4 == 0 ? GAME()->materials_list.LAVA.id : GAME()->materials_list.WATER.id;
+            else if (y < zy + zh / 2) id = sand;
+            w->real_tiles[x + y * w->width] = TilesCreate(id, x, y);
+        }
+    }
+    std::vector<MaterialInstance> start = w->real_tiles;
+    auto countSand = [&]() {
+        int c = 0;
+        for (const MaterialInstance &t : w->real_tiles) c += t.mat->id == sand;
+        for (u32 i = 0; i < w->cells.capacity(); i++) c += w->cells.alive[i] && w->cells.tile[i].mat->id == sand;
+        return c;
+    };
+    int sand0 = countSand();
+
+    // 0: 4 相棋盘 1: 内部一次并行扫描 + outbox 合并
+    f64 ms[2] = {}, mergeMs = 0;
+    int sandAfter[2] = {};
+    long long deferred = 0;
+    for (int mode = 0; mode < 2; mode++) {
+        w->real_tiles = start;
+        w->rebuildChunkStats();
+        w->cells.clear();
+        w->tickBudget = TickBudget{};
+        w->tickLod = TickLod{};
+        w->borderExchange = mode == 1;
+        srand(n);
+        for (int f = 0; f < n; f++) {
+            Timer timer;
+            timer.start();
+            w->tick();
+            timer.stop();
+            ms[mode] += timer.get();
+            if (mode == 1) {
+                mergeMs += w->tickExchange.mergeMs;
+                deferred += w->tickExchange.deferred;
+            }
+        }
+        sandAfter[mode] = countSand();
+    }
+
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->tickBudget = savedBudget;
+    w->tickLod = savedLod;
+    w->borderExchange = savedExchange;
+
+    METADOT_INFO(std::format("[bench] tick_exchange {0} ticks {1} threads 4-pass {2:.3f} ms/tick exchange {3:.3f} ms/tick ({4:.2f}x)", n, w->world_sys.tickPool->size(), ms[0] / n, ms[1] / n,
+                             ms[0] / std::max(ms[1], 0.001))
+                         .c_str());
+    METADOT_INFO(std::format("[bench] tick_exchange merge {0:.3f} ms/tick ({1:.1f}%) {2} outbox cells/tick", mergeMs / n, mergeMs / std::max(ms[1], 0.001) * 100.0, deferred / n).c_str());
+    if (sandAfter[0] != sand0 || sandAfter[1] != sand0) {
+        METADOT_ERROR(std::format("[bench] tick_exchange sand count changed: {0} -> 4-pass {1} exchange {2}", sand0, sandAfter[0], sandAfter[1]).c_str());
+    } else {
+        METADOT_INFO(std::format("[bench] tick_exchange sand count preserved ({0})", sand0).c_str());
+    }
+}
+
+#pragma endregion TickExchange
+
+#pragma region FluidDrain
+
+void fluid_drain(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] fluid_drain needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 300;
+
+    // 最多 512x512 的水池 底板中间开 32 格排水口 下面是空的盆地
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    TickBudget savedBudget = w->tickBudget;
+    TickLod savedLod = w->tickLod;
+    bool savedFluid = w->fluidPass;
+    int zx = std::max((int)w->tickZone.x, 1), zy = std::max((int)w->tickZone.y, 1);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    int bw = std::min(512, zx1 - zx - 8), bh = std::min(512, (zy1 - zy) * 2 / 3);
+    int bx = zx + (zx1 - zx - bw) / 2, by = zy + 2;
+    int floorY = by + bh;
+    mat_id solid = GAME()->materials_list.GENERIC_SOLID.id, water = GAME()->materials_list.WATER.id, air = GAME()->materials_list.GENERIC_AIR.id;
+    for (int y = zy; y < zy1; y++) {
+        for (int x = zx; x < zx1; x++) {
+            mat_id id = air;
+            if (y >= zy1 - 2 || x < zx + 2 || x >= zx1 - 2) id = solid;
+            else if ((x == bx - 1 || x == bx + bw) && y < floorY + 2) id = solid;
+            else if (y >= floorY && y < floorY + 2 && x >= bx - 1 && x <= bx + bw && std::abs(x - (bx + bw / 2)) >= 16) id = solid;
+            else if (x >= bx && x < bx + bw && y >= by && y < floorY) id = water;
+            w->real_tiles[x + y * w->width] = TilesCreate(id, x, y);
+        }
+    }
+    std::vector<MaterialInstance> start = w->real_tiles;
+
+    // 返回 {总液量 (含粒子), 排水口以上的液量}
+    auto mass = [&]() {
+        f64 total = 0, above = 0;
+        for (int y = zy; y < zy1; y++) {
+            for (int x = zx; x < zx1; x++) {
+                const MaterialInstance &t = w->real_tiles[x + y * w->width];
+                if (t.mat->physicsType != PhysicsType::SOUP) continue;
+                total += t.fluidAmount;
+                if (y < floorY) above += t.fluidAmount;
+            }
+        }
+        for (u32 i = 0; i < w->cells.capacity(); i++) {
+            if (w->cells.alive[i] && w->cells.tile[i].mat->physicsType == PhysicsType::SOUP) total += w->cells.tile[i].fluidAmount;
+        }
+        return std::make_pair(total, above);
+    };
+    auto [mass0, above0] = mass();
+
+    // 0: 格子扫描逐格处理液体 1: tickFluids
+    f64 ms[2] = {}, fluidMs = 0, endMass[2] = {}, endAbove[2] = {};
+    int active = 0, resting = 0, settleTick = -1;
+    for (int mode = 0; mode < 2; mode++) {
+        w->real_tiles = start;
+        w->rebuildChunkStats();
+        w->cells.clear();
+        w->tickBudget = TickBudget{};
+        w->tickLod = TickLod{};
+        w->fluidPass = mode == 1;
+        w->fluidPlanes = FluidPlanes{};
+        std::fill(w->dirty, w->dirty + w->width * w->height, false);
+        srand(n);
+        for (int f = 0; f < n; f++) {
+            Timer timer;
+            timer.start();
+            w->tick();
+            w->tickCells();
+            timer.stop();
+            ms[mode] += timer.get();
+            std::fill(w->dirty, w->dirty + w->width * w->height, false);
+            if (mode == 1) {
+                fluidMs += w->fluidPlanes.ms;
+                active += w->fluidPlanes.active;
+                resting = w->fluidPlanes.resting;
+                if (settleTick < 0 && w->fluidPlanes.active == 0) settleTick = f;
+            }
+        }
+        std::tie(endMass[mode], endAbove[mode]) = mass();
+    }
+
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->tickBudget = savedBudget;
+    w->tickLod = savedLod;
+    w->fluidPass = savedFluid;
+    w->fluidPlanes = FluidPlanes{};
+
+    METADOT_INFO(std::format("[bench] fluid_drain {0}x{1} water {2} ticks cell scan {3:.3f} ms/tick fluid pass {4:.3f} ms/tick ({5:.2f}x, solver {6:.3f} ms/tick)", bw, bh, n, ms[0] / n, ms[1] / n,
+                             ms[0] / std::max(ms[1], 0.001), fluidMs / n)
+                         .c_str());
+    for (int mode = 0; mode < 2; mode++) {
+        METADOT_INFO(std::format("[bench] fluid_drain {0}: mass {1:.1f} -> {2:.1f}, above drain {3:.1f} -> {4:.1f} ({5:.1f}% drained)", mode == 0 ? "cell scan" : "fluid pass", mass0, endMass[mode], above0,
+                                 endAbove[mode], (1.0 - endAbove[mode] / std::max(above0, 1e-6)) * 100.0)
+                             .c_str());
+    }
+    METADOT_INFO(std::format("[bench] fluid_drain fluid pass {0:.1f} active blocks/tick, {1} resting at end, all settled at tick {2}", (f64)active / n, resting, settleTick).c_str());
+}
+
+#pragma endregion FluidDrain
+
+#pragma region ChunkStats
+
+void chunk_stats(int n) {
+    world *w = global.game->Iso.world.get();
+    if (w == nullptr) {
+        METADOT_ERROR("[bench] chunk_stats needs a loaded world");
+        return;
+    }
+    if (n <= 0) n = 20000;
+
+    // tickZone 内随机改动: setTile / 直接写入并标记 dirty / 只改温度 每轮之后跑几帧 tick + tickTemperature
+    std::vector<MaterialInstance> saved = w->real_tiles;
+    CellPool savedCells = w->cells;
+    TickBudget savedBudget = w->tickBudget;
+    TickLod savedLod = w->tickLod;
+    int savedTempCt = w->temperatureCt;
+    int zx = std::max((int)w->tickZone.x, 1), zy = std::max((int)w->tickZone.y, 1);
+    int zx1 = std::min((int)(w->tickZone.x + w->tickZone.w), w->width - 1), zy1 = std::min((int)(w->tickZone.y + w->tickZone.h), w->height - 1);
+    const mat_id ids[] = {GAME()->materials_list.GENERIC_AIR.id, GAME()->materials_list.GENERIC_SOLID.id, GAME()->materials_list.GENERIC_SAND.id, GAME()->materials_list.WATER.id,
+                          GAME()->materials_list.LAVA.id,        GAME()->materials_list.STEAM.id,         GAME()->materials_list.FIRE.id};
+    w->cells.clear();
+    w->tickBudget = TickBudget{};
+    w->tickLod = TickLod{};
+    w->rebuildChunkStats();
+    std::fill(w->dirty, w->dirty + w->width * w->height, false);
+
+    // 逐块全量重新统计 与缓存比较 返回不一致的块数
+    const ChunkStatsGrid &g = w->chunkStats;
+    f64 recountMs = 0, queryMs = 0;
+    auto verify = [&]() {
+        int bad = 0;
+        Timer timer;
+        timer.start();
+        std::vector<ChunkStats> ref(g.blocks.size());
+        for (int by = 0; by < g.rows; by++) {
+            for (int bx = 0; bx < g.cols; bx++) {
+                ChunkStats &r = ref[bx + by * g.cols];
+                r.hist.assign(GAME()->materials_count, 0);
+                r.minTemp = std::numeric_limits<mat_temperature>::max();
+                r.maxTemp = std::numeric_limits<mat_temperature>::min();
+                for (int y = by * CHUNK_H; y < std::min((by + 1) * CHUNK_H, (int)w->height); y++) {
+                    for (int x = bx * CHUNK_W; x < std::min((bx + 1) * CHUNK_W, (int)w->width); x++) {
+                        const MaterialInstance &t = w->real_tiles[x + y * w->width];
+                        if (t.mat->id >= r.hist.size()) r.hist.resize(t.mat->id + 1, 0);
+                        r.hist[t.mat->id]++;
+                        u8 f = g.flagsOf(t.mat);
+                        r.active += (f & ChunkStatsGrid::ACTIVE) ? 1 : 0;
+                        r.solid += (f & ChunkStatsGrid::SOLID) ? 1 : 0;
+                        r.heat += (f & ChunkStatsGrid::HEAT) ? 1 : 0;
+                        if (t.mat->physicsType == PhysicsType::SOUP) r.fluid += t.fluidAmount;
+                        r.minTemp = std::min(r.minTemp, t.temperature);
+                        r.maxTemp = std::max(r.maxTemp, t.temperature);
+                    }
+                }
+            }
+        }
+        timer.stop();
+        recountMs += timer.get();
+
+        timer.start();
+        u64 sink = 0;
+        for (int by = 0; by < g.rows; by++) {
+            for (int bx = 0; bx < g.cols; bx++) {
+                const ChunkStats &c = w->chunkStatsBlock(bx, by);
+                sink += c.active + c.solid + c.heat + (u64)c.fluid + (u16)c.minTemp + (u16)c.maxTemp;
+                for (u32 h : c.hist) sink += h;
+            }
+        }
+        timer.stop();
+        queryMs += timer.get();
+        if (sink == 0) METADOT_INFO("[bench] chunk_stats empty world");
+
+        for (size_t i = 0; i < ref.size(); i++) {
+            const ChunkStats &r = ref[i];
+            const ChunkStats &c = g.blocks[i];
+            bool histOk = true;
+            for (size_t m = 0; m < std::max(r.hist.size(), c.hist.size()); m++) {
+                if ((m < r.hist.size() ? r.hist[m] : 0) != (m < c.hist.size() ? c.hist[m] : 0)) histOk = false;
+            }
+            if (!histOk || r.active != c.active || r.solid != c.solid || r.heat != c.heat || std::abs(r.fluid - c.fluid) > 1e-3 * std::max(1.0, std::abs(r.fluid)) ||
+                r.minTemp != c.minTemp || r.maxTemp != c.maxTemp)
+                bad++;
+        }
+        return bad;
+    };
+
+    int rounds = 8, frames = 4;
+    int mismatch = verify();
+    int idle = 0;
+    srand(n);
+    for (int round = 0; round < rounds; round++) {
+        for (int k = 0; k < n / rounds; k++) {
+            int x = zx + rand() % std::max(zx1 - zx, 1), y = zy + rand() % std::max(zy1 - zy, 1);
+            MaterialInstance t = TilesCreate(ids[rand() % std::size(ids)], x, y);
+            t.temperature = (mat_temperature)(rand() % 400 - 200);
+            if (t.mat->physicsType == PhysicsType::SOUP) t.fluidAmount = (rand() % 100) / 50.0f;
+            switch (rand() % 3) {
+                case 0:
+                    w->setTile(x, y, t);
+                    break;
+                case 1:
+                    w->real_tiles[x + y * w->width] = t;
+                    w->dirty[x + y * w->width] = true;
+                    break;
+                default:
+                    w->real_tiles[x + y * w->width].temperature = t.temperature;
+                    w->dirty[x + y * w->width] = true;
+                    break;
+            }
+        }
+        for (int f = 0; f < frames; f++) {
+            w->tick();
+            w->tickTemperature();
+            w->tickCells();
+            // 与游戏一样按 dirty 同步后清除
+            w->syncChunkStatsDirty(0, 0, w->width, w->height);
+            std::fill(w->dirty, w->dirty + w->width * w->height, false);
+            idle += w->tickBudget.idle;
+        }
+        mismatch += verify();
+    }
+    int blocks = g.cols * g.rows;
+
+    w->real_tiles = saved;
+    std::fill(w->dirty, w->dirty + w->width * w->height, true);
+    w->cells = savedCells;
+    w->tickBudget = savedBudget;
+    w->tickLod = savedLod;
+    w->temperatureCt = savedTempCt;
+    w->rebuildChunkStats();
+
+    int checks = rounds + 1;
+    METADOT_INFO(std::format("[bench] chunk_stats {0} edits {1} ticks over {2} blocks: recount {3:.3f} ms query {4:.4f} ms per check ({5:.0f}x) {6:.1f} idle tick blocks/frame", n / rounds * rounds,
+                             rounds * frames, blocks, recountMs / checks, queryMs / checks, recountMs / std::max(queryMs, 0.0001), (f64)idle / (rounds * frames))
+                         .c_str());
+    if (mismatch > 0) {
+        METADOT_ERROR(std::format("[bench] chunk_stats {0} block aggregates differ from a full recount", mismatch).c_str());
+    } else {
+        METADOT_INFO(std::format("[bench] chunk_stats all block aggregates match a full recount after {0} checks", checks).c_str());
+    }
+}
+
+#pragma endregion ChunkStats
+
+void register_commands(cvar::ConVar &convar) {
+    convar.Command("bench_structure_stamp", [](int n) { structure_stamp(n); });
+    convar.Command("bench_worldgen", [](int n) { worldgen(n); });
+    convar.Command("bench_pristine_regen", [](int n) { pristine_regen(n); });
+    convar.Command("bench_cavebg", [](int n) { cavebg(n); });
+    convar.Command("bench_physics_check", [](int n) { physics_check(n); });
+    convar.Command("bench_chunk_mesh", [](int n) { chunk_mesh(n); });
+    convar.Command("bench_chunk_mesh_parallel", [](int n) { chunk_mesh_parallel(n); });
+    convar.Command("bench_chunk_mesh_bits", [](int n) { chunk_mesh_bits(n); });
+    convar.Command("bench_chunk_mesh_rects", [](int n) { chunk_mesh_rects(n); });
+    convar.Command("bench_box2d_islands", [](int n) { box2d_islands(n); });
+    convar.Command("bench_rigidbody_dig", [](int n) { rigidbody_dig(n); });
+    convar.Command("bench_rigidbody_index", [](int n) { rigidbody_index(n); });
+    convar.Command("bench_explosions", [](int n) { explosions(n); });
+    convar.Command("bench_rigidbody_dormant", [](int n) { rigidbody_dormant(n); });
+    convar.Command("bench_particles", [](int n) { particles(n); });
+    convar.Command("bench_particles_parallel", [](int n) { particles_parallel(n); });
+    convar.Command("bench_material_interactions", [](int n) { material_interactions(n); });
+    convar.Command("bench_entity_collision", [](int n) { entity_collision(n); });
+    convar.Command("bench_rays", [](int n) { rays(n); });
+    convar.Command("bench_tick_budget", [](int n) { tick_budget(n); });
+    convar.Command("bench_sim_lod", [](int n) { sim_lod(n); });
+    convar.Command("bench_tick_exchange", [](int n) { tick_exchange(n); });
+    convar.Command("bench_fluid_drain", [](int n) { fluid_drain(n); });
+    convar.Command("bench_chunk_stats", [](int n) { chunk_stats(n); });
+}
+
+}  // namespace bench
+
+}  // namespace ME
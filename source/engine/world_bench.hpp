@@ -0,0 +1,109 @@
+// Copyright(c) 2022-2023, KaoruXun All rights reserved.
+
+#ifndef ME_WORLD_BENCH_HPP
+#define ME_WORLD_BENCH_HPP
+
+#include "cvar.hpp"
+
+namespace ME {
+
+// 世界模拟相关的基准测试 通过控制台命令 bench_* 调用
+// 结果通过 METADOT_INFO 输出
+namespace bench {
+
+// 在 3x3 区块区域内随机放置 n 棵树 对比逐格写入与行段写入
+void structure_stamp(int n);
+
+// 用当前世界分别以 DefaultGenerator 与 ScriptingWorldGenerator 生成 n 个区块 对比每秒区块数
+void worldgen(int n);
+
+// 对比未修改区块重新生成(含0阶段填充)与读盘的耗时
+void pristine_regen(int n);
+
+// 对比洞穴背景逐像素采样与预平铺行段拷贝 并逐格校验两者输出一致
+void cavebg(int n);
+
+// 对比 physicsCheck 原先整图分配+递归填充与扫描线标记的每秒调用次数 并校验连通块大小一致
+void physics_check(int n);
+
+// 模拟挖掘 n 帧 对比地形碰撞网格全量重建与按实心掩码哈希缓存的每帧耗时
+void chunk_mesh(int n);
+
+// 在 meshZone 内铺满粗糙地形 对比区块网格几何阶段串行与线程池并行的全量重建耗时
+void chunk_mesh_parallel(int n);
+
+// 在 n 个随机实心位图上校验按字起点搜索与逐格搜索生成的多边形一致 并对比耗时
+// 同时检查当前世界的增量实心位图与 real_tiles 是否一致
+void chunk_mesh_bits(int n);
+
+// 在 n 个随机实心位图上对比轮廓追踪+三角化与实心位图矩形合并的耗时与形状数
+// 并以像素中心点测试校验矩形覆盖与位图逐格一致
+void chunk_mesh_rects(int n);
+
+// 无窗口的 box2d 压力测试: n 个方块分列下落 对比串行与并行岛屿求解的每步耗时 并逐个比较刚体变换
+void box2d_islands(int n);
+
+// 一个圆盘刚体每帧从顶部被挖掉 4x2 像素 对比全量重写/重建与按脏行同步的 hitbox 更新耗时
+// 并校验 surface 与实心位图一致
+void rigidbody_dig(int n);
+
+// n 个刚体 (n <= 0 时分别测 1000 与 5000) 每帧悬停查询 + 32 次删除/加入
+// 对比原先复制列表+线性扫描与句柄列表+宽相位查询的每帧耗时
+void rigidbody_index(int n);
+
+// 同一 tick 内 n 个爆炸 (默认 200) 对比逐个破坏+碎块检测+网格更新与排队后统一处理的耗时
+// 并校验逐个与按区块并行的地形破坏结果一致
+void explosions(int n);
+
+// n 个 (默认 4000) 停在 tickZone 外的刚体与 64 个跨越 tickZone 边缘的刚体
+// 对比逐帧 SetEnabled / 滞后带 / 滞后带+冻结到区块的每帧边界判断与物理步进耗时 并校验冻结/解冻往返
+void rigidbody_dormant(int n);
+
+// n 个 (默认 100000) 存活的临时粒子 每帧补充死亡的粒子
+// 对比原先逐个堆分配+std::function 与字段数组粒子池串行/按区块并行的每帧耗时 并校验串行与并行结果一致
+void particles(int n);
+
+// n 个粒子 (默认 100000 其中一成会落地 部分落在同一格子) 分别用 1/2/4/8/16 线程的 tickPool 运行 30 帧
+// 输出每帧耗时 并校验各线程数的粒子 空闲链表与地形和单线程完全一致
+void particles_parallel(int n);
+
+// 临时打开随机材料的相互作用 在 tickZone 内铺满反应材料/水/熔岩 运行 n 次 (默认 30) world::tick
+// 对比沿材料指针查找与扁平查找表的每次耗时 并校验查找表与各材料的相互作用数组一致
+void material_interactions(int n);
+
+// n 个 (默认 1000) NPC 实体在起伏的沙地上来回走动 120 帧 对比逐格读 real_tiles 与碰撞位图按行 popcount 的每帧耗时
+// 并校验两者的实体状态 地形与推开的粒子数一致
+void entity_collision(int n);
+
+// 从 64 个中心发出 n 条 (默认 100000) 射线 对比 std::function 版 forLine 模板版 批量 forRays 与只测碰撞位图的 traceRays 每秒射线数
+// 并校验各路径停下的格子一致 另对比 forLineCornered 去重前后的耗时
+void rays(int n);
+
+// tickZone 上半部分灌满水和熔岩 运行 n 次 (默认 60) world::tick
+// 对比不限预算与预算为其平均耗时一半时的每帧耗时 并输出每帧更新/推迟/减少迭代的块数与最长推迟帧数
+void tick_budget(int n);
+
+// tickZone 内铺沙丘/水池/熔岩 焦点在中心 近环 1 块 中环 2 块 运行 n 次 (默认 120) world::tick + tickTemperature
+// 对比关闭与开启细节层次的每秒 tick 数 并输出每帧更新/错开/休眠的块数
+void sim_lod(int n);
+
+// tickZone 上部灌满水/熔岩 下面一层沙子 运行 n 次 (默认 60) world::tick
+// 对比 4 相棋盘与内部一次并行扫描 + 边带 outbox 合并的每帧耗时 输出合并阶段占比与 outbox 格子数 并校验沙子数量不变
+void tick_exchange(int n);
+
+// 最多 512x512 的水池从底部排水口流进下面的盆地 运行 n 帧 (默认 300) world::tick + tickCells
+// 对比格子扫描逐格处理液体与 tickFluids 的每帧耗时 输出总液量 排出比例与静止的块
+void fluid_drain(int n);
+
+// tickZone 内 n 次 (默认 20000) 随机改动 (setTile / 直接写入并标记 dirty / 只改温度) 分 8 轮 每轮之后运行 4 帧 tick + tickTemperature + tickCells
+// 逐块全量重新统计 校验统计缓存的直方图 液量 活动格子与温度范围 并对比查询与重新统计的耗时
+void chunk_stats(int n);
+
+// 注册所有 bench_* 控制台命令
+void register_commands(cvar::ConVar &convar);
+
+}  // namespace bench
+
+}  // namespace ME
+
+#endif
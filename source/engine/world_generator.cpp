@@ -2,7 +2,13 @@
 
 #include "world_generator.h"
 
+#include <cstring>
+
 #include "engine/core/global.hpp"
+#include "engine/core/io/filesystem.h"
+#include "engine/scripting/ffi/ffi.h"
+#include "engine/scripting/lua_wrapper.hpp"
+#include "engine/scripting/scripting.hpp"
 #include "engine/utils/random.hpp"
 #include "game.hpp"
 #include "game_datastruct.hpp"
@@ -62,6 +68,25 @@ std::vector<Populator *> MaterialTestGenerator::getPopulators() { return {}; }
 
 #pragma region DefaultGenerator
 
+void CaveBGFillRows(u32 *background, const u8 *mask, int cx, int cy) {
+    const TiledTexture &bg = global.game->Iso.texturepack.caveBGTiled;
+    for (int y = 0; y < CHUNK_H; y++) {
+        u32 *dst = background + y * CHUNK_W;
+        const u8 *m = mask + y * CHUNK_W;
+
+        bool any = false;
+        for (int x = 0; x < CHUNK_W; x++) any |= m[x] != 0;
+        if (!any) {
+            std::fill(dst, dst + CHUNK_W, 0x00000000);
+            continue;
+        }
+
+        // 与原先逐像素采样一致 py 使用 CHUNK_W 换算
+        std::memcpy(dst, bg.span(cx * CHUNK_W, y + cy * CHUNK_W), CHUNK_W * sizeof(u32));
+        for (int x = 0; x < CHUNK_W; x++) dst[x] = m[x] ? dst[x] : 0x00000000;
+    }
+}
+
 int DefaultGenerator::getBaseHeight(world *world, int x, Chunk *ch) {
 
     if (nullptr == ch) {
@@ -133,13 +158,15 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
 
 #if 1
 
+    // 洞穴背景先只记录掩码 生成结束后按行从预平铺贴图拷贝
+    u8 bgMask[CHUNK_W * CHUNK_H] = {};
+
     for (int x = 0; x < CHUNK_W; x++) {
         int px = x + ch->x * CHUNK_W;
 
         int surf = getHeight(world, px, ch);
 
         for (int y = 0; y < CHUNK_H; y++) {
-            background[x + y * CHUNK_W] = 0x00000000;
             int py = y + ch->y * CHUNK_W;
             int b = world->getBiomeAt(px, py);
 
@@ -168,10 +195,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
 
             if (b == Biome::biomeGetID("DEFAULT")) {
                 if (py > surf) {
-                    int tx = (global.game->Iso.texturepack.caveBG->surface()->w + (px % global.game->Iso.texturepack.caveBG->surface()->w)) % global.game->Iso.texturepack.caveBG->surface()->w;
-                    int ty = (global.game->Iso.texturepack.caveBG->surface()->h + (py % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    background[x + y * CHUNK_W] = ME_get_pixel(global.game->Iso.texturepack.caveBG->surface(), tx % global.game->Iso.texturepack.caveBG->surface()->w,
-                                                               ty % global.game->Iso.texturepack.caveBG->surface()->h);
+                    bgMask[x + y * CHUNK_W] = 1;
                     f64 thru = std::fmin(std::fmax(0, abs(surf - py) / 150.0), 1);
 
                     f64 n = (world->noise.GetPerlin(px * 4.0, py * 4.0, 2960) / 2.0 + 0.5) - 0.1;
@@ -181,7 +205,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                     f64 n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                     prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? TilesCreateSmoothDirt(px, py) : TilesCreateSoftDirt(px, py);
                 } else if (py > surf - 65) {
-                    if (rand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
+                    if (TilesRand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
                 } else {
                     prop[x + y * CHUNK_W] = Tiles_NOTHING;
                 }
@@ -189,12 +213,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                 layer2[x + y * CHUNK_W] = Tiles_NOTHING;
             } else if (b == Biome::biomeGetID("PLAINS")) {
                 if (py > surf) {
-                    int tx = (global.game->Iso.texturepack.caveBG->surface()->w + (px % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    int ty = (global.game->Iso.texturepack.caveBG->surface()->h + (py % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    u8 *pixel = (u8 *)global.game->Iso.texturepack.caveBG->surface()->pixels;
-                    pixel += ((ty % global.game->Iso.texturepack.caveBG->surface()->h) * global.game->Iso.texturepack.caveBG->surface()->pitch) +
-                             ((tx % global.game->Iso.texturepack.caveBG->surface()->w) * sizeof(u32));
-                    background[x + y * CHUNK_W] = *((u32 *)pixel);
+                    bgMask[x + y * CHUNK_W] = 1;
                     f64 thru = std::fmin(std::fmax(0, abs(surf - py) / 150.0), 1);
 
                     f64 n = (world->noise.GetPerlin(px * 4.0, py * 4.0, 2960) / 2.0 + 0.5) - 0.1;
@@ -204,7 +223,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                     f64 n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                     prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? TilesCreateSmoothDirt(px, py) : MaterialInstance(&GAME()->materials_list.GENERIC_SOLID, 0xff0000);
                 } else if (py > surf - 65) {
-                    if (rand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
+                    if (TilesRand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
                 } else {
                     prop[x + y * CHUNK_W] = Tiles_NOTHING;
                 }
@@ -212,12 +231,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                 layer2[x + y * CHUNK_W] = Tiles_NOTHING;
             } else if (b == Biome::biomeGetID("MOUNTAINS")) {
                 if (py > surf) {
-                    int tx = (global.game->Iso.texturepack.caveBG->surface()->w + (px % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    int ty = (global.game->Iso.texturepack.caveBG->surface()->h + (py % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    u8 *pixel = (u8 *)global.game->Iso.texturepack.caveBG->surface()->pixels;
-                    pixel += ((ty % global.game->Iso.texturepack.caveBG->surface()->h) * global.game->Iso.texturepack.caveBG->surface()->pitch) +
-                             ((tx % global.game->Iso.texturepack.caveBG->surface()->w) * sizeof(u32));
-                    background[x + y * CHUNK_W] = *((u32 *)pixel);
+                    bgMask[x + y * CHUNK_W] = 1;
                     f64 thru = std::fmin(std::fmax(0, abs(surf - py) / 150.0), 1);
 
                     f64 n = (world->noise.GetPerlin(px * 4.0, py * 4.0, 2960) / 2.0 + 0.5) - 0.1;
@@ -227,7 +241,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                     f64 n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                     prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? TilesCreateSmoothDirt(px, py) : MaterialInstance(&GAME()->materials_list.GENERIC_SOLID, 0x00ff00);
                 } else if (py > surf - 65) {
-                    if (rand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
+                    if (TilesRand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
                 } else {
                     prop[x + y * CHUNK_W] = Tiles_NOTHING;
                 }
@@ -235,12 +249,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                 layer2[x + y * CHUNK_W] = Tiles_NOTHING;
             } else if (b == Biome::biomeGetID("FOREST")) {
                 if (py > surf) {
-                    int tx = (global.game->Iso.texturepack.caveBG->surface()->w + (px % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    int ty = (global.game->Iso.texturepack.caveBG->surface()->h + (py % global.game->Iso.texturepack.caveBG->surface()->h)) % global.game->Iso.texturepack.caveBG->surface()->h;
-                    u8 *pixel = (u8 *)global.game->Iso.texturepack.caveBG->surface()->pixels;
-                    pixel += ((ty % global.game->Iso.texturepack.caveBG->surface()->h) * global.game->Iso.texturepack.caveBG->surface()->pitch) +
-                             ((tx % global.game->Iso.texturepack.caveBG->surface()->w) * sizeof(u32));
-                    background[x + y * CHUNK_W] = *((u32 *)pixel);
+                    bgMask[x + y * CHUNK_W] = 1;
                     f64 thru = std::fmin(std::fmax(0, abs(surf - py) / 150.0), 1);
 
                     f64 n = (world->noise.GetPerlin(px * 4.0, py * 4.0, 2960) / 2.0 + 0.5) - 0.1;
@@ -250,7 +259,7 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
                     f64 n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                     prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? TilesCreateSmoothDirt(px, py) : MaterialInstance(&GAME()->materials_list.GENERIC_SOLID, 0x0000ff);
                 } else if (py > surf - 65) {
-                    if (rand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
+                    if (TilesRand() % 2 == 0) prop[x + y * CHUNK_W] = TilesCreateGrass();
                 } else {
                     prop[x + y * CHUNK_W] = Tiles_NOTHING;
                 }
@@ -262,6 +271,8 @@ void DefaultGenerator::generateChunk(world *world, Chunk *ch) {
             // layer2[x + y * CHUNK_W] = Tiles_NOTHING;
         }
     }
+
+    CaveBGFillRows(background, bgMask, ch->x, ch->y);
 #else
 
     for (int x = 0; x < CHUNK_W; x++) {
@@ -315,9 +326,131 @@ std::vector<Populator *> DefaultGenerator::getPopulators() {
 
 #pragma endregion
 
-void ScriptingWorldGenerator::generateChunk(world *world, Chunk *ch) {}
+#pragma region ScriptingWorldGenerator
+
+ScriptingGenBufferPool::~ScriptingGenBufferPool() {
+    for (auto buf : pool) delete buf;
+    pool.clear();
+}
+
+ScriptingGenBuffers *ScriptingGenBufferPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!pool.empty()) {
+            ScriptingGenBuffers *buf = pool.back();
+            pool.pop_back();
+            return buf;
+        }
+    }
+    return new ScriptingGenBuffers;
+}
+
+void ScriptingGenBufferPool::release(ScriptingGenBuffers *buf) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pool.push_back(buf);
+}
+
+// 根据 index_name 查询材料ID 找不到返回 -1
+static int scriptgen_material_id(lua_State *L) {
+    const char *name = luaL_checkstring(L, 1);
+    for (Material *mat : GAME()->materials_container) {
+        if (mat->index_name == name) {
+            lua_pushinteger(L, mat->id);
+            return 1;
+        }
+    }
+    lua_pushinteger(L, -1);
+    return 1;
+}
+
+ScriptingWorldGenerator::ScriptingWorldGenerator(std::string script) {
+    if (ME_str_starts_with(script, "LUA::")) ME_str_replace_with(script, "LUA::", "data/scripts/");
+
+    L = luaL_newstate();
+    luaL_openlibs(L);
+    ME_preload_auto(L, ffi_module_open, "ffi");
+    lua_register(L, "materials_get_id", scriptgen_material_id);
+
+    if (luaL_loadfile(L, METADOT_RESLOC(script.c_str())) != LUA_OK || ME_debug_pcall(L, 0, 1, 0) != LUA_OK) {
+        print_error(L);
+        return;
+    }
+
+    if (!lua_isfunction(L, -1)) {
+        METADOT_ERROR(std::format("ScriptingWorldGenerator: {0} did not return a generator function", script).c_str());
+        lua_pop(L, 1);
+        return;
+    }
+
+    genFuncRef = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+ScriptingWorldGenerator::~ScriptingWorldGenerator() {
+    if (L) lua_close(L);
+}
+
+void ScriptingWorldGenerator::generateChunk(world *world, Chunk *ch) {
+    MaterialInstance *prop = new MaterialInstance[CHUNK_W * CHUNK_H];
+    MaterialInstance *layer2 = new MaterialInstance[CHUNK_W * CHUNK_H];
+    u32 *background = new u32[CHUNK_W * CHUNK_H];
+
+    std::fill(layer2, layer2 + CHUNK_W * CHUNK_H, Tiles_NOTHING);
+    std::fill(background, background + CHUNK_W * CHUNK_H, 0x00000000);
+
+    ScriptingGenBuffers *buf = bufferPool.acquire();
+
+    // 噪声场与高度在原生代码中整块采样 可以在多个生成线程中并行
+    for (int x = 0; x < CHUNK_W; x++) {
+        int px = x + ch->x * CHUNK_W;
+        buf->height[x] = heightGen.getHeight(world, px, ch);
+        for (int y = 0; y < CHUNK_H; y++) {
+            int py = y + ch->y * CHUNK_H;
+            buf->noise[x + y * CHUNK_W] = world->noise.GetPerlin(px * 4.0, py * 4.0, 2960);
+        }
+    }
+
+    bool ok = false;
+    if (genFuncRef != -1) {
+        // 同一个 lua_State 只能被一个线程使用
+        std::lock_guard<std::mutex> lock(luaMutex);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, genFuncRef);
+        lua_pushinteger(L, ch->x);
+        lua_pushinteger(L, ch->y);
+        lua_pushinteger(L, CHUNK_W);
+        lua_pushinteger(L, CHUNK_H);
+        lua_pushlightuserdata(L, buf->noise);
+        lua_pushlightuserdata(L, buf->height);
+        lua_pushlightuserdata(L, buf->material);
+        if (ME_debug_pcall(L, 7, 0, 0) == LUA_OK) {
+            ok = true;
+        } else {
+            print_error(L);
+        }
+    }
+
+    if (ok) {
+        for (int y = 0; y < CHUNK_H; y++) {
+            int py = y + ch->y * CHUNK_H;
+            for (int x = 0; x < CHUNK_W; x++) {
+                int px = x + ch->x * CHUNK_W;
+                i32 id = buf->material[x + y * CHUNK_W];
+                prop[x + y * CHUNK_W] = (id < 0 || id >= GAME()->materials_count) ? Tiles_NOTHING : TilesCreate(id, px, py);
+            }
+        }
+    } else {
+        std::fill(prop, prop + CHUNK_W * CHUNK_H, Tiles_NOTHING);
+    }
+
+    bufferPool.release(buf);
+
+    ch->tiles = prop;
+    ch->layer2 = layer2;
+    ch->background = background;
+}
+
+std::vector<Populator *> ScriptingWorldGenerator::getPopulators() { return {new CavePopulator(), new OrePopulator(), new CobblePopulator()}; }
 
-std::vector<Populator *> ScriptingWorldGenerator::getPopulators() { return {}; }
+#pragma endregion ScriptingWorldGenerator
 
 double wang_seed = 0;
 static CLGMRandom random(wang_seed);
@@ -3,30 +3,75 @@
 #ifndef ME_GENERATOR_WORLD_H
 #define ME_GENERATOR_WORLD_H
 
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include "engine/core/global.hpp"
 #include "game.hpp"
 #include "game_datastruct.hpp"
 
+struct lua_State;
+
 namespace ME {
 
-class ScriptingWorldGenerator : public WorldGenerator {
+// 用预平铺的洞穴背景(TexturePack::caveBGTiled)按行填充区块 (cx, cy) 的背景
+// mask 为 0 的格子置为透明
+void CaveBGFillRows(u32 *background, const u8 *mask, int cx, int cy);
+
+class DefaultGenerator : public WorldGenerator {
+public:
+    int getBaseHeight(world *world, int x, Chunk *ch);
+    int getHeight(world *world, int x, Chunk *ch);
 
     void generateChunk(world *world, Chunk *ch) override;
+
     std::vector<Populator *> getPopulators() override;
 };
 
-class MaterialTestGenerator : public WorldGenerator {
-    void generateChunk(world *world, Chunk *ch) override;
-    std::vector<Populator *> getPopulators() override;
+// 脚本世界生成器的整块缓冲区 以指针形式交给 Lua 侧通过 ffi.cast 访问
+// 这样 Lua 每个区块只需要一次调用 而不是每个像素一次
+struct ScriptingGenBuffers {
+    f32 noise[CHUNK_W * CHUNK_H];     // 预采样的噪声场 [-1, 1]
+    i32 height[CHUNK_W];              // 每列地表高度 (世界坐标)
+    i32 material[CHUNK_W * CHUNK_H];  // 输出的材料ID -1 为空气
 };
 
-class DefaultGenerator : public WorldGenerator {
+// 缓冲区池 区块生成在异步线程中进行 用完归还复用
+class ScriptingGenBufferPool {
+public:
+    ~ScriptingGenBufferPool();
 
-    int getBaseHeight(world *world, int x, Chunk *ch);
-    int getHeight(world *world, int x, Chunk *ch);
+    ScriptingGenBuffers *acquire();
+    void release(ScriptingGenBuffers *buf);
+
+private:
+    std::mutex mutex;
+    std::vector<ScriptingGenBuffers *> pool;
+};
+
+class ScriptingWorldGenerator : public WorldGenerator {
+public:
+    // script 为 data/scripts 下的生成器脚本 需要返回生成函数
+    // function(cx, cy, w, h, noise, height, material)
+    explicit ScriptingWorldGenerator(std::string script = "LUA::worldgen/default.lua");
+    ~ScriptingWorldGenerator();
 
     void generateChunk(world *world, Chunk *ch) override;
+    std::vector<Populator *> getPopulators() override;
+
+private:
+    // 生成器使用独立的 lua_State 不与主线程脚本共享
+    lua_State *L = nullptr;
+    int genFuncRef = -1;
+    std::mutex luaMutex;
+
+    ScriptingGenBufferPool bufferPool;
+    DefaultGenerator heightGen;
+};
 
+class MaterialTestGenerator : public WorldGenerator {
+    void generateChunk(world *world, Chunk *ch) override;
     std::vector<Populator *> getPopulators() override;
 };
 
@@ -0,0 +1,236 @@
+// Copyright(c) 2022-2023, KaoruXun All rights reserved.
+
+#include "world_pregen.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "chunk.hpp"
+#include "engine/core/base_debug.hpp"
+#include "engine/core/const.h"
+#include "engine/core/global.hpp"
+#include "engine/core/macros.hpp"
+#include "engine/game_utils/rng.h"
+#include "engine/scripting/scripting.hpp"
+#include "engine/utils/module.hpp"
+#include "engine/utils/utility.hpp"
+#include "game.hpp"
+#include "game_basic.hpp"
+#include "game_datastruct.hpp"
+#include "textures.hpp"
+#include "world.hpp"
+#include "world_generator.h"
+
+namespace ME {
+
+namespace pregen {
+
+#pragma region Setup
+
+// 与 game::init 相同的脚本/材质/群系初始化 但不创建窗口与渲染器
+static void init_headless() {
+    global.game->RNG = RNG_Create();
+
+    ME::modules::initialize<scripting>();
+    the<scripting>().init();
+
+    // 只注册 materials_*/create_biome 等绑定
+    // 不调用 OnGameEngineLoad 其中会初始化图形/音频/字体
+    auto gp = create_ref<gameplay>(2);
+    gp->registerLua(the<scripting>().s_lua);
+
+    // 生成器只读取贴图的 surface
+    InitTexture(global.game->Iso.texturepack, false);
+
+    InitMaterials();
+    PushMaterials();
+
+    the<scripting>().fast_load_lua(METADOT_RESLOC("data/scripts/game.lua"));
+    the<scripting>().fast_call_func("OnGameLoad")(global.game);
+}
+
+#pragma endregion Setup
+
+#pragma region Progress
+
+struct Progress {
+    std::atomic<int> done = 0;
+    int total = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last = start;
+
+    void report(bool force) {
+        auto now = std::chrono::steady_clock::now();
+        if (!force && now - last < std::chrono::seconds(1)) return;
+        last = now;
+
+        int d = done.load();
+        f64 sec = std::chrono::duration<f64>(now - start).count();
+        f64 rate = sec > 0.0 ? d / sec : 0.0;
+        f64 eta = rate > 0.0 ? (total - d) / rate : 0.0;
+        METADOT_INFO(std::format("[pregen] {0}/{1} chunks ({2:.1f}%) {3:.1f} chunks/s ETA {4:.0f}s", d, total, total > 0 ? d * 100.0 / total : 100.0, rate, eta).c_str());
+    }
+};
+
+// 主线程等待一批任务 期间按秒输出进度
+static void wait_all(std::vector<std::future<void>> &futures, Progress &progress) {
+    for (auto &f : futures) {
+        while (f.wait_for(std::chrono::milliseconds(250)) != std::future_status::ready) progress.report(false);
+        f.get();
+    }
+    futures.clear();
+}
+
+#pragma endregion Progress
+
+int run(int argc, char *argv[]) {
+
+    if (argc < 7) {
+        printf("Usage: pregen <worldName> <cx0> <cy0> <cx1> <cy1> [threads]\n");
+        return METADOT_FAILED;
+    }
+
+    std::string name = argv[2];
+    int cx0 = std::min(atoi(argv[3]), atoi(argv[5]));
+    int cx1 = std::max(atoi(argv[3]), atoi(argv[5]));
+    int cy0 = std::min(atoi(argv[4]), atoi(argv[6]));
+    int cy1 = std::max(atoi(argv[4]), atoi(argv[6]));
+    int threads = argc > 7 ? atoi(argv[7]) : (int)std::thread::hardware_concurrency();
+    threads = std::max(threads, 1);
+
+    init_headless();
+
+    std::string path = METADOT_RESLOC(std::format("saves/{0}", name).c_str());
+
+    // 世界尺寸与 game_ui 中新建世界一致 生成器的地表高度依赖 world->height
+    u16 w = (int)ceil(WINDOWS_MAX_WIDTH / 3 / (f64)CHUNK_W) * CHUNK_W + CHUNK_W * 3;
+    u16 h = (int)ceil(WINDOWS_MAX_HEIGHT / 3 / (f64)CHUNK_H) * CHUNK_H + CHUNK_H * 3;
+
+    // 每个工作线程一个世界外壳 getBiomeAt 会修改噪声状态 不能跨线程共享
+    // 第一个外壳负责写入噪声种子 其余外壳从 world.json 读取同一种子
+    std::vector<scope<world>> shells(threads);
+    for (int i = 0; i < threads; i++) {
+        shells[i] = create_scope<world>();
+        shells[i]->initHeadless(path, w, h, new DefaultGenerator());
+    }
+
+    // 阶段 p 的填充需要周围 p 圈区块已完成阶段 p-1
+    // 因此在矩形外额外生成 margin 圈 外圈只推进到较低阶段 进入游戏后继续填充
+    int margin = std::min(shells[0]->highestPopulator, 5);
+
+    phmap::flat_hash_map<int, phmap::flat_hash_map<int, Chunk *>> chunks;
+    std::vector<Chunk *> all;
+    for (int cx = cx0 - margin; cx <= cx1 + margin; cx++) {
+        for (int cy = cy0 - margin; cy <= cy1 + margin; cy++) {
+            Chunk *ch = new Chunk;
+            ch->ChunkInit(cx, cy, path);
+            ch->generationPhase = -1;
+            chunks[cx][cy] = ch;
+            all.push_back(ch);
+        }
+    }
+
+    for (auto &s : shells) s->chunkCache = chunks;
+
+    METADOT_INFO(std::format("[pregen] {0} chunks ({1},{2})-({3},{4}) + {5} ring(s) @ {6} with {7} threads, seed {8}", (cx1 - cx0 + 1) * (cy1 - cy0 + 1), cx0, cy0, cx1, cy1, margin, path,
+                             threads, shells[0]->metadata.noiseSeed)
+                         .c_str());
+
+    thread_pool pool(threads);
+    Progress progress;
+    std::atomic<int> skipped = 0;
+
+    // 预生成的目的就是落盘 不走未修改区块跳过写盘的逻辑
+    auto persist = [](Chunk *ch) {
+        ch->pristine = false;
+        ch->ChunkWrite(ch->tiles, ch->layer2, ch->background);
+    };
+
+    // 每个阶段需要处理的区块数 用于进度与 ETA
+    progress.total = (int)all.size();
+    for (int p = 1; p <= margin; p++) progress.total += (cx1 - cx0 + 1 + 2 * (margin - p)) * (cy1 - cy0 + 1 + 2 * (margin - p));
+
+    std::vector<std::future<void>> futures;
+
+    // 0 阶段: 读盘或生成 各区块互不依赖 完全并行
+    for (Chunk *ch : all) {
+        futures.push_back(pool.push([&, ch](int id) {
+            world *wd = shells[id].get();
+            bool loaded = false;
+            if (ch->ChunkHasFile()) {
+                try {
+                    ch->ChunkRead();
+                    loaded = true;
+                } catch (...) {
+                    METADOT_BUG(std::format("[pregen] Failed to read chunk {0} {1} so regenerate it", ch->x, ch->y).c_str());
+                }
+            }
+            if (loaded) {
+                ch->hasTileCache = true;
+                skipped++;
+            } else {
+                wd->generateChunk(ch);
+                ch->generationPhase = 0;
+                ch->hasTileCache = true;
+                wd->populateChunk(ch, 0, false);
+                persist(ch);
+            }
+            progress.done++;
+        }));
+    }
+    wait_all(futures, progress);
+
+    // 1..margin 阶段: 填充会写入周围 p 圈区块
+    // 按 (2p+1) 步长分组 同组区块的影响范围互不重叠 可以并行
+    for (int p = 1; p <= margin; p++) {
+        int stride = 2 * p + 1;
+        int r = margin - p;
+        for (int ox = 0; ox < stride; ox++) {
+            for (int oy = 0; oy < stride; oy++) {
+                for (int cx = cx0 - r + ox; cx <= cx1 + r; cx += stride) {
+                    for (int cy = cy0 - r + oy; cy <= cy1 + r; cy += stride) {
+                        Chunk *ch = chunks[cx][cy];
+                        futures.push_back(pool.push([&, ch, p](int id) {
+                            if (ch->generationPhase < p) {
+                                shells[id]->populateChunk(ch, p, false);
+                                ch->generationPhase = p;
+                                persist(ch);
+                            } else {
+                                skipped++;
+                            }
+                            progress.done++;
+                        }));
+                    }
+                }
+                wait_all(futures, progress);
+            }
+        }
+    }
+
+    progress.report(true);
+    METADOT_INFO(std::format("[pregen] done, {0} chunk step(s) already on disk were skipped", skipped.load()).c_str());
+
+    pool.stop(true);
+
+    // 区块归本函数所有 外壳析构时不能再释放
+    for (auto &s : shells) s->chunkCache.clear();
+    shells.clear();
+
+    for (Chunk *ch : all) {
+        ch->ChunkDelete();
+        delete ch;
+    }
+
+    return METADOT_OK;
+}
+
+}  // namespace pregen
+
+}  // namespace ME
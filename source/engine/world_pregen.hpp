@@ -0,0 +1,21 @@
+// Copyright(c) 2022-2023, KaoruXun All rights reserved.
+
+#ifndef ME_WORLD_PREGEN_HPP
+#define ME_WORLD_PREGEN_HPP
+
+namespace ME {
+
+// 无窗口的世界预生成工具
+// 用法: pregen <worldName> <cx0> <cy0> <cx1> <cy1> [threads]
+// 在 saves/<worldName> 中生成/填充/存盘区块矩形 [cx0, cx1] x [cy0, cy1]
+// 已存盘且阶段足够的区块会被跳过 中断后重新执行即可继续
+namespace pregen {
+
+// 返回 METADOT_OK 或 METADOT_FAILED
+int run(int argc, char *argv[]);
+
+}  // namespace pregen
+
+}  // namespace ME
+
+#endif
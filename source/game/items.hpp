@@ -56,7 +56,7 @@ public:
     std::vector<U16Point> fill;
     u16 capacity = 0;
 
-    std::vector<CellData *> vacuumCells = {};
+    std::vector<CellHandle> vacuumCells = {};
 
     Item(const Item &p) = default;
 
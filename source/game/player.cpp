@@ -1,6 +1,9 @@
 
 #include "game/player.hpp"
 
+#include <algorithm>
+#include <bit>
+
 #include "engine/core/core.hpp"
 #include "engine/core/global.hpp"
 #include "engine/game.hpp"
@@ -69,6 +72,100 @@ void RigidBody::chunk_clean() {
     }
 }
 
+void RigidBody::buildMask() {
+    maskStride = (matWidth + 63) / 64;
+    mask.assign((size_t)maskStride * matHeight, 0);
+    for (int y = 0; y < matHeight; y++) {
+        u64 *row = &mask[y * maskStride];
+        for (int x = 0; x < matWidth; x++) {
+            if (tiles[x + y * matWidth].mat->id != GAME()->materials_list.GENERIC_AIR.id) row[x >> 6] |= 1ull << (x & 63);
+        }
+    }
+    dirtyMinY = 0;
+    dirtyMaxY = matHeight - 1;
+    maskChanged = true;
+}
+
+bool RigidBody::setTile(int x, int y, MaterialInstance mat) {
+    MaterialInstance &cur = tiles[x + y * matWidth];
+    if (cur.mat == mat.mat && cur.color == mat.color) {
+        cur = mat;
+        return false;
+    }
+    cur = mat;
+
+    dirtyMinY = std::min(dirtyMinY, y);
+    dirtyMaxY = std::max(dirtyMaxY, y);
+
+    u64 &w = mask[y * maskStride + (x >> 6)];
+    u64 bit = 1ull << (x & 63);
+    bool solid = mat.mat->id != GAME()->materials_list.GENERIC_AIR.id;
+    if (((w & bit) != 0) == solid) return false;
+    w ^= bit;
+    maskChanged = true;
+    return true;
+}
+
+int RigidBody::syncSurface(bool all) {
+    C_Surface *sfc = get_surface();
+    int y0 = all ? 0 : std::max(dirtyMinY, 0);
+    int y1 = all ? matHeight - 1 : std::min(dirtyMaxY, matHeight - 1);
+    dirtyMinY = INT_MAX;
+    dirtyMaxY = -1;
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = 0; x < matWidth; x++) {
+            MaterialInstance &mat = tiles[x + y * matWidth];
+            if (mat.mat->id == GAME()->materials_list.GENERIC_AIR.id) {
+                ME_get_pixel(sfc, x, y) = 0x00000000;
+            } else {
+                ME_get_pixel(sfc, x, y) = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
+            }
+        }
+    }
+    return std::max(y1 - y0 + 1, 0);
+}
+
+bool RigidBody::maskBounds(int &minX, int &minY, int &maxX, int &maxY) const {
+    minX = matWidth;
+    maxX = 0;
+    minY = matHeight;
+    maxY = 0;
+    for (int y = 0; y < matHeight; y++) {
+        const u64 *row = &mask[y * maskStride];
+        int first = -1, last = -1;
+        for (int k = 0; k < maskStride; k++) {
+            if (row[k] == 0) continue;
+            if (first < 0) first = k * 64 + std::countr_zero(row[k]);
+            last = k * 64 + 63 - std::countl_zero(row[k]);
+        }
+        if (first < 0) continue;
+        minX = std::min(minX, first);
+        maxX = std::max(maxX, last + 1);
+        if (y < minY) minY = y;
+        maxY = y + 1;
+    }
+    return maxY > 0;
+}
+
+void RigidBody::cropTiles(int x, int y, int w, int h) {
+    MaterialInstance *nt = new MaterialInstance[w * h];
+    for (int yy = 0; yy < h; yy++) {
+        std::copy_n(&tiles[x + (y + yy) * matWidth], w, &nt[yy * w]);
+    }
+    delete[] tiles;
+    tiles = nt;
+    matWidth = w;
+    matHeight = h;
+
+    // 裁剪后位图按列平移 直接重建 此时 surface 已与 tiles 一致
+    bool changed = maskChanged;
+    buildMask();
+    dirtyMinY = INT_MAX;
+    dirtyMaxY = -1;
+    maskChanged = changed;
+}
+
 void Player::render(WorldEntity *we, R_Target *target, int ofsX, int ofsY) {
     if (heldItem != NULL) {
         int scaleEnt = global.game->Iso.globaldef.hd_objects ? global.game->Iso.globaldef.hd_objects_size : 1;
@@ -186,8 +283,8 @@ void WorldEntitySystem::process(ecs::registry &world, const entity_update_event
                             evt.g->objectDelete[wx + wy * evt.g->Iso.world->width] = true;
                         } else if (evt.g->Iso.world->real_tiles[wx + wy * evt.g->Iso.world->width].mat->physicsType == PhysicsType::SAND ||
                                    evt.g->Iso.world->real_tiles[wx + wy * evt.g->Iso.world->width].mat->physicsType == PhysicsType::SOUP) {
-                            evt.g->Iso.world->addCell(new CellData(evt.g->Iso.world->real_tiles[wx + wy * evt.g->Iso.world->width], (f32)(wx + rand() % 3 - 1 - pl.vx), (f32)(wy - abs(pl.vy)),
-                                                                   (f32)(-pl.vx / 4 + (rand() % 10 - 5) / 5.0f), (f32)(-pl.vy / 4 + -(rand() % 5 + 5) / 5.0f), 0, (f32)0.1));
+                            evt.g->Iso.world->addCell(CellData(evt.g->Iso.world->real_tiles[wx + wy * evt.g->Iso.world->width], (f32)(wx + rand() % 3 - 1 - pl.vx), (f32)(wy - abs(pl.vy)),
+                                                               (f32)(-pl.vx / 4 + (rand() % 10 - 5) / 5.0f), (f32)(-pl.vy / 4 + -(rand() % 5 + 5) / 5.0f), 0, (f32)0.1));
                             evt.g->Iso.world->real_tiles[wx + wy * evt.g->Iso.world->width] = Tiles_OBJECT;
                             evt.g->objectDelete[wx + wy * evt.g->Iso.world->width] = true;
                             evt.g->Iso.world->dirty[wx + wy * evt.g->Iso.world->width] = true;
@@ -3,6 +3,8 @@
 #ifndef ME_PLAYER_HPP
 #define ME_PLAYER_HPP
 
+#include <climits>
+
 #include "engine/game_datastruct.hpp"
 #include "engine/physics/box2d/inc/box2d.h"
 #include "engine/physics/physics_math.hpp"
@@ -30,6 +32,18 @@ public:
     int matHeight = 0;
     MaterialInstance *tiles = nullptr;
 
+    // 实心位图 每行 maskStride 个字 bit x 对应第 x 列 非空气为 1
+    // 行尾多出的位恒为 0
+    std::vector<u64> mask;
+    int maskStride = 0;
+
+    // 自上次同步 surface 以来被修改过的行 [dirtyMinY, dirtyMaxY]
+    int dirtyMinY = INT_MAX;
+    int dirtyMaxY = -1;
+
+    // 实心位图自上次 hitbox 更新以来有变化
+    bool maskChanged = false;
+
     // hitbox needs update
     bool needsUpdate = false;
 
@@ -45,6 +59,15 @@ public:
 
     Item *item = nullptr;
 
+    // 在 world::rigidBodies 中的槽位
+    u32 listSlot = UINT32_MAX;
+    // 最近一次报告该刚体的查询 同一刚体的多个夹具只报告一次
+    u32 queryStamp = 0;
+
+    // tickObjectBounds 使用: 连续静止的帧数 / 连续处于冻结带外的帧数
+    u16 restTicks = 0;
+    u16 offZoneTicks = 0;
+
 public:
     RigidBody(b2Body *body, std::string name = "unknown");
     ~RigidBody() = default;
@@ -62,6 +85,18 @@ public:
 
     void clean();
     void chunk_clean();
+
+    // 由 tiles 全量生成实心位图 并把所有行标记为脏
+    void buildMask();
+    bool solidAt(int x, int y) const { return (mask[y * maskStride + (x >> 6)] >> (x & 63)) & 1; }
+    // 写入一个像素的材质并标记所在行 返回实心状态是否改变
+    bool setTile(int x, int y, MaterialInstance mat);
+    // 把脏行从 tiles 写回 surface 返回写回的行数
+    int syncSurface(bool all = false);
+    // 按字求实心像素的包围盒 [minX, maxX) x [minY, maxY) 没有实心像素时返回 false
+    bool maskBounds(int &minX, int &minY, int &maxX, int &maxY) const;
+    // 把 tiles 与位图裁剪到 (x, y, w, h)
+    void cropTiles(int x, int y, int w, int h);
 };
 
 template <>